@@ -1,20 +1,26 @@
 #include "ppfs/disk/file_disk.hpp"
+#include "ppfs/disk/mmap_disk.hpp"
 #include "ppfs/filesystem/fs_config_helpers.hpp"
 #include "ppfs/filesystem/ppfs.hpp"
 
 #include <iostream>
 #include <memory>
+#include <string>
 
 int main(int argc, char** argv)
 {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <config_file_path> <disk_image_path>\n";
+    std::string option = argc == 4 ? argv[1] : "";
+    bool use_mmap = option == "--mmap";
+    bool use_direct = option == "--direct";
+    if (argc != 3 && !use_mmap && !use_direct) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--mmap | --direct] <config_file_path> <disk_image_path>\n";
         print_fs_config_usage(std::cerr);
         return 1;
     }
 
-    std::string_view disk_image_path = argv[2];
-    std::string_view config_path = argv[1];
+    std::string_view disk_image_path = argv[argc - 1];
+    std::string_view config_path = argv[argc - 2];
 
     auto cfg_res = load_fs_config(config_path);
     if (!cfg_res.has_value()) {
@@ -26,8 +32,11 @@ int main(int argc, char** argv)
 
     FsConfig cfg = cfg_res.value();
 
-    FileDisk disk;
-    auto create_res = disk.create(disk_image_path, cfg.total_size);
+    FileDisk file_disk;
+    MmapDisk mmap_disk;
+    auto create_res = use_mmap ? mmap_disk.create(disk_image_path, cfg.total_size)
+                               : file_disk.create(disk_image_path, cfg.total_size, use_direct);
+    IDisk& disk = use_mmap ? static_cast<IDisk&>(mmap_disk) : file_disk;
     if (!create_res.has_value()) {
         std::cerr << "Failed to create disk file at: " << disk_image_path
                   << ", error: " << toString(create_res.error()) << std::endl;
@@ -1,34 +1,88 @@
 #include "ppfs/disk/file_disk.hpp"
+#include "ppfs/disk/mmap_disk.hpp"
 #include "ppfs/filesystem/fs_config_helpers.hpp" // dla load_fs_config
 #include "ppfs/low_level_fuse/fuse_ppfs.hpp"
+#include <array>
+#include <cstdlib>
 #include <iostream>
+#include <string>
+#include <vector>
 
 int main(int argc, char* argv[])
 {
     try {
-        if (argc < 3) {
+        // Positional arguments and options before "--", fuse arguments after it
+        std::vector<std::string> positional;
+        bool use_mmap = false;
+        bool mmap_populate = false;
+        bool use_direct = false;
+        bool clone_fd = false;
+        unsigned long threads = 0;
+        int fuse_args_start = argc;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--") {
+                fuse_args_start = i + 1;
+                break;
+            }
+            if (arg == "--mmap")
+                use_mmap = true;
+            else if (arg == "--mmap-populate")
+                use_mmap = mmap_populate = true;
+            else if (arg == "--direct")
+                use_direct = true;
+            else if (arg == "--clone-fd")
+                clone_fd = true;
+            else if (arg == "--threads" && i + 1 < argc)
+                threads = std::strtoul(argv[++i], nullptr, 10);
+            else
+                positional.push_back(arg);
+        }
+
+        if (positional.size() < 2 || (use_mmap && use_direct)) {
             std::cerr << "Usage: " << argv[0]
-                      << " <disk_file> <mount_point> [config_file] [-- fuse args...]\n";
+                      << " [--mmap | --mmap-populate | --direct] [--threads N] [--clone-fd]"
+                         " <disk_file> <mount_point> [config_file] [-- fuse args...]\n";
             return 1;
         }
 
-        std::string disk_path = argv[1];
-        std::string mount_point = argv[2];
-        std::string cfg_path = (argc >= 4) ? argv[3] : "";
+        std::string disk_path = positional[0];
+        std::string mount_point = positional[1];
+        std::string cfg_path = (positional.size() >= 3) ? positional[2] : "";
 
-        FileDisk disk;
+        FileDisk file_disk;
+        MmapDisk mmap_disk;
         // create/open disk, format, etc.
 
-        auto open_res = disk.open(disk_path);
+        auto open_res = use_mmap
+            ? mmap_disk.open(
+                  disk_path, { .populate = mmap_populate, .advice = MmapAdvice::Random })
+            : file_disk.open(disk_path, use_direct);
+        IDisk& disk = use_mmap ? static_cast<IDisk&>(mmap_disk) : file_disk;
         if (!open_res.has_value()) {
             std::cerr << "Failed to open disk file: " << disk_path << "\n";
             return 1;
         }
 
-        PpFSLowLevel ppfs(disk);
+        // Only runtime options (cache policy) are taken from the config, layout comes from disk
+        CachePolicy cache_policy = CachePolicy::None;
+        if (!cfg_path.empty()) {
+            auto cfg_res = load_fs_config(cfg_path, false);
+            if (!cfg_res.has_value()) {
+                std::cerr << "Failed to load FsConfig from " << cfg_path << "\n";
+                return 1;
+            }
+            cache_policy = cfg_res.value().cache_policy;
+        }
+
+        // Static, so that the cache doesn't take the stack of the main thread
+        static std::array<CachingBlockDevice::Entry, CachingBlockDevice::DEFAULT_CAPACITY>
+            cache_entries;
+        PpFSLowLevel ppfs(disk, cache_policy, { cache_entries.data(), cache_entries.size() });
         auto init_res = ppfs.init();
         if (!init_res.has_value()) {
-            std::cerr << "Disk not formatted...\n";
+            std::cerr << "Failed to mount " << disk_path << ": " << toString(init_res.error())
+                      << "\n";
             return 1;
         }
 
@@ -36,13 +90,22 @@ int main(int argc, char* argv[])
         fuse_argv.push_back(argv[0]); // nazwa programu
         fuse_argv.push_back(const_cast<char*>(mount_point.c_str()));
 
-        for (int i = 3; i < argc; ++i) {
-            if (std::string(argv[i]) == "--") {
-                for (int j = i + 1; j < argc; ++j)
-                    fuse_argv.push_back(argv[j]);
-                break;
-            }
+        // Requests are dispatched by fuse_session_loop_mt unless a single worker is asked for.
+        // FUSE 3.10 spawns workers on demand, the count bounds how many stay idle between bursts.
+        std::string idle_threads_opt = "max_idle_threads=" + std::to_string(threads);
+        if (threads == 1) {
+            fuse_argv.push_back(const_cast<char*>("-s"));
+        } else if (threads > 1) {
+            fuse_argv.push_back(const_cast<char*>("-o"));
+            fuse_argv.push_back(idle_threads_opt.data());
         }
+        if (clone_fd) {
+            fuse_argv.push_back(const_cast<char*>("-o"));
+            fuse_argv.push_back(const_cast<char*>("clone_fd"));
+        }
+
+        for (int i = fuse_args_start; i < argc; ++i)
+            fuse_argv.push_back(argv[i]);
 
         FusePpFS fuse_ppfs(ppfs);
 
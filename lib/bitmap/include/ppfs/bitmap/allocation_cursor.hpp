@@ -0,0 +1,52 @@
+#pragma once
+#include "ppfs/bitmap/bitmap.hpp"
+#include "ppfs/common/allocation_policy.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+
+/**
+ * Remembers where allocations in a bitmap happened, so that the next search can start there
+ *
+ * With ThreadGroups the bitmap is split into ALLOCATION_GROUPS equal parts, each with its own
+ * cursor starting at the beginning of its part. The calling thread picks the group, so
+ * concurrent writers allocate from different bitmap blocks.
+ */
+class AllocationCursor {
+public:
+    static constexpr size_t ALLOCATION_GROUPS = 8;
+
+    /**
+     * @param policy where searches should start
+     * @param bit_count number of bits of the bitmap searched
+     */
+    AllocationCursor(AllocationPolicy policy, size_t bit_count);
+
+    /**
+     * Bit the next search should start at
+     */
+    unsigned int start() const;
+
+    /**
+     * Moves the cursor past an allocated bit
+     *
+     * @param bit last bit that was allocated
+     */
+    void advance(unsigned int bit);
+
+    /**
+     * Finds first bit equal to value at or after start(), wrapping around to the beginning
+     *
+     * @return index of the bit, Bitmap_NotFound if there is none
+     */
+    [[nodiscard]] std::expected<unsigned int, FsError> find(Bitmap& bitmap, bool value) const;
+
+private:
+    AllocationPolicy _policy;
+    size_t _bit_count;
+    std::array<unsigned int, ALLOCATION_GROUPS> _cursors;
+
+    size_t _cursorIndex() const;
+};
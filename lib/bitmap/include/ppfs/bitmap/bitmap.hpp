@@ -1,11 +1,19 @@
 #pragma once
 #include "ppfs/blockdevice/iblock_device.hpp"
+#include "ppfs/common/static_vector.hpp"
 #include "ppfs/common/types.hpp"
+#include <array>
 #include <cstdint>
 #include <optional>
 
 /**
  * Class for working with bitmaps in disk
+ *
+ * Given a buffer of at least mirrorWords(bit_count) words, the bitmap is mirrored in it as 64
+ * bit words, loaded by load() or on first use. Reads are then served from the mirror and writes
+ * go to both the mirror and the disk. Two summary levels keep one bit per word telling whether
+ * the word has any zero or any one, so searching for a bit touches a few summary words and a
+ * single mirror word. Mirror assumes the bitmap is modified only through this object.
  */
 class Bitmap {
     IBlockDevice& _block_device;
@@ -13,21 +21,92 @@ class Bitmap {
     size_t _bit_count;
     std::optional<std::uint32_t> _ones_count;
 
+    bool _use_mirror;
+    bool _mirror_loaded = false;
+    /** Bit i of the bitmap is bit i % 64 of word i / 64, bits past the end are zero */
+    std::uint64_t* _words = nullptr;
+    std::uint64_t* _has_zero = nullptr;
+    std::uint64_t* _has_one = nullptr;
+
     DataLocation _getByteLocation(unsigned int bit_index);
     [[nodiscard]] std::expected<unsigned char, FsError> _getByte(unsigned int bit_index);
 
+    size_t _wordCount() const;
+    size_t _summaryWordCount() const;
+    std::uint64_t _validMask(size_t word_index) const;
+    void _updateSummary(size_t word_index);
+    /** Mirror word with bits equal to value set, bits past the end cleared */
+    std::uint64_t _mirrorWord(bool value, size_t word_index) const;
+    [[nodiscard]] std::expected<void, FsError> _loadMirror();
+    /** Byte of the bitmap as stored on disk, taken from the mirror */
+    std::uint8_t _mirrorByte(unsigned int bit_index) const;
+    /** Reads one bitmap block, from the mirror if it is loaded */
+    [[nodiscard]] std::expected<void, FsError> _readBitmapBlock(
+        size_t block, static_vector<uint8_t>& data);
+    /**
+     * Applies changes of bits in one bitmap block to data, returns number of bits that changed
+     * from zero to one minus those that changed from one to zero
+     */
+    [[nodiscard]] std::expected<int, FsError> _applyToBlock(const std::uint32_t* bits,
+        size_t count, bool value, bool flip_only, static_vector<uint8_t>& data) const;
+
 public:
+    /** Number of words a mirror of bit_count bits takes, summaries included */
+    static constexpr size_t mirrorWords(size_t bit_count)
+    {
+        size_t words = (bit_count + 63) / 64;
+        return words + 2 * ((words + 63) / 64);
+    }
+
     /**
      * @param block_device Block device on which bitmap is stored
      * @param start_block Starting block of the bitmap (bitmap always starts at the start of a
      * block)
      * @param bit_count Number of bits stored in bitmap
+     * @param mirror Buffer for the in-memory mirror, bitmap is kept only on disk if it holds
+     * fewer than mirrorWords(bit_count) words
      */
-    Bitmap(IBlockDevice& block_device, block_index_t start_block, size_t bit_count);
+    Bitmap(IBlockDevice& block_device, block_index_t start_block, size_t bit_count,
+        static_vector<std::uint64_t> mirror = {});
+
+    /** Loads the mirror now instead of on first use, does nothing without a mirror */
+    [[nodiscard]] std::expected<void, FsError> load();
+
     [[nodiscard]] std::expected<std::uint32_t, FsError> count(bool value);
     [[nodiscard]] std::expected<bool, FsError> getBit(unsigned int bit_index);
     [[nodiscard]] std::expected<void, FsError> setBit(unsigned int bit_index, bool value);
-    [[nodiscard]] std::expected<unsigned int, FsError> getFirstEq(bool value);
+
+    /**
+     * Sets many bits to value, writing every touched bitmap block once
+     *
+     * Bits are sorted in place. With flip_only set, all bits are checked before anything is
+     * written and if some bit already equals value nothing changes and Bitmap_AlreadySet is
+     * returned. If writing fails, blocks written before the failure keep their changes.
+     *
+     * @param bits indices of bits to set, may repeat only without flip_only, otherwise a
+     * repeated bit counts as already set
+     * @param value value to set the bits to
+     * @param flip_only whether every bit has to change
+     */
+    [[nodiscard]] std::expected<void, FsError> setBits(
+        static_vector<std::uint32_t>& bits, bool value, bool flip_only = false);
+
+    /**
+     * Finds first bit equal to value at or after start
+     *
+     * @return index of the bit, Bitmap_NotFound if there is none
+     */
+    [[nodiscard]] std::expected<unsigned int, FsError> getFirstEq(
+        bool value, unsigned int start = 0);
+
+    /**
+     * Counts consecutive bits equal to value starting at start, stops at max_length
+     *
+     * @return length of the run, zero if bit at start differs
+     */
+    [[nodiscard]] std::expected<unsigned int, FsError> runLength(
+        bool value, unsigned int start, unsigned int max_length);
+
     [[nodiscard]] std::expected<void, FsError> setAll(bool value);
     int blocksSpanned() const;
     [[nodiscard]] std::expected<std::uint32_t, FsError> count(bool value) const;
@@ -0,0 +1,72 @@
+#include "ppfs/bitmap/allocation_cursor.hpp"
+
+#ifdef PPFS_USE_FREERTOS
+#    include "FreeRTOS.h"
+#    include "task.h"
+#else
+#    include <pthread.h>
+#endif
+
+namespace {
+
+size_t currentThreadGroup(size_t groups)
+{
+#ifdef PPFS_USE_FREERTOS
+    auto key = (std::uint64_t)(std::uintptr_t)xTaskGetCurrentTaskHandle();
+#else
+    auto key = (std::uint64_t)pthread_self();
+#endif
+    // Thread handles are aligned addresses, so they are mixed before taking the group
+    return ((key * 0x9e3779b97f4a7c15ULL) >> 32) % groups;
+}
+
+}
+
+AllocationCursor::AllocationCursor(AllocationPolicy policy, size_t bit_count)
+    : _policy(policy)
+    , _bit_count(bit_count)
+{
+    for (size_t group = 0; group < ALLOCATION_GROUPS; group++) {
+        _cursors[group] = _policy == AllocationPolicy::ThreadGroups
+            ? group * bit_count / ALLOCATION_GROUPS
+            : 0;
+    }
+}
+
+size_t AllocationCursor::_cursorIndex() const
+{
+    if (_policy != AllocationPolicy::ThreadGroups) {
+        return 0;
+    }
+    return currentThreadGroup(ALLOCATION_GROUPS);
+}
+
+unsigned int AllocationCursor::start() const
+{
+    if (_policy == AllocationPolicy::FirstFit) {
+        return 0;
+    }
+    return _cursors[_cursorIndex()];
+}
+
+void AllocationCursor::advance(unsigned int bit)
+{
+    if (_policy == AllocationPolicy::FirstFit) {
+        return;
+    }
+    _cursors[_cursorIndex()] = bit + 1 < _bit_count ? bit + 1 : 0;
+}
+
+std::expected<unsigned int, FsError> AllocationCursor::find(Bitmap& bitmap, bool value) const
+{
+    auto first = start();
+    auto find_ret = bitmap.getFirstEq(value, first);
+    if (find_ret.has_value() || find_ret.error() != FsError::Bitmap_NotFound || first == 0) {
+        return find_ret;
+    }
+    find_ret = bitmap.getFirstEq(value, 0);
+    if (find_ret.has_value() && find_ret.value() >= first) {
+        return std::unexpected(FsError::Bitmap_NotFound);
+    }
+    return find_ret;
+}
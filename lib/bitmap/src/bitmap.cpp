@@ -2,9 +2,25 @@
 #include "ppfs/common/bit_helpers.hpp"
 #include "ppfs/common/static_vector.hpp"
 
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <cmath>
 
+namespace {
+
+/** Disk bytes keep bit 0 as the most significant bit, mirror words as the least significant */
+constexpr std::uint8_t reverseBits(std::uint8_t byte)
+{
+    std::uint8_t reversed = 0;
+    for (int i = 0; i < 8; i++) {
+        reversed = static_cast<std::uint8_t>((reversed << 1) | ((byte >> i) & 1));
+    }
+    return reversed;
+}
+
+}
+
 DataLocation Bitmap::_getByteLocation(unsigned int bit_index)
 {
     auto byte = bit_index / 8;
@@ -30,11 +46,91 @@ int Bitmap::blocksSpanned() const
         / static_cast<float>(_block_device.dataSize()));
 }
 
-Bitmap::Bitmap(IBlockDevice& block_device, block_index_t start_block, size_t bit_count)
+Bitmap::Bitmap(IBlockDevice& block_device, block_index_t start_block, size_t bit_count,
+    static_vector<std::uint64_t> mirror)
     : _block_device(block_device)
     , _start_block(start_block)
     , _bit_count(bit_count)
+    , _use_mirror(mirror.capacity() >= mirrorWords(bit_count))
+{
+    if (_use_mirror) {
+        _words = mirror.data();
+        _has_zero = _words + _wordCount();
+        _has_one = _has_zero + _summaryWordCount();
+    }
+}
+
+size_t Bitmap::_wordCount() const { return (_bit_count + 63) / 64; }
+
+size_t Bitmap::_summaryWordCount() const { return (_wordCount() + 63) / 64; }
+
+std::uint64_t Bitmap::_validMask(size_t word_index) const
+{
+    if ((word_index + 1) * 64 <= _bit_count) {
+        return ~std::uint64_t(0);
+    }
+    return (std::uint64_t(1) << (_bit_count % 64)) - 1;
+}
+
+void Bitmap::_updateSummary(size_t word_index)
+{
+    auto word = _words[word_index];
+    auto valid = _validMask(word_index);
+    auto summary_bit = std::uint64_t(1) << (word_index % 64);
+    auto& has_zero = _has_zero[word_index / 64];
+    auto& has_one = _has_one[word_index / 64];
+    has_zero = (~word & valid) != 0 ? (has_zero | summary_bit) : (has_zero & ~summary_bit);
+    has_one = (word & valid) != 0 ? (has_one | summary_bit) : (has_one & ~summary_bit);
+}
+
+std::expected<void, FsError> Bitmap::_loadMirror()
+{
+    auto words = _wordCount();
+    std::fill_n(_words, words, 0);
+    std::fill_n(_has_zero, _summaryWordCount(), 0);
+    std::fill_n(_has_one, _summaryWordCount(), 0);
+
+    size_t bytes = (_bit_count + 7) / 8;
+    size_t data_size = _block_device.dataSize();
+    std::array<uint8_t, MAX_BLOCK_SIZE> block_buffer;
+    for (int block = 0; block < blocksSpanned(); block++) {
+        static_vector<uint8_t> block_data(block_buffer.data(), MAX_BLOCK_SIZE);
+        auto read_ret = _block_device.readBlock(
+            DataLocation(_start_block + block, 0), data_size, block_data);
+        if (!read_ret.has_value()) {
+            return std::unexpected(read_ret.error());
+        }
+        for (size_t i = 0; i < data_size && block * data_size + i < bytes; i++) {
+            size_t byte_index = block * data_size + i;
+            _words[byte_index / 8]
+                |= std::uint64_t(reverseBits(block_data[i])) << (8 * (byte_index % 8));
+        }
+    }
+
+    std::uint32_t ones = 0;
+    for (size_t word = 0; word < words; word++) {
+        _words[word] &= _validMask(word);
+        ones += std::popcount(_words[word]);
+        _updateSummary(word);
+    }
+    _ones_count = ones;
+    _mirror_loaded = true;
+    return {};
+}
+
+std::expected<void, FsError> Bitmap::load()
+{
+    if (!_use_mirror || _mirror_loaded) {
+        return {};
+    }
+    return _loadMirror();
+}
+
+std::uint8_t Bitmap::_mirrorByte(unsigned int bit_index) const
 {
+    unsigned int byte_index = bit_index / 8;
+    auto byte = static_cast<std::uint8_t>(_words[byte_index / 8] >> (8 * (byte_index % 8)));
+    return reverseBits(byte);
 }
 
 std::expected<std::uint32_t, FsError> Bitmap::count(bool value)
@@ -45,6 +141,12 @@ std::expected<std::uint32_t, FsError> Bitmap::count(bool value)
         }
         return _bit_count - _ones_count.value();
     }
+    if (_use_mirror) {
+        if (auto load_ret = _loadMirror(); !load_ret.has_value()) {
+            return std::unexpected(load_ret.error());
+        }
+        return count(value);
+    }
     std::uint32_t count = 0;
     auto blocks_spanned = blocksSpanned();
     for (int block = 0; block < blocks_spanned - 1; block++) {
@@ -89,6 +191,14 @@ std::expected<bool, FsError> Bitmap::getBit(unsigned int bit_index)
     if (bit_index >= _bit_count) {
         return std::unexpected(FsError::Bitmap_IndexOutOfRange);
     }
+    if (_use_mirror) {
+        if (!_mirror_loaded) {
+            if (auto load_ret = _loadMirror(); !load_ret.has_value()) {
+                return std::unexpected(load_ret.error());
+            }
+        }
+        return ((_words[bit_index / 64] >> (bit_index % 64)) & 1) != 0;
+    }
     auto byte_ret = _getByte(bit_index);
     if (!byte_ret.has_value()) {
         return std::unexpected(byte_ret.error());
@@ -104,11 +214,22 @@ std::expected<void, FsError> Bitmap::setBit(unsigned int bit_index, bool value)
     if (bit_index >= _bit_count) {
         return std::unexpected(FsError::Bitmap_IndexOutOfRange);
     }
-    auto byte_ret = _getByte(bit_index);
-    if (!byte_ret.has_value()) {
-        return std::unexpected(byte_ret.error());
+    if (_use_mirror && !_mirror_loaded) {
+        if (auto load_ret = _loadMirror(); !load_ret.has_value()) {
+            return std::unexpected(load_ret.error());
+        }
+    }
+    std::uint8_t old_byte;
+    if (_use_mirror) {
+        // Mirror knows the neighbouring bits, the block doesn't have to be read
+        old_byte = _mirrorByte(bit_index);
+    } else {
+        auto byte_ret = _getByte(bit_index);
+        if (!byte_ret.has_value()) {
+            return std::unexpected(byte_ret.error());
+        }
+        old_byte = byte_ret.value();
     }
-    auto old_byte = byte_ret.value();
     auto bit = bit_index % 8;
 
     std::uint8_t byte;
@@ -126,6 +247,13 @@ std::expected<void, FsError> Bitmap::setBit(unsigned int bit_index, bool value)
         return std::unexpected(write_ret.error());
     }
 
+    if (_use_mirror) {
+        auto mask = std::uint64_t(1) << (bit_index % 64);
+        auto& word = _words[bit_index / 64];
+        word = value ? (word | mask) : (word & ~mask);
+        _updateSummary(bit_index / 64);
+    }
+
     if (_ones_count.has_value() && byte != old_byte) {
         if (value) {
             _ones_count.value()++;
@@ -137,11 +265,163 @@ std::expected<void, FsError> Bitmap::setBit(unsigned int bit_index, bool value)
     return {};
 }
 
-std::expected<unsigned int, FsError> Bitmap::getFirstEq(bool value)
+std::expected<void, FsError> Bitmap::_readBitmapBlock(size_t block, static_vector<uint8_t>& data)
 {
+    size_t data_size = _block_device.dataSize();
+    if (!_mirror_loaded) {
+        return _block_device.readBlock(DataLocation(_start_block + block, 0), data_size, data);
+    }
+
+    // Whole block is rebuilt from the mirror, bytes past the end of the bitmap are zero
+    size_t bytes = (_bit_count + 7) / 8;
+    data.resize(data_size);
+    for (size_t i = 0; i < data_size; i++) {
+        size_t byte_index = block * data_size + i;
+        data[i] = byte_index < bytes ? _mirrorByte(byte_index * 8) : 0;
+    }
+    return {};
+}
+
+std::expected<int, FsError> Bitmap::_applyToBlock(const std::uint32_t* bits, size_t count,
+    bool value, bool flip_only, static_vector<uint8_t>& data) const
+{
+    size_t bits_per_block = _block_device.dataSize() * 8;
+    int ones_change = 0;
+    for (size_t i = 0; i < count; i++) {
+        auto bit = bits[i] % bits_per_block;
+        bool old_value = BitHelpers::getBit(data, bit);
+        if (old_value == value) {
+            if (flip_only) {
+                return std::unexpected(FsError::Bitmap_AlreadySet);
+            }
+            continue;
+        }
+        BitHelpers::setBit(data, bit, value);
+        ones_change += value ? 1 : -1;
+    }
+    return ones_change;
+}
+
+std::expected<void, FsError> Bitmap::setBits(
+    static_vector<std::uint32_t>& bits, bool value, bool flip_only)
+{
+    if (bits.empty()) {
+        return {};
+    }
+    std::sort(bits.begin(), bits.end());
+    if (bits[bits.size() - 1] >= _bit_count) {
+        return std::unexpected(FsError::Bitmap_IndexOutOfRange);
+    }
+    if (_use_mirror && !_mirror_loaded) {
+        if (auto load_ret = _loadMirror(); !load_ret.has_value()) {
+            return std::unexpected(load_ret.error());
+        }
+    }
+
+    size_t bits_per_block = _block_device.dataSize() * 8;
+    std::array<uint8_t, MAX_BLOCK_SIZE> block_buffer;
+
+    // Every block is checked first, so a failed check leaves the bitmap untouched
+    for (size_t group = 0; flip_only && group < bits.size();) {
+        size_t block = bits[group] / bits_per_block;
+        size_t group_end = group;
+        while (group_end < bits.size() && bits[group_end] / bits_per_block == block) {
+            group_end++;
+        }
+        static_vector<uint8_t> block_data(block_buffer.data(), MAX_BLOCK_SIZE);
+        if (auto read_ret = _readBitmapBlock(block, block_data); !read_ret.has_value()) {
+            return std::unexpected(read_ret.error());
+        }
+        auto check_ret
+            = _applyToBlock(bits.data() + group, group_end - group, value, true, block_data);
+        if (!check_ret.has_value()) {
+            return std::unexpected(check_ret.error());
+        }
+        group = group_end;
+    }
+
+    for (size_t group = 0; group < bits.size();) {
+        size_t block = bits[group] / bits_per_block;
+        size_t group_end = group;
+        while (group_end < bits.size() && bits[group_end] / bits_per_block == block) {
+            group_end++;
+        }
+        static_vector<uint8_t> block_data(block_buffer.data(), MAX_BLOCK_SIZE);
+        if (auto read_ret = _readBitmapBlock(block, block_data); !read_ret.has_value()) {
+            return std::unexpected(read_ret.error());
+        }
+        auto apply_ret
+            = _applyToBlock(bits.data() + group, group_end - group, value, false, block_data);
+        if (!apply_ret.has_value()) {
+            return std::unexpected(apply_ret.error());
+        }
+        auto write_ret
+            = _block_device.writeBlock(block_data, DataLocation(_start_block + block, 0));
+        if (!write_ret.has_value()) {
+            return std::unexpected(write_ret.error());
+        }
+
+        if (_use_mirror) {
+            for (size_t i = group; i < group_end; i++) {
+                auto mask = std::uint64_t(1) << (bits[i] % 64);
+                auto& word = _words[bits[i] / 64];
+                word = value ? (word | mask) : (word & ~mask);
+                _updateSummary(bits[i] / 64);
+            }
+        }
+        if (_ones_count.has_value()) {
+            _ones_count.value() += apply_ret.value();
+        }
+        group = group_end;
+    }
+    return {};
+}
+
+std::uint64_t Bitmap::_mirrorWord(bool value, size_t word_index) const
+{
+    return (value ? _words[word_index] : ~_words[word_index]) & _validMask(word_index);
+}
+
+std::expected<unsigned int, FsError> Bitmap::getFirstEq(bool value, unsigned int start)
+{
+    if (start >= _bit_count) {
+        return std::unexpected(FsError::Bitmap_NotFound);
+    }
+
+    if (_use_mirror) {
+        if (!_mirror_loaded) {
+            if (auto load_ret = _loadMirror(); !load_ret.has_value()) {
+                return std::unexpected(load_ret.error());
+            }
+        }
+        size_t first_word = start / 64;
+        auto word = _mirrorWord(value, first_word) & (~std::uint64_t(0) << (start % 64));
+        if (word != 0) {
+            return static_cast<unsigned int>(first_word * 64 + std::countr_zero(word));
+        }
+
+        // Remaining words are found through the summary
+        const auto& summary = value ? _has_one : _has_zero;
+        size_t next_word = first_word + 1;
+        for (size_t s = next_word / 64; s * 64 < _wordCount(); s++) {
+            auto summary_word = summary[s];
+            if (s == next_word / 64) {
+                summary_word &= ~std::uint64_t(0) << (next_word % 64);
+            }
+            if (summary_word == 0) {
+                continue;
+            }
+            size_t word_index = s * 64 + std::countr_zero(summary_word);
+            return static_cast<unsigned int>(
+                word_index * 64 + std::countr_zero(_mirrorWord(value, word_index)));
+        }
+        return std::unexpected(FsError::Bitmap_NotFound);
+    }
+
     int blocks_spanned = blocksSpanned();
+    size_t bits_per_block = _block_device.dataSize() * 8;
 
-    for (int block = 0; block < blocks_spanned; block++) {
+    for (int block = start / bits_per_block; block < blocks_spanned; block++) {
         std::array<uint8_t, MAX_BLOCK_SIZE> block_buffer;
         static_vector<uint8_t> block_data(block_buffer.data(), MAX_BLOCK_SIZE);
         auto block_ret = _block_device.readBlock(
@@ -149,19 +429,63 @@ std::expected<unsigned int, FsError> Bitmap::getFirstEq(bool value)
         if (!block_ret.has_value()) {
             return std::unexpected(block_ret.error());
         }
-        for (int i = 0; i < _block_device.dataSize() * 8; i++) {
-            if (block * _block_device.dataSize() * 8 + i >= _bit_count) {
+        size_t first_bit = block == start / bits_per_block ? start % bits_per_block : 0;
+        for (size_t i = first_bit; i < bits_per_block; i++) {
+            if (block * bits_per_block + i >= _bit_count) {
                 // there is no more value in bitmap
                 return std::unexpected(FsError::Bitmap_NotFound);
             }
             if (BitHelpers::getBit(block_data, i) == value) {
-                return block * _block_device.dataSize() * 8 + i;
+                return block * bits_per_block + i;
             }
         }
     }
     return std::unexpected(FsError::Bitmap_NotFound);
 }
 
+std::expected<unsigned int, FsError> Bitmap::runLength(
+    bool value, unsigned int start, unsigned int max_length)
+{
+    if (start >= _bit_count) {
+        return std::unexpected(FsError::Bitmap_IndexOutOfRange);
+    }
+
+    if (_use_mirror) {
+        if (!_mirror_loaded) {
+            if (auto load_ret = _loadMirror(); !load_ret.has_value()) {
+                return std::unexpected(load_ret.error());
+            }
+        }
+        unsigned int length = 0;
+        size_t position = start;
+        while (length < max_length && position < _bit_count) {
+            auto offset = position % 64;
+            // Bits past the end are never equal, so the run stops there
+            unsigned int run = std::countr_one(_mirrorWord(value, position / 64) >> offset);
+            run = std::min<unsigned int>(run, 64 - offset);
+            length += run;
+            position += run;
+            if (run < 64 - offset) {
+                break;
+            }
+        }
+        return std::min(length, max_length);
+    }
+
+    unsigned int length = 0;
+    while (length < max_length && start + length < _bit_count) {
+        auto bit_ret = getBit(start + length);
+        if (!bit_ret.has_value()) {
+            return std::unexpected(bit_ret.error());
+        }
+        if (bit_ret.value() != value) {
+            break;
+        }
+        length++;
+    }
+    return length;
+}
+
 std::expected<void, FsError> Bitmap::setAll(bool value)
 {
     auto blocks_spanned = blocksSpanned();
@@ -178,5 +502,14 @@ std::expected<void, FsError> Bitmap::setAll(bool value)
     }
 
     _ones_count = value * _bit_count;
+    if (_use_mirror) {
+        std::fill_n(_has_zero, _summaryWordCount(), 0);
+        std::fill_n(_has_one, _summaryWordCount(), 0);
+        for (size_t word = 0; word < _wordCount(); word++) {
+            _words[word] = value ? _validMask(word) : 0;
+            _updateSummary(word);
+        }
+        _mirror_loaded = true;
+    }
     return {};
 }
@@ -2,32 +2,66 @@
 #include "iblock_manager.hpp"
 #include "ppfs/super_block_manager/super_block.hpp"
 
+#include "ppfs/bitmap/allocation_cursor.hpp"
 #include "ppfs/bitmap/bitmap.hpp"
+#include "ppfs/common/ppfs_mutex.hpp"
 #include "ppfs/common/types.hpp"
 
 #include <optional>
 
 /**
  * Manages allocation and deallocation of data blocks.
+ *
+ * Public methods hold an internal allocator lock, so files can grow from several threads.
  */
 class BlockManager : public IBlockManager {
+    /** Number of too short free fragments skipped before settling for a shorter run */
+    static constexpr size_t MAX_RUN_CANDIDATES = 64;
+    /** Number of bits of a run handed to the bitmap in one batch */
+    static constexpr size_t RUN_BATCH_SIZE = 256;
+
     Bitmap _bitmap;
     block_index_t _data_blocks_start;
     block_index_t _num_data_blocks;
+    AllocationCursor _cursor;
+    PpFSMutex _mutex;
 
     block_index_t _toRelative(block_index_t absolute_block) const;
     block_index_t _toAbsolute(block_index_t relative_block) const;
+    [[nodiscard]] std::expected<void, FsError> _setBlocks(
+        static_vector<block_index_t>& blocks, bool value);
+    [[nodiscard]] std::expected<void, FsError> _setRun(BlockRun run, bool value);
+    [[nodiscard]] std::expected<block_index_t, FsError> _unprotectedGetFree();
+    [[nodiscard]] std::expected<BlockRun, FsError> _unprotectedReserveRun(
+        block_index_t goal, size_t count);
 
 public:
     /**
+     * Searches for free blocks start as chosen by sb.allocation_policy.
+     *
      * @param sb superblock with valid bitmap and data addresses
      * @param block_device device for io
+     * @param bitmap_mirror buffer for the in-memory copy of the block bitmap, see Bitmap
      */
-    BlockManager(const SuperBlock& sb, IBlockDevice& block_device);
+    BlockManager(const SuperBlock& sb, IBlockDevice& block_device,
+        static_vector<std::uint64_t> bitmap_mirror = {});
+
+    /** Whether the internal mutex was created, every operation fails otherwise */
+    bool isInitialized() const { return _mutex.isInitialized(); }
+
     [[nodiscard]] virtual std::expected<void, FsError> format() override;
     [[nodiscard]] virtual std::expected<void, FsError> reserve(block_index_t block) override;
     [[nodiscard]] virtual std::expected<void, FsError> free(block_index_t block) override;
+    [[nodiscard]] virtual std::expected<void, FsError> reserveBlocks(
+        static_vector<block_index_t>& blocks) override;
+    [[nodiscard]] virtual std::expected<void, FsError> freeBlocks(
+        static_vector<block_index_t>& blocks) override;
     [[nodiscard]] virtual std::expected<block_index_t, FsError> getFree() override;
+    [[nodiscard]] virtual std::expected<BlockRun, FsError> reserveRun(
+        block_index_t goal, size_t count) override;
     [[nodiscard]] virtual std::expected<std::uint32_t, FsError> numFree() override;
     [[nodiscard]] virtual std::expected<std::uint32_t, FsError> numTotal() override;
+
+    /** Loads the block bitmap mirror, so that the first allocation doesn't have to */
+    [[nodiscard]] std::expected<void, FsError> loadBitmap();
 };
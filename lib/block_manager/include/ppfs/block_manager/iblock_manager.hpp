@@ -1,9 +1,19 @@
 #pragma once
+#include "ppfs/common/static_vector.hpp"
 #include "ppfs/common/types.hpp"
 #include "ppfs/disk/idisk.hpp"
 
+#include <cstddef>
 #include <expected>
 
+/**
+ * Contiguous range of blocks
+ */
+struct BlockRun {
+    block_index_t start; /**< First block of the run */
+    size_t count; /**< Number of blocks in the run */
+};
+
 /**
  * Interface containing data blocks operations
  *
@@ -35,6 +45,30 @@ struct IBlockManager {
      */
     [[nodiscard]] virtual std::expected<void, FsError> free(block_index_t block) = 0;
 
+    /**
+     * Mark many blocks as used, writing each touched bitmap block once
+     *
+     * Nothing is reserved if some block is already taken, a block listed twice counts as such.
+     *
+     * @param blocks blocks to be reserved, reordered by the call
+     * @return void on success, error otherwise
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> reserveBlocks(
+        static_vector<block_index_t>& blocks)
+        = 0;
+
+    /**
+     * Mark many blocks as free, writing each touched bitmap block once
+     *
+     * Nothing is freed if some block is already free, a block listed twice counts as such.
+     *
+     * @param blocks blocks to be freed, reordered by the call
+     * @return void on success, error otherwise
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> freeBlocks(
+        static_vector<block_index_t>& blocks)
+        = 0;
+
     /**
      * Get one free block
      *
@@ -42,6 +76,22 @@ struct IBlockManager {
      */
     [[nodiscard]] virtual std::expected<block_index_t, FsError> getFree() = 0;
 
+    /**
+     * Find and reserve contiguous free blocks close to goal
+     *
+     * Prefers the first run of count free blocks at or after goal (wrapping around to the start),
+     * if there is none nearby, reserves the free blocks starting at the first free block after
+     * goal, so the run may be shorter.
+     *
+     * @param goal block the run should start at, for example the one after the last block of a
+     * file, if it is not a data block the search starts where the allocation policy says
+     * @param count wanted number of blocks, at least one
+     * @return reserved run with at least one block on success, error otherwise
+     */
+    [[nodiscard]] virtual std::expected<BlockRun, FsError> reserveRun(
+        block_index_t goal, size_t count)
+        = 0;
+
     /**
      * Calculate number of free blocks
      *
@@ -1,6 +1,10 @@
 #include "ppfs/block_manager/block_manager.hpp"
 
 #include "ppfs/bitmap/bitmap.hpp"
+#include "ppfs/common/mutex_wrapper.hpp"
+
+#include <algorithm>
+#include <array>
 
 block_index_t BlockManager::_toRelative(block_index_t absolute_block) const
 {
@@ -11,12 +15,15 @@ block_index_t BlockManager::_toAbsolute(block_index_t relative_block) const
 {
     return relative_block + _data_blocks_start;
 }
-BlockManager::BlockManager(const SuperBlock& sb, IBlockDevice& block_device)
+BlockManager::BlockManager(
+    const SuperBlock& sb, IBlockDevice& block_device, static_vector<std::uint64_t> bitmap_mirror)
     : _bitmap(block_device, sb.block_bitmap_address,
-          sb.last_data_block_address - sb.first_data_blocks_address + 1)
+          sb.last_data_block_address - sb.first_data_blocks_address + 1, bitmap_mirror)
     , _data_blocks_start(sb.first_data_blocks_address)
     , _num_data_blocks(sb.last_data_block_address - sb.first_data_blocks_address + 1)
+    , _cursor(sb.allocation_policy, _num_data_blocks)
 {
+    (void)_mutex.init();
 }
 
 // Kept for bitmap size calculation
@@ -32,52 +39,85 @@ BlockManager::BlockManager(const SuperBlock& sb, IBlockDevice& block_device)
 
 std::expected<void, FsError> BlockManager::format()
 {
-    if (auto ret = _bitmap.setAll(false); !ret.has_value()) {
-        return std::unexpected(ret.error());
-    }
-    return {};
+    return mutex_wrapper<void>(_mutex, [&]() { return _bitmap.setAll(false); });
 }
 
-std::expected<void, FsError> BlockManager::reserve(block_index_t block)
+std::expected<void, FsError> BlockManager::_setBlocks(
+    static_vector<block_index_t>& blocks, bool value)
 {
-    block = _toRelative(block);
-    auto read_ret = _bitmap.getBit(block);
-    if (!read_ret.has_value()) {
-        return std::unexpected(read_ret.error());
+    for (auto& block : blocks) {
+        block = _toRelative(block);
+    }
+    auto set_ret = _bitmap.setBits(blocks, value, true);
+    if (set_ret.has_value() && value && !blocks.empty()) {
+        _cursor.advance(blocks[blocks.size() - 1]);
     }
-    auto prev_value = read_ret.value();
-    if (prev_value == true) {
-        return std::unexpected(FsError::BlockManager_AlreadyTaken);
+    for (auto& block : blocks) {
+        block = _toAbsolute(block);
     }
-    auto write_ret = _bitmap.setBit(block, true);
-    if (!write_ret.has_value()) {
-        return std::unexpected(write_ret.error());
+    if (!set_ret.has_value()) {
+        if (set_ret.error() == FsError::Bitmap_AlreadySet) {
+            return std::unexpected(
+                value ? FsError::BlockManager_AlreadyTaken : FsError::BlockManager_AlreadyFree);
+        }
+        return std::unexpected(set_ret.error());
     }
     return {};
 }
 
-std::expected<void, FsError> BlockManager::free(block_index_t block)
+std::expected<void, FsError> BlockManager::_setRun(BlockRun run, bool value)
 {
-    block = _toRelative(block);
-    auto read_ret = _bitmap.getBit(block);
-    if (!read_ret.has_value()) {
-        return std::unexpected(read_ret.error());
-    }
-    auto prev_value = read_ret.value();
-    if (prev_value == false) {
-        return std::unexpected(FsError::BlockManager_AlreadyFree);
-    }
-    auto write_ret = _bitmap.setBit(block, false);
-    if (!write_ret.has_value()) {
-        return std::unexpected(write_ret.error());
+    std::array<block_index_t, RUN_BATCH_SIZE> batch_buffer;
+    for (size_t done = 0; done < run.count;) {
+        size_t batch_size = std::min(RUN_BATCH_SIZE, run.count - done);
+        static_vector<block_index_t> batch(batch_buffer.data(), RUN_BATCH_SIZE, batch_size);
+        for (size_t i = 0; i < batch_size; i++) {
+            batch[i] = run.start + done + i;
+        }
+        auto set_ret = _bitmap.setBits(batch, value);
+        if (!set_ret.has_value()) {
+            return std::unexpected(set_ret.error());
+        }
+        done += batch_size;
     }
-
     return {};
 }
 
+std::expected<void, FsError> BlockManager::reserve(block_index_t block)
+{
+    static_vector<block_index_t> blocks(&block, 1, 1);
+    return mutex_wrapper<void>(_mutex, [&]() { return _setBlocks(blocks, true); });
+}
+
+std::expected<void, FsError> BlockManager::free(block_index_t block)
+{
+    static_vector<block_index_t> blocks(&block, 1, 1);
+    return mutex_wrapper<void>(_mutex, [&]() { return _setBlocks(blocks, false); });
+}
+
+std::expected<void, FsError> BlockManager::reserveBlocks(static_vector<block_index_t>& blocks)
+{
+    return mutex_wrapper<void>(_mutex, [&]() { return _setBlocks(blocks, true); });
+}
+
+std::expected<void, FsError> BlockManager::freeBlocks(static_vector<block_index_t>& blocks)
+{
+    return mutex_wrapper<void>(_mutex, [&]() { return _setBlocks(blocks, false); });
+}
+
 std::expected<block_index_t, FsError> BlockManager::getFree()
 {
-    auto get_ret = _bitmap.getFirstEq(false);
+    return mutex_wrapper<block_index_t>(_mutex, [&]() { return _unprotectedGetFree(); });
+}
+
+std::expected<BlockRun, FsError> BlockManager::reserveRun(block_index_t goal, size_t count)
+{
+    return mutex_wrapper<BlockRun>(_mutex, [&]() { return _unprotectedReserveRun(goal, count); });
+}
+
+std::expected<block_index_t, FsError> BlockManager::_unprotectedGetFree()
+{
+    auto get_ret = _cursor.find(_bitmap, false);
     if (!get_ret.has_value()) {
         if (get_ret.error() == FsError::Bitmap_NotFound) {
             return std::unexpected(FsError::BlockManager_NoMoreFreeBlocks);
@@ -87,6 +127,77 @@ std::expected<block_index_t, FsError> BlockManager::getFree()
     return _toAbsolute(get_ret.value());
 }
 
-std::expected<std::uint32_t, FsError> BlockManager::numFree() { return _bitmap.count(false); }
+std::expected<BlockRun, FsError> BlockManager::_unprotectedReserveRun(
+    block_index_t goal, size_t count)
+{
+    if (_num_data_blocks == 0) {
+        return std::unexpected(FsError::BlockManager_NoMoreFreeBlocks);
+    }
+    block_index_t relative_goal = goal >= _data_blocks_start && _toRelative(goal) < _num_data_blocks
+        ? _toRelative(goal)
+        : _cursor.start();
+    count = std::clamp<size_t>(count, 1, _num_data_blocks);
+
+    // Search from goal to the end, then from the start to goal
+    std::optional<BlockRun> fallback;
+    size_t candidates = 0;
+    for (block_index_t pass_start : { relative_goal, block_index_t { 0 } }) {
+        block_index_t pass_end = pass_start == 0 && relative_goal != 0 ? relative_goal
+                                                                       : _num_data_blocks;
+        block_index_t position = pass_start;
+        while (position < pass_end && candidates < MAX_RUN_CANDIDATES) {
+            auto free_ret = _bitmap.getFirstEq(false, position);
+            if (!free_ret.has_value()) {
+                if (free_ret.error() == FsError::Bitmap_NotFound) {
+                    break;
+                }
+                return std::unexpected(free_ret.error());
+            }
+            if (free_ret.value() >= pass_end) {
+                break;
+            }
+            auto length_ret = _bitmap.runLength(false, free_ret.value(), count);
+            if (!length_ret.has_value()) {
+                return std::unexpected(length_ret.error());
+            }
+            BlockRun run { free_ret.value(), length_ret.value() };
+            if (!fallback.has_value()) {
+                fallback = run;
+            }
+            if (run.count == count) {
+                fallback = run;
+                break;
+            }
+            candidates++;
+            position = run.start + run.count;
+        }
+        if ((fallback.has_value() && fallback->count == count) || relative_goal == 0) {
+            break;
+        }
+    }
+    if (!fallback.has_value()) {
+        return std::unexpected(FsError::BlockManager_NoMoreFreeBlocks);
+    }
+
+    // Blocks were just found free, so the run is marked without checking them again
+    auto set_ret = _setRun(fallback.value(), true);
+    if (!set_ret.has_value()) {
+        // Give back what was already taken
+        (void)_setRun(fallback.value(), false);
+        return std::unexpected(set_ret.error());
+    }
+    _cursor.advance(fallback->start + fallback->count - 1);
+    return BlockRun { _toAbsolute(fallback->start), fallback->count };
+}
+
+std::expected<std::uint32_t, FsError> BlockManager::numFree()
+{
+    return mutex_wrapper<std::uint32_t>(_mutex, [&]() { return _bitmap.count(false); });
+}
 
 std::expected<std::uint32_t, FsError> BlockManager::numTotal() { return _num_data_blocks; }
+
+std::expected<void, FsError> BlockManager::loadBitmap()
+{
+    return mutex_wrapper<void>(_mutex, [&]() { return _bitmap.load(); });
+}
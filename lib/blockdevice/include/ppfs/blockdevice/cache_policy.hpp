@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Enumeration of caching policies of decoded blocks.
+ */
+enum class CachePolicy : std::uint8_t {
+    None, ///< Blocks are not cached
+    WriteThrough, ///< Writes go to the device immediately, cache keeps a copy
+    WriteBack, ///< Writes stay in cache until the block is evicted or flushed
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "ppfs/blockdevice/cache_policy.hpp"
+#include "ppfs/blockdevice/iblock_device.hpp"
+#include "ppfs/common/ppfs_mutex.hpp"
+#include "ppfs/common/static_vector.hpp"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+/**
+ * Block device decorator that keeps decoded payloads of recently used blocks.
+ *
+ * Wraps any IBlockDevice, so blocks read repeatedly (inode table, bitmaps, index blocks) are
+ * decoded only once. The pool is an array of entries provided by the caller, one block each,
+ * and is managed with CLOCK eviction. Single-block reads and partial writes go through the
+ * cache, vectored transfers only use blocks that are already cached and pass the rest straight
+ * to the wrapped device, so streaming file data doesn't evict metadata.
+ *
+ * With write-back policy modified blocks are written to the device when evicted, flushed or
+ * when the cache is destroyed. The pool is guarded by an internal mutex. Vectored reads drop it
+ * while uncached extents are decoded, then take it again and replace blocks cached meanwhile
+ * with their cached contents, so a block written through the cache is never returned stale.
+ */
+class CachingBlockDevice : public IBlockDevice {
+public:
+    /** Number of entries the tools give the cache */
+    static constexpr size_t DEFAULT_CAPACITY = 32;
+
+    struct Entry {
+        block_index_t block_index;
+        bool valid = false;
+        bool dirty = false;
+        bool referenced = false;
+        std::array<std::uint8_t, MAX_BLOCK_SIZE> data;
+    };
+
+    /**
+     * @param device Wrapped block device, must outlive the cache.
+     * @param policy WriteThrough or WriteBack, None behaves like WriteThrough.
+     * @param entries Storage of the pool, must hold at least one entry and outlive the cache.
+     * Entries left in it by a previous cache are dropped.
+     */
+    CachingBlockDevice(IBlockDevice& device, CachePolicy policy, static_vector<Entry> entries);
+
+    /** Writes back dirty blocks, errors are ignored. */
+    ~CachingBlockDevice() override;
+
+    CachingBlockDevice(const CachingBlockDevice&) = delete;
+    CachingBlockDevice& operator=(const CachingBlockDevice&) = delete;
+
+    /** Whether the internal mutex was created, every operation fails otherwise */
+    bool isInitialized() const { return _mutex.isInitialized(); }
+
+    [[nodiscard]] virtual std::expected<size_t, FsError> writeBlock(
+        const static_vector<std::uint8_t>& data, DataLocation data_location) override;
+
+    [[nodiscard]] virtual std::expected<void, FsError> readBlock(
+        DataLocation data_location, size_t bytes_to_read, static_vector<uint8_t>& data) override;
+
+    /**
+     * Writes cached extents into the cache (and through, depending on policy), other extents
+     * are passed to the wrapped device without being cached.
+     */
+    [[nodiscard]] virtual std::expected<size_t, FsError> writeBlocks(
+        const static_vector<BlockExtent>& extents,
+        const static_vector<std::uint8_t>& data) override;
+
+    /**
+     * Serves cached extents from the cache, other extents are read from the wrapped device
+     * without being cached and without holding the cache lock. Blocks cached while they were
+     * read are then taken from the cache.
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> readBlocks(
+        const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data) override;
+
+    /** Formats block on the wrapped device and drops its cached copy. */
+    [[nodiscard]] virtual std::expected<void, FsError> formatBlock(
+        unsigned int block_index) override;
+
+    virtual size_t rawBlockSize() const override;
+    virtual size_t dataSize() const override;
+    virtual size_t numOfBlocks() const override;
+
+    /**
+     * Writes all dirty blocks to the wrapped device.
+     * @return void on success, error of the first failed write otherwise
+     */
+    [[nodiscard]] std::expected<void, FsError> flush();
+
+    /**
+     * Drops cached copy of a block, modifications not written yet are lost. Used when the block
+     * was changed on the wrapped device directly, for example by a scrubber.
+     */
+    void invalidate(block_index_t block_index);
+
+    /** Drops all cached blocks, modifications not written yet are lost. */
+    void invalidateAll();
+
+    /** Number of single-block requests and extents served from the cache. */
+    size_t hits() const;
+
+    /** Number of single-block requests and extents that had to go to the wrapped device. */
+    size_t misses() const;
+
+private:
+    IBlockDevice& _device;
+    CachePolicy _policy;
+    static_vector<Entry> _entries;
+    size_t _clock_hand = 0;
+    size_t _hits = 0;
+    size_t _misses = 0;
+    /** Number of dirty blocks written to the device, vectored reads check it for changes */
+    size_t _write_backs = 0;
+    mutable PpFSMutex _mutex;
+
+    /** Returns cached entry of block or nullptr. */
+    Entry* _find(block_index_t block_index);
+
+    /**
+     * Picks a free entry or evicts one with CLOCK, dirty victim is written back first.
+     */
+    [[nodiscard]] std::expected<Entry*, FsError> _allocate();
+
+    /**
+     * Returns entry with the block, loading it from the wrapped device on miss.
+     * @param load whether old content has to be read, false if caller overwrites all of it
+     */
+    [[nodiscard]] std::expected<Entry*, FsError> _get(block_index_t block_index, bool load);
+
+    [[nodiscard]] std::expected<void, FsError> _writeBack(Entry& entry);
+
+    /**
+     * Copies cached extents starting at first into data.
+     * @return range of uncached extents following them, empty when all extents were read
+     */
+    [[nodiscard]] std::expected<std::pair<size_t, size_t>, FsError> _readCached(
+        const static_vector<BlockExtent>& extents, size_t first, static_vector<uint8_t>& data);
+
+    /** Overwrites data read for extents with contents of those that are cached now */
+    void _copyCached(const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data);
+
+    [[nodiscard]] std::expected<size_t, FsError> _unprotectedWriteBlock(
+        const static_vector<std::uint8_t>& data, DataLocation data_location);
+    [[nodiscard]] std::expected<void, FsError> _unprotectedReadBlock(
+        DataLocation data_location, size_t bytes_to_read, static_vector<uint8_t>& data);
+    [[nodiscard]] std::expected<size_t, FsError> _unprotectedWriteBlocks(
+        const static_vector<BlockExtent>& extents, const static_vector<std::uint8_t>& data);
+    [[nodiscard]] std::expected<void, FsError> _unprotectedFlush();
+    void _unprotectedInvalidate(block_index_t block_index);
+};
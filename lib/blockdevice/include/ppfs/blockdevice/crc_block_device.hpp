@@ -2,6 +2,7 @@
 
 #include "ppfs/blockdevice/iblock_device.hpp"
 #include "ppfs/common/static_vector.hpp"
+#include "ppfs/ecc_helpers/crc_engine.hpp"
 #include "ppfs/ecc_helpers/crc_polynomial.hpp"
 #include <memory>
 
@@ -14,6 +15,7 @@ class Logger;
  */
 class CrcBlockDevice : public IBlockDevice {
     CrcPolynomial _polynomial;
+    CrcEngine _engine;
     IDisk& _disk;
     size_t _block_size;
     std::shared_ptr<Logger> _logger;
@@ -38,6 +40,17 @@ class CrcBlockDevice : public IBlockDevice {
     [[nodiscard]] std::expected<void, FsError> _readAndCheckRaw(
         block_index_t block, static_vector<std::uint8_t>& block_buffer);
 
+    /**
+     * checks integrity of a block that was already read
+     *
+     * @param block whole block with redundancy bits
+     * @return void on success, error otherwise
+     */
+    [[nodiscard]] std::expected<void, FsError> _checkRaw(const static_vector<std::uint8_t>& block);
+
+    /** sets redundancy bits of block without writing it */
+    void _calculate(static_vector<std::uint8_t>& block);
+
 public:
     /**
      * Create CrcBlockDevice with specified polynomial
@@ -77,6 +90,21 @@ public:
     [[nodiscard]] virtual std::expected<void, FsError> readBlock(
         DataLocation data_location, size_t bytes_to_read, static_vector<uint8_t>& data) override;
 
+    /**
+     * Writes several extents, raw blocks of consecutive extents are read, checked and written
+     * back with one disk operation each.
+     */
+    [[nodiscard]] virtual std::expected<size_t, FsError> writeBlocks(
+        const static_vector<BlockExtent>& extents,
+        const static_vector<std::uint8_t>& data) override;
+
+    /**
+     * Reads several extents, raw blocks of consecutive extents are read with one disk operation
+     * and checked one after another.
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> readBlocks(
+        const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data) override;
+
     /**
      * Returns the physical (raw) block size of the underlying device.
      * @return Size of one raw block in bytes.
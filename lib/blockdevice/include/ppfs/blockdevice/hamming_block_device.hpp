@@ -2,6 +2,7 @@
 
 #include "ppfs/blockdevice/iblock_device.hpp"
 #include "ppfs/common/static_vector.hpp"
+#include "ppfs/ecc_helpers/hamming_codec.hpp"
 
 #include <memory>
 #include <optional>
@@ -54,6 +55,21 @@ public:
     [[nodiscard]] virtual std::expected<void, FsError> readBlock(
         DataLocation data_location, size_t bytes_to_read, static_vector<uint8_t>& data) override;
 
+    /**
+     * @brief Writes several extents, raw blocks of consecutive extents are read, corrected and
+     * written back with one disk operation each.
+     */
+    [[nodiscard]] virtual std::expected<size_t, FsError> writeBlocks(
+        const static_vector<BlockExtent>& extents,
+        const static_vector<std::uint8_t>& data) override;
+
+    /**
+     * @brief Reads several extents, raw blocks of consecutive extents are read with one disk
+     * operation and decoded one after another.
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> readBlocks(
+        const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data) override;
+
     /**
      * @brief Fills a specific block with zeros.
      */
@@ -79,18 +95,20 @@ private:
     size_t _data_size;
     IDisk& _disk;
     std::shared_ptr<Logger> _logger;
-
-    void _encodeData(const static_vector<uint8_t>& data, static_vector<uint8_t>& encoded_data);
-    void _extractData(const static_vector<uint8_t>& encoded_data, static_vector<uint8_t>& data);
+    HammingCodec _codec; /**< Word-level encoder and syndrome calculator. */
 
     [[nodiscard]] std::expected<void, FsError> _readAndFixBlock(
         int block_index, static_vector<uint8_t>& data);
+    /** Corrects raw block that was already read, the fixed byte is written back to disk. */
+    [[nodiscard]] std::expected<void, FsError> _fixBlock(
+        int block_index, static_vector<uint8_t>& data);
 };
 
 /**
  * @brief Iterator to traverse data bit indices in a Hamming-encoded block.
  *
- * This iterator skips parity bits and returns indices of data bits only.
+ * This iterator skips parity bits and returns indices of data bits only. It describes the layout
+ * bit by bit, HammingCodec implements the same layout on 64-bit words.
  */
 class HammingDataBitsIterator {
 public:
@@ -1,6 +1,7 @@
 #pragma once
 
 #define MAX_BLOCK_SIZE 4096
+#define MAX_BATCH_SIZE (4 * MAX_BLOCK_SIZE)
 
 #include <expected>
 
@@ -19,6 +20,39 @@ struct DataLocation {
     DataLocation() = default;
 };
 
+/**
+ * Part of a vectored transfer: length bytes starting at a data location.
+ */
+struct BlockExtent {
+    DataLocation location;
+    size_t length;
+
+    BlockExtent(DataLocation location, size_t length);
+    BlockExtent() = default;
+};
+
+/**
+ * Counts extents starting at first that address consecutive blocks, so that their raw blocks
+ * form one contiguous range on disk.
+ *
+ * @param extents extents of a vectored transfer
+ * @param first index of the first extent of the run
+ * @param max_blocks maximum length of the run
+ * @return number of extents in the run, at least one if first is a valid index
+ */
+size_t consecutiveBlocks(
+    const static_vector<BlockExtent>& extents, size_t first, size_t max_blocks);
+
+/**
+ * Checks whether count extents starting at first overwrite all data of their blocks, so the old
+ * content of these blocks doesn't have to be read before writing.
+ *
+ * @param data_size data size of a block
+ * @param available number of bytes left to be written, starting with the first extent
+ */
+bool wholeBlocks(const static_vector<BlockExtent>& extents, size_t first, size_t count,
+    size_t data_size, size_t available);
+
 /**
  * Abstract interface for block-level storage operations.
  *
@@ -64,6 +98,34 @@ public:
         DataLocation data_location, size_t bytes_to_read, static_vector<uint8_t>& data)
         = 0;
 
+    /**
+     * Writes several extents at once, data holds bytes of all extents one after another.
+     *
+     * Each extent is truncated to the data size of its block, like in writeBlock. Devices
+     * transfer raw blocks of consecutive extents with one disk operation. Default
+     * implementation calls writeBlock for every extent.
+     *
+     * @param extents Target extents, in order of data.
+     * @param data Bytes to be written.
+     * @return On success, returns the number of bytes written; otherwise returns a FsError.
+     */
+    [[nodiscard]] virtual std::expected<size_t, FsError> writeBlocks(
+        const static_vector<BlockExtent>& extents, const static_vector<std::uint8_t>& data);
+
+    /**
+     * Reads several extents at once, bytes of all extents are stored in data one after another.
+     *
+     * Each extent is truncated to the data size of its block, like in readBlock. Devices
+     * transfer raw blocks of consecutive extents with one disk operation. Default
+     * implementation calls readBlock for every extent.
+     *
+     * @param extents Source extents.
+     * @param data Output buffer, must have capacity for lengths of all extents.
+     * @return void on success, error otherwise
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> readBlocks(
+        const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data);
+
     /**
      * Returns the physical (raw) block size of the underlying device.
      * @return Size of one raw block in bytes.
@@ -32,6 +32,21 @@ public:
     [[nodiscard]] virtual std::expected<void, FsError> readBlock(
         DataLocation data_location, size_t bytes_to_read, static_vector<uint8_t>& data) override;
 
+    /**
+     * Writes several extents, raw blocks of consecutive extents are read, checked and written
+     * back with one disk operation each.
+     */
+    [[nodiscard]] virtual std::expected<size_t, FsError> writeBlocks(
+        const static_vector<BlockExtent>& extents,
+        const static_vector<std::uint8_t>& data) override;
+
+    /**
+     * Reads several extents, raw blocks of consecutive extents are read with one disk operation
+     * and checked one after another.
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> readBlocks(
+        const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data) override;
+
     /** Formats a block (fills it with zeros and valid parity). */
     [[nodiscard]] virtual std::expected<void, FsError> formatBlock(
         unsigned int block_index) override;
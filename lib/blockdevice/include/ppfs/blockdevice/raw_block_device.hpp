@@ -18,6 +18,11 @@ private:
     size_t _block_size;
     IDisk& _disk;
 
+    /** Disk address of the first byte of extent. */
+    size_t _address(const BlockExtent& extent) const;
+    /** Length of extent truncated to its block. */
+    size_t _length(const BlockExtent& extent) const;
+
 public:
     /**
      * Constructs a RawBlockDevice instance.
@@ -47,6 +52,21 @@ public:
     [[nodiscard]] virtual std::expected<void, FsError> readBlock(
         DataLocation data_location, size_t bytes_to_read, static_vector<uint8_t>& data) override;
 
+    /**
+     * Writes several extents, extents that are adjacent on disk are written with one disk
+     * operation straight from data.
+     */
+    [[nodiscard]] virtual std::expected<size_t, FsError> writeBlocks(
+        const static_vector<BlockExtent>& extents,
+        const static_vector<std::uint8_t>& data) override;
+
+    /**
+     * Reads several extents, extents that are adjacent on disk are read with one disk operation
+     * straight into data.
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> readBlocks(
+        const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data) override;
+
     /**
      * This function does nothing - every state is valid.
      */
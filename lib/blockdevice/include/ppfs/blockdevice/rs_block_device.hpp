@@ -2,6 +2,9 @@
 #include "ppfs/blockdevice/iblock_device.hpp"
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/ecc_helpers/polynomial_gf256.hpp"
+#include "ppfs/ecc_helpers/rs_decoder.hpp"
+#include "ppfs/ecc_helpers/rs_encoder.hpp"
+#include "ppfs/ecc_helpers/syndrome_calculator.hpp"
 #include <memory>
 
 #define MAX_RS_BLOCK_SIZE 255
@@ -44,6 +47,21 @@ public:
     [[nodiscard]] virtual std::expected<void, FsError> readBlock(
         DataLocation data_location, size_t bytes_to_read, static_vector<uint8_t>& data);
 
+    /**
+     * Writes several extents, raw blocks of consecutive extents are read, corrected and written
+     * back with one disk operation each.
+     */
+    [[nodiscard]] virtual std::expected<size_t, FsError> writeBlocks(
+        const static_vector<BlockExtent>& extents,
+        const static_vector<std::uint8_t>& data) override;
+
+    /**
+     * Reads several extents, raw blocks of consecutive extents are read with one disk operation
+     * and decoded one after another.
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> readBlocks(
+        const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data) override;
+
     /** Returns the size of a raw encoded block in bytes. */
     virtual size_t rawBlockSize() const override;
 
@@ -59,37 +77,40 @@ public:
 
 private:
     IDisk& _disk; /**< Reference to the underlying disk. */
-    PolynomialGF256 _generator; /**< Reed-Solomon generator polynomial. */
     size_t _raw_block_size; /**< Total size of one encoded block in bytes (data + redundancy). */
     size_t
         _correctable_bytes; /**< Number of individual bytes that the code can detect and correct. */
+    PolynomialGF256 _generator; /**< Reed-Solomon generator polynomial. */
     std::shared_ptr<Logger> _logger; /**< Optional logger for error corrections. */
+    SyndromeCalculator _syndromes; /**< Syndrome kernel for 2 * correctable_bytes syndromes. */
+    RsEncoder _encoder; /**< Shift register encoder built from the generator. */
+    RsDecoder _decoder; /**< Chien search and Forney based error corrector. */
+
+    /**
+     * Fixes a block in place using Reed-Solomon decoding, corrected block is written back to disk.
+     * After fixing, message is set to view of the data bytes inside raw_block, nothing is copied.
+     *
+     * @return true if errors were found and corrected, BlockDevice_CorrectionError if there are
+     * too many errors to correct
+     */
+    [[nodiscard]] std::expected<bool, FsError> _fixBlockAndExtract(
+        static_vector<std::uint8_t>& raw_block, static_vector<std::uint8_t>& message,
+        block_index_t block_index);
 
-    /** Encodes data into a full RS block with parity bytes. */
-    void _encodeBlock(
-        const static_vector<std::uint8_t>& raw_block, static_vector<std::uint8_t>& data);
+    /**
+     * Fixes raw block and applies data to its message, parity is updated from deltas when
+     * possible and recalculated otherwise. Nothing is written to disk. If data replaces the whole
+     * message, raw block doesn't have to be read and isn't decoded.
+     *
+     * @return number of bytes of data applied
+     */
+    [[nodiscard]] std::expected<size_t, FsError> _applyWrite(static_vector<std::uint8_t>& raw_block,
+        const static_vector<std::uint8_t>& data, DataLocation data_location);
 
-    /** Fixes a block using Reed-Solomon decoding. After fixing, data is returned. */
-    void _fixBlockAndExtract(static_vector<std::uint8_t> raw_block,
-        const static_vector<std::uint8_t>& data, block_index_t block_index);
+    /** Whether writing data at data_location overwrites the whole message of the block. */
+    bool _replacesMessage(
+        const static_vector<std::uint8_t>& data, DataLocation data_location) const;
 
     /** Computes the RS generator polynomial. */
     PolynomialGF256 _calculateGenerator();
-
-    /** Extracts the original message bytes from a full RS-encoded polynomial. */
-    void _extractMessage(PolynomialGF256 p, static_vector<std::uint8_t>& data);
-
-    /** Computes error values using Forney’s algorithm. */
-    void _forney(const PolynomialGF256& omega, PolynomialGF256& sigma,
-        const static_vector<GF256>& error_locations, static_vector<GF256>& error_values);
-
-    /** Computes the error evaluator polynomial omega(x). */
-    PolynomialGF256 _calculateOmega(const static_vector<GF256>& syndromes, PolynomialGF256& sigma);
-
-    /** Computes the error locator polynomial sigma(x) using Berlekamp-Massey. */
-    PolynomialGF256 _berlekampMassey(const static_vector<GF256>& syndromes);
-
-    /** Finds error locations (inverse of roots of sigma(x)). */
-    void _errorLocations(
-        PolynomialGF256 error_location_polynomial, static_vector<GF256>& error_locations);
 };
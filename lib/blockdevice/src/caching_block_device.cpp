@@ -0,0 +1,379 @@
+#include "ppfs/blockdevice/caching_block_device.hpp"
+#include "ppfs/common/mutex_wrapper.hpp"
+
+#include <algorithm>
+
+CachingBlockDevice::CachingBlockDevice(
+    IBlockDevice& device, CachePolicy policy, static_vector<Entry> entries)
+    : _device(device)
+    , _policy(policy)
+    , _entries(entries.data(), entries.capacity(), entries.capacity())
+{
+    for (auto& entry : _entries) {
+        entry.valid = false;
+        entry.dirty = false;
+        entry.referenced = false;
+    }
+    (void)_mutex.init();
+}
+
+CachingBlockDevice::~CachingBlockDevice() { (void)flush(); }
+
+size_t CachingBlockDevice::rawBlockSize() const { return _device.rawBlockSize(); }
+
+size_t CachingBlockDevice::dataSize() const { return _device.dataSize(); }
+
+size_t CachingBlockDevice::numOfBlocks() const { return _device.numOfBlocks(); }
+
+size_t CachingBlockDevice::hits() const
+{
+    auto hits = mutex_wrapper<size_t>(_mutex, [&]() { return _hits; });
+    return hits.value_or(0);
+}
+
+size_t CachingBlockDevice::misses() const
+{
+    auto misses = mutex_wrapper<size_t>(_mutex, [&]() { return _misses; });
+    return misses.value_or(0);
+}
+
+CachingBlockDevice::Entry* CachingBlockDevice::_find(block_index_t block_index)
+{
+    for (auto& entry : _entries) {
+        if (entry.valid && entry.block_index == block_index) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+std::expected<CachingBlockDevice::Entry*, FsError> CachingBlockDevice::_allocate()
+{
+    // Every entry is visited at most twice, the second time its reference bit is already cleared
+    while (true) {
+        Entry& entry = _entries[_clock_hand];
+        _clock_hand = (_clock_hand + 1) % _entries.size();
+        if (!entry.valid) {
+            return &entry;
+        }
+        if (entry.referenced) {
+            entry.referenced = false;
+            continue;
+        }
+        if (entry.dirty) {
+            auto write_res = _writeBack(entry);
+            if (!write_res.has_value()) {
+                return std::unexpected(write_res.error());
+            }
+        }
+        entry.valid = false;
+        return &entry;
+    }
+}
+
+std::expected<CachingBlockDevice::Entry*, FsError> CachingBlockDevice::_get(
+    block_index_t block_index, bool load)
+{
+    if (Entry* entry = _find(block_index)) {
+        _hits++;
+        entry->referenced = true;
+        return entry;
+    }
+    _misses++;
+
+    auto alloc_res = _allocate();
+    if (!alloc_res.has_value()) {
+        return std::unexpected(alloc_res.error());
+    }
+    Entry* entry = alloc_res.value();
+    if (load) {
+        static_vector<uint8_t> buf(entry->data.data(), MAX_BLOCK_SIZE);
+        auto read_res = _device.readBlock(DataLocation(block_index, 0), dataSize(), buf);
+        if (!read_res.has_value()) {
+            return std::unexpected(read_res.error());
+        }
+    }
+    entry->block_index = block_index;
+    entry->valid = true;
+    entry->dirty = false;
+    entry->referenced = true;
+    return entry;
+}
+
+std::expected<void, FsError> CachingBlockDevice::_writeBack(Entry& entry)
+{
+    static_vector<uint8_t> buf(entry.data.data(), MAX_BLOCK_SIZE, dataSize());
+    auto write_res = _device.writeBlock(buf, DataLocation(entry.block_index, 0));
+    if (!write_res.has_value()) {
+        return std::unexpected(write_res.error());
+    }
+    entry.dirty = false;
+    _write_backs++;
+    return {};
+}
+
+std::expected<size_t, FsError> CachingBlockDevice::writeBlock(
+    const static_vector<std::uint8_t>& data, DataLocation data_location)
+{
+    return mutex_wrapper<size_t>(
+        _mutex, [&]() { return _unprotectedWriteBlock(data, data_location); });
+}
+
+std::expected<size_t, FsError> CachingBlockDevice::_unprotectedWriteBlock(
+    const static_vector<std::uint8_t>& data, DataLocation data_location)
+{
+    size_t to_write = std::min(data.size(), dataSize() - data_location.offset);
+    bool whole_block = data_location.offset == 0 && to_write == dataSize();
+
+    if (_policy != CachePolicy::WriteBack) {
+        auto write_res = _device.writeBlock(data, data_location);
+        if (!write_res.has_value()) {
+            return std::unexpected(write_res.error());
+        }
+        // Partial writes of blocks that aren't cached don't allocate, nothing would be saved
+        Entry* entry = _find(data_location.block_index);
+        if (entry == nullptr && whole_block) {
+            auto get_res = _get(data_location.block_index, false);
+            entry = get_res.has_value() ? get_res.value() : nullptr;
+        }
+        if (entry != nullptr) {
+            std::copy_n(data.begin(), to_write, entry->data.begin() + data_location.offset);
+        }
+        return write_res;
+    }
+
+    auto get_res = _get(data_location.block_index, !whole_block);
+    if (!get_res.has_value()) {
+        return std::unexpected(get_res.error());
+    }
+    Entry* entry = get_res.value();
+    std::copy_n(data.begin(), to_write, entry->data.begin() + data_location.offset);
+    entry->dirty = true;
+    return to_write;
+}
+
+std::expected<void, FsError> CachingBlockDevice::readBlock(
+    DataLocation data_location, size_t bytes_to_read, static_vector<uint8_t>& data)
+{
+    return mutex_wrapper<void>(
+        _mutex, [&]() { return _unprotectedReadBlock(data_location, bytes_to_read, data); });
+}
+
+std::expected<void, FsError> CachingBlockDevice::_unprotectedReadBlock(
+    DataLocation data_location, size_t bytes_to_read, static_vector<uint8_t>& data)
+{
+    data.resize(0);
+    if (data.capacity() < bytes_to_read) {
+        return std::unexpected(FsError::Disk_InvalidRequest);
+    }
+    size_t to_read = std::min(bytes_to_read, dataSize() - data_location.offset);
+
+    auto get_res = _get(data_location.block_index, true);
+    if (!get_res.has_value()) {
+        return std::unexpected(get_res.error());
+    }
+    data.resize(to_read);
+    std::copy_n(get_res.value()->data.begin() + data_location.offset, to_read, data.begin());
+    return {};
+}
+
+std::expected<size_t, FsError> CachingBlockDevice::writeBlocks(
+    const static_vector<BlockExtent>& extents, const static_vector<std::uint8_t>& data)
+{
+    return mutex_wrapper<size_t>(_mutex, [&]() { return _unprotectedWriteBlocks(extents, data); });
+}
+
+std::expected<size_t, FsError> CachingBlockDevice::_unprotectedWriteBlocks(
+    const static_vector<BlockExtent>& extents, const static_vector<std::uint8_t>& data)
+{
+    size_t written = 0;
+    for (size_t first = 0; first < extents.size();) {
+        const auto& location = extents[first].location;
+        if (Entry* entry = _find(location.block_index)) {
+            _hits++;
+            entry->referenced = true;
+            size_t to_write = std::min(
+                { extents[first].length, dataSize() - location.offset, data.size() - written });
+            static_vector<std::uint8_t> part(
+                const_cast<uint8_t*>(data.data()) + written, to_write, to_write);
+            if (_policy != CachePolicy::WriteBack) {
+                auto write_res = _device.writeBlock(part, location);
+                if (!write_res.has_value()) {
+                    return std::unexpected(write_res.error());
+                }
+            } else {
+                entry->dirty = true;
+            }
+            std::copy_n(part.begin(), to_write, entry->data.begin() + location.offset);
+            written += to_write;
+            first++;
+            continue;
+        }
+
+        // Extents that aren't cached go to the device together
+        size_t last = first + 1;
+        while (last < extents.size() && _find(extents[last].location.block_index) == nullptr) {
+            last++;
+        }
+        _misses += last - first;
+        static_vector<BlockExtent> missing(
+            const_cast<BlockExtent*>(extents.data()) + first, last - first, last - first);
+        static_vector<std::uint8_t> part(const_cast<uint8_t*>(data.data()) + written,
+            data.size() - written, data.size() - written);
+        auto write_res = _device.writeBlocks(missing, part);
+        if (!write_res.has_value()) {
+            return std::unexpected(write_res.error());
+        }
+        written += write_res.value();
+        first = last;
+    }
+    return written;
+}
+
+std::expected<void, FsError> CachingBlockDevice::readBlocks(
+    const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data)
+{
+    size_t total = 0;
+    for (const auto& extent : extents) {
+        total += std::min(extent.length, dataSize() - extent.location.offset);
+    }
+    data.resize(0);
+    if (data.capacity() < total) {
+        return std::unexpected(FsError::Disk_InvalidRequest);
+    }
+
+    for (size_t first = 0; first < extents.size();) {
+        size_t write_backs = 0;
+        auto span_res = mutex_wrapper<std::pair<size_t, size_t>>(_mutex, [&]() {
+            write_backs = _write_backs;
+            return _readCached(extents, first, data);
+        });
+        if (!span_res.has_value()) {
+            return std::unexpected(span_res.error());
+        }
+        auto [missing_first, missing_last] = span_res.value();
+        if (missing_first == missing_last) {
+            break;
+        }
+
+        // Decoded without the lock, so reads of other files don't wait for it
+        size_t count = missing_last - missing_first;
+        static_vector<BlockExtent> missing(
+            const_cast<BlockExtent*>(extents.data()) + missing_first, count, count);
+        static_vector<uint8_t> part(data.end(), data.capacity() - data.size());
+        auto read_res = _device.readBlocks(missing, part);
+        if (!read_res.has_value()) {
+            return std::unexpected(read_res.error());
+        }
+
+        // Blocks written meanwhile are newer in the cache, or were written back during the read
+        auto check_res = mutex_wrapper<void>(_mutex, [&]() -> std::expected<void, FsError> {
+            if (_write_backs != write_backs) {
+                auto reread_res = _device.readBlocks(missing, part);
+                if (!reread_res.has_value()) {
+                    return std::unexpected(reread_res.error());
+                }
+            }
+            _copyCached(missing, part);
+            return {};
+        });
+        if (!check_res.has_value()) {
+            return std::unexpected(check_res.error());
+        }
+        data.resize(data.size() + part.size());
+        first = missing_last;
+    }
+    return {};
+}
+
+void CachingBlockDevice::_copyCached(
+    const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data)
+{
+    size_t position = 0;
+    for (const auto& extent : extents) {
+        const auto& location = extent.location;
+        size_t length = std::min(extent.length, dataSize() - location.offset);
+        if (Entry* entry = _find(location.block_index)) {
+            std::copy_n(entry->data.begin() + location.offset, length, data.begin() + position);
+        }
+        position += length;
+    }
+}
+
+std::expected<std::pair<size_t, size_t>, FsError> CachingBlockDevice::_readCached(
+    const static_vector<BlockExtent>& extents, size_t first, static_vector<uint8_t>& data)
+{
+    while (first < extents.size()) {
+        const auto& location = extents[first].location;
+        Entry* entry = _find(location.block_index);
+        if (entry == nullptr) {
+            break;
+        }
+        _hits++;
+        entry->referenced = true;
+        size_t to_read = std::min(extents[first].length, dataSize() - location.offset);
+        std::copy_n(entry->data.begin() + location.offset, to_read, data.end());
+        data.resize(data.size() + to_read);
+        first++;
+    }
+
+    size_t last = first;
+    while (last < extents.size() && _find(extents[last].location.block_index) == nullptr) {
+        last++;
+    }
+    _misses += last - first;
+    return std::pair { first, last };
+}
+
+std::expected<void, FsError> CachingBlockDevice::formatBlock(unsigned int block_index)
+{
+    return mutex_wrapper<void>(_mutex, [&]() {
+        _unprotectedInvalidate(block_index);
+        return _device.formatBlock(block_index);
+    });
+}
+
+std::expected<void, FsError> CachingBlockDevice::flush()
+{
+    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedFlush(); });
+}
+
+std::expected<void, FsError> CachingBlockDevice::_unprotectedFlush()
+{
+    for (auto& entry : _entries) {
+        if (entry.valid && entry.dirty) {
+            auto write_res = _writeBack(entry);
+            if (!write_res.has_value()) {
+                return std::unexpected(write_res.error());
+            }
+        }
+    }
+    return {};
+}
+
+void CachingBlockDevice::invalidate(block_index_t block_index)
+{
+    (void)mutex_wrapper<void>(_mutex, [&]() {
+        _unprotectedInvalidate(block_index);
+        return std::expected<void, FsError> {};
+    });
+}
+
+void CachingBlockDevice::_unprotectedInvalidate(block_index_t block_index)
+{
+    if (Entry* entry = _find(block_index)) {
+        entry->valid = false;
+        entry->dirty = false;
+    }
+}
+
+void CachingBlockDevice::invalidateAll()
+{
+    (void)mutex_wrapper<void>(_mutex, [&]() {
+        for (auto& entry : _entries) {
+            entry.valid = false;
+            entry.dirty = false;
+        }
+        return std::expected<void, FsError> {};
+    });
+}
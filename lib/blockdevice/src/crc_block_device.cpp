@@ -17,48 +17,43 @@ std::expected<void, FsError> CrcBlockDevice::_readAndCheckRaw(
     if (!bytes_res.has_value()) {
         return std::unexpected(bytes_res.error());
     }
-    std::array<bool, MAX_BLOCK_SIZE * 8> block_bits_buffer;
-    static_vector<bool> block_bits(block_bits_buffer.data(), MAX_BLOCK_SIZE * 8);
-    BitHelpers::blockToBits(block_buffer, block_bits);
-    auto amount_unused_bits = (_block_size - dataSize()) * 8 - _polynomial.getDegree();
-    block_bits.resize(block_bits.size() - amount_unused_bits);
-
-    std::array<bool, MAX_CRC_POLYNOMIAL_SIZE> remainder_buffer;
-    static_vector<bool> remainder(remainder_buffer.data(), MAX_CRC_POLYNOMIAL_SIZE);
-    _polynomial.divide(block_bits, remainder);
-
-    // reminder should be 0
-    if (std::ranges::contains(remainder.begin(), remainder.end(), true)) {
+
+    return _checkRaw(block_buffer);
+}
+
+std::expected<void, FsError> CrcBlockDevice::_checkRaw(const static_vector<std::uint8_t>& block)
+{
+    std::uint64_t stored = 0;
+    for (unsigned int i = 0; i < _engine.getDegree(); i++) {
+        stored = (stored << 1) | BitHelpers::getBit(block, dataSize() * 8 + i);
+    }
+
+    // Stored check bits must match the ones calculated from data
+    static_vector<uint8_t> data_view(const_cast<uint8_t*>(block.data()), dataSize(), dataSize());
+    if (_engine.checkBits(data_view) != stored) {
         return std::unexpected(FsError::BlockDevice_CorrectionError);
     }
     return {};
 }
 
-std::expected<void, FsError> CrcBlockDevice::_calculateAndWrite(
-    static_vector<std::uint8_t>& block, block_index_t block_index)
+void CrcBlockDevice::_calculate(static_vector<std::uint8_t>& block)
 {
-    // Get data bits - only process the data portion, not the redundancy area
+    // Only the data portion is protected, not the redundancy area
     static_vector<uint8_t> data_view(block.data(), dataSize(), dataSize());
-    std::array<bool, MAX_BLOCK_SIZE * 8> block_bits_buffer;
-    static_vector<bool> block_bits(block_bits_buffer.data(), MAX_BLOCK_SIZE * 8);
-    BitHelpers::blockToBits(data_view, block_bits);
-
-    // Add padding
-    size_t original_size = block_bits.size();
-    block_bits.resize(original_size + _polynomial.getDegree());
-    for (size_t i = original_size; i < block_bits.size(); i++) {
-        block_bits[i] = false;
-    }
-
-    std::array<bool, MAX_CRC_POLYNOMIAL_SIZE> remainder_buffer;
-    static_vector<bool> remainder(remainder_buffer.data(), MAX_CRC_POLYNOMIAL_SIZE);
-    _polynomial.divide(block_bits, remainder);
-    for (int i = 0; i < _polynomial.getDegree(); i++) {
-        BitHelpers::setBit(block, dataSize() * 8 + i, remainder[i]);
-    }
+    auto check_bits = _engine.checkBits(data_view);
 
     // Ensure block is the correct size before writing
     block.resize(_block_size);
+    auto degree = _engine.getDegree();
+    for (unsigned int i = 0; i < degree; i++) {
+        BitHelpers::setBit(block, dataSize() * 8 + i, (check_bits >> (degree - 1 - i)) & 1);
+    }
+}
+
+std::expected<void, FsError> CrcBlockDevice::_calculateAndWrite(
+    static_vector<std::uint8_t>& block, block_index_t block_index)
+{
+    _calculate(block);
     auto disk_res = _disk.write(_block_size * block_index, block);
     if (!disk_res.has_value()) {
         return std::unexpected(disk_res.error());
@@ -69,6 +64,7 @@ std::expected<void, FsError> CrcBlockDevice::_calculateAndWrite(
 CrcBlockDevice::CrcBlockDevice(
     CrcPolynomial polynomial, IDisk& disk, size_t block_size, std::shared_ptr<Logger> logger)
     : _polynomial(std::move(polynomial))
+    , _engine(_polynomial)
     , _disk(disk)
     , _block_size(block_size)
     , _logger(logger)
@@ -78,13 +74,18 @@ CrcBlockDevice::CrcBlockDevice(
 std::expected<size_t, FsError> CrcBlockDevice::writeBlock(
     const static_vector<std::uint8_t>& data, DataLocation data_location)
 {
+    size_t to_write = std::min(data.size(), dataSize() - data_location.offset);
     std::array<uint8_t, MAX_BLOCK_SIZE> block_buffer;
-    static_vector<uint8_t> block(block_buffer.data(), MAX_BLOCK_SIZE);
-    auto read_res = _readAndCheckRaw(data_location.block_index, block);
-    if (!read_res.has_value()) {
-        return std::unexpected(read_res.error());
+    static_vector<uint8_t> block(block_buffer.data(), MAX_BLOCK_SIZE, _block_size);
+    if (data_location.offset == 0 && to_write == dataSize()) {
+        // Whole block is replaced, only the redundancy area needs defined content
+        std::fill(block.begin() + dataSize(), block.end(), static_cast<std::uint8_t>(0x00));
+    } else {
+        auto read_res = _readAndCheckRaw(data_location.block_index, block);
+        if (!read_res.has_value()) {
+            return std::unexpected(read_res.error());
+        }
     }
-    size_t to_write = std::min(data.size(), dataSize() - data_location.offset);
     std::copy_n(data.begin(), to_write, block.begin() + data_location.offset);
     auto ret = _calculateAndWrite(block, data_location.block_index);
     if (!ret.has_value()) {
@@ -112,6 +113,91 @@ std::expected<void, FsError> CrcBlockDevice::readBlock(
     return {};
 }
 
+std::expected<size_t, FsError> CrcBlockDevice::writeBlocks(
+    const static_vector<BlockExtent>& extents, const static_vector<std::uint8_t>& data)
+{
+    std::array<uint8_t, MAX_BATCH_SIZE> run_buffer;
+    size_t max_blocks = MAX_BATCH_SIZE / _block_size;
+    size_t written = 0;
+
+    for (size_t first = 0; first < extents.size();) {
+        size_t count = consecutiveBlocks(extents, first, max_blocks);
+        size_t address = extents[first].location.block_index * _block_size;
+        static_vector<uint8_t> run(run_buffer.data(), MAX_BATCH_SIZE, count * _block_size);
+        if (!wholeBlocks(extents, first, count, dataSize(), data.size() - written)) {
+            auto read_res = _disk.read(address, count * _block_size, run);
+            if (!read_res.has_value()) {
+                return std::unexpected(read_res.error());
+            }
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const auto& location = extents[first + i].location;
+            static_vector<uint8_t> block(run.data() + i * _block_size, _block_size, _block_size);
+            size_t to_write = std::min(
+                { extents[first + i].length, dataSize() - location.offset, data.size() - written });
+            if (location.offset == 0 && to_write == dataSize()) {
+                std::fill(block.begin() + dataSize(), block.end(), static_cast<std::uint8_t>(0x00));
+            } else {
+                auto check_res = _checkRaw(block);
+                if (!check_res.has_value()) {
+                    return std::unexpected(check_res.error());
+                }
+            }
+            std::copy_n(data.begin() + written, to_write, block.begin() + location.offset);
+            written += to_write;
+            _calculate(block);
+        }
+
+        auto write_res = _disk.write(address, run);
+        if (!write_res.has_value()) {
+            return std::unexpected(write_res.error());
+        }
+        first += count;
+    }
+    return written;
+}
+
+std::expected<void, FsError> CrcBlockDevice::readBlocks(
+    const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data)
+{
+    size_t total = 0;
+    for (const auto& extent : extents) {
+        total += std::min(extent.length, dataSize() - extent.location.offset);
+    }
+    data.resize(0);
+    if (data.capacity() < total) {
+        return std::unexpected(FsError::Disk_InvalidRequest);
+    }
+
+    std::array<uint8_t, MAX_BATCH_SIZE> run_buffer;
+    size_t max_blocks = MAX_BATCH_SIZE / _block_size;
+
+    for (size_t first = 0; first < extents.size();) {
+        size_t count = consecutiveBlocks(extents, first, max_blocks);
+        static_vector<uint8_t> run(run_buffer.data(), MAX_BATCH_SIZE);
+        auto read_res = _disk.read(
+            extents[first].location.block_index * _block_size, count * _block_size, run);
+        if (!read_res.has_value()) {
+            return std::unexpected(read_res.error());
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const auto& location = extents[first + i].location;
+            static_vector<uint8_t> block(run.data() + i * _block_size, _block_size, _block_size);
+            auto check_res = _checkRaw(block);
+            if (!check_res.has_value()) {
+                return std::unexpected(check_res.error());
+            }
+            size_t to_read = std::min(extents[first + i].length, dataSize() - location.offset);
+            std::copy_n(block.begin() + location.offset, to_read, data.end());
+            data.resize(data.size() + to_read);
+        }
+        first += count;
+    }
+    return {};
+}
+
 size_t CrcBlockDevice::rawBlockSize() const { return _block_size; }
 
 size_t CrcBlockDevice::dataSize() const
@@ -3,8 +3,8 @@
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/data_collection/data_colection.hpp"
 
+#include <algorithm>
 #include <array>
-#include <cmath>
 #include <cstdint>
 #include <memory>
 
@@ -12,10 +12,10 @@ HammingBlockDevice::HammingBlockDevice(
     int block_size_power, IDisk& disk, std::shared_ptr<Logger> logger)
     : _disk(disk)
     , _logger(logger)
+    , _codec(block_size_power)
 {
-    _block_size = 1 << block_size_power;
-    int parity_bytes = (int)std::ceil(((float)(block_size_power * 3 + 1)) / 8.0);
-    _data_size = _block_size - parity_bytes;
+    _block_size = _codec.blockSize();
+    _data_size = _codec.dataSize();
 }
 
 std::expected<void, FsError> HammingBlockDevice::_readAndFixBlock(
@@ -26,86 +26,37 @@ std::expected<void, FsError> HammingBlockDevice::_readAndFixBlock(
     if (!read_result.has_value()) {
         return std::unexpected(read_result.error());
     }
-
-    unsigned int error_position = 0;
-    bool parity = true;
-
-    HammingUsedBitsIterator it(_block_size, _data_size);
-    while (auto index = it.next()) {
-        if (BitHelpers::getBit(data, *index)) {
-            error_position ^= *index;
-            parity = !parity;
-        }
-    }
-
-    if (!parity) {
-        bool flipped_bit_value = !BitHelpers::getBit(data, error_position);
-
-        BitHelpers::setBit(data, error_position, flipped_bit_value);
-        std::array<uint8_t, 1> temp_buffer;
-        static_vector<uint8_t> temp(temp_buffer.data(), 1, 1);
-        temp[0] = data[error_position / 8];
-        auto disk_result = _disk.write(block_index * _block_size + error_position / 8, temp);
-        if (!disk_result.has_value()) {
-            return std::unexpected(disk_result.error());
-        }
-
-        // Log error correction
-        if (_logger) {
-            ErrorCorrectionEvent event("Hamming", block_index);
-            _logger->logEvent(event);
-        }
-    } else {
-        if (error_position != 0) {
-            return std::unexpected(FsError::BlockDevice_CorrectionError);
-        }
-    }
-
-    return {};
+    return _fixBlock(block_index, data);
 }
 
-void HammingBlockDevice::_extractData(
-    const static_vector<uint8_t>& encoded_data, static_vector<uint8_t>& data)
-{
-    data.resize(_data_size);
-    HammingDataBitsIterator it(_block_size, _data_size);
-    for (unsigned int i = 0; i < _data_size * 8; i++)
-        BitHelpers::setBit(data, i, BitHelpers::getBit(encoded_data, *it.next()));
-}
-
-void HammingBlockDevice::_encodeData(
-    const static_vector<uint8_t>& data, static_vector<uint8_t>& encoded_data)
+std::expected<void, FsError> HammingBlockDevice::_fixBlock(
+    int block_index, static_vector<uint8_t>& data)
 {
-    encoded_data.resize(_block_size);
-
-    bool parity = true;
-
-    unsigned int parity_xor = 0;
+    auto error_position = _codec.findError(data);
+    if (!error_position.has_value()) {
+        return std::unexpected(error_position.error());
+    }
+    if (!error_position->has_value()) {
+        return {};
+    }
 
-    HammingDataBitsIterator it(_block_size, _data_size);
-    for (unsigned int i = 0; i < _data_size * 8; i++) {
-        bool bit_value = BitHelpers::getBit(data, i);
-        int raw_index = *it.next();
-        if (bit_value) {
-            parity = !parity;
-            parity_xor ^= raw_index;
-        }
-        BitHelpers::setBit(encoded_data, raw_index, bit_value);
+    unsigned int position = **error_position;
+    BitHelpers::setBit(data, position, !BitHelpers::getBit(data, position));
+    std::array<uint8_t, 1> temp_buffer;
+    static_vector<uint8_t> temp(temp_buffer.data(), 1, 1);
+    temp[0] = data[position / 8];
+    auto disk_result = _disk.write(block_index * _block_size + position / 8, temp);
+    if (!disk_result.has_value()) {
+        return std::unexpected(disk_result.error());
     }
 
-    unsigned int parity_index = 1;
-    while (parity_index < _block_size * 8) {
-        bool parity_bit_value = false;
-        if (parity_xor & parity_index) {
-            parity = !parity;
-            parity_bit_value = true;
-        }
-        BitHelpers::setBit(encoded_data, parity_index, parity_bit_value);
-        parity_index <<= 1;
+    // Log error correction
+    if (_logger) {
+        ErrorCorrectionEvent event("Hamming", block_index);
+        _logger->logEvent(event);
     }
 
-    bool parity_bit = !parity;
-    BitHelpers::setBit(encoded_data, 0, parity_bit);
+    return {};
 }
 
 std::expected<size_t, FsError> HammingBlockDevice::writeBlock(
@@ -115,17 +66,25 @@ std::expected<size_t, FsError> HammingBlockDevice::writeBlock(
 
     std::array<uint8_t, MAX_BLOCK_SIZE> raw_block_buffer;
     static_vector<uint8_t> raw_block(raw_block_buffer.data(), MAX_BLOCK_SIZE);
-    auto read_fix_res = _readAndFixBlock(data_location.block_index, raw_block);
-    if (!read_fix_res.has_value()) {
-        return std::unexpected(read_fix_res.error());
-    }
+    if (data_location.offset == 0 && to_write == _data_size) {
+        // Whole block is replaced, encode straight from data
+        raw_block.resize(_block_size);
+        std::fill(raw_block.begin(), raw_block.end(), std::uint8_t(0));
+        _codec.encode(data, raw_block);
+    } else {
+        auto read_fix_res = _readAndFixBlock(data_location.block_index, raw_block);
+        if (!read_fix_res.has_value()) {
+            return std::unexpected(read_fix_res.error());
+        }
 
-    std::array<uint8_t, MAX_BLOCK_SIZE> decoded_data_buffer;
-    static_vector<uint8_t> decoded_data(decoded_data_buffer.data(), MAX_BLOCK_SIZE);
-    _extractData(raw_block, decoded_data);
-    std::copy(data.begin(), data.begin() + to_write, decoded_data.begin() + data_location.offset);
+        std::array<uint8_t, MAX_BLOCK_SIZE> decoded_data_buffer;
+        static_vector<uint8_t> decoded_data(decoded_data_buffer.data(), MAX_BLOCK_SIZE);
+        _codec.extract(raw_block, decoded_data);
+        std::copy(
+            data.begin(), data.begin() + to_write, decoded_data.begin() + data_location.offset);
 
-    _encodeData(decoded_data, raw_block);
+        _codec.encode(decoded_data, raw_block);
+    }
 
     auto disk_result = _disk.write(data_location.block_index * _block_size, raw_block);
 
@@ -154,13 +113,112 @@ std::expected<void, FsError> HammingBlockDevice::readBlock(
     std::array<uint8_t, MAX_BLOCK_SIZE> decoded_data_buffer;
     static_vector<uint8_t> decoded_data(decoded_data_buffer.data(), MAX_BLOCK_SIZE);
 
-    _extractData(raw_block, decoded_data);
+    _codec.extract(raw_block, decoded_data);
 
     data.resize(bytes_to_read);
     std::copy_n(decoded_data.begin() + data_location.offset, bytes_to_read, data.begin());
     return {};
 }
 
+std::expected<size_t, FsError> HammingBlockDevice::writeBlocks(
+    const static_vector<BlockExtent>& extents, const static_vector<std::uint8_t>& data)
+{
+    std::array<uint8_t, MAX_BATCH_SIZE> run_buffer;
+    std::array<uint8_t, MAX_BLOCK_SIZE> decoded_data_buffer;
+    size_t max_blocks = MAX_BATCH_SIZE / _block_size;
+    size_t written = 0;
+
+    for (size_t first = 0; first < extents.size();) {
+        size_t count = consecutiveBlocks(extents, first, max_blocks);
+        int block_index = extents[first].location.block_index;
+        static_vector<uint8_t> run(run_buffer.data(), MAX_BATCH_SIZE, count * _block_size);
+        if (!wholeBlocks(extents, first, count, _data_size, data.size() - written)) {
+            auto read_res = _disk.read(block_index * _block_size, count * _block_size, run);
+            if (!read_res.has_value()) {
+                return std::unexpected(read_res.error());
+            }
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const auto& location = extents[first + i].location;
+            static_vector<uint8_t> raw_block(
+                run.data() + i * _block_size, _block_size, _block_size);
+            size_t to_write = std::min(
+                { extents[first + i].length, _data_size - location.offset, data.size() - written });
+            static_vector<uint8_t> part(
+                const_cast<uint8_t*>(data.data()) + written, to_write, to_write);
+            written += to_write;
+
+            if (location.offset == 0 && to_write == _data_size) {
+                std::fill(raw_block.begin(), raw_block.end(), std::uint8_t(0));
+                _codec.encode(part, raw_block);
+                continue;
+            }
+
+            auto fix_res = _fixBlock(location.block_index, raw_block);
+            if (!fix_res.has_value()) {
+                return std::unexpected(fix_res.error());
+            }
+            static_vector<uint8_t> decoded_data(decoded_data_buffer.data(), MAX_BLOCK_SIZE);
+            _codec.extract(raw_block, decoded_data);
+            std::copy_n(part.begin(), to_write, decoded_data.begin() + location.offset);
+            _codec.encode(decoded_data, raw_block);
+        }
+
+        auto disk_result = _disk.write(block_index * _block_size, run);
+        if (!disk_result.has_value()) {
+            return std::unexpected(disk_result.error());
+        }
+        first += count;
+    }
+    return written;
+}
+
+std::expected<void, FsError> HammingBlockDevice::readBlocks(
+    const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data)
+{
+    size_t total = 0;
+    for (const auto& extent : extents) {
+        total += std::min(extent.length, _data_size - extent.location.offset);
+    }
+    data.resize(0);
+    if (data.capacity() < total) {
+        return std::unexpected(FsError::Disk_InvalidRequest);
+    }
+
+    std::array<uint8_t, MAX_BATCH_SIZE> run_buffer;
+    std::array<uint8_t, MAX_BLOCK_SIZE> decoded_data_buffer;
+    size_t max_blocks = MAX_BATCH_SIZE / _block_size;
+
+    for (size_t first = 0; first < extents.size();) {
+        size_t count = consecutiveBlocks(extents, first, max_blocks);
+        static_vector<uint8_t> run(run_buffer.data(), MAX_BATCH_SIZE);
+        auto read_res = _disk.read(
+            extents[first].location.block_index * _block_size, count * _block_size, run);
+        if (!read_res.has_value()) {
+            return std::unexpected(read_res.error());
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const auto& location = extents[first + i].location;
+            static_vector<uint8_t> raw_block(
+                run.data() + i * _block_size, _block_size, _block_size);
+            auto fix_res = _fixBlock(location.block_index, raw_block);
+            if (!fix_res.has_value()) {
+                return std::unexpected(fix_res.error());
+            }
+
+            static_vector<uint8_t> decoded_data(decoded_data_buffer.data(), MAX_BLOCK_SIZE);
+            _codec.extract(raw_block, decoded_data);
+            size_t to_read = std::min(extents[first + i].length, _data_size - location.offset);
+            std::copy_n(decoded_data.begin() + location.offset, to_read, data.end());
+            data.resize(data.size() + to_read);
+        }
+        first += count;
+    }
+    return {};
+}
+
 std::expected<void, FsError> HammingBlockDevice::formatBlock(unsigned int block_index)
 {
     std::array<uint8_t, MAX_BLOCK_SIZE> zero_data_buffer;
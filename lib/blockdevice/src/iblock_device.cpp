@@ -0,0 +1,73 @@
+#include "ppfs/blockdevice/iblock_device.hpp"
+
+#include <algorithm>
+
+BlockExtent::BlockExtent(DataLocation location, size_t length)
+    : location(location)
+    , length(length)
+{
+}
+
+size_t consecutiveBlocks(
+    const static_vector<BlockExtent>& extents, size_t first, size_t max_blocks)
+{
+    size_t count = 1;
+    while (first + count < extents.size() && count < max_blocks
+        && extents[first + count].location.block_index
+            == extents[first + count - 1].location.block_index + 1) {
+        count++;
+    }
+    return count;
+}
+
+bool wholeBlocks(const static_vector<BlockExtent>& extents, size_t first, size_t count,
+    size_t data_size, size_t available)
+{
+    for (size_t i = first; i < first + count; i++) {
+        if (extents[i].location.offset != 0 || std::min(extents[i].length, available) < data_size) {
+            return false;
+        }
+        available -= data_size;
+    }
+    return true;
+}
+
+std::expected<size_t, FsError> IBlockDevice::writeBlocks(
+    const static_vector<BlockExtent>& extents, const static_vector<std::uint8_t>& data)
+{
+    size_t written = 0;
+    for (const auto& extent : extents) {
+        size_t length = std::min(extent.length, data.size() - written);
+        static_vector<std::uint8_t> part(
+            const_cast<uint8_t*>(data.data()) + written, length, length);
+        auto write_res = writeBlock(part, extent.location);
+        if (!write_res.has_value()) {
+            return std::unexpected(write_res.error());
+        }
+        written += write_res.value();
+    }
+    return written;
+}
+
+std::expected<void, FsError> IBlockDevice::readBlocks(
+    const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data)
+{
+    size_t total = 0;
+    for (const auto& extent : extents) {
+        total += extent.length;
+    }
+    data.resize(0);
+    if (data.capacity() < total) {
+        return std::unexpected(FsError::Disk_InvalidRequest);
+    }
+
+    for (const auto& extent : extents) {
+        static_vector<uint8_t> part(data.end(), extent.length);
+        auto read_res = readBlock(extent.location, extent.length, part);
+        if (!read_res.has_value()) {
+            return std::unexpected(read_res.error());
+        }
+        data.resize(data.size() + part.size());
+    }
+    return {};
+}
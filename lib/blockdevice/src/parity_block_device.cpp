@@ -2,6 +2,7 @@
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/data_collection/data_colection.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <memory>
@@ -31,24 +32,29 @@ std::expected<void, FsError> ParityBlockDevice::formatBlock(unsigned int block_i
 std::expected<size_t, FsError> ParityBlockDevice::writeBlock(
     const static_vector<std::uint8_t>& data, DataLocation data_location)
 {
-    size_t to_write = std::min(data.size(), _data_size - data_location.offset);
+    size_t data_size = static_cast<size_t>(_data_size);
+    size_t to_write = std::min(data.size(), data_size - data_location.offset);
 
     std::array<uint8_t, MAX_BLOCK_SIZE> raw_block_buffer;
     static_vector<uint8_t> raw_block(raw_block_buffer.data(), MAX_BLOCK_SIZE);
     raw_block.resize(_raw_block_size);
-    auto read_res
-        = _disk.read(data_location.block_index * _raw_block_size, _raw_block_size, raw_block);
-    if (!read_res.has_value())
-        return std::unexpected(read_res.error());
-
-    bool parity = _checkParity(raw_block);
-    if (!parity) {
-        return std::unexpected(FsError::BlockDevice_CorrectionError);
+    if (data_location.offset == 0 && to_write == data_size) {
+        // Whole block is replaced, old content doesn't matter
+        raw_block[_raw_block_size - 1] = 0;
+    } else {
+        auto read_res
+            = _disk.read(data_location.block_index * _raw_block_size, _raw_block_size, raw_block);
+        if (!read_res.has_value())
+            return std::unexpected(read_res.error());
+
+        if (!_checkParity(raw_block)) {
+            return std::unexpected(FsError::BlockDevice_CorrectionError);
+        }
     }
 
     std::copy_n(data.begin(), to_write, raw_block.begin() + data_location.offset);
 
-    parity = _checkParity(raw_block);
+    bool parity = _checkParity(raw_block);
 
     if (!parity)
         raw_block[_raw_block_size - 1] ^= static_cast<std::uint8_t>(1);
@@ -87,6 +93,88 @@ std::expected<void, FsError> ParityBlockDevice::readBlock(
     return {};
 }
 
+std::expected<size_t, FsError> ParityBlockDevice::writeBlocks(
+    const static_vector<BlockExtent>& extents, const static_vector<std::uint8_t>& data)
+{
+    std::array<uint8_t, MAX_BATCH_SIZE> run_buffer;
+    size_t max_blocks = MAX_BATCH_SIZE / _raw_block_size;
+    size_t data_size = static_cast<size_t>(_data_size);
+    size_t written = 0;
+
+    for (size_t first = 0; first < extents.size();) {
+        size_t count = consecutiveBlocks(extents, first, max_blocks);
+        size_t address = extents[first].location.block_index * _raw_block_size;
+        static_vector<uint8_t> run(run_buffer.data(), MAX_BATCH_SIZE, count * _raw_block_size);
+        if (!wholeBlocks(extents, first, count, data_size, data.size() - written)) {
+            auto read_res = _disk.read(address, count * _raw_block_size, run);
+            if (!read_res.has_value())
+                return std::unexpected(read_res.error());
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            const auto& location = extents[first + i].location;
+            static_vector<uint8_t> raw_block(
+                run.data() + i * _raw_block_size, _raw_block_size, _raw_block_size);
+            size_t to_write = std::min(
+                { extents[first + i].length, data_size - location.offset, data.size() - written });
+            if (location.offset == 0 && to_write == data_size)
+                raw_block[_raw_block_size - 1] = 0;
+            else if (!_checkParity(raw_block))
+                return std::unexpected(FsError::BlockDevice_CorrectionError);
+
+            std::copy_n(data.begin() + written, to_write, raw_block.begin() + location.offset);
+            written += to_write;
+            if (!_checkParity(raw_block))
+                raw_block[_raw_block_size - 1] ^= static_cast<std::uint8_t>(1);
+        }
+
+        auto write_res = _disk.write(address, run);
+        if (!write_res.has_value())
+            return std::unexpected(write_res.error());
+        first += count;
+    }
+    return written;
+}
+
+std::expected<void, FsError> ParityBlockDevice::readBlocks(
+    const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data)
+{
+    size_t total = 0;
+    for (const auto& extent : extents) {
+        total += std::min(extent.length, _data_size - extent.location.offset);
+    }
+    data.resize(0);
+    if (data.capacity() < total) {
+        return std::unexpected(FsError::Disk_InvalidRequest);
+    }
+
+    std::array<uint8_t, MAX_BATCH_SIZE> run_buffer;
+    size_t max_blocks = MAX_BATCH_SIZE / _raw_block_size;
+
+    for (size_t first = 0; first < extents.size();) {
+        size_t count = consecutiveBlocks(extents, first, max_blocks);
+        static_vector<uint8_t> run(run_buffer.data(), MAX_BATCH_SIZE);
+        auto read_res = _disk.read(
+            extents[first].location.block_index * _raw_block_size, count * _raw_block_size, run);
+        if (!read_res.has_value())
+            return std::unexpected(read_res.error());
+
+        for (size_t i = 0; i < count; i++) {
+            const auto& location = extents[first + i].location;
+            static_vector<uint8_t> raw_block(
+                run.data() + i * _raw_block_size, _raw_block_size, _raw_block_size);
+            if (!_checkParity(raw_block))
+                return std::unexpected(FsError::BlockDevice_CorrectionError);
+
+            size_t to_read = std::min(extents[first + i].length, _data_size - location.offset);
+            std::copy_n(raw_block.begin() + location.offset, to_read, data.end());
+            data.resize(data.size() + to_read);
+        }
+        first += count;
+    }
+    return {};
+}
+
 bool ParityBlockDevice::_checkParity(const static_vector<std::uint8_t>& data)
 {
     size_t ones = 0;
@@ -36,6 +36,76 @@ std::expected<void, FsError> RawBlockDevice::readBlock(
     return _disk.read(address, to_read, data);
 }
 
+size_t RawBlockDevice::_address(const BlockExtent& extent) const
+{
+    return extent.location.block_index * _block_size + extent.location.offset;
+}
+
+size_t RawBlockDevice::_length(const BlockExtent& extent) const
+{
+    return std::min(extent.length, _block_size - extent.location.offset);
+}
+
+std::expected<size_t, FsError> RawBlockDevice::writeBlocks(
+    const static_vector<BlockExtent>& extents, const static_vector<std::uint8_t>& data)
+{
+    size_t written = 0;
+    size_t first = 0;
+    while (first < extents.size() && written < data.size()) {
+        size_t address = _address(extents[first]);
+        size_t length = 0;
+        size_t last = first;
+        // Merge extents as long as the next one starts where the previous ended
+        do {
+            length += std::min(_length(extents[last]), data.size() - written - length);
+            last++;
+        } while (last < extents.size() && _address(extents[last]) == address + length
+            && written + length < data.size());
+
+        static_vector<uint8_t> part(const_cast<uint8_t*>(data.data()) + written, length, length);
+        auto disk_result = _disk.write(address, part);
+        if (!disk_result.has_value()) {
+            return std::unexpected(disk_result.error());
+        }
+        written += length;
+        first = last;
+    }
+    return written;
+}
+
+std::expected<void, FsError> RawBlockDevice::readBlocks(
+    const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data)
+{
+    size_t total = 0;
+    for (const auto& extent : extents) {
+        total += _length(extent);
+    }
+    data.resize(0);
+    if (data.capacity() < total) {
+        return std::unexpected(FsError::Disk_InvalidRequest);
+    }
+
+    size_t first = 0;
+    while (first < extents.size()) {
+        size_t address = _address(extents[first]);
+        size_t length = 0;
+        size_t last = first;
+        do {
+            length += _length(extents[last]);
+            last++;
+        } while (last < extents.size() && _address(extents[last]) == address + length);
+
+        static_vector<uint8_t> part(data.end(), length);
+        auto read_res = _disk.read(address, length, part);
+        if (!read_res.has_value()) {
+            return std::unexpected(read_res.error());
+        }
+        data.resize(data.size() + length);
+        first = last;
+    }
+    return {};
+}
+
 std::expected<void, FsError> RawBlockDevice::formatBlock(unsigned int block_index) { return {}; }
 
 size_t RawBlockDevice::numOfBlocks() const { return _disk.size() / _block_size; }
@@ -3,6 +3,7 @@
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/data_collection/data_colection.hpp"
 
+#include <algorithm>
 #include <array>
 #include <iostream>
 
@@ -39,157 +40,201 @@ std::expected<void, FsError> ReedSolomonBlockDevice::readBlock(
         return std::unexpected(read_res.error());
     }
 
-    std::array<uint8_t, MAX_RS_BLOCK_SIZE> decoded_buffer;
-    static_vector<uint8_t> decoded_data(decoded_buffer.data(), MAX_RS_BLOCK_SIZE);
-    decoded_data.resize(dataSize());
-    _fixBlockAndExtract(raw_block, decoded_data, data_location.block_index);
+    static_vector<uint8_t> message;
+    auto fix_res = _fixBlockAndExtract(raw_block, message, data_location.block_index);
+    if (!fix_res.has_value()) {
+        return std::unexpected(fix_res.error());
+    }
 
     data.resize(bytes_to_read);
-    std::copy_n(decoded_data.begin() + data_location.offset, bytes_to_read, data.begin());
+    std::copy_n(message.begin() + data_location.offset, bytes_to_read, data.begin());
     return {};
 }
 
 ReedSolomonBlockDevice::ReedSolomonBlockDevice(
     IDisk& disk, size_t raw_block_size, size_t correctable_bytes, std::shared_ptr<Logger> logger)
     : _disk(disk)
+    , _raw_block_size(std::min(raw_block_size, static_cast<size_t>(MAX_RS_BLOCK_SIZE)))
+    , _correctable_bytes(std::min(correctable_bytes, _raw_block_size / 2))
+    , _generator(_calculateGenerator())
     , _logger(logger)
+    , _syndromes(2 * _correctable_bytes)
+    , _encoder(_generator, _raw_block_size)
+    , _decoder(_raw_block_size, 2 * _correctable_bytes)
 {
-    _raw_block_size = std::min(raw_block_size, static_cast<size_t>(MAX_RS_BLOCK_SIZE));
-    _correctable_bytes = std::min(correctable_bytes, _raw_block_size / 2);
-    _generator = _calculateGenerator();
 }
 std::expected<size_t, FsError> ReedSolomonBlockDevice::writeBlock(
     const static_vector<std::uint8_t>& data, DataLocation data_location)
 {
-    size_t to_write = std::min(data.size(), dataSize() - data_location.offset);
-
     std::array<uint8_t, MAX_RS_BLOCK_SIZE> raw_block_buffer;
     static_vector<uint8_t> raw_block(raw_block_buffer.data(), MAX_RS_BLOCK_SIZE);
     raw_block.resize(_raw_block_size);
-    auto read_res
-        = _disk.read(_raw_block_size * data_location.block_index, _raw_block_size, raw_block);
-    if (!read_res.has_value()) {
-        return std::unexpected(read_res.error());
+    if (!_replacesMessage(data, data_location)) {
+        auto read_res
+            = _disk.read(_raw_block_size * data_location.block_index, _raw_block_size, raw_block);
+        if (!read_res.has_value()) {
+            return std::unexpected(read_res.error());
+        }
     }
 
-    std::array<uint8_t, MAX_RS_BLOCK_SIZE> decoded_buffer;
-    static_vector<uint8_t> decoded(decoded_buffer.data(), MAX_RS_BLOCK_SIZE);
-    decoded.resize(dataSize());
-    _fixBlockAndExtract(raw_block, decoded, data_location.block_index);
-
-    std::copy(data.begin(), data.begin() + to_write, decoded.begin() + data_location.offset);
-
-    std::array<uint8_t, MAX_RS_BLOCK_SIZE> encoded_buffer;
-    static_vector<uint8_t> encoded_block(encoded_buffer.data(), MAX_RS_BLOCK_SIZE);
-    encoded_block.resize(_raw_block_size);
-    _encodeBlock(decoded, encoded_block);
+    auto apply_res = _applyWrite(raw_block, data, data_location);
+    if (!apply_res.has_value()) {
+        return std::unexpected(apply_res.error());
+    }
 
-    auto disk_result = _disk.write(data_location.block_index * _raw_block_size, encoded_block);
+    auto disk_result = _disk.write(data_location.block_index * _raw_block_size, raw_block);
 
     if (!disk_result.has_value())
         return std::unexpected(disk_result.error());
 
-    return to_write;
+    return apply_res.value();
 }
 
-void ReedSolomonBlockDevice::_encodeBlock(
-    const static_vector<std::uint8_t>& raw_block, static_vector<std::uint8_t>& data)
+std::expected<size_t, FsError> ReedSolomonBlockDevice::_applyWrite(
+    static_vector<std::uint8_t>& raw_block, const static_vector<std::uint8_t>& data,
+    DataLocation data_location)
 {
-    int t = 2 * _correctable_bytes;
-
-    static_vector<GF256> gf_message(
-        reinterpret_cast<GF256*>(const_cast<uint8_t*>(raw_block.data())), MAX_RS_BLOCK_SIZE,
-        raw_block.size());
-    auto message = PolynomialGF256(gf_message);
-    auto shifted_message = message.multiply_by_xk(t);
+    size_t to_write = std::min(data.size(), dataSize() - data_location.offset);
 
-    auto encoded = shifted_message + shifted_message.mod(_generator);
+    // Whole message is replaced, old content of the block isn't needed, not even decoded
+    if (_replacesMessage(data, data_location)) {
+        std::copy_n(data.begin(), to_write, raw_block.begin() + 2 * _correctable_bytes);
+        _encoder.encode(raw_block);
+        return to_write;
+    }
 
-    std::array<GF256, MAX_RS_BLOCK_SIZE> encoded_slice_buffer;
-    static_vector<GF256> encoded_slice(encoded_slice_buffer.data(), MAX_RS_BLOCK_SIZE);
-    encoded.slice(0, _raw_block_size, encoded_slice);
-    static_vector<uint8_t> encoded_bytes(
-        reinterpret_cast<uint8_t*>(encoded_slice.data()), MAX_RS_BLOCK_SIZE, encoded_slice.size());
+    static_vector<uint8_t> message;
+    auto fix_res = _fixBlockAndExtract(raw_block, message, data_location.block_index);
+    if (!fix_res.has_value()) {
+        return std::unexpected(fix_res.error());
+    }
 
-    // Write encoded result to data (output buffer)
-    data.resize(encoded_bytes.size());
-    std::copy_n(encoded_bytes.data(), encoded_bytes.size(), data.begin());
+    // Parity can be updated from deltas only if the block is a valid codeword, so encode from
+    // scratch when decoding had to correct something
+    if (fix_res.value()) {
+        std::copy_n(data.begin(), to_write, message.begin() + data_location.offset);
+        _encoder.encode(raw_block);
+    } else {
+        _encoder.update(raw_block, data_location.offset, data);
+    }
+    return to_write;
 }
 
-void ReedSolomonBlockDevice::_fixBlockAndExtract(static_vector<std::uint8_t> raw_block,
-    const static_vector<std::uint8_t>& data, block_index_t block_index)
+bool ReedSolomonBlockDevice::_replacesMessage(
+    const static_vector<std::uint8_t>& data, DataLocation data_location) const
 {
-    static_vector<GF256> gf_static(
-        reinterpret_cast<GF256*>(raw_block.data()), MAX_RS_BLOCK_SIZE, raw_block.size());
-    auto code_word = PolynomialGF256(gf_static);
+    return data_location.offset == 0 && data.size() >= dataSize();
+}
 
-    // Calculate syndromes
-    std::array<GF256, MAX_RS_BLOCK_SIZE> syndromes_buffer;
-    static_vector<GF256> syndromes(syndromes_buffer.data(), MAX_RS_BLOCK_SIZE);
-    syndromes.resize(0);
+std::expected<size_t, FsError> ReedSolomonBlockDevice::writeBlocks(
+    const static_vector<BlockExtent>& extents, const static_vector<std::uint8_t>& data)
+{
+    std::array<uint8_t, MAX_BATCH_SIZE> run_buffer;
+    size_t max_blocks = MAX_BATCH_SIZE / _raw_block_size;
+    size_t written = 0;
+
+    for (size_t first = 0; first < extents.size();) {
+        size_t count = consecutiveBlocks(extents, first, max_blocks);
+        size_t address = extents[first].location.block_index * _raw_block_size;
+        static_vector<uint8_t> run(run_buffer.data(), MAX_BATCH_SIZE, count * _raw_block_size);
+        if (!wholeBlocks(extents, first, count, dataSize(), data.size() - written)) {
+            auto read_res = _disk.read(address, count * _raw_block_size, run);
+            if (!read_res.has_value()) {
+                return std::unexpected(read_res.error());
+            }
+        }
 
-    GF256 alpha = GF256::getPrimitiveElement();
-    GF256 power = GF256(alpha);
+        for (size_t i = 0; i < count; i++) {
+            static_vector<uint8_t> raw_block(
+                run.data() + i * _raw_block_size, _raw_block_size, _raw_block_size);
+            size_t length = std::min(extents[first + i].length, data.size() - written);
+            static_vector<uint8_t> part(
+                const_cast<uint8_t*>(data.data()) + written, length, length);
+            auto apply_res = _applyWrite(raw_block, part, extents[first + i].location);
+            if (!apply_res.has_value()) {
+                return std::unexpected(apply_res.error());
+            }
+            written += apply_res.value();
+        }
 
-    bool is_message_correct = true;
-    for (int i = 0; i < 2 * _correctable_bytes; i++) {
-        auto s = code_word.evaluate(power);
-        syndromes.push_back(s);
-        if (s != 0)
-            is_message_correct = false;
-        power = power * alpha;
+        auto disk_result = _disk.write(address, run);
+        if (!disk_result.has_value()) {
+            return std::unexpected(disk_result.error());
+        }
+        first += count;
     }
+    return written;
+}
 
-    if (is_message_correct) {
-        _extractMessage(code_word, const_cast<static_vector<std::uint8_t>&>(data));
-        return;
+std::expected<void, FsError> ReedSolomonBlockDevice::readBlocks(
+    const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data)
+{
+    size_t total = 0;
+    for (const auto& extent : extents) {
+        total += std::min(extent.length, dataSize() - extent.location.offset);
+    }
+    data.resize(0);
+    if (data.capacity() < total) {
+        return std::unexpected(FsError::Disk_InvalidRequest);
     }
 
-    // Calculate error locator polynomial
-    auto sigma = _berlekampMassey(syndromes);
+    std::array<uint8_t, MAX_BATCH_SIZE> run_buffer;
+    size_t max_blocks = MAX_BATCH_SIZE / _raw_block_size;
 
-    // Find locations of errors
-    std::array<GF256, MAX_RS_BLOCK_SIZE> error_positions_buffer;
-    static_vector<GF256> error_positions(error_positions_buffer.data(), MAX_RS_BLOCK_SIZE);
-    _errorLocations(sigma, error_positions);
+    for (size_t first = 0; first < extents.size();) {
+        size_t count = consecutiveBlocks(extents, first, max_blocks);
+        static_vector<uint8_t> run(run_buffer.data(), MAX_BATCH_SIZE);
+        auto read_res = _disk.read(extents[first].location.block_index * _raw_block_size,
+            count * _raw_block_size, run);
+        if (!read_res.has_value()) {
+            return std::unexpected(read_res.error());
+        }
 
-    // Calculate omega polynomial to find error values
-    auto omega = _calculateOmega(syndromes, sigma);
+        for (size_t i = 0; i < count; i++) {
+            const auto& location = extents[first + i].location;
+            static_vector<uint8_t> raw_block(
+                run.data() + i * _raw_block_size, _raw_block_size, _raw_block_size);
+            static_vector<uint8_t> message;
+            auto fix_res = _fixBlockAndExtract(raw_block, message, location.block_index);
+            if (!fix_res.has_value()) {
+                return std::unexpected(fix_res.error());
+            }
+            size_t to_read = std::min(extents[first + i].length, dataSize() - location.offset);
+            std::copy_n(message.begin() + location.offset, to_read, data.end());
+            data.resize(data.size() + to_read);
+        }
+        first += count;
+    }
+    return {};
+}
 
-    // Calculate error values
-    std::array<GF256, MAX_RS_BLOCK_SIZE> error_values_buffer;
-    static_vector<GF256> error_values(error_values_buffer.data(), MAX_RS_BLOCK_SIZE);
-    _forney(omega, sigma, error_positions, error_values);
+std::expected<bool, FsError> ReedSolomonBlockDevice::_fixBlockAndExtract(
+    static_vector<std::uint8_t>& raw_block, static_vector<std::uint8_t>& message,
+    block_index_t block_index)
+{
+    size_t parity_size = 2 * _correctable_bytes;
+    message = static_vector<std::uint8_t>(raw_block.data() + parity_size, dataSize(), dataSize());
+
+    // Calculate syndromes
+    std::array<GF256, MAX_RS_BLOCK_SIZE> syndromes_buffer;
+    static_vector<GF256> syndromes(syndromes_buffer.data(), MAX_RS_BLOCK_SIZE);
+    if (_syndromes.calculate(raw_block, syndromes)) {
+        return false;
+    }
 
-    // Correct errors
-    for (size_t i = 0; i < error_positions.size(); i++) {
-        auto pos = error_positions[i].log();
-        code_word[pos] = code_word[pos] + error_values[i];
+    auto correct_res = _decoder.correct(raw_block, syndromes);
+    if (!correct_res.has_value()) {
+        return std::unexpected(correct_res.error());
     }
 
     // Write fixed version to disk
     if (_logger) {
         _logger->logEvent(ErrorCorrectionEvent("ReedSolomon", block_index));
     }
-
-    std::array<GF256, MAX_RS_BLOCK_SIZE> correct_slice_buffer;
-    static_vector<GF256> correct_slice(correct_slice_buffer.data(), MAX_RS_BLOCK_SIZE);
-    code_word.slice(0, correct_slice);
-    static_vector<uint8_t> correct_vec(
-        reinterpret_cast<uint8_t*>(correct_slice.data()), MAX_RS_BLOCK_SIZE, correct_slice.size());
-    auto disk_result = _disk.write(block_index * _raw_block_size, correct_vec);
-
-    _extractMessage(code_word, const_cast<static_vector<std::uint8_t>&>(data));
-}
-
-void ReedSolomonBlockDevice::_extractMessage(PolynomialGF256 p, static_vector<std::uint8_t>& data)
-{
-    std::array<GF256, MAX_RS_BLOCK_SIZE> message_slice_buffer;
-    static_vector<GF256> message_slice(message_slice_buffer.data(), MAX_RS_BLOCK_SIZE);
-    p.slice(2 * _correctable_bytes, _raw_block_size, message_slice);
-    data.resize(message_slice.size());
-    std::copy_n(
-        reinterpret_cast<uint8_t*>(message_slice.data()), message_slice.size(), data.begin());
+    auto disk_result = _disk.write(block_index * _raw_block_size, raw_block);
+    if (!disk_result.has_value())
+        return std::unexpected(disk_result.error());
+    return true;
 }
 
 PolynomialGF256 ReedSolomonBlockDevice::_calculateGenerator()
@@ -206,75 +251,3 @@ PolynomialGF256 ReedSolomonBlockDevice::_calculateGenerator()
 
     return g;
 }
-
-void ReedSolomonBlockDevice::_forney(const PolynomialGF256& omega, PolynomialGF256& sigma,
-    const static_vector<GF256>& error_locations, static_vector<GF256>& error_values)
-{
-    PolynomialGF256 sigma_derivative = sigma.derivative();
-
-    error_values.resize(error_locations.size());
-    for (size_t i = 0; i < error_locations.size(); i++) {
-        GF256 Xi_inv = error_locations[i].inv();
-        GF256 numerator = omega.evaluate(Xi_inv);
-        GF256 denominator = sigma_derivative.evaluate(Xi_inv);
-        error_values[i] = numerator / denominator;
-    }
-}
-
-PolynomialGF256 ReedSolomonBlockDevice::_calculateOmega(
-    const static_vector<GF256>& syndromes, PolynomialGF256& sigma)
-{
-    PolynomialGF256 S(syndromes);
-    std::array<GF256, MAX_RS_BLOCK_SIZE> omega_slice_buffer;
-    static_vector<GF256> omega_slice(omega_slice_buffer.data(), MAX_RS_BLOCK_SIZE);
-    (S * sigma).slice(0, syndromes.size(), omega_slice);
-    return PolynomialGF256(omega_slice);
-}
-
-PolynomialGF256 ReedSolomonBlockDevice::_berlekampMassey(const static_vector<GF256>& syndromes)
-{
-    PolynomialGF256 sigma({ GF256(1) });
-    PolynomialGF256 B({ GF256(1) });
-    GF256 b(1);
-
-    int L = 0;
-    int m = 1;
-
-    for (size_t n = 0; n < syndromes.size(); n++) {
-        GF256 d = syndromes[n];
-        for (int i = 1; i <= L; i++) {
-            d = d + sigma[i] * syndromes[n - i];
-        }
-
-        if (d != 0) {
-            auto T = sigma;
-            PolynomialGF256 diff = B * PolynomialGF256({ d / b });
-            diff = diff.multiply_by_xk(m);
-            sigma += diff;
-
-            if (2 * L <= static_cast<int>(n)) {
-                L = n + 1 - L;
-                B = T;
-                b = d;
-                m = 1;
-            } else {
-                m++;
-            }
-        } else {
-            m++;
-        }
-    }
-
-    return sigma;
-}
-
-void ReedSolomonBlockDevice::_errorLocations(
-    PolynomialGF256 error_location_polynomial, static_vector<GF256>& error_locations)
-{
-    error_locations.resize(0);
-    for (int i = 1; i <= 255; i++) {
-        if (error_location_polynomial.evaluate(i) == 0) {
-            error_locations.push_back(GF256(i).inv());
-        }
-    }
-}
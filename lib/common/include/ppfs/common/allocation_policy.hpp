@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Enumeration of policies choosing where the search for a free block or inode starts.
+ */
+enum class AllocationPolicy : std::uint8_t {
+    FirstFit, ///< Always search from the start of the bitmap
+    NextFit, ///< Search from the place after the last allocation
+    ThreadGroups, ///< Next-fit with a cursor per group, threads are spread among the groups
+};
+
+/**
+ * Whether a policy read from disk is one of the known ones.
+ */
+constexpr bool isValidAllocationPolicy(AllocationPolicy policy)
+{
+    return static_cast<std::uint8_t>(policy)
+        <= static_cast<std::uint8_t>(AllocationPolicy::ThreadGroups);
+}
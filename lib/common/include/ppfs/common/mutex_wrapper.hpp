@@ -0,0 +1,48 @@
+#pragma once
+
+#include <expected>
+
+#include "ppfs/common/ppfs_mutex.hpp"
+#include "ppfs/common/types.hpp"
+
+/**
+ * Runs f holding mutex exclusively, works with both PpFSMutex and PpFSSharedMutex.
+ */
+template <typename T, typename Mutex, typename Func>
+std::expected<T, FsError> mutex_wrapper(Mutex& mutex, Func f)
+{
+    auto lock = mutex.lock();
+    if (!lock.has_value()) {
+        if (lock.error() == FsError::Mutex_NotInitialized) {
+            return std::unexpected(FsError::PpFS_NotInitialized);
+        }
+        return std::unexpected(lock.error());
+    }
+    auto ret = f();
+    auto unlock = mutex.unlock();
+    if (!unlock.has_value()) {
+        return std::unexpected(unlock.error());
+    }
+    return ret;
+};
+
+/**
+ * Runs f holding mutex together with other readers.
+ */
+template <typename T, typename Func>
+std::expected<T, FsError> shared_mutex_wrapper(PpFSSharedMutex& mutex, Func f)
+{
+    auto lock = mutex.lockShared();
+    if (!lock.has_value()) {
+        if (lock.error() == FsError::Mutex_NotInitialized) {
+            return std::unexpected(FsError::PpFS_NotInitialized);
+        }
+        return std::unexpected(lock.error());
+    }
+    auto ret = f();
+    auto unlock = mutex.unlockShared();
+    if (!unlock.has_value()) {
+        return std::unexpected(unlock.error());
+    }
+    return ret;
+};
@@ -118,4 +118,186 @@ private:
 #else
     pthread_mutex_t _mutex_handle;
 #endif
-};
\ No newline at end of file
+};
+
+/**
+ * Cross-platform reader/writer lock supporting both FreeRTOS and pthread.
+ *
+ * Any number of readers may hold the lock with lockShared, a writer holding it with lock
+ * excludes everyone else. On FreeRTOS the first reader takes a binary semaphore on behalf of
+ * all readers and the last one gives it back, so readers are preferred over waiting writers.
+ */
+class PpFSSharedMutex {
+public:
+    PpFSSharedMutex()
+        : _is_initialized(false)
+    {
+#ifdef PPFS_USE_FREERTOS
+        _readers_handle = nullptr;
+        _writer_handle = nullptr;
+        _readers = 0;
+#endif
+    }
+
+    ~PpFSSharedMutex() { (void)deinit(); }
+
+    [[nodiscard]] std::expected<void, FsError> init()
+    {
+        if (_is_initialized) {
+            return std::unexpected(FsError::Mutex_AlreadyInitialized);
+        }
+
+#ifdef PPFS_USE_FREERTOS
+        _readers_handle = xSemaphoreCreateMutex();
+        _writer_handle = xSemaphoreCreateBinary();
+        if (_readers_handle == nullptr || _writer_handle == nullptr
+            || xSemaphoreGive(_writer_handle) != pdTRUE) {
+            _deleteHandles();
+            return std::unexpected(FsError::Mutex_InitFailed);
+        }
+        _readers = 0;
+#else
+        if (pthread_rwlock_init(&_rwlock_handle, nullptr) != 0) {
+            return std::unexpected(FsError::Mutex_InitFailed);
+        }
+#endif
+
+        _is_initialized = true;
+        return {};
+    }
+
+    [[nodiscard]] std::expected<void, FsError> deinit()
+    {
+        if (!_is_initialized) {
+            return std::unexpected(FsError::Mutex_NotInitialized);
+        }
+
+#ifdef PPFS_USE_FREERTOS
+        _deleteHandles();
+#else
+        if (pthread_rwlock_destroy(&_rwlock_handle) != 0) {
+            return std::unexpected(FsError::Mutex_InternalError);
+        }
+#endif
+
+        _is_initialized = false;
+        return {};
+    }
+
+    /** Takes the lock exclusively. */
+    [[nodiscard]] std::expected<void, FsError> lock()
+    {
+        if (!_is_initialized) {
+            return std::unexpected(FsError::Mutex_NotInitialized);
+        }
+
+#ifdef PPFS_USE_FREERTOS
+        if (xSemaphoreTake(_writer_handle, portMAX_DELAY) != pdTRUE) {
+            return std::unexpected(FsError::Mutex_LockFailed);
+        }
+#else
+        if (pthread_rwlock_wrlock(&_rwlock_handle) != 0) {
+            return std::unexpected(FsError::Mutex_LockFailed);
+        }
+#endif
+        return {};
+    }
+
+    [[nodiscard]] std::expected<void, FsError> unlock()
+    {
+        if (!_is_initialized) {
+            return std::unexpected(FsError::Mutex_NotInitialized);
+        }
+
+#ifdef PPFS_USE_FREERTOS
+        if (xSemaphoreGive(_writer_handle) != pdTRUE) {
+            return std::unexpected(FsError::Mutex_UnlockFailed);
+        }
+#else
+        if (pthread_rwlock_unlock(&_rwlock_handle) != 0) {
+            return std::unexpected(FsError::Mutex_UnlockFailed);
+        }
+#endif
+        return {};
+    }
+
+    /** Takes the lock together with other readers. */
+    [[nodiscard]] std::expected<void, FsError> lockShared()
+    {
+        if (!_is_initialized) {
+            return std::unexpected(FsError::Mutex_NotInitialized);
+        }
+
+#ifdef PPFS_USE_FREERTOS
+        if (xSemaphoreTake(_readers_handle, portMAX_DELAY) != pdTRUE) {
+            return std::unexpected(FsError::Mutex_LockFailed);
+        }
+        if (_readers == 0 && xSemaphoreTake(_writer_handle, portMAX_DELAY) != pdTRUE) {
+            (void)xSemaphoreGive(_readers_handle);
+            return std::unexpected(FsError::Mutex_LockFailed);
+        }
+        _readers++;
+        (void)xSemaphoreGive(_readers_handle);
+#else
+        if (pthread_rwlock_rdlock(&_rwlock_handle) != 0) {
+            return std::unexpected(FsError::Mutex_LockFailed);
+        }
+#endif
+        return {};
+    }
+
+    [[nodiscard]] std::expected<void, FsError> unlockShared()
+    {
+        if (!_is_initialized) {
+            return std::unexpected(FsError::Mutex_NotInitialized);
+        }
+
+#ifdef PPFS_USE_FREERTOS
+        if (xSemaphoreTake(_readers_handle, portMAX_DELAY) != pdTRUE) {
+            return std::unexpected(FsError::Mutex_UnlockFailed);
+        }
+        _readers--;
+        bool give_failed = _readers == 0 && xSemaphoreGive(_writer_handle) != pdTRUE;
+        (void)xSemaphoreGive(_readers_handle);
+        if (give_failed) {
+            return std::unexpected(FsError::Mutex_UnlockFailed);
+        }
+#else
+        if (pthread_rwlock_unlock(&_rwlock_handle) != 0) {
+            return std::unexpected(FsError::Mutex_UnlockFailed);
+        }
+#endif
+        return {};
+    }
+
+    bool isInitialized() const { return _is_initialized; }
+
+    // Disable copying
+    PpFSSharedMutex(const PpFSSharedMutex&) = delete;
+    PpFSSharedMutex& operator=(const PpFSSharedMutex&) = delete;
+
+private:
+    bool _is_initialized;
+
+#ifdef PPFS_USE_FREERTOS
+    /** Guards the reader count */
+    SemaphoreHandle_t _readers_handle;
+    /** Held by a writer or on behalf of all readers */
+    SemaphoreHandle_t _writer_handle;
+    std::uint32_t _readers;
+
+    void _deleteHandles()
+    {
+        if (_readers_handle != nullptr) {
+            vSemaphoreDelete(_readers_handle);
+            _readers_handle = nullptr;
+        }
+        if (_writer_handle != nullptr) {
+            vSemaphoreDelete(_writer_handle);
+            _writer_handle = nullptr;
+        }
+    }
+#else
+    pthread_rwlock_t _rwlock_handle;
+#endif
+};
@@ -12,6 +12,7 @@ enum class FsError : uint8_t {
     // Bitmap errors
     Bitmap_IndexOutOfRange,
     Bitmap_NotFound,
+    Bitmap_AlreadySet,
 
     // Block manager errors
     BlockManager_AlreadyTaken,
@@ -64,6 +65,8 @@ enum class FsError : uint8_t {
 
     // SuperBlock Manager errors
     SuperBlockManager_InvalidRequest,
+    SuperBlockManager_UnsupportedVersion,
+    SuperBlockManager_InvalidValue,
 
     // Static vector error
     StaticVector_AllocationError,
@@ -86,6 +89,8 @@ inline std::string_view toString(FsError err)
         return "Bitmap_IndexOutOfRange";
     case FsError::Bitmap_NotFound:
         return "Bitmap_NotFound";
+    case FsError::Bitmap_AlreadySet:
+        return "Bitmap_AlreadySet";
 
     case FsError::BlockManager_AlreadyTaken:
         return "BlockManager_AlreadyTaken";
@@ -163,6 +168,10 @@ inline std::string_view toString(FsError err)
 
     case FsError::SuperBlockManager_InvalidRequest:
         return "SuperBlockManager_InvalidRequest";
+    case FsError::SuperBlockManager_UnsupportedVersion:
+        return "SuperBlockManager_UnsupportedVersion";
+    case FsError::SuperBlockManager_InvalidValue:
+        return "SuperBlockManager_InvalidValue";
 
     case FsError::StaticVector_AllocationError:
         return "StaticVector_AllocationError";
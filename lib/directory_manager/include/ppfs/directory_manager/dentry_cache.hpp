@@ -0,0 +1,79 @@
+#pragma once
+#include "ppfs/common/ppfs_mutex.hpp"
+#include "ppfs/common/types.hpp"
+#include "ppfs/directory_manager/directory.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <optional>
+
+#ifndef PPFS_DENTRY_CACHE_ENTRIES
+/** Number of name lookups remembered by DirectoryManager */
+#    define PPFS_DENTRY_CACHE_ENTRIES 64
+#endif
+
+/**
+ * Fixed pool of recent name lookups, evicted with CLOCK.
+ *
+ * Entries are keyed by parent directory and name hash, the name itself is kept to rule out
+ * collisions. Negative entries remember names that do not exist in the parent. The cache knows
+ * nothing about the disk, its owner has to drop entries whenever a directory changes. Methods
+ * are guarded by an internal mutex, lookups of concurrent readers may fill the cache. While the
+ * mutex cannot be taken the cache stays empty, lookups miss and inserts are dropped.
+ */
+class DentryCache {
+public:
+    static constexpr size_t ENTRIES = PPFS_DENTRY_CACHE_ENTRIES;
+
+private:
+    struct CacheEntry {
+        inode_index_t parent;
+        std::uint32_t hash;
+        bool valid = false;
+        bool referenced = false;
+        /** Whether the name exists, inode is only meaningful if it does */
+        bool exists = false;
+        inode_index_t inode;
+        std::array<char, sizeof(DirectoryEntry::name)> name;
+    };
+
+    std::array<CacheEntry, ENTRIES> _cache;
+    size_t _clock_hand = 0;
+    size_t _hits = 0;
+    size_t _misses = 0;
+    mutable PpFSMutex _mutex;
+
+    CacheEntry* _find(inode_index_t parent, std::uint32_t hash, const char* name);
+    CacheEntry& _allocate();
+
+public:
+    DentryCache();
+
+    /** Whether the internal mutex was created */
+    bool isInitialized() const { return _mutex.isInitialized(); }
+
+    /**
+     * Looks up a name.
+     *
+     * @return nothing on a miss, inode or PpFS_NotFound for negative entries otherwise
+     */
+    std::optional<std::expected<inode_index_t, FsError>> lookup(
+        inode_index_t parent, const char* name);
+
+    /**
+     * Remembers result of a lookup. Names not fitting a directory entry are ignored.
+     *
+     * @param inode inode of the entry, nothing if the name does not exist in parent
+     */
+    void insert(inode_index_t parent, const char* name, std::optional<inode_index_t> inode);
+
+    /** Drops entry of a name. */
+    void forget(inode_index_t parent, const char* name);
+
+    /** Drops entries pointing to inode from parent and every entry inside inode. */
+    void forgetInode(inode_index_t parent, inode_index_t inode);
+
+    size_t hits() const;
+    size_t misses() const;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include "ppfs/common/types.hpp"
 #include <array>
+#include <cstdint>
 
 /**
  * Represents a directory entry containing inode reference and filename.
@@ -10,3 +11,18 @@ struct DirectoryEntry {
     // TODO: do something more clever
     std::array<char, 128 - sizeof(inode_index_t)> name; ///< Null-terminated filename
 };
+
+/**
+ * FNV-1a hash of a null-terminated name.
+ *
+ * Directory indexes store it on disk, so it must not change. DentryCache uses it as well.
+ */
+inline std::uint32_t hashEntryName(const char* name)
+{
+    std::uint32_t hash = 2166136261u;
+    for (; *name != '\0'; name++) {
+        hash ^= static_cast<std::uint8_t>(*name);
+        hash *= 16777619u;
+    }
+    return hash;
+}
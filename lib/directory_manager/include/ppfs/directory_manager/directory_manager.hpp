@@ -2,28 +2,120 @@
 
 #include "ppfs/blockdevice/iblock_device.hpp"
 #include "ppfs/common/static_vector.hpp"
+#include "ppfs/directory_manager/dentry_cache.hpp"
 #include "ppfs/directory_manager/idirectory_manager.hpp"
 #include "ppfs/file_io/file_io.hpp"
 #include <optional>
 
+#ifndef PPFS_DIRECTORY_INDEX_MIN_ENTRIES
+/** Number of entries at which a directory gets a hashed index, smaller ones are scanned */
+#    define PPFS_DIRECTORY_INDEX_MIN_ENTRIES 256
+#endif
+
 /**
  * Manages directory entries and operations.
+ *
+ * With indexing enabled, a directory reaching INDEX_MIN_ENTRIES entries gets a hashed index of
+ * names. The index is an open addressing hash table with linear probing, stored in its own
+ * inode as slots of name hash and entry position. Its inode is kept in a hidden first entry
+ * with an empty name and the directory inode is marked with hashed_index. Lookups then read a
+ * few slots and entries instead of the whole directory. Table doubles when it gets half full and
+ * is dropped once the directory is empty. It is built in memory part by part, so every block of
+ * it is written once. Directories without the mark are scanned linearly.
+ *
+ * Results of name lookups, including names that were not found, are kept in a DentryCache, so
+ * resolving the same path again does not read the directory. Entries are dropped when the
+ * directory changes through addEntry or removeEntry.
  */
 class DirectoryManager : public IDirectoryManager {
+public:
+    static constexpr size_t INDEX_MIN_ENTRIES = PPFS_DIRECTORY_INDEX_MIN_ENTRIES;
+
+private:
+    struct __attribute__((packed)) IndexSlot {
+        std::uint32_t hash;
+        /** Position of the entry in the directory, zero marks an empty slot */
+        std::uint32_t position;
+    };
+
     IBlockDevice& _block_device;
     IInodeManager& _inode_manager;
     FileIO& _file_io;
+    bool _use_index;
+    DentryCache _dentries;
 
     [[nodiscard]] std::expected<void, FsError> _readDirectoryData(inode_index_t inode_index,
         Inode& dir_inode, static_vector<DirectoryEntry>& buf, size_t offset, size_t size);
     std::optional<std::pair<size_t, DirectoryEntry>> _findEntryByName(
         const static_vector<DirectoryEntry>& entries, char const* name);
-    std::optional<std::pair<size_t, DirectoryEntry>> _findEntryByInode(
-        const static_vector<DirectoryEntry>& entries, inode_index_t inode);
     [[nodiscard]] std::expected<Inode, FsError> _getDirectoryInode(inode_index_t inode_index);
+    [[nodiscard]] std::expected<void, FsError> _addEntry(
+        inode_index_t directory, const DirectoryEntry& entry);
+    [[nodiscard]] std::expected<inode_index_t, FsError> _getInodeByName(
+        inode_index_t directory, const char* name);
+    /** Finds position and contents of the entry with given name, through the index if any */
+    [[nodiscard]] std::expected<std::pair<size_t, DirectoryEntry>, FsError> _findEntry(
+        inode_index_t directory, Inode& dir_inode, const char* name);
+    [[nodiscard]] std::expected<void, FsError> _writeEntry(
+        inode_index_t directory, Inode& dir_inode, size_t position, const DirectoryEntry& entry);
+
+    /** Reads index inode number from the hidden first entry */
+    [[nodiscard]] std::expected<inode_index_t, FsError> _getIndex(
+        inode_index_t directory, Inode& dir_inode);
+    [[nodiscard]] std::expected<IndexSlot, FsError> _readSlot(
+        inode_index_t index, Inode& index_inode, size_t slot);
+    [[nodiscard]] std::expected<void, FsError> _writeSlot(
+        inode_index_t index, Inode& index_inode, size_t slot, IndexSlot value);
+    [[nodiscard]] std::expected<void, FsError> _insertSlot(
+        inode_index_t index, Inode& index_inode, IndexSlot value);
+    /** Finds slot pointing to position */
+    [[nodiscard]] std::expected<size_t, FsError> _findSlot(
+        inode_index_t index, Inode& index_inode, std::uint32_t hash, std::uint32_t position);
+    /** Empties slot, moving later slots of the probe sequence back */
+    [[nodiscard]] std::expected<void, FsError> _eraseSlot(
+        inode_index_t index, Inode& index_inode, size_t slot);
+    /**
+     * Creates index with given number of slots for entries of directory, except the first one.
+     * @return inode of the new index
+     */
+    [[nodiscard]] std::expected<inode_index_t, FsError> _buildIndex(
+        inode_index_t directory, Inode& dir_inode, size_t capacity);
+    /** Number of slots an index is built in at once, ending at block boundaries if possible */
+    size_t _indexPartSlots();
+    /** Reads slots of entries from position first + 1 on, leaving slots empty past the end */
+    [[nodiscard]] std::expected<void, FsError> _readEntrySlots(inode_index_t directory,
+        Inode& dir_inode, size_t first, static_vector<IndexSlot>& slots);
+    /** Writes slots of entries of directory, except the first one, to an empty file */
+    [[nodiscard]] std::expected<void, FsError> _collectSlots(inode_index_t directory,
+        Inode& dir_inode, inode_index_t file, Inode& file_inode);
+    /**
+     * Writes empty index table part by part, so that every block is written once.
+     * @param read_slots reads slots of entries from given one on, like _readEntrySlots
+     */
+    template <typename ReadSlots>
+    [[nodiscard]] std::expected<void, FsError> _fillIndex(
+        inode_index_t index, Inode& index_inode, size_t capacity, ReadSlots&& read_slots);
+    [[nodiscard]] std::expected<void, FsError> _removeIndex(inode_index_t index);
+    /** Moves first entry to the end, puts index reference in its place */
+    [[nodiscard]] std::expected<void, FsError> _enableIndex(
+        inode_index_t directory, Inode& dir_inode);
+    [[nodiscard]] std::expected<std::pair<size_t, DirectoryEntry>, FsError> _indexedLookup(
+        inode_index_t directory, Inode& dir_inode, const char* name);
+    /** Updates index after entry was removed and last one moved to its position */
+    [[nodiscard]] std::expected<void, FsError> _unindexEntry(inode_index_t directory,
+        Inode& dir_inode, const DirectoryEntry& removed, std::uint32_t position,
+        const std::optional<DirectoryEntry>& moved, std::uint32_t moved_from);
 
 public:
-    DirectoryManager(IBlockDevice& block_device, IInodeManager& inode_manager, FileIO& file_io);
+    /**
+     * @param use_index whether large directories get a hashed index, existing indexes are
+     * maintained either way
+     */
+    DirectoryManager(IBlockDevice& block_device, IInodeManager& inode_manager, FileIO& file_io,
+        bool use_index = false);
+
+    /** Whether the name cache could create its mutex */
+    bool isInitialized() const { return _dentries.isInitialized(); }
 
     [[nodiscard]] std::expected<void, FsError> getEntries(inode_index_t inode,
         std::uint32_t elements, std::uint32_t offset, static_vector<DirectoryEntry>& buf) override;
@@ -32,11 +124,16 @@ public:
         inode_index_t directory, DirectoryEntry entry) override;
 
     [[nodiscard]] virtual std::expected<void, FsError> removeEntry(
-        inode_index_t directory, inode_index_t entry) override;
+        inode_index_t directory, const char* name) override;
 
     [[nodiscard]] virtual std::expected<void, FsError> checkNameUnique(
         inode_index_t directory, const char* name) override;
 
     [[nodiscard]] virtual std::expected<inode_index_t, FsError> getInodeByName(
         inode_index_t directory, const char* name) override;
+
+    /** Number of name lookups answered by the dentry cache */
+    size_t dentryHits() const;
+    /** Number of name lookups that had to read the directory */
+    size_t dentryMisses() const;
 };
\ No newline at end of file
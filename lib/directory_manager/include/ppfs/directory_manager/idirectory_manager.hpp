@@ -43,11 +43,11 @@ struct IDirectoryManager {
      * does not free inode.
      *
      * @param directory directory to remove entry from
-     * @param entry inode of entry to be removed
+     * @param name name of entry to be removed
      * @return void on success, error otherwise
      */
     [[nodiscard]] virtual std::expected<void, FsError> removeEntry(
-        inode_index_t directory, inode_index_t entry)
+        inode_index_t directory, const char* name)
         = 0;
 
     /**
@@ -0,0 +1,135 @@
+#include "ppfs/directory_manager/dentry_cache.hpp"
+#include <cstring>
+
+DentryCache::DentryCache() { (void)_mutex.init(); }
+
+DentryCache::CacheEntry* DentryCache::_find(
+    inode_index_t parent, std::uint32_t hash, const char* name)
+{
+    for (auto& entry : _cache) {
+        if (entry.valid && entry.hash == hash && entry.parent == parent
+            && std::strcmp(entry.name.data(), name) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+DentryCache::CacheEntry& DentryCache::_allocate()
+{
+    for (auto& entry : _cache) {
+        if (!entry.valid) {
+            return entry;
+        }
+    }
+    // Nothing is pinned, so a victim is found within two rounds
+    while (true) {
+        auto& entry = _cache[_clock_hand];
+        _clock_hand = (_clock_hand + 1) % ENTRIES;
+        if (!entry.referenced) {
+            return entry;
+        }
+        entry.referenced = false;
+    }
+}
+
+std::optional<std::expected<inode_index_t, FsError>> DentryCache::lookup(
+    inode_index_t parent, const char* name)
+{
+    auto hash = hashEntryName(name);
+    std::optional<std::expected<inode_index_t, FsError>> result;
+    if (!_mutex.lock().has_value()) {
+        return result;
+    }
+    auto entry = _find(parent, hash, name);
+    if (entry == nullptr) {
+        _misses++;
+    } else {
+        _hits++;
+        entry->referenced = true;
+        if (entry->exists) {
+            result = entry->inode;
+        } else {
+            result = std::unexpected(FsError::PpFS_NotFound);
+        }
+    }
+    (void)_mutex.unlock();
+    return result;
+}
+
+void DentryCache::insert(
+    inode_index_t parent, const char* name, std::optional<inode_index_t> inode)
+{
+    size_t length = strnlen(name, sizeof(CacheEntry::name));
+    if (length == sizeof(CacheEntry::name)) {
+        return;
+    }
+    auto hash = hashEntryName(name);
+    if (!_mutex.lock().has_value()) {
+        return;
+    }
+    auto entry = _find(parent, hash, name);
+    if (entry == nullptr) {
+        entry = &_allocate();
+    }
+    *entry = CacheEntry {
+        .parent = parent,
+        .hash = hash,
+        .valid = true,
+        .referenced = true,
+        .exists = inode.has_value(),
+        .inode = inode.value_or(0),
+        .name = {},
+    };
+    std::memcpy(entry->name.data(), name, length + 1);
+    (void)_mutex.unlock();
+}
+
+void DentryCache::forget(inode_index_t parent, const char* name)
+{
+    auto hash = hashEntryName(name);
+    if (!_mutex.lock().has_value()) {
+        return;
+    }
+    if (auto entry = _find(parent, hash, name); entry != nullptr) {
+        *entry = CacheEntry {};
+    }
+    (void)_mutex.unlock();
+}
+
+void DentryCache::forgetInode(inode_index_t parent, inode_index_t inode)
+{
+    if (!_mutex.lock().has_value()) {
+        return;
+    }
+    for (auto& entry : _cache) {
+        if (!entry.valid) {
+            continue;
+        }
+        if ((entry.parent == parent && entry.exists && entry.inode == inode)
+            || entry.parent == inode) {
+            entry = CacheEntry {};
+        }
+    }
+    (void)_mutex.unlock();
+}
+
+size_t DentryCache::hits() const
+{
+    if (!_mutex.lock().has_value()) {
+        return 0;
+    }
+    size_t hits = _hits;
+    (void)_mutex.unlock();
+    return hits;
+}
+
+size_t DentryCache::misses() const
+{
+    if (!_mutex.lock().has_value()) {
+        return 0;
+    }
+    size_t misses = _misses;
+    (void)_mutex.unlock();
+    return misses;
+}
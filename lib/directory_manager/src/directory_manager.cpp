@@ -1,16 +1,26 @@
 #include "ppfs/directory_manager/directory_manager.hpp"
 #include "ppfs/blockdevice/iblock_device.hpp"
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <cstring>
+#include <numeric>
 
 // number of entries we read in one batch to find given entry
 #define ENTRY_BATCH_SIZE 256
+// number of slots a new index starts with
+#define MIN_INDEX_CAPACITY 64
+// number of slots of an index built at once
+#define INDEX_BUILD_SLOTS 1024
+// number of slots whose probe may run from one built part of an index into the next
+#define INDEX_BUILD_CARRY 64
 
 DirectoryManager::DirectoryManager(
-    IBlockDevice& block_device, IInodeManager& inode_manager, FileIO& file_io)
+    IBlockDevice& block_device, IInodeManager& inode_manager, FileIO& file_io, bool use_index)
     : _block_device(block_device)
     , _inode_manager(inode_manager)
     , _file_io(file_io)
+    , _use_index(use_index)
 {
 }
 
@@ -24,39 +34,98 @@ DirectoryManager::DirectoryManager(
 
     Inode dir_inode = inode_result.value();
 
+    // Hidden index reference is skipped
+    size_t first = dir_inode.hashed_index ? 1 : 0;
     size_t size = elements;
     if (elements == 0) {
         size_t max_entries = dir_inode.file_size / sizeof(DirectoryEntry);
-        size = max_entries - offset;
+        size = max_entries - first - offset;
     }
 
-    return _readDirectoryData(inode, dir_inode, buf, offset, size);
+    return _readDirectoryData(inode, dir_inode, buf, offset + first, size);
 }
 
 std::expected<void, FsError> DirectoryManager::addEntry(
     inode_index_t directory, DirectoryEntry entry)
+{
+    auto add_res = _addEntry(directory, entry);
+    if (!add_res.has_value()) {
+        _dentries.forget(directory, entry.name.data());
+        return std::unexpected(add_res.error());
+    }
+    _dentries.insert(directory, entry.name.data(), entry.inode);
+    return {};
+}
+
+std::expected<void, FsError> DirectoryManager::_addEntry(
+    inode_index_t directory, const DirectoryEntry& entry)
 {
     auto inode_result = _getDirectoryInode(directory);
     if (!inode_result.has_value()) {
         return std::unexpected(inode_result.error());
     }
     Inode dir_inode = inode_result.value();
+    size_t position = dir_inode.file_size / sizeof(DirectoryEntry);
 
-    std::array<uint8_t, sizeof(DirectoryEntry)> entry_buffer;
-    std::memcpy(entry_buffer.data(), &entry, sizeof(DirectoryEntry));
-    static_vector<uint8_t> entry_data(
-        entry_buffer.data(), sizeof(DirectoryEntry), sizeof(DirectoryEntry));
-    auto write_res = _file_io.writeFile(directory, dir_inode, dir_inode.file_size, entry_data);
+    if (!dir_inode.hashed_index) {
+        auto write_res = _writeEntry(directory, dir_inode, position, entry);
+        if (!write_res.has_value()) {
+            return std::unexpected(write_res.error());
+        }
+        if (_use_index && position + 1 >= INDEX_MIN_ENTRIES) {
+            return _enableIndex(directory, dir_inode);
+        }
+        return {};
+    }
 
+    auto index_res = _getIndex(directory, dir_inode);
+    if (!index_res.has_value()) {
+        return std::unexpected(index_res.error());
+    }
+    inode_index_t index = index_res.value();
+    auto index_inode_res = _inode_manager.get(index);
+    if (!index_inode_res.has_value()) {
+        return std::unexpected(index_inode_res.error());
+    }
+    Inode index_inode = index_inode_res.value();
+
+    // Table is kept at most half full, so that probe sequences stay short
+    size_t capacity = index_inode.file_size / sizeof(IndexSlot);
+    if (2 * position > capacity) {
+        auto build_res = _buildIndex(directory, dir_inode, 2 * capacity);
+        if (!build_res.has_value()) {
+            return std::unexpected(build_res.error());
+        }
+        DirectoryEntry reference { .inode = build_res.value(), .name = {} };
+        auto reference_res = _writeEntry(directory, dir_inode, 0, reference);
+        if (!reference_res.has_value()) {
+            (void)_removeIndex(build_res.value());
+            return std::unexpected(reference_res.error());
+        }
+        (void)_removeIndex(index);
+        index = build_res.value();
+        index_inode_res = _inode_manager.get(index);
+        if (!index_inode_res.has_value()) {
+            return std::unexpected(index_inode_res.error());
+        }
+        index_inode = index_inode_res.value();
+    }
+
+    auto write_res = _writeEntry(directory, dir_inode, position, entry);
     if (!write_res.has_value()) {
         return std::unexpected(write_res.error());
     }
-    return {};
+    return _insertSlot(index, index_inode,
+        IndexSlot { .hash = hashEntryName(entry.name.data()),
+            .position = static_cast<std::uint32_t>(position) });
 }
 
 std::expected<void, FsError> DirectoryManager::removeEntry(
-    inode_index_t directory, inode_index_t entry)
+    inode_index_t directory, const char* name)
 {
+    // Dropped up front, a failed removal may leave the directory in any state
+    _dentries.forget(directory, name);
+
     auto inode_result = _getDirectoryInode(directory);
     if (!inode_result.has_value()) {
         return std::unexpected(inode_result.error());
@@ -64,32 +133,16 @@ std::expected<void, FsError> DirectoryManager::removeEntry(
 
     Inode dir_inode = inode_result.value();
 
-    size_t num_entries = dir_inode.file_size / sizeof(DirectoryEntry);
-    size_t checked = 0;
-    std::optional<std::pair<size_t, DirectoryEntry>> found_entry;
-
-    while (checked < num_entries) {
-        std::array<DirectoryEntry, ENTRY_BATCH_SIZE> entries_buffer;
-        static_vector<DirectoryEntry> entries(entries_buffer.data(), entries_buffer.size());
-        auto read_res
-            = _readDirectoryData(directory, dir_inode, entries, checked, ENTRY_BATCH_SIZE);
-        if (!read_res.has_value())
-            return std::unexpected(read_res.error());
-
-        found_entry = _findEntryByInode(entries, entry);
-
-        if (found_entry.has_value()) {
-            found_entry.value().first += checked;
-            break;
-        }
-
-        checked += entries.size();
+    auto found_entry = _findEntry(directory, dir_inode, name);
+    if (!found_entry.has_value()) {
+        if (found_entry.error() == FsError::PpFS_NotFound)
+            return std::unexpected(FsError::DirectoryManager_NotFound);
+        return std::unexpected(found_entry.error());
     }
-
-    if (!found_entry.has_value())
-        return std::unexpected(FsError::DirectoryManager_NotFound);
+    _dentries.forgetInode(directory, found_entry.value().second.inode);
 
     auto new_dir_size = dir_inode.file_size - sizeof(DirectoryEntry);
+    std::optional<DirectoryEntry> moved_entry;
     if (found_entry.value().first * sizeof(DirectoryEntry) != new_dir_size) {
         // move last entry to deleted entry position
         size_t last_entry_index = (dir_inode.file_size / sizeof(DirectoryEntry)) - 1;
@@ -111,12 +164,18 @@ std::expected<void, FsError> DirectoryManager::removeEntry(
         if (!write_res.has_value()) {
             return std::unexpected(write_res.error());
         }
+        moved_entry = last_entry[0];
     }
     auto resize_res = _file_io.resizeFile(directory, dir_inode, new_dir_size);
     if (!resize_res.has_value()) {
         return std::unexpected(resize_res.error());
     }
-    return {};
+
+    if (!dir_inode.hashed_index) {
+        return {};
+    }
+    return _unindexEntry(directory, dir_inode, found_entry.value().second,
+        found_entry.value().first, moved_entry, new_dir_size / sizeof(DirectoryEntry));
 }
 
 std::expected<void, FsError> DirectoryManager::checkNameUnique(
@@ -134,6 +193,25 @@ std::expected<void, FsError> DirectoryManager::checkNameUnique(
 
 std::expected<inode_index_t, FsError> DirectoryManager::getInodeByName(
     inode_index_t directory, const char* name)
+{
+    if (auto cached = _dentries.lookup(directory, name); cached.has_value()) {
+        return cached.value();
+    }
+    auto lookup_res = _getInodeByName(directory, name);
+    if (lookup_res.has_value()) {
+        _dentries.insert(directory, name, lookup_res.value());
+    } else if (lookup_res.error() == FsError::PpFS_NotFound) {
+        _dentries.insert(directory, name, std::nullopt);
+    }
+    return lookup_res;
+}
+
+size_t DirectoryManager::dentryHits() const { return _dentries.hits(); }
+
+size_t DirectoryManager::dentryMisses() const { return _dentries.misses(); }
+
+std::expected<inode_index_t, FsError> DirectoryManager::_getInodeByName(
+    inode_index_t directory, const char* name)
 {
     auto inode_result = _getDirectoryInode(directory);
     if (!inode_result.has_value()) {
@@ -141,6 +219,20 @@ std::expected<inode_index_t, FsError> DirectoryManager::getInodeByName(
     }
     Inode dir_inode = inode_result.value();
 
+    auto find_res = _findEntry(directory, dir_inode, name);
+    if (!find_res.has_value()) {
+        return std::unexpected(find_res.error());
+    }
+    return find_res.value().second.inode;
+}
+
+std::expected<std::pair<size_t, DirectoryEntry>, FsError> DirectoryManager::_findEntry(
+    inode_index_t directory, Inode& dir_inode, const char* name)
+{
+    if (dir_inode.hashed_index) {
+        return _indexedLookup(directory, dir_inode, name);
+    }
+
     size_t num_entries = dir_inode.file_size / sizeof(DirectoryEntry);
     size_t checked = 0;
 
@@ -152,10 +244,12 @@ std::expected<inode_index_t, FsError> DirectoryManager::getInodeByName(
         if (!read_res.has_value())
             return std::unexpected(read_res.error());
 
-        auto unique_res = _findEntryByName(entries, name);
+        auto found_entry = _findEntryByName(entries, name);
 
-        if (unique_res.has_value())
-            return unique_res.value().second.inode;
+        if (found_entry.has_value()) {
+            found_entry.value().first += checked;
+            return found_entry.value();
+        }
 
         checked += entries.size();
     }
@@ -198,17 +292,6 @@ std::optional<std::pair<size_t, DirectoryEntry>> DirectoryManager::_findEntryByN
     return {};
 }
 
-std::optional<std::pair<size_t, DirectoryEntry>> DirectoryManager::_findEntryByInode(
-    const static_vector<DirectoryEntry>& entries, inode_index_t inode)
-{
-    for (size_t i = 0; i < entries.size(); ++i) {
-        if (entries[i].inode == inode) {
-            return std::make_pair(i, entries[i]);
-        }
-    }
-    return {};
-}
-
 std::expected<Inode, FsError> DirectoryManager::_getDirectoryInode(inode_index_t inode_index)
 {
     auto inode_result = _inode_manager.get(inode_index);
@@ -221,3 +304,481 @@ std::expected<Inode, FsError> DirectoryManager::_getDirectoryInode(inode_index_t
 
     return *inode_result;
 }
+
+std::expected<void, FsError> DirectoryManager::_writeEntry(
+    inode_index_t directory, Inode& dir_inode, size_t position, const DirectoryEntry& entry)
+{
+    std::array<uint8_t, sizeof(DirectoryEntry)> entry_buffer;
+    std::memcpy(entry_buffer.data(), &entry, sizeof(DirectoryEntry));
+    static_vector<uint8_t> entry_data(
+        entry_buffer.data(), sizeof(DirectoryEntry), sizeof(DirectoryEntry));
+    auto write_res
+        = _file_io.writeFile(directory, dir_inode, position * sizeof(DirectoryEntry), entry_data);
+    if (!write_res.has_value()) {
+        return std::unexpected(write_res.error());
+    }
+    return {};
+}
+
+std::expected<inode_index_t, FsError> DirectoryManager::_getIndex(
+    inode_index_t directory, Inode& dir_inode)
+{
+    std::array<DirectoryEntry, 1> reference_buffer;
+    static_vector<DirectoryEntry> reference(reference_buffer.data(), 1);
+    auto read_res = _readDirectoryData(directory, dir_inode, reference, 0, 1);
+    if (!read_res.has_value()) {
+        return std::unexpected(read_res.error());
+    }
+    if (reference.size() != 1 || reference[0].name[0] != '\0') {
+        return std::unexpected(FsError::DirectoryManager_InvalidRequest);
+    }
+    return reference[0].inode;
+}
+
+std::expected<DirectoryManager::IndexSlot, FsError> DirectoryManager::_readSlot(
+    inode_index_t index, Inode& index_inode, size_t slot)
+{
+    IndexSlot value;
+    static_vector<uint8_t> data(reinterpret_cast<uint8_t*>(&value), sizeof(IndexSlot));
+    auto read_res = _file_io.readFile(
+        index, index_inode, slot * sizeof(IndexSlot), sizeof(IndexSlot), data);
+    if (!read_res.has_value()) {
+        return std::unexpected(read_res.error());
+    }
+    return value;
+}
+
+std::expected<void, FsError> DirectoryManager::_writeSlot(
+    inode_index_t index, Inode& index_inode, size_t slot, IndexSlot value)
+{
+    static_vector<uint8_t> data(
+        reinterpret_cast<uint8_t*>(&value), sizeof(IndexSlot), sizeof(IndexSlot));
+    auto write_res = _file_io.writeFile(index, index_inode, slot * sizeof(IndexSlot), data);
+    if (!write_res.has_value()) {
+        return std::unexpected(write_res.error());
+    }
+    return {};
+}
+
+std::expected<void, FsError> DirectoryManager::_insertSlot(
+    inode_index_t index, Inode& index_inode, IndexSlot value)
+{
+    size_t capacity = index_inode.file_size / sizeof(IndexSlot);
+    size_t slot = value.hash & (capacity - 1);
+    for (size_t probe = 0; probe < capacity; probe++) {
+        auto slot_res = _readSlot(index, index_inode, slot);
+        if (!slot_res.has_value()) {
+            return std::unexpected(slot_res.error());
+        }
+        if (slot_res.value().position == 0) {
+            return _writeSlot(index, index_inode, slot, value);
+        }
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return std::unexpected(FsError::DirectoryManager_InvalidRequest);
+}
+
+std::expected<size_t, FsError> DirectoryManager::_findSlot(
+    inode_index_t index, Inode& index_inode, std::uint32_t hash, std::uint32_t position)
+{
+    size_t capacity = index_inode.file_size / sizeof(IndexSlot);
+    size_t slot = hash & (capacity - 1);
+    for (size_t probe = 0; probe < capacity; probe++) {
+        auto slot_res = _readSlot(index, index_inode, slot);
+        if (!slot_res.has_value()) {
+            return std::unexpected(slot_res.error());
+        }
+        if (slot_res.value().position == position) {
+            return slot;
+        }
+        if (slot_res.value().position == 0) {
+            break;
+        }
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return std::unexpected(FsError::DirectoryManager_NotFound);
+}
+
+std::expected<void, FsError> DirectoryManager::_eraseSlot(
+    inode_index_t index, Inode& index_inode, size_t slot)
+{
+    size_t capacity = index_inode.file_size / sizeof(IndexSlot);
+    size_t next = slot;
+    while (true) {
+        next = (next + 1) & (capacity - 1);
+        auto next_res = _readSlot(index, index_inode, next);
+        if (!next_res.has_value()) {
+            return std::unexpected(next_res.error());
+        }
+        if (next_res.value().position == 0) {
+            break;
+        }
+        // Slot stays if its home lies cyclically between the hole and itself
+        size_t home = next_res.value().hash & (capacity - 1);
+        bool stays = slot <= next ? (slot < home && home <= next) : (slot < home || home <= next);
+        if (stays) {
+            continue;
+        }
+        auto move_res = _writeSlot(index, index_inode, slot, next_res.value());
+        if (!move_res.has_value()) {
+            return std::unexpected(move_res.error());
+        }
+        slot = next;
+    }
+    return _writeSlot(index, index_inode, slot, IndexSlot { .hash = 0, .position = 0 });
+}
+
+size_t DirectoryManager::_indexPartSlots()
+{
+    size_t block_slots
+        = std::lcm(_block_device.dataSize(), sizeof(IndexSlot)) / sizeof(IndexSlot);
+    if (block_slots > INDEX_BUILD_SLOTS) {
+        return INDEX_BUILD_SLOTS;
+    }
+    return INDEX_BUILD_SLOTS / block_slots * block_slots;
+}
+
+std::expected<void, FsError> DirectoryManager::_readEntrySlots(
+    inode_index_t directory, Inode& dir_inode, size_t first, static_vector<IndexSlot>& slots)
+{
+    slots.resize(0);
+    // Entry 0 is the reference to the index, it has no slot
+    size_t position = first + 1;
+    while (slots.size() < slots.capacity()) {
+        std::array<DirectoryEntry, ENTRY_BATCH_SIZE> entries_buffer;
+        static_vector<DirectoryEntry> entries(entries_buffer.data(), entries_buffer.size());
+        auto read_res = _readDirectoryData(directory, dir_inode, entries, position,
+            std::min<size_t>(ENTRY_BATCH_SIZE, slots.capacity() - slots.size()));
+        if (!read_res.has_value()) {
+            return std::unexpected(read_res.error());
+        }
+        if (entries.size() == 0) {
+            break;
+        }
+        for (size_t i = 0; i < entries.size(); i++) {
+            (void)slots.push_back(IndexSlot { .hash = hashEntryName(entries[i].name.data()),
+                .position = static_cast<std::uint32_t>(position + i) });
+        }
+        position += entries.size();
+    }
+    return {};
+}
+
+std::expected<void, FsError> DirectoryManager::_collectSlots(
+    inode_index_t directory, Inode& dir_inode, inode_index_t file, Inode& file_inode)
+{
+    std::array<IndexSlot, INDEX_BUILD_SLOTS> slots_buffer;
+    for (size_t first = 0;;) {
+        static_vector<IndexSlot> slots(slots_buffer.data(), _indexPartSlots());
+        auto read_res = _readEntrySlots(directory, dir_inode, first, slots);
+        if (!read_res.has_value()) {
+            return std::unexpected(read_res.error());
+        }
+        if (slots.size() == 0) {
+            return {};
+        }
+        size_t bytes = slots.size() * sizeof(IndexSlot);
+        static_vector<uint8_t> data(reinterpret_cast<uint8_t*>(slots.data()), bytes, bytes);
+        auto write_res = _file_io.writeFile(file, file_inode, first * sizeof(IndexSlot), data);
+        if (!write_res.has_value()) {
+            return std::unexpected(write_res.error());
+        }
+        first += slots.size();
+    }
+}
+
+template <typename ReadSlots>
+std::expected<void, FsError> DirectoryManager::_fillIndex(
+    inode_index_t index, Inode& index_inode, size_t capacity, ReadSlots&& read_slots)
+{
+    std::array<IndexSlot, INDEX_BUILD_SLOTS> table;
+    std::array<IndexSlot, INDEX_BUILD_SLOTS> slots_buffer;
+    // Slots whose probe ran past the end of the previous part
+    std::array<IndexSlot, INDEX_BUILD_CARRY> carry;
+    size_t num_carried = 0;
+    bool dropped = false;
+
+    size_t part = _indexPartSlots();
+    for (size_t start = 0; start < capacity; start += part) {
+        size_t size = std::min(part, capacity - start);
+        std::fill_n(table.begin(), size, IndexSlot { .hash = 0, .position = 0 });
+        std::array<IndexSlot, INDEX_BUILD_CARRY> next_carry;
+        size_t num_next_carried = 0;
+        auto place = [&](IndexSlot value, size_t slot) {
+            for (; slot < size; slot++) {
+                if (table[slot].position == 0) {
+                    table[slot] = value;
+                    return;
+                }
+            }
+            if (num_next_carried < INDEX_BUILD_CARRY) {
+                next_carry[num_next_carried++] = value;
+            } else {
+                dropped = true;
+            }
+        };
+
+        for (size_t i = 0; i < num_carried; i++) {
+            place(carry[i], 0);
+        }
+        for (size_t first = 0;;) {
+            static_vector<IndexSlot> slots(slots_buffer.data(), slots_buffer.size());
+            auto read_res = read_slots(first, slots);
+            if (!read_res.has_value()) {
+                return std::unexpected(read_res.error());
+            }
+            if (slots.size() == 0) {
+                break;
+            }
+            for (size_t i = 0; i < slots.size(); i++) {
+                size_t home = slots[i].hash & (capacity - 1);
+                if (start <= home && home < start + size) {
+                    place(slots[i], home - start);
+                }
+            }
+            first += slots.size();
+        }
+
+        size_t bytes = size * sizeof(IndexSlot);
+        static_vector<uint8_t> data(reinterpret_cast<uint8_t*>(table.data()), bytes, bytes);
+        auto write_res = _file_io.writeFile(index, index_inode, start * sizeof(IndexSlot), data);
+        if (!write_res.has_value()) {
+            return std::unexpected(write_res.error());
+        }
+        std::copy_n(next_carry.begin(), num_next_carried, carry.begin());
+        num_carried = num_next_carried;
+    }
+
+    // Probes running past the last slot continue at the start of the table
+    for (size_t i = 0; i < num_carried; i++) {
+        auto insert_res = _insertSlot(index, index_inode, carry[i]);
+        if (!insert_res.has_value()) {
+            return std::unexpected(insert_res.error());
+        }
+    }
+    if (!dropped) {
+        return {};
+    }
+
+    // Too many equal hashes to carry between parts, missing slots are inserted one by one
+    for (size_t first = 0;;) {
+        static_vector<IndexSlot> slots(slots_buffer.data(), slots_buffer.size());
+        auto read_res = read_slots(first, slots);
+        if (!read_res.has_value()) {
+            return std::unexpected(read_res.error());
+        }
+        if (slots.size() == 0) {
+            return {};
+        }
+        for (size_t i = 0; i < slots.size(); i++) {
+            auto find_res = _findSlot(index, index_inode, slots[i].hash, slots[i].position);
+            if (find_res.has_value()) {
+                continue;
+            }
+            if (find_res.error() != FsError::DirectoryManager_NotFound) {
+                return std::unexpected(find_res.error());
+            }
+            auto insert_res = _insertSlot(index, index_inode, slots[i]);
+            if (!insert_res.has_value()) {
+                return std::unexpected(insert_res.error());
+            }
+        }
+        first += slots.size();
+    }
+}
+
+std::expected<inode_index_t, FsError> DirectoryManager::_buildIndex(
+    inode_index_t directory, Inode& dir_inode, size_t capacity)
+{
+    Inode index_inode {};
+    index_inode.type = InodeType::File;
+    auto create_res = _inode_manager.create(index_inode);
+    if (!create_res.has_value()) {
+        return std::unexpected(create_res.error());
+    }
+    inode_index_t index = create_res.value();
+
+    auto build = [&]() -> std::expected<void, FsError> {
+        auto read_entries = [&](size_t first, static_vector<IndexSlot>& slots) {
+            return _readEntrySlots(directory, dir_inode, first, slots);
+        };
+        if (capacity <= _indexPartSlots()) {
+            return _fillIndex(index, index_inode, capacity, read_entries);
+        }
+
+        // Every part of the table goes through slots of all entries, so they are first collected
+        // in a temporary file, which is much smaller than the directory
+        Inode slots_inode {};
+        slots_inode.type = InodeType::File;
+        auto slots_res = _inode_manager.create(slots_inode);
+        if (!slots_res.has_value()) {
+            return std::unexpected(slots_res.error());
+        }
+        inode_index_t slots_file = slots_res.value();
+        auto read_collected = [&](size_t first, static_vector<IndexSlot>& slots)
+            -> std::expected<void, FsError> {
+            size_t count = std::min(
+                slots.capacity(), slots_inode.file_size / sizeof(IndexSlot) - first);
+            slots.resize(count);
+            if (count == 0) {
+                return {};
+            }
+            static_vector<uint8_t> data(
+                reinterpret_cast<uint8_t*>(slots.data()), count * sizeof(IndexSlot));
+            return _file_io.readFile(slots_file, slots_inode, first * sizeof(IndexSlot),
+                count * sizeof(IndexSlot), data);
+        };
+        auto fill_res = _collectSlots(directory, dir_inode, slots_file, slots_inode);
+        if (fill_res.has_value()) {
+            fill_res = _fillIndex(index, index_inode, capacity, read_collected);
+        }
+        (void)_removeIndex(slots_file);
+        return fill_res;
+    };
+
+    auto build_res = build();
+    if (!build_res.has_value()) {
+        (void)_removeIndex(index);
+        return std::unexpected(build_res.error());
+    }
+    return index;
+}
+
+std::expected<void, FsError> DirectoryManager::_removeIndex(inode_index_t index)
+{
+    auto index_inode_res = _inode_manager.get(index);
+    if (!index_inode_res.has_value()) {
+        return std::unexpected(index_inode_res.error());
+    }
+    Inode index_inode = index_inode_res.value();
+    auto resize_res = _file_io.resizeFile(index, index_inode, 0);
+    if (!resize_res.has_value()) {
+        return std::unexpected(resize_res.error());
+    }
+    return _inode_manager.remove(index);
+}
+
+std::expected<void, FsError> DirectoryManager::_enableIndex(
+    inode_index_t directory, Inode& dir_inode)
+{
+    std::array<DirectoryEntry, 1> first_buffer;
+    static_vector<DirectoryEntry> first(first_buffer.data(), 1);
+    auto read_res = _readDirectoryData(directory, dir_inode, first, 0, 1);
+    if (!read_res.has_value()) {
+        return std::unexpected(read_res.error());
+    }
+    size_t num_entries = dir_inode.file_size / sizeof(DirectoryEntry);
+    auto move_res = _writeEntry(directory, dir_inode, num_entries, first[0]);
+    if (!move_res.has_value()) {
+        return std::unexpected(move_res.error());
+    }
+
+    auto build_res = _buildIndex(directory, dir_inode,
+        std::max<size_t>(MIN_INDEX_CAPACITY, std::bit_ceil(2 * num_entries)));
+    if (!build_res.has_value()) {
+        // Directory stays unindexed, first entry is there twice until the copy is cut off
+        (void)_file_io.resizeFile(directory, dir_inode, num_entries * sizeof(DirectoryEntry));
+        return std::unexpected(build_res.error());
+    }
+
+    DirectoryEntry reference { .inode = build_res.value(), .name = {} };
+    auto reference_res = _writeEntry(directory, dir_inode, 0, reference);
+    if (!reference_res.has_value()) {
+        (void)_removeIndex(build_res.value());
+        return std::unexpected(reference_res.error());
+    }
+    dir_inode.hashed_index = true;
+    return _inode_manager.update(directory, dir_inode);
+}
+
+std::expected<std::pair<size_t, DirectoryEntry>, FsError> DirectoryManager::_indexedLookup(
+    inode_index_t directory, Inode& dir_inode, const char* name)
+{
+    auto index_res = _getIndex(directory, dir_inode);
+    if (!index_res.has_value()) {
+        return std::unexpected(index_res.error());
+    }
+    auto index_inode_res = _inode_manager.get(index_res.value());
+    if (!index_inode_res.has_value()) {
+        return std::unexpected(index_inode_res.error());
+    }
+    Inode index_inode = index_inode_res.value();
+
+    std::uint32_t hash = hashEntryName(name);
+    size_t capacity = index_inode.file_size / sizeof(IndexSlot);
+    size_t slot = hash & (capacity - 1);
+    for (size_t probe = 0; probe < capacity; probe++) {
+        auto slot_res = _readSlot(index_res.value(), index_inode, slot);
+        if (!slot_res.has_value()) {
+            return std::unexpected(slot_res.error());
+        }
+        if (slot_res.value().position == 0) {
+            break;
+        }
+        if (slot_res.value().hash == hash) {
+            std::array<DirectoryEntry, 1> entry_buffer;
+            static_vector<DirectoryEntry> entry(entry_buffer.data(), 1);
+            auto read_res
+                = _readDirectoryData(directory, dir_inode, entry, slot_res.value().position, 1);
+            if (!read_res.has_value()) {
+                return std::unexpected(read_res.error());
+            }
+            if (_findEntryByName(entry, name).has_value()) {
+                return std::make_pair(size_t { slot_res.value().position }, entry[0]);
+            }
+        }
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return std::unexpected(FsError::PpFS_NotFound);
+}
+
+std::expected<void, FsError> DirectoryManager::_unindexEntry(inode_index_t directory,
+    Inode& dir_inode, const DirectoryEntry& removed, std::uint32_t position,
+    const std::optional<DirectoryEntry>& moved, std::uint32_t moved_from)
+{
+    auto index_res = _getIndex(directory, dir_inode);
+    if (!index_res.has_value()) {
+        return std::unexpected(index_res.error());
+    }
+    inode_index_t index = index_res.value();
+
+    // Only the hidden reference is left, so the index goes away
+    if (dir_inode.file_size == sizeof(DirectoryEntry)) {
+        auto remove_res = _removeIndex(index);
+        if (!remove_res.has_value()) {
+            return std::unexpected(remove_res.error());
+        }
+        auto resize_res = _file_io.resizeFile(directory, dir_inode, 0);
+        if (!resize_res.has_value()) {
+            return std::unexpected(resize_res.error());
+        }
+        dir_inode.hashed_index = false;
+        return _inode_manager.update(directory, dir_inode);
+    }
+
+    auto index_inode_res = _inode_manager.get(index);
+    if (!index_inode_res.has_value()) {
+        return std::unexpected(index_inode_res.error());
+    }
+    Inode index_inode = index_inode_res.value();
+
+    auto slot_res = _findSlot(index, index_inode, hashEntryName(removed.name.data()), position);
+    if (!slot_res.has_value()) {
+        return std::unexpected(slot_res.error());
+    }
+    auto erase_res = _eraseSlot(index, index_inode, slot_res.value());
+    if (!erase_res.has_value()) {
+        return std::unexpected(erase_res.error());
+    }
+
+    if (!moved.has_value()) {
+        return {};
+    }
+    std::uint32_t moved_hash = hashEntryName(moved->name.data());
+    auto moved_slot_res = _findSlot(index, index_inode, moved_hash, moved_from);
+    if (!moved_slot_res.has_value()) {
+        return std::unexpected(moved_slot_res.error());
+    }
+    return _writeSlot(index, index_inode, moved_slot_res.value(),
+        IndexSlot { .hash = moved_hash, .position = position });
+}
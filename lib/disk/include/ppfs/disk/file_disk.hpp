@@ -1,19 +1,29 @@
 #pragma once
 
+#include "ppfs/common/ppfs_mutex.hpp"
 #include "ppfs/disk/idisk.hpp"
 
 #include <cstddef>
 #include <cstdint>
-#include <fstream>
+#include <string_view>
 
 /**
  * File-backed disk implementation.
  *
  * Implements the IDisk interface using a binary file as the underlying
- * storage medium.
+ * storage medium. Every access is a single positional pread/pwrite on the
+ * file descriptor, there is no shared file position, so one disk can be used
+ * from many threads at once.
+ *
+ * In direct mode the file is opened with O_DIRECT and bypasses the host page
+ * cache. Requests are then transferred through stack bounce buffers aligned to
+ * DIRECT_ALIGNMENT, unaligned writes read the surrounding pages first.
  */
 class FileDisk : public IDisk {
 public:
+    /** Alignment of offsets, lengths and buffers required by O_DIRECT */
+    static constexpr size_t DIRECT_ALIGNMENT = 4096;
+
     /**
      * Constructs an unopened file disk.
      *
@@ -27,6 +37,9 @@ public:
      */
     ~FileDisk() override;
 
+    FileDisk(const FileDisk&) = delete;
+    FileDisk& operator=(const FileDisk&) = delete;
+
     /**
      * Opens an existing file and treats it as a disk.
      *
@@ -34,9 +47,10 @@ public:
      * The disk size is inferred from the current file size.
      *
      * @param path Path to an existing file.
+     * @param direct Bypass the page cache, file size has to be a multiple of DIRECT_ALIGNMENT.
      * @return Empty on success, FsError on failure.
      */
-    std::expected<void, FsError> open(std::string_view path);
+    std::expected<void, FsError> open(std::string_view path, bool direct = false);
 
     /**
      * Creates a new file-backed disk with a fixed size.
@@ -45,9 +59,10 @@ public:
      *
      * @param path Path to the file to create.
      * @param size Size of the disk in bytes.
+     * @param direct Bypass the page cache, size has to be a multiple of DIRECT_ALIGNMENT.
      * @return Empty on success, FsError on failure.s
      */
-    std::expected<void, FsError> create(std::string_view path, size_t size);
+    std::expected<void, FsError> create(std::string_view path, size_t size, bool direct = false);
 
     /**
      * Returns the total size of the disk in bytes.
@@ -62,7 +77,22 @@ public:
     [[nodiscard]] std::expected<size_t, FsError> write(
         size_t address, const static_vector<uint8_t>& data) override;
 
+    /**
+     * Writes file data back to the storage with fdatasync.
+     */
+    [[nodiscard]] std::expected<void, FsError> flush() override;
+
 private:
-    std::fstream _file;
+    int _fd = -1;
     size_t _size = 0;
+    bool _direct = false;
+
+    /** Serializes direct writes, unaligned ones read and rewrite whole pages */
+    PpFSMutex _directWriteMutex;
+
+    void _close();
+    [[nodiscard]] std::expected<void, FsError> _directRead(
+        size_t address, size_t size, std::uint8_t* data);
+    [[nodiscard]] std::expected<void, FsError> _directWrite(
+        size_t address, size_t size, const std::uint8_t* data);
 };
@@ -16,4 +16,11 @@ struct IDisk {
         size_t address, const static_vector<uint8_t>& data)
         = 0;
     virtual size_t size() = 0;
+
+    /**
+     * Makes completed writes durable on the backing storage.
+     *
+     * Disks without volatile state (memory disks) have nothing to do.
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> flush() { return {}; }
 };
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "ppfs/disk/idisk.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Access pattern hint passed to madvise for the whole mapping.
+ */
+enum class MmapAdvice : std::uint8_t {
+    Normal, ///< No hint, kernel default readahead
+    Random, ///< Blocks are accessed in random order, readahead is disabled
+    Sequential, ///< Image is read front to back, aggressive readahead
+};
+
+/**
+ * Mapping options of MmapDisk.
+ */
+struct MmapOptions {
+    /** Fault in the whole image when mapping it (MAP_POPULATE) */
+    bool populate = false;
+
+    /** Access pattern hint */
+    MmapAdvice advice = MmapAdvice::Normal;
+
+    /** Synchronously write modified pages back after every write */
+    bool sync_writes = false;
+};
+
+/**
+ * Memory-mapped file disk implementation.
+ *
+ * Maps the whole image file shared and read-write, reads and writes are plain copies from and
+ * to the mapping without syscalls or stream buffers. Modified pages are written back by the
+ * kernel at its own pace, flush() forces them to the file. Accessing the disk after the image
+ * was truncated by someone else raises SIGBUS.
+ */
+class MmapDisk : public IDisk {
+public:
+    /**
+     * Constructs an unmapped disk.
+     *
+     * No file is associated with the disk until open() or create() is successfully called.
+     */
+    MmapDisk();
+
+    /**
+     * Writes back modified pages, unmaps and closes the file.
+     */
+    ~MmapDisk() override;
+
+    MmapDisk(const MmapDisk&) = delete;
+    MmapDisk& operator=(const MmapDisk&) = delete;
+
+    /**
+     * Maps an existing file as a disk.
+     *
+     * The disk size is inferred from the current file size.
+     *
+     * @param path Path to an existing file.
+     * @param options Mapping options.
+     * @return Empty on success, FsError on failure.
+     */
+    std::expected<void, FsError> open(std::string_view path, MmapOptions options = {});
+
+    /**
+     * Creates a new zero-filled file with a fixed size and maps it.
+     *
+     * If the file already exists, it will be truncated.
+     *
+     * @param path Path to the file to create.
+     * @param size Size of the disk in bytes.
+     * @param options Mapping options.
+     * @return Empty on success, FsError on failure.
+     */
+    std::expected<void, FsError> create(
+        std::string_view path, size_t size, MmapOptions options = {});
+
+    size_t size() override;
+
+    [[nodiscard]] std::expected<void, FsError> read(
+        size_t address, size_t size, static_vector<uint8_t>& data) override;
+
+    [[nodiscard]] std::expected<size_t, FsError> write(
+        size_t address, const static_vector<uint8_t>& data) override;
+
+    /**
+     * Synchronously writes modified pages of the whole disk back to the file.
+     */
+    [[nodiscard]] std::expected<void, FsError> flush() override;
+
+    /**
+     * Synchronously writes modified pages covering the range back to the file.
+     */
+    [[nodiscard]] std::expected<void, FsError> flush(size_t address, size_t size);
+
+private:
+    int _fd = -1;
+    std::uint8_t* _data = nullptr;
+    size_t _size = 0;
+    bool _sync_writes = false;
+
+    std::expected<void, FsError> _map(int fd, size_t size, MmapOptions options);
+    void _close();
+};
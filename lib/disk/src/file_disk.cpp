@@ -1,54 +1,135 @@
 #include "ppfs/disk/file_disk.hpp"
+#include "ppfs/common/mutex_wrapper.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
 #include <cstring>
-#include <filesystem>
-#include <fstream>
+#include <string>
 
-FileDisk::FileDisk() = default;
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-FileDisk::~FileDisk()
+namespace {
+
+/** Size of the stack bounce buffer, larger direct requests are split */
+constexpr size_t BOUNCE_SIZE = 64 * 1024;
+
+bool preadAll(int fd, std::uint8_t* data, size_t size, size_t offset)
+{
+    while (size > 0) {
+        ssize_t count = ::pread(fd, data, size, static_cast<off_t>(offset));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        size -= count;
+        offset += count;
+    }
+    return true;
+}
+
+bool pwriteAll(int fd, const std::uint8_t* data, size_t size, size_t offset)
+{
+    while (size > 0) {
+        ssize_t count = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        size -= count;
+        offset += count;
+    }
+    return true;
+}
+
+size_t alignUp(size_t value)
+{
+    constexpr size_t alignment = FileDisk::DIRECT_ALIGNMENT;
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+FileDisk::FileDisk() { (void)_directWriteMutex.init(); }
+
+FileDisk::~FileDisk() { _close(); }
+
+void FileDisk::_close()
 {
-    if (_file.is_open()) {
-        _file.close();
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
     }
+    _size = 0;
 }
 
-std::expected<void, FsError> FileDisk::open(std::string_view path)
+std::expected<void, FsError> FileDisk::open(std::string_view path, bool direct)
 {
-    if (_file.is_open()) {
-        _file.close();
+    _close();
+
+    int flags = O_RDWR | O_CLOEXEC;
+#ifdef O_DIRECT
+    if (direct) {
+        flags |= O_DIRECT;
     }
+#else
+    if (direct) {
+        return std::unexpected(FsError::Disk_InvalidRequest);
+    }
+#endif
 
-    _file.open(path.data(), std::ios::binary | std::ios::in | std::ios::out);
+    int fd = ::open(std::string(path).c_str(), flags);
+    if (fd < 0) {
+        return std::unexpected(FsError::Disk_IOError);
+    }
 
-    if (!_file.is_open()) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
         return std::unexpected(FsError::Disk_IOError);
     }
+    auto size = static_cast<size_t>(st.st_size);
 
-    _file.seekg(0, std::ios::end);
-    _size = static_cast<size_t>(_file.tellg());
-    _file.seekg(0, std::ios::beg);
+    // Aligned transfers must not reach past the end of the file
+    if (direct && size % DIRECT_ALIGNMENT != 0) {
+        ::close(fd);
+        return std::unexpected(FsError::Disk_InvalidRequest);
+    }
 
+    _fd = fd;
+    _size = size;
+    _direct = direct;
     return {};
 }
 
-std::expected<void, FsError> FileDisk::create(std::string_view path, size_t size)
+std::expected<void, FsError> FileDisk::create(std::string_view path, size_t size, bool direct)
 {
-    if (_file.is_open())
+    if (_fd >= 0)
         return std::unexpected(FsError::Disk_InvalidRequest);
 
-    std::ofstream ofs(path.data(), std::ios::binary | std::ios::trunc);
-    if (!ofs.is_open()) {
+    if (direct && size % DIRECT_ALIGNMENT != 0)
+        return std::unexpected(FsError::Disk_InvalidRequest);
+
+    int fd = ::open(std::string(path).c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
         return std::unexpected(FsError::Disk_IOError);
     }
 
-    if (size > 0) {
-        ofs.seekp(size - 1);
-        ofs.put(0);
+    bool resized = ftruncate(fd, static_cast<off_t>(size)) == 0;
+    ::close(fd);
+    if (!resized) {
+        return std::unexpected(FsError::Disk_IOError);
     }
 
-    ofs.close();
-    return open(path);
+    return open(path, direct);
 }
 
 size_t FileDisk::size() { return _size; }
@@ -56,7 +137,7 @@ size_t FileDisk::size() { return _size; }
 std::expected<void, FsError> FileDisk::read(
     size_t address, size_t size, static_vector<uint8_t>& data)
 {
-    if (!_file.is_open()) {
+    if (_fd < 0) {
         return std::unexpected(FsError::Disk_IOError);
     }
 
@@ -70,10 +151,11 @@ std::expected<void, FsError> FileDisk::read(
 
     data.resize(size);
 
-    _file.seekg(address, std::ios::beg);
-    _file.read(reinterpret_cast<char*>(data.data()), size);
+    if (_direct) {
+        return _directRead(address, size, data.data());
+    }
 
-    if (!_file.good()) {
+    if (!preadAll(_fd, data.data(), size, address)) {
         return std::unexpected(FsError::Disk_IOError);
     }
 
@@ -82,7 +164,7 @@ std::expected<void, FsError> FileDisk::read(
 
 std::expected<size_t, FsError> FileDisk::write(size_t address, const static_vector<uint8_t>& data)
 {
-    if (!_file.is_open()) {
+    if (_fd < 0) {
         return std::unexpected(FsError::Disk_IOError);
     }
 
@@ -90,12 +172,83 @@ std::expected<size_t, FsError> FileDisk::write(size_t address, const static_vect
         return std::unexpected(FsError::Disk_OutOfBounds);
     }
 
-    _file.seekp(address, std::ios::beg);
-    _file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (_direct) {
+        auto write_res = _directWrite(address, data.size(), data.data());
+        if (!write_res.has_value()) {
+            return std::unexpected(write_res.error());
+        }
+        return data.size();
+    }
 
-    if (!_file.good()) {
+    if (!pwriteAll(_fd, data.data(), data.size(), address)) {
         return std::unexpected(FsError::Disk_IOError);
     }
 
     return data.size();
 }
+
+std::expected<void, FsError> FileDisk::flush()
+{
+    if (_fd < 0) {
+        return std::unexpected(FsError::Disk_IOError);
+    }
+
+    if (fdatasync(_fd) != 0) {
+        return std::unexpected(FsError::Disk_IOError);
+    }
+
+    return {};
+}
+
+std::expected<void, FsError> FileDisk::_directRead(
+    size_t address, size_t size, std::uint8_t* data)
+{
+    alignas(DIRECT_ALIGNMENT) std::array<std::uint8_t, BOUNCE_SIZE> bounce;
+
+    size_t done = 0;
+    while (done < size) {
+        size_t position = address + done;
+        size_t start = position - position % DIRECT_ALIGNMENT;
+        size_t length = std::min(BOUNCE_SIZE, alignUp(address + size) - start);
+        if (!preadAll(_fd, bounce.data(), length, start)) {
+            return std::unexpected(FsError::Disk_IOError);
+        }
+
+        size_t skip = position - start;
+        size_t chunk = std::min(length - skip, size - done);
+        std::memcpy(data + done, bounce.data() + skip, chunk);
+        done += chunk;
+    }
+    return {};
+}
+
+std::expected<void, FsError> FileDisk::_directWrite(
+    size_t address, size_t size, const std::uint8_t* data)
+{
+    alignas(DIRECT_ALIGNMENT) std::array<std::uint8_t, BOUNCE_SIZE> bounce;
+
+    // Unaligned writes rewrite neighbouring bytes, so aligned writes to the same pages must not
+    // land between their read and write back
+    return mutex_wrapper<void>(_directWriteMutex, [&]() -> std::expected<void, FsError> {
+        size_t done = 0;
+        while (done < size) {
+            size_t position = address + done;
+            size_t start = position - position % DIRECT_ALIGNMENT;
+            size_t length = std::min(BOUNCE_SIZE, alignUp(address + size) - start);
+            size_t skip = position - start;
+            size_t chunk = std::min(length - skip, size - done);
+
+            if (skip != 0 || chunk != length) {
+                if (!preadAll(_fd, bounce.data(), length, start)) {
+                    return std::unexpected(FsError::Disk_IOError);
+                }
+            }
+            std::memcpy(bounce.data() + skip, data + done, chunk);
+            if (!pwriteAll(_fd, bounce.data(), length, start)) {
+                return std::unexpected(FsError::Disk_IOError);
+            }
+            done += chunk;
+        }
+        return {};
+    });
+}
@@ -0,0 +1,175 @@
+#include "ppfs/disk/mmap_disk.hpp"
+
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MmapDisk::MmapDisk() = default;
+
+MmapDisk::~MmapDisk() { _close(); }
+
+void MmapDisk::_close()
+{
+    if (_data != nullptr) {
+        msync(_data, _size, MS_SYNC);
+        munmap(_data, _size);
+        _data = nullptr;
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+    _size = 0;
+}
+
+std::expected<void, FsError> MmapDisk::_map(int fd, size_t size, MmapOptions options)
+{
+    // Empty file can't be mapped, disk is open but every access is out of bounds
+    if (size > 0) {
+        int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+        if (options.populate) {
+            flags |= MAP_POPULATE;
+        }
+#endif
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            return std::unexpected(FsError::Disk_IOError);
+        }
+
+        // Only a hint, failure doesn't matter
+        switch (options.advice) {
+        case MmapAdvice::Random:
+            madvise(address, size, MADV_RANDOM);
+            break;
+        case MmapAdvice::Sequential:
+            madvise(address, size, MADV_SEQUENTIAL);
+            break;
+        case MmapAdvice::Normal:
+            break;
+        }
+        _data = static_cast<std::uint8_t*>(address);
+    }
+
+    _fd = fd;
+    _size = size;
+    _sync_writes = options.sync_writes;
+    return {};
+}
+
+std::expected<void, FsError> MmapDisk::open(std::string_view path, MmapOptions options)
+{
+    _close();
+
+    int fd = ::open(std::string(path).c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return std::unexpected(FsError::Disk_IOError);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return std::unexpected(FsError::Disk_IOError);
+    }
+
+    return _map(fd, static_cast<size_t>(st.st_size), options);
+}
+
+std::expected<void, FsError> MmapDisk::create(
+    std::string_view path, size_t size, MmapOptions options)
+{
+    if (_fd >= 0)
+        return std::unexpected(FsError::Disk_InvalidRequest);
+
+    int fd = ::open(std::string(path).c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return std::unexpected(FsError::Disk_IOError);
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        return std::unexpected(FsError::Disk_IOError);
+    }
+
+    return _map(fd, size, options);
+}
+
+size_t MmapDisk::size() { return _size; }
+
+std::expected<void, FsError> MmapDisk::read(
+    size_t address, size_t size, static_vector<uint8_t>& data)
+{
+    if (_fd < 0) {
+        return std::unexpected(FsError::Disk_IOError);
+    }
+
+    if (address + size > _size) {
+        return std::unexpected(FsError::Disk_OutOfBounds);
+    }
+
+    if (data.capacity() < size) {
+        return std::unexpected(FsError::Disk_InvalidRequest);
+    }
+
+    data.resize(size);
+    if (size > 0) {
+        std::memcpy(data.data(), _data + address, size);
+    }
+
+    return {};
+}
+
+std::expected<size_t, FsError> MmapDisk::write(size_t address, const static_vector<uint8_t>& data)
+{
+    if (_fd < 0) {
+        return std::unexpected(FsError::Disk_IOError);
+    }
+
+    if (address + data.size() > _size) {
+        return std::unexpected(FsError::Disk_OutOfBounds);
+    }
+
+    if (data.size() > 0) {
+        std::memcpy(_data + address, data.data(), data.size());
+    }
+
+    if (_sync_writes) {
+        auto flush_res = flush(address, data.size());
+        if (!flush_res.has_value()) {
+            return std::unexpected(flush_res.error());
+        }
+    }
+
+    return data.size();
+}
+
+std::expected<void, FsError> MmapDisk::flush() { return flush(0, _size); }
+
+std::expected<void, FsError> MmapDisk::flush(size_t address, size_t size)
+{
+    if (_fd < 0) {
+        return std::unexpected(FsError::Disk_IOError);
+    }
+
+    if (address + size > _size) {
+        return std::unexpected(FsError::Disk_OutOfBounds);
+    }
+
+    if (size == 0) {
+        return {};
+    }
+
+    // msync needs page aligned start
+    auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t start = address - address % page_size;
+    if (msync(_data + start, address + size - start, MS_SYNC) != 0) {
+        return std::unexpected(FsError::Disk_IOError);
+    }
+
+    return {};
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "ppfs/common/static_vector.hpp"
+#include "ppfs/ecc_helpers/crc_polynomial.hpp"
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Fast crc calculation for polynomials of degree up to 63
+ *
+ * Produces exactly the same check bits as dividing data followed by degree zero bits with
+ * CrcPolynomial::divide, but works on whole bytes instead of single bits. Data is processed
+ * eight bytes at a time using slicing-by-8 lookup tables, or, on x86-64 cpus supporting it,
+ * with carry-less multiplication (PCLMULQDQ) folding 64 bytes at a time.
+ *
+ * Internally remainder is kept left aligned in 64 bit register, which lets every polynomial
+ * degree share the same code.
+ */
+class CrcEngine {
+    static constexpr unsigned int SLICES = 8;
+
+    unsigned int _n;
+    /**
+     * Polynomial without leading term, shifted to be left aligned in 64 bits
+     */
+    std::uint64_t _poly;
+    std::array<std::array<std::uint64_t, 256>, SLICES> _table;
+
+    bool _use_clmul;
+    /**
+     * Folding constants x^k mod P for k = 576, 512, 192, 128 (P left aligned)
+     */
+    std::array<std::uint64_t, 4> _fold_constants;
+
+    /**
+     * Calculate x^k mod P, where P is polynomial aligned to degree 64
+     */
+    std::uint64_t _xPowMod(unsigned int k) const;
+
+    /**
+     * Advance left aligned remainder over data using lookup tables
+     */
+    std::uint64_t _updateTable(std::uint64_t reg, const std::uint8_t* data, size_t size) const;
+
+    /**
+     * Advance left aligned remainder over data using carry-less multiplication
+     */
+    std::uint64_t _updateClmul(std::uint64_t reg, const std::uint8_t* data, size_t size) const;
+
+public:
+    /**
+     * Create engine for polynomial
+     *
+     * @param polynomial crc polynomial, degree must be between 1 and 63
+     * @param allow_clmul whether carry-less multiplication may be used when cpu supports it
+     */
+    explicit CrcEngine(const CrcPolynomial& polynomial, bool allow_clmul = true);
+
+    /**
+     * Calculate check bits of data
+     *
+     * @param data bytes protected by crc
+     * @return degree check bits, right aligned, most significant bit is the first bit stored
+     */
+    std::uint64_t checkBits(const static_vector<std::uint8_t>& data) const;
+
+    unsigned int getDegree() const;
+
+    /**
+     * @return true if carry-less multiplication is used
+     */
+    bool usesClmul() const;
+};
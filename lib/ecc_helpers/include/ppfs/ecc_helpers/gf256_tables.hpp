@@ -0,0 +1,47 @@
+#pragma once
+#include "ppfs/ecc_helpers/gf256.hpp"
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Lookup tables for branch free arithmetic in GF256, used by vector-friendly RS kernels.
+ *
+ * Logarithm of zero is LOG_ZERO and exponent table is zero from that index on, so
+ * EXP[LOG[a] + LOG[b]] equals a * b for all a, b, zeros included. Exponent table repeats the
+ * powers of alpha twice, so sum of two logarithms or a logarithm plus exponent below 255 never
+ * has to be reduced.
+ */
+namespace GF256Tables {
+
+inline constexpr std::uint16_t LOG_ZERO = 510;
+
+constexpr std::array<std::uint8_t, 1024> makeExpTable()
+{
+    std::array<std::uint8_t, 1024> exp {};
+    std::uint16_t x = 1;
+    for (size_t i = 0; i < 255; i++) {
+        exp[i] = static_cast<std::uint8_t>(x);
+        exp[i + 255] = static_cast<std::uint8_t>(x);
+        x <<= 1;
+        if (x & 0x100)
+            x ^= GF256::PRIMITIVE_POLY;
+    }
+    return exp;
+}
+
+constexpr std::array<std::uint16_t, 256> makeLogTable(const std::array<std::uint8_t, 1024>& exp)
+{
+    std::array<std::uint16_t, 256> log {};
+    log[0] = LOG_ZERO;
+    for (size_t i = 0; i < 255; i++)
+        log[exp[i]] = static_cast<std::uint16_t>(i);
+    return log;
+}
+
+inline constexpr auto EXP = makeExpTable();
+inline constexpr auto LOG = makeLogTable(EXP);
+
+inline std::uint8_t mul(std::uint8_t a, std::uint8_t b) { return EXP[LOG[a] + LOG[b]]; }
+
+}
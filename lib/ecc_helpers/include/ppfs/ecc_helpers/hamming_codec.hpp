@@ -0,0 +1,78 @@
+#pragma once
+#include "ppfs/common/static_vector.hpp"
+#include "ppfs/common/types.hpp"
+
+#include <cstdint>
+#include <expected>
+#include <optional>
+
+/**
+ * Extended Hamming (SECDED) code over a whole block, processed 64 bits at a time
+ *
+ * Bits are numbered most significant first. Bit 0 is overall parity, bits at powers of two are
+ * Hamming parity bits and data bits fill the remaining indices in order. Bits after the last data
+ * bit that are not powers of two are unused and kept as they are.
+ *
+ * Block is read as big endian 64 bit words, so word w holds indices 64w..64w+63. Syndrome (xor of
+ * indices of set bits) is then built per word: index bits 6 and up come from the word number
+ * and parity of its popcount, lower six bits from popcounts of the word masked with precomputed
+ * masks of positions having that index bit set. Data bits are moved between data and block with
+ * PEXT/PDEP (BMI2) when cpu supports them, or with a portable loop otherwise. Only the first word,
+ * words at power of two positions and the last data word actually need them, others are copied
+ * whole.
+ */
+class HammingCodec {
+public:
+    /**
+     * @param block_size_power raw block has 2^block_size_power bytes, at least 3
+     * @param allow_bmi2 whether PEXT/PDEP may be used when cpu supports them
+     */
+    explicit HammingCodec(int block_size_power, bool allow_bmi2 = true);
+
+    /**
+     * Check block for errors
+     *
+     * @param block raw block
+     * @return index of the single flipped bit, empty if block is correct,
+     * BlockDevice_CorrectionError if there are two errors or the
+     * syndrome points outside of the block
+     */
+    [[nodiscard]] std::expected<std::optional<unsigned int>, FsError> findError(
+        const static_vector<std::uint8_t>& block) const;
+
+    /**
+     * Extract data bits of block
+     *
+     * @param block raw block
+     * @param data output, resized to data size
+     */
+    void extract(
+        const static_vector<std::uint8_t>& block, static_vector<std::uint8_t>& data) const;
+
+    /**
+     * Place data bits into block and calculate parity bits, unused bits of block are kept
+     *
+     * @param data data size bytes
+     * @param block raw block, resized to block size
+     */
+    void encode(
+        const static_vector<std::uint8_t>& data, static_vector<std::uint8_t>& block) const;
+
+    size_t blockSize() const;
+    size_t dataSize() const;
+
+private:
+    using BitFunction = std::uint64_t (*)(std::uint64_t, std::uint64_t);
+
+    size_t _block_size;
+    size_t _data_size;
+    size_t _words;
+    unsigned int _last_data_index;
+    BitFunction _pext;
+    BitFunction _pdep;
+
+    /** Positions of data bits in word w */
+    std::uint64_t _dataMask(size_t w) const;
+    /** Positions of bits covered by the code (data, parity and bit 0) in word w */
+    std::uint64_t _usedMask(size_t w) const;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include "ppfs/common/static_vector.hpp"
+#include "ppfs/common/types.hpp"
+#include "ppfs/ecc_helpers/gf256.hpp"
+
+#include <cstdint>
+#include <expected>
+
+/**
+ * Reed-Solomon error corrector working on syndromes S_j = c(alpha^j), j = 1..2t
+ *
+ * Error locator sigma is found with Berlekamp-Massey, its roots with Chien search. The search
+ * only visits positions inside the (possibly shortened) codeword and keeps one running term
+ * sigma_i * alpha^(-i*p) per coefficient, multiplying it by constant alpha^(-i) when moving to
+ * next position. It stops as soon as deg(sigma) roots are found. Forney step reuses odd terms
+ * of the search, because sigma'(X^-1) = X * sum of odd terms, so derivative is never evaluated.
+ */
+class RsDecoder {
+public:
+    static constexpr size_t MAX_SYNDROMES = 255;
+
+    /**
+     * @param codeword_size size of codeword in bytes, at most 255
+     * @param syndrome_count number of syndromes, 2 * correctable bytes
+     */
+    RsDecoder(size_t codeword_size, size_t syndrome_count);
+
+    /**
+     * Correct codeword in place
+     *
+     * @param codeword codeword of codeword_size bytes, coefficient i is byte i
+     * @param syndromes syndromes of the codeword
+     * @return number of corrected bytes, BlockDevice_CorrectionError if there are more errors
+     * than the code can correct
+     */
+    [[nodiscard]] std::expected<size_t, FsError> correct(
+        static_vector<std::uint8_t>& codeword, const static_vector<GF256>& syndromes) const;
+
+private:
+    size_t _codeword_size;
+    size_t _syndrome_count;
+
+    /**
+     * Find error locator polynomial with Berlekamp-Massey
+     *
+     * @param sigma output coefficients, lowest degree first, must hold syndrome_count + 1 values
+     * @return degree of sigma (number of errors)
+     */
+    size_t _berlekampMassey(const static_vector<GF256>& syndromes, std::uint8_t* sigma) const;
+};
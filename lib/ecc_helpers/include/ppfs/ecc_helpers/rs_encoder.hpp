@@ -0,0 +1,66 @@
+#pragma once
+#include "ppfs/common/static_vector.hpp"
+#include "ppfs/ecc_helpers/polynomial_gf256.hpp"
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Systematic Reed-Solomon encoder
+ *
+ * Codeword coefficient i is byte i, first parity_size bytes are parity and the rest is message.
+ * Parity is the remainder of message * x^parity_size divided by generator, calculated in one
+ * pass of a linear feedback shift register. Multiplying the generator by the feedback byte is
+ * done with precomputed table of generator multiples for every low and high nibble, so one step
+ * is just xor of three rows.
+ *
+ * Because the code is linear, parity can also be updated in place when only a few message bytes
+ * change: every changed byte adds its delta times parity of a single byte at that position.
+ */
+class RsEncoder {
+public:
+    static constexpr size_t MAX_CODEWORD_SIZE = 255;
+    static constexpr size_t MAX_PARITY_SIZE = MAX_CODEWORD_SIZE - 1;
+    /** parity_size * message_size is largest when both are half of the codeword */
+    static constexpr size_t MAX_POSITION_TABLE_SIZE = MAX_CODEWORD_SIZE * MAX_CODEWORD_SIZE / 4;
+
+    /**
+     * @param generator monic generator polynomial, its degree is the number of parity bytes
+     * @param codeword_size total size of codeword (parity and message) in bytes, at most 255
+     */
+    RsEncoder(const PolynomialGF256& generator, size_t codeword_size);
+
+    /**
+     * Calculate parity of the message stored in codeword and write it to the parity bytes
+     *
+     * @param codeword buffer of codeword_size bytes, message already in place
+     */
+    void encode(static_vector<std::uint8_t>& codeword) const;
+
+    /**
+     * Write data into message part of a valid codeword and update parity from byte deltas
+     *
+     * @param codeword valid codeword of codeword_size bytes
+     * @param offset offset of data from the start of the message
+     * @param data new message bytes, trimmed to fit into message
+     * @return number of bytes written
+     */
+    size_t update(static_vector<std::uint8_t>& codeword, size_t offset,
+        const static_vector<std::uint8_t>& data) const;
+
+private:
+    size_t _parity_size;
+    size_t _message_size;
+
+    /**
+     * Rows 0-15 hold generator * v and rows 16-31 generator * (v << 4), with coefficients in
+     * reversed order to match the shift register layout
+     */
+    std::array<std::array<std::uint8_t, MAX_PARITY_SIZE + 1>, 32> _generator_table;
+
+    /**
+     * Parity of a single one at every message position, x^(parity_size + j) mod generator,
+     * parity_size coefficients per position
+     */
+    std::array<std::uint8_t, MAX_POSITION_TABLE_SIZE> _position_parity;
+};
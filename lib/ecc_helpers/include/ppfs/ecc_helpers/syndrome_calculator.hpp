@@ -0,0 +1,54 @@
+#pragma once
+#include "ppfs/common/static_vector.hpp"
+#include "ppfs/ecc_helpers/gf256.hpp"
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Calculates Reed-Solomon syndromes S_j = c(alpha^j), j = 1..count, of a codeword in one pass.
+ *
+ * Codeword is split into lanes of width W, and every lane is evaluated with Horner scheme using
+ * alpha^(j*W) as multiplier, so all lanes are multiplied by the same constant. Such
+ * multiplication is done with two 16 entry lookup tables (low and high nibble) and pshufb,
+ * 32 bytes at a time with AVX2 or 16 with SSSE3. Lanes are combined at the end. When the cpu
+ * supports neither, plain Horner scheme over GF256 is used.
+ */
+class SyndromeCalculator {
+public:
+    static constexpr size_t MAX_SYNDROMES = 255;
+    static constexpr size_t MAX_WIDTH = 32;
+
+    /**
+     * @param syndrome_count number of syndromes to calculate (2 * correctable bytes)
+     * @param allow_simd whether vector instructions may be used when cpu supports them
+     */
+    explicit SyndromeCalculator(size_t syndrome_count, bool allow_simd = true);
+
+    /**
+     * Calculate syndromes of a codeword, coefficient i being byte i
+     *
+     * @param codeword bytes of codeword, at most 255
+     * @param syndromes output, resized to syndrome count
+     * @return true if every syndrome is zero, meaning the codeword has no detectable errors
+     */
+    bool calculate(
+        const static_vector<std::uint8_t>& codeword, static_vector<GF256>& syndromes) const;
+
+    /**
+     * @return number of bytes processed by single vector instruction, 1 if scalar path is used
+     */
+    size_t width() const;
+
+private:
+    size_t _syndrome_count;
+    size_t _width;
+
+    /**
+     * Nibble multiplication tables for alpha^(j*W): 16 products of low nibble followed by 16
+     * products of high nibble
+     */
+    std::array<std::array<std::uint8_t, 32>, MAX_SYNDROMES> _tables;
+
+    void _calculateScalar(const std::uint8_t* codeword, size_t size, GF256* syndromes) const;
+};
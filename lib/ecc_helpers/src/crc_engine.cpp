@@ -0,0 +1,186 @@
+#include "ppfs/ecc_helpers/crc_engine.hpp"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#    define PPFS_CRC_CLMUL 1
+#    include <immintrin.h>
+#endif
+
+namespace {
+
+std::uint64_t loadBigEndian(const std::uint8_t* data)
+{
+    std::uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    if constexpr (std::endian::native == std::endian::little) {
+        value = std::byteswap(value);
+    }
+    return value;
+}
+
+#ifdef PPFS_CRC_CLMUL
+
+bool cpuSupportsClmul()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+}
+
+/**
+ * Load 16 bytes so that the first byte ends up as the most significant byte of the high lane
+ */
+__attribute__((target("pclmul,ssse3"))) inline __m128i loadChunk(const std::uint8_t* data)
+{
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), reverse);
+}
+
+/**
+ * Multiply high lane of x by high lane of k and low lane of x by low lane of k, then add results
+ */
+__attribute__((target("pclmul,ssse3"))) inline __m128i fold(__m128i x, __m128i k)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), _mm_clmulepi64_si128(x, k, 0x00));
+}
+
+/**
+ * Fold data into 128 bit remainder candidate. Requires at least 64 bytes of data.
+ *
+ * @param out_chunk bytes of 128 bit value congruent to reg and data, most significant first
+ * @return number of bytes consumed, multiple of 16
+ */
+__attribute__((target("pclmul,ssse3"))) size_t foldClmul(std::uint64_t reg,
+    const std::uint8_t* data, size_t size, const std::array<std::uint64_t, 4>& constants,
+    std::uint8_t* out_chunk)
+{
+    const __m128i k512 = _mm_set_epi64x(static_cast<long long>(constants[0]),
+        static_cast<long long>(constants[1]));
+    const __m128i k128 = _mm_set_epi64x(static_cast<long long>(constants[2]),
+        static_cast<long long>(constants[3]));
+
+    __m128i x0 = _mm_xor_si128(loadChunk(data), _mm_set_epi64x(static_cast<long long>(reg), 0));
+    __m128i x1 = loadChunk(data + 16);
+    __m128i x2 = loadChunk(data + 32);
+    __m128i x3 = loadChunk(data + 48);
+    size_t pos = 64;
+
+    for (; pos + 64 <= size; pos += 64) {
+        x0 = _mm_xor_si128(fold(x0, k512), loadChunk(data + pos));
+        x1 = _mm_xor_si128(fold(x1, k512), loadChunk(data + pos + 16));
+        x2 = _mm_xor_si128(fold(x2, k512), loadChunk(data + pos + 32));
+        x3 = _mm_xor_si128(fold(x3, k512), loadChunk(data + pos + 48));
+    }
+
+    x1 = _mm_xor_si128(fold(x0, k128), x1);
+    x2 = _mm_xor_si128(fold(x1, k128), x2);
+    x3 = _mm_xor_si128(fold(x2, k128), x3);
+
+    for (; pos + 16 <= size; pos += 16) {
+        x3 = _mm_xor_si128(fold(x3, k128), loadChunk(data + pos));
+    }
+
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out_chunk), _mm_shuffle_epi8(x3, reverse));
+    return pos;
+}
+
+#endif
+
+}
+
+CrcEngine::CrcEngine(const CrcPolynomial& polynomial, bool allow_clmul)
+    : _n(polynomial.getDegree())
+    , _use_clmul(false)
+{
+    // Drop leading term and align the rest to the top of the register
+    _poly = (polynomial.getExplicitPolynomial() << (64 - _n));
+
+    for (unsigned int byte = 0; byte < 256; byte++) {
+        std::uint64_t reg = static_cast<std::uint64_t>(byte) << 56;
+        for (int bit = 0; bit < 8; bit++) {
+            reg = (reg << 1) ^ ((reg >> 63) ? _poly : 0);
+        }
+        _table[0][byte] = reg;
+    }
+    for (unsigned int slice = 1; slice < SLICES; slice++) {
+        for (unsigned int byte = 0; byte < 256; byte++) {
+            auto prev = _table[slice - 1][byte];
+            _table[slice][byte] = (prev << 8) ^ _table[0][prev >> 56];
+        }
+    }
+
+    _fold_constants = { _xPowMod(576), _xPowMod(512), _xPowMod(192), _xPowMod(128) };
+#ifdef PPFS_CRC_CLMUL
+    _use_clmul = allow_clmul && cpuSupportsClmul();
+#else
+    (void)allow_clmul;
+#endif
+}
+
+std::uint64_t CrcEngine::_xPowMod(unsigned int k) const
+{
+    std::uint64_t reg = 1;
+    for (unsigned int i = 0; i < k; i++) {
+        reg = (reg << 1) ^ ((reg >> 63) ? _poly : 0);
+    }
+    return reg;
+}
+
+std::uint64_t CrcEngine::_updateTable(
+    std::uint64_t reg, const std::uint8_t* data, size_t size) const
+{
+    for (; size >= SLICES; data += SLICES, size -= SLICES) {
+        reg ^= loadBigEndian(data);
+        reg = _table[7][reg >> 56] ^ _table[6][(reg >> 48) & 0xff]
+            ^ _table[5][(reg >> 40) & 0xff] ^ _table[4][(reg >> 32) & 0xff]
+            ^ _table[3][(reg >> 24) & 0xff] ^ _table[2][(reg >> 16) & 0xff]
+            ^ _table[1][(reg >> 8) & 0xff] ^ _table[0][reg & 0xff];
+    }
+    for (; size > 0; data++, size--) {
+        reg = (reg << 8) ^ _table[0][(reg >> 56) ^ *data];
+    }
+    return reg;
+}
+
+std::uint64_t CrcEngine::_updateClmul(
+    std::uint64_t reg, const std::uint8_t* data, size_t size) const
+{
+#ifdef PPFS_CRC_CLMUL
+    if (size >= 64) {
+        std::array<std::uint8_t, 16> chunk;
+        auto consumed = foldClmul(reg, data, size, _fold_constants, chunk.data());
+        reg = _updateTable(0, chunk.data(), chunk.size());
+        data += consumed;
+        size -= consumed;
+    }
+#endif
+    return _updateTable(reg, data, size);
+}
+
+std::uint64_t CrcEngine::checkBits(const static_vector<std::uint8_t>& data) const
+{
+    if (data.size() == 0) {
+        return 0;
+    }
+
+    // Bit-serial division skips the very last step, so the result equals remainder of data
+    // multiplied by x^(n-1), shifted left by one. Last byte is therefore handled bit by bit.
+    size_t whole_bytes = data.size() - 1;
+    auto reg = _use_clmul ? _updateClmul(0, data.data(), whole_bytes)
+                          : _updateTable(0, data.data(), whole_bytes);
+
+    std::uint8_t last = data[whole_bytes];
+    for (int bit = 7; bit > 0; bit--) {
+        bool top = ((reg >> 63) ^ (last >> bit)) & 1;
+        reg = (reg << 1) ^ (top ? _poly : 0);
+    }
+    reg ^= static_cast<std::uint64_t>(last & 1) << 63;
+
+    return (reg << 1) >> (64 - _n);
+}
+
+unsigned int CrcEngine::getDegree() const { return _n; }
+
+bool CrcEngine::usesClmul() const { return _use_clmul; }
@@ -0,0 +1,313 @@
+#include "ppfs/ecc_helpers/hamming_codec.hpp"
+#include "ppfs/blockdevice/iblock_device.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#    define PPFS_HAMMING_BMI2 1
+#    include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t MAX_WORDS = MAX_BLOCK_SIZE / 8 + 1;
+
+std::uint64_t loadWord(const std::uint8_t* bytes)
+{
+    std::uint64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    if constexpr (std::endian::native == std::endian::little) {
+        value = std::byteswap(value);
+    }
+    return value;
+}
+
+void storeWord(std::uint8_t* bytes, std::uint64_t value)
+{
+    if constexpr (std::endian::native == std::endian::little) {
+        value = std::byteswap(value);
+    }
+    std::memcpy(bytes, &value, sizeof(value));
+}
+
+/** Bit of index j (0 is the first, most significant bit) in a big endian word */
+constexpr std::uint64_t positionBit(unsigned int j) { return std::uint64_t(1) << (63 - j); }
+
+constexpr std::array<std::uint64_t, 6> makeIndexMasks()
+{
+    std::array<std::uint64_t, 6> masks {};
+    for (unsigned int b = 0; b < 6; b++) {
+        for (unsigned int j = 0; j < 64; j++) {
+            if ((j >> b) & 1) {
+                masks[b] |= positionBit(j);
+            }
+        }
+    }
+    return masks;
+}
+
+/** masks[b] has set every position whose index within the word has bit b set */
+constexpr auto INDEX_MASKS = makeIndexMasks();
+
+/** Bit 0 and powers of two inside the first word */
+constexpr std::uint64_t FIRST_WORD_PARITY_MASK = positionBit(0) | positionBit(1) | positionBit(2)
+    | positionBit(4) | positionBit(8) | positionBit(16) | positionBit(32);
+
+std::uint64_t pextPortable(std::uint64_t value, std::uint64_t mask)
+{
+    std::uint64_t result = 0;
+    for (std::uint64_t bit = 1; mask != 0; bit <<= 1) {
+        if (value & mask & -mask) {
+            result |= bit;
+        }
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+std::uint64_t pdepPortable(std::uint64_t value, std::uint64_t mask)
+{
+    std::uint64_t result = 0;
+    for (std::uint64_t bit = 1; mask != 0; bit <<= 1) {
+        if (value & bit) {
+            result |= mask & -mask;
+        }
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+#ifdef PPFS_HAMMING_BMI2
+__attribute__((target("bmi2"))) std::uint64_t pextBmi2(std::uint64_t value, std::uint64_t mask)
+{
+    return _pext_u64(value, mask);
+}
+
+__attribute__((target("bmi2"))) std::uint64_t pdepBmi2(std::uint64_t value, std::uint64_t mask)
+{
+    return _pdep_u64(value, mask);
+}
+#endif
+
+/**
+ * Contribution of set bits of word w to the syndrome, xor of their indices
+ */
+unsigned int wordSyndrome(std::uint64_t word, size_t w)
+{
+    unsigned int syndrome = (std::popcount(word) & 1) ? static_cast<unsigned int>(w << 6) : 0;
+    for (unsigned int b = 0; b < 6; b++) {
+        syndrome |= (std::popcount(word & INDEX_MASKS[b]) & 1) << b;
+    }
+    return syndrome;
+}
+
+/**
+ * Sequential reader of a big endian bit stream stored in words
+ */
+class BitReader {
+    const std::uint64_t* _words;
+    size_t _position = 0;
+
+public:
+    explicit BitReader(const std::uint64_t* words)
+        : _words(words)
+    {
+    }
+
+    /** Take next count (1-64) bits, first bit ends up as the most significant of result */
+    std::uint64_t take(unsigned int count)
+    {
+        size_t word = _position / 64;
+        unsigned int offset = _position % 64;
+        std::uint64_t value = _words[word] << offset;
+        if (offset != 0) {
+            value |= _words[word + 1] >> (64 - offset);
+        }
+        _position += count;
+        return value >> (64 - count);
+    }
+};
+
+/**
+ * Sequential writer of a big endian bit stream into zeroed words
+ */
+class BitWriter {
+    std::uint64_t* _words;
+    size_t _position = 0;
+
+public:
+    explicit BitWriter(std::uint64_t* words)
+        : _words(words)
+    {
+    }
+
+    /** Append lowest count (1-64) bits of value, most significant of them first */
+    void put(std::uint64_t value, unsigned int count)
+    {
+        size_t word = _position / 64;
+        unsigned int offset = _position % 64;
+        std::uint64_t aligned = value << (64 - count);
+        _words[word] |= aligned >> offset;
+        if (offset + count > 64) {
+            _words[word + 1] |= aligned << (64 - offset);
+        }
+        _position += count;
+    }
+};
+
+}
+
+HammingCodec::HammingCodec(int block_size_power, bool allow_bmi2)
+    : _pext(pextPortable)
+    , _pdep(pdepPortable)
+{
+    _block_size = static_cast<size_t>(1) << block_size_power;
+    size_t parity_bytes = static_cast<size_t>(std::ceil((block_size_power * 3 + 1) / 8.0));
+    _data_size = _block_size - parity_bytes;
+    _words = _block_size / 8;
+
+    // Data bits take every index that is neither zero nor a power of two
+    size_t data_bits = 0;
+    unsigned int index = 0;
+    while (data_bits < _data_size * 8) {
+        index++;
+        if ((index & (index - 1)) != 0) {
+            data_bits++;
+        }
+    }
+    _last_data_index = index;
+
+#ifdef PPFS_HAMMING_BMI2
+    __builtin_cpu_init();
+    if (allow_bmi2 && __builtin_cpu_supports("bmi2")) {
+        _pext = pextBmi2;
+        _pdep = pdepBmi2;
+    }
+#else
+    (void)allow_bmi2;
+#endif
+}
+
+std::uint64_t HammingCodec::_dataMask(size_t w) const
+{
+    size_t first_index = w * 64;
+    if (first_index > _last_data_index) {
+        return 0;
+    }
+    std::uint64_t mask = ~std::uint64_t(0);
+    if (w == 0) {
+        mask &= ~FIRST_WORD_PARITY_MASK;
+    } else if ((w & (w - 1)) == 0) {
+        mask &= ~positionBit(0);
+    }
+    if (first_index + 63 > _last_data_index) {
+        mask &= ~std::uint64_t(0) << (63 - (_last_data_index - first_index));
+    }
+    return mask;
+}
+
+std::uint64_t HammingCodec::_usedMask(size_t w) const
+{
+    size_t first_index = w * 64;
+    if (first_index + 63 <= _last_data_index) {
+        return ~std::uint64_t(0);
+    }
+    // Parity bits after the last data bit are only at the start of power of two words
+    std::uint64_t parity = (w != 0 && (w & (w - 1)) == 0) ? positionBit(0) : 0;
+    if (first_index > _last_data_index) {
+        return parity;
+    }
+    return parity | (~std::uint64_t(0) << (63 - (_last_data_index - first_index)));
+}
+
+std::expected<std::optional<unsigned int>, FsError> HammingCodec::findError(
+    const static_vector<std::uint8_t>& block) const
+{
+    unsigned int syndrome = 0;
+    unsigned int ones = 0;
+    for (size_t w = 0; w < _words; w++) {
+        auto word = loadWord(block.data() + w * 8) & _usedMask(w);
+        syndrome ^= wordSyndrome(word, w);
+        ones += std::popcount(word);
+    }
+
+    if (ones % 2 == 1 && syndrome < _block_size * 8) {
+        return syndrome;
+    }
+    // Even number of flips, or odd number pointing outside of the block, can't be corrected
+    if (ones % 2 == 1 || syndrome != 0) {
+        return std::unexpected(FsError::BlockDevice_CorrectionError);
+    }
+    return std::nullopt;
+}
+
+void HammingCodec::extract(
+    const static_vector<std::uint8_t>& block, static_vector<std::uint8_t>& data) const
+{
+    std::array<std::uint64_t, MAX_WORDS> out {};
+    BitWriter writer(out.data());
+    for (size_t w = 0; w < _words; w++) {
+        auto mask = _dataMask(w);
+        if (mask == 0) {
+            break;
+        }
+        auto word = loadWord(block.data() + w * 8);
+        auto count = std::popcount(mask);
+        writer.put(count == 64 ? word : _pext(word, mask), count);
+    }
+
+    data.resize(_data_size);
+    std::array<std::uint8_t, MAX_BLOCK_SIZE + 8> bytes;
+    for (size_t w = 0; w * 8 < _data_size; w++) {
+        storeWord(bytes.data() + w * 8, out[w]);
+    }
+    std::copy_n(bytes.begin(), _data_size, data.begin());
+}
+
+void HammingCodec::encode(
+    const static_vector<std::uint8_t>& data, static_vector<std::uint8_t>& block) const
+{
+    block.resize(_block_size);
+
+    std::array<std::uint8_t, MAX_BLOCK_SIZE + 16> padded {};
+    std::copy_n(data.begin(), std::min(data.size(), _data_size), padded.begin());
+    std::array<std::uint64_t, MAX_WORDS + 1> in {};
+    for (size_t w = 0; w * 8 < _data_size; w++) {
+        in[w] = loadWord(padded.data() + w * 8);
+    }
+
+    BitReader reader(in.data());
+    unsigned int syndrome = 0;
+    unsigned int ones = 0;
+    for (size_t w = 0; w < _words; w++) {
+        auto mask = _dataMask(w);
+        if (mask == 0) {
+            break;
+        }
+        auto count = std::popcount(mask);
+        auto bits = reader.take(count);
+        auto deposited = count == 64 ? bits : _pdep(bits, mask);
+        auto word = (loadWord(block.data() + w * 8) & ~mask) | deposited;
+        storeWord(block.data() + w * 8, word);
+        syndrome ^= wordSyndrome(deposited, w);
+        ones += std::popcount(deposited);
+    }
+
+    // Parity bit at every power of two makes the syndrome zero, bit 0 makes the count even
+    for (size_t parity_index = 1; parity_index < _block_size * 8; parity_index <<= 1) {
+        bool value = syndrome & parity_index;
+        ones += value;
+        auto byte = parity_index / 8;
+        auto bit = static_cast<std::uint8_t>(1 << (7 - parity_index % 8));
+        block[byte] = value ? (block[byte] | bit) : (block[byte] & ~bit);
+    }
+    block[0] = (ones % 2 == 1) ? (block[0] | 0x80) : (block[0] & 0x7f);
+}
+
+size_t HammingCodec::blockSize() const { return _block_size; }
+
+size_t HammingCodec::dataSize() const { return _data_size; }
@@ -0,0 +1,144 @@
+#include "ppfs/ecc_helpers/rs_decoder.hpp"
+#include "ppfs/ecc_helpers/gf256_tables.hpp"
+
+#include <algorithm>
+#include <array>
+
+using GF256Tables::EXP;
+using GF256Tables::LOG;
+using GF256Tables::mul;
+
+RsDecoder::RsDecoder(size_t codeword_size, size_t syndrome_count)
+    : _codeword_size(std::min(codeword_size, static_cast<size_t>(255)))
+    , _syndrome_count(std::min(syndrome_count, MAX_SYNDROMES))
+{
+}
+
+size_t RsDecoder::_berlekampMassey(
+    const static_vector<GF256>& syndromes, std::uint8_t* sigma) const
+{
+    size_t count = std::min(_syndrome_count, syndromes.size());
+    std::array<std::uint8_t, MAX_SYNDROMES + 1> prev {};
+    std::array<std::uint8_t, MAX_SYNDROMES + 1> temp;
+    std::fill(sigma, sigma + count + 1, std::uint8_t(0));
+    sigma[0] = 1;
+    prev[0] = 1;
+
+    size_t L = 0;
+    size_t m = 1;
+    std::uint8_t b = 1;
+
+    for (size_t n = 0; n < count; n++) {
+        auto d = static_cast<std::uint8_t>(syndromes[n]);
+        for (size_t i = 1; i <= L; i++) {
+            d ^= mul(sigma[i], static_cast<std::uint8_t>(syndromes[n - i]));
+        }
+        if (d == 0) {
+            m++;
+            continue;
+        }
+
+        // sigma -= d / b * x^m * prev
+        std::uint8_t factor = EXP[LOG[d] + 255 - LOG[b]];
+        bool grow = 2 * L <= n;
+        if (grow) {
+            std::copy_n(sigma, count + 1, temp.begin());
+        }
+        for (size_t i = 0; i + m <= count; i++) {
+            sigma[i + m] ^= mul(factor, prev[i]);
+        }
+
+        if (grow) {
+            L = n + 1 - L;
+            prev = temp;
+            b = d;
+            m = 1;
+        } else {
+            m++;
+        }
+    }
+    return L;
+}
+
+std::expected<size_t, FsError> RsDecoder::correct(
+    static_vector<std::uint8_t>& codeword, const static_vector<GF256>& syndromes) const
+{
+    std::array<std::uint8_t, MAX_SYNDROMES + 1> sigma;
+    size_t errors = _berlekampMassey(syndromes, sigma.data());
+    if (errors == 0 || 2 * errors > _syndrome_count) {
+        return std::unexpected(FsError::BlockDevice_CorrectionError);
+    }
+
+    // omega = S * sigma mod x^2t, only coefficients below deg(sigma) are nonzero for valid words
+    std::array<std::uint16_t, MAX_SYNDROMES> omega_logs;
+    for (size_t k = 0; k < errors; k++) {
+        std::uint8_t value = 0;
+        for (size_t i = 0; i <= k; i++) {
+            value ^= mul(sigma[i], static_cast<std::uint8_t>(syndromes[k - i]));
+        }
+        omega_logs[k] = LOG[value];
+    }
+
+    // Running terms sigma_i * alpha^(-i*p) for nonzero coefficients, kept as logarithms
+    std::array<std::uint16_t, MAX_SYNDROMES> term_logs;
+    std::array<std::uint16_t, MAX_SYNDROMES> term_steps;
+    std::array<bool, MAX_SYNDROMES> term_odd;
+    size_t terms = 0;
+    for (size_t i = 1; i <= errors; i++) {
+        if (sigma[i] == 0) {
+            continue;
+        }
+        term_logs[terms] = LOG[sigma[i]];
+        term_steps[terms] = static_cast<std::uint16_t>((255 - i % 255) % 255);
+        term_odd[terms] = i % 2 == 1;
+        terms++;
+    }
+
+    std::array<std::uint8_t, MAX_SYNDROMES> positions;
+    std::array<std::uint8_t, MAX_SYNDROMES> values;
+    size_t found = 0;
+    for (size_t p = 0; p < _codeword_size && found < errors; p++) {
+        std::uint8_t sum = sigma[0];
+        std::uint8_t odd_sum = 0;
+        for (size_t t = 0; t < terms; t++) {
+            std::uint8_t term = EXP[term_logs[t]];
+            sum ^= term;
+            odd_sum ^= term_odd[t] ? term : 0;
+            term_logs[t] += term_steps[t];
+            if (term_logs[t] >= 255) {
+                term_logs[t] -= 255;
+            }
+        }
+        if (sum != 0) {
+            continue;
+        }
+
+        // Forney: e = omega(X^-1) / sigma'(X^-1), where X = alpha^p and sigma'(X^-1) = X * odd
+        if (odd_sum == 0) {
+            return std::unexpected(FsError::BlockDevice_CorrectionError);
+        }
+        std::uint8_t numerator = 0;
+        unsigned int step = (255 - p) % 255;
+        unsigned int exponent = 0;
+        for (size_t k = 0; k < errors; k++) {
+            numerator ^= EXP[omega_logs[k] + exponent];
+            exponent += step;
+            if (exponent >= 255) {
+                exponent -= 255;
+            }
+        }
+        unsigned int denominator_log = (p + LOG[odd_sum]) % 255;
+        positions[found] = static_cast<std::uint8_t>(p);
+        values[found] = EXP[LOG[numerator] + 255 - denominator_log];
+        found++;
+    }
+
+    // Roots outside of the codeword or repeated roots mean there are too many errors
+    if (found != errors) {
+        return std::unexpected(FsError::BlockDevice_CorrectionError);
+    }
+    for (size_t i = 0; i < found; i++) {
+        codeword[positions[i]] ^= values[i];
+    }
+    return found;
+}
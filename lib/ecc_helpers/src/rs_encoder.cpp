@@ -0,0 +1,80 @@
+#include "ppfs/ecc_helpers/rs_encoder.hpp"
+#include "ppfs/ecc_helpers/gf256_tables.hpp"
+
+#include <algorithm>
+
+RsEncoder::RsEncoder(const PolynomialGF256& generator, size_t codeword_size)
+{
+    codeword_size = std::min(codeword_size, MAX_CODEWORD_SIZE);
+    _parity_size = std::min(generator.degree(), codeword_size);
+    _message_size = codeword_size - _parity_size;
+    size_t p = _parity_size;
+
+    for (unsigned int nibble = 0; nibble < 16; nibble++) {
+        auto low = static_cast<std::uint8_t>(nibble);
+        auto high = static_cast<std::uint8_t>(nibble << 4);
+        for (size_t i = 0; i < p; i++) {
+            auto coefficient = static_cast<std::uint8_t>(generator[p - 1 - i]);
+            _generator_table[nibble][i] = GF256Tables::mul(coefficient, low);
+            _generator_table[16 + nibble][i] = GF256Tables::mul(coefficient, high);
+        }
+        _generator_table[nibble][p] = 0;
+        _generator_table[16 + nibble][p] = 0;
+    }
+
+    // x^p mod g is g without the leading term, every next position is multiplied by x
+    for (size_t i = 0; i < p; i++) {
+        _position_parity[i] = static_cast<std::uint8_t>(generator[i]);
+    }
+    for (size_t j = 1; j < _message_size; j++) {
+        const std::uint8_t* prev = _position_parity.data() + (j - 1) * p;
+        std::uint8_t* current = _position_parity.data() + j * p;
+        std::uint8_t top = prev[p - 1];
+        for (size_t i = 0; i < p; i++) {
+            std::uint8_t shifted = i > 0 ? prev[i - 1] : 0;
+            current[i] = shifted ^ GF256Tables::mul(static_cast<std::uint8_t>(generator[i]), top);
+        }
+    }
+}
+
+void RsEncoder::encode(static_vector<std::uint8_t>& codeword) const
+{
+    size_t p = _parity_size;
+
+    // Shift register stored highest coefficient first, with one extra zero at the end
+    std::array<std::uint8_t, MAX_PARITY_SIZE + 1> reg {};
+    for (size_t k = _message_size; k-- > 0;) {
+        std::uint8_t feedback = codeword[p + k] ^ reg[0];
+        const auto& low = _generator_table[feedback & 0x0f];
+        const auto& high = _generator_table[16 + (feedback >> 4)];
+        for (size_t i = 0; i < p; i++) {
+            reg[i] = reg[i + 1] ^ low[i] ^ high[i];
+        }
+    }
+
+    for (size_t i = 0; i < p; i++) {
+        codeword[i] = reg[p - 1 - i];
+    }
+}
+
+size_t RsEncoder::update(static_vector<std::uint8_t>& codeword, size_t offset,
+    const static_vector<std::uint8_t>& data) const
+{
+    size_t p = _parity_size;
+    size_t to_write = std::min(data.size(), _message_size - std::min(offset, _message_size));
+
+    for (size_t idx = 0; idx < to_write; idx++) {
+        size_t j = offset + idx;
+        std::uint8_t delta = data[idx] ^ codeword[p + j];
+        if (delta == 0) {
+            continue;
+        }
+        auto log_delta = GF256Tables::LOG[delta];
+        const std::uint8_t* parity = _position_parity.data() + j * p;
+        for (size_t i = 0; i < p; i++) {
+            codeword[i] ^= GF256Tables::EXP[log_delta + GF256Tables::LOG[parity[i]]];
+        }
+        codeword[p + j] = data[idx];
+    }
+    return to_write;
+}
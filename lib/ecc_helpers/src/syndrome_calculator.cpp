@@ -0,0 +1,157 @@
+#include "ppfs/ecc_helpers/syndrome_calculator.hpp"
+#include "ppfs/common/math_helpers.hpp"
+#include "ppfs/ecc_helpers/gf256_tables.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#    define PPFS_RS_SIMD 1
+#    include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t PADDED_CODEWORD_SIZE = 256;
+
+/**
+ * Combine lanes into syndrome j: lane k holds sum of coefficients k, k + W, k + 2W, ... already
+ * scaled by powers of alpha^(j*W), so only alpha^(j*k) is missing.
+ */
+GF256 combineLanes(const std::uint8_t* lanes, size_t width, size_t j)
+{
+    std::uint8_t syndrome = 0;
+    unsigned int exponent = 0;
+    for (size_t k = 0; k < width; k++) {
+        syndrome ^= GF256Tables::EXP[GF256Tables::LOG[lanes[k]] + exponent];
+        exponent += j;
+        if (exponent >= 255)
+            exponent -= 255;
+    }
+    return GF256(syndrome);
+}
+
+GF256 alphaPower(size_t exponent) { return GF256(GF256Tables::EXP[exponent % 255]); }
+
+#ifdef PPFS_RS_SIMD
+
+__attribute__((target("avx2"))) void calculateAvx2(const std::uint8_t* padded, size_t blocks,
+    const std::array<std::array<std::uint8_t, 32>, SyndromeCalculator::MAX_SYNDROMES>& tables,
+    size_t count, GF256* syndromes)
+{
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    alignas(32) std::array<std::uint8_t, 32> lanes;
+
+    for (size_t j = 0; j < count; j++) {
+        auto low_table = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables[j].data())));
+        auto high_table = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables[j].data() + 16)));
+
+        __m256i acc = _mm256_setzero_si256();
+        for (size_t b = blocks; b-- > 0;) {
+            auto low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(acc, low_mask));
+            auto high = _mm256_shuffle_epi8(
+                high_table, _mm256_and_si256(_mm256_srli_epi16(acc, 4), low_mask));
+            auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(padded + 32 * b));
+            acc = _mm256_xor_si256(_mm256_xor_si256(low, high), chunk);
+        }
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.data()), acc);
+        syndromes[j] = combineLanes(lanes.data(), 32, j + 1);
+    }
+}
+
+__attribute__((target("ssse3"))) void calculateSsse3(const std::uint8_t* padded, size_t blocks,
+    const std::array<std::array<std::uint8_t, 32>, SyndromeCalculator::MAX_SYNDROMES>& tables,
+    size_t count, GF256* syndromes)
+{
+    const __m128i low_mask = _mm_set1_epi8(0x0f);
+    alignas(16) std::array<std::uint8_t, 16> lanes;
+
+    for (size_t j = 0; j < count; j++) {
+        auto low_table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables[j].data()));
+        auto high_table
+            = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables[j].data() + 16));
+
+        __m128i acc = _mm_setzero_si128();
+        for (size_t b = blocks; b-- > 0;) {
+            auto low = _mm_shuffle_epi8(low_table, _mm_and_si128(acc, low_mask));
+            auto high
+                = _mm_shuffle_epi8(high_table, _mm_and_si128(_mm_srli_epi16(acc, 4), low_mask));
+            auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(padded + 16 * b));
+            acc = _mm_xor_si128(_mm_xor_si128(low, high), chunk);
+        }
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes.data()), acc);
+        syndromes[j] = combineLanes(lanes.data(), 16, j + 1);
+    }
+}
+
+#endif
+
+}
+
+SyndromeCalculator::SyndromeCalculator(size_t syndrome_count, bool allow_simd)
+    : _syndrome_count(std::min(syndrome_count, MAX_SYNDROMES))
+    , _width(1)
+{
+#ifdef PPFS_RS_SIMD
+    __builtin_cpu_init();
+    if (allow_simd && __builtin_cpu_supports("avx2")) {
+        _width = 32;
+    } else if (allow_simd && __builtin_cpu_supports("ssse3")) {
+        _width = 16;
+    }
+#else
+    (void)allow_simd;
+#endif
+
+    if (_width == 1) {
+        return;
+    }
+    for (size_t j = 0; j < _syndrome_count; j++) {
+        GF256 multiplier = alphaPower((j + 1) * _width);
+        for (std::uint8_t nibble = 0; nibble < 16; nibble++) {
+            _tables[j][nibble] = static_cast<std::uint8_t>(multiplier * GF256(nibble));
+            auto high_nibble = static_cast<std::uint8_t>(nibble << 4);
+            _tables[j][16 + nibble] = static_cast<std::uint8_t>(multiplier * GF256(high_nibble));
+        }
+    }
+}
+
+bool SyndromeCalculator::calculate(
+    const static_vector<std::uint8_t>& codeword, static_vector<GF256>& syndromes) const
+{
+    syndromes.resize(_syndrome_count);
+    size_t size = std::min(codeword.size(), PADDED_CODEWORD_SIZE - 1);
+
+#ifdef PPFS_RS_SIMD
+    if (_width > 1) {
+        // High coefficients are padded with zeros, which does not change the polynomial
+        alignas(32) std::array<std::uint8_t, PADDED_CODEWORD_SIZE> padded;
+        size_t blocks = divCeil(size, _width);
+        std::copy_n(codeword.data(), size, padded.begin());
+        std::fill(padded.begin() + size, padded.begin() + blocks * _width, std::uint8_t(0));
+        if (_width == 32) {
+            calculateAvx2(padded.data(), blocks, _tables, _syndrome_count, syndromes.data());
+        } else {
+            calculateSsse3(padded.data(), blocks, _tables, _syndrome_count, syndromes.data());
+        }
+    } else {
+        _calculateScalar(codeword.data(), size, syndromes.data());
+    }
+#else
+    _calculateScalar(codeword.data(), size, syndromes.data());
+#endif
+
+    return std::all_of(
+        syndromes.begin(), syndromes.end(), [](GF256 s) { return s == GF256(0); });
+}
+
+size_t SyndromeCalculator::width() const { return _width; }
+
+void SyndromeCalculator::_calculateScalar(
+    const std::uint8_t* codeword, size_t size, GF256* syndromes) const
+{
+    for (size_t j = 0; j < _syndrome_count; j++) {
+        syndromes[j] = combineLanes(codeword, size, j + 1);
+    }
+}
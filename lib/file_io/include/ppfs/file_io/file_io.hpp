@@ -1,39 +1,110 @@
 #pragma once
 #include "ppfs/block_manager/iblock_manager.hpp"
 #include "ppfs/blockdevice/iblock_device.hpp"
+#include "ppfs/common/ppfs_mutex.hpp"
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/inode_manager/iinode_manager.hpp"
 #include <array>
 #include <cstddef>
 #include <optional>
 
+#ifndef PPFS_BLOCK_MAP_SLOTS
+/** Number of decoded index blocks kept between calls to FileIO, shared by all files */
+#    define PPFS_BLOCK_MAP_SLOTS 4
+#endif
+
+/**
+ * Decoded index blocks shared by all files, kept between calls to FileIO.
+ *
+ * Each slot holds one index block, tagged with the inode, the depth in the block map of that
+ * inode and the block number. BlockIndexIterator borrows a slot for every depth the file has,
+ * preferring the one already tagged with that inode and depth, so walking the same or the next
+ * part of a file doesn't decode index blocks again. Borrowed slots belong to one iterator, an
+ * iterator that finds none free uses its own buffers. Contents always match the disk, FileIO
+ * forgets the slots of a file it changes.
+ */
+class BlockMapPool {
+public:
+    static constexpr size_t LEVELS = 3;
+    static constexpr size_t SLOTS = PPFS_BLOCK_MAP_SLOTS;
+
+    struct Slot {
+        std::array<block_index_t, MAX_BLOCK_SIZE / sizeof(block_index_t)> indices;
+        inode_index_t inode = 0;
+        size_t level = 0;
+        /** Index block held in indices, empty if it holds none */
+        std::optional<block_index_t> block;
+        bool borrowed = false;
+        /** Value of the use counter when last borrowed, least recently used slot is reused */
+        size_t last_use = 0;
+    };
+
+    // A failed init leaves the mutex unusable, no slot is then ever borrowed
+    BlockMapPool() { (void)_mutex.init(); }
+
+    BlockMapPool(const BlockMapPool&) = delete;
+    BlockMapPool& operator=(const BlockMapPool&) = delete;
+
+    /** Borrows a slot for index blocks of inode at level, nullptr if all are borrowed */
+    Slot* borrow(inode_index_t inode, size_t level);
+
+    /** Returns a borrowed slot, its contents are kept for the next borrow */
+    void giveBack(Slot* slot);
+
+    /** Forgets index blocks of inode held by slots that are not borrowed */
+    void invalidate(inode_index_t inode);
+
+    /** Forgets index blocks held by slots that are not borrowed, for a newly mounted disk */
+    void invalidateAll();
+
+private:
+    std::array<Slot, SLOTS> _slots;
+    size_t _uses = 0;
+    PpFSMutex _mutex;
+};
+
 /**
  * Handles file-level read/write operations and resizing.
+ *
+ * Given a BlockMapPool, reads and writes may keep decoded index blocks in it instead of reading
+ * them from the block device on every call.
  */
 class FileIO {
+    /** Number of blocks passed to the block device in one vectored call. */
+    static constexpr size_t MAX_BATCH_EXTENTS = 16;
+    /** Number of blocks freed with one call to the block manager when shrinking a file. */
+    static constexpr size_t MAX_FREE_BATCH = 256;
+
     IBlockDevice& _block_device;
     IBlockManager& _block_manager;
     IInodeManager& _inode_manager;
+    BlockMapPool* _block_maps;
 
 public:
-    FileIO(IBlockDevice& block_device, IBlockManager& block_manager, IInodeManager& inode_manager);
+    FileIO(IBlockDevice& block_device, IBlockManager& block_manager, IInodeManager& inode_manager,
+        BlockMapPool* block_maps = nullptr);
     /**
      * Reads file with given inode. If read exceeds file size, returns FsError::OutOfBounds.
+     * With cache_index_blocks, index blocks are kept in the block map pool.
      */
     [[nodiscard]] std::expected<void, FsError> readFile(inode_index_t inode_index, Inode& inode,
-        size_t offset, size_t bytes_to_read, static_vector<uint8_t>& buf);
+        size_t offset, size_t bytes_to_read, static_vector<uint8_t>& buf,
+        bool cache_index_blocks = false);
 
     /**
      * Writes file with given inode. Resizes file if necessary and updates inode table.
      * If writing fails after some blocks were written, those blocks are not freed again.
      * Inode is updated with inode manager to reflect new file size and inode blocks.
+     * With cache_index_blocks, index blocks are kept in the block map pool.
      */
 
     [[nodiscard]] std::expected<size_t, FsError> writeFile(inode_index_t inode_index, Inode& inode,
-        size_t offset, const static_vector<uint8_t>& bytes_to_write);
+        size_t offset, const static_vector<uint8_t>& bytes_to_write,
+        bool cache_index_blocks = false);
 
     /**
-     * Resizes file to a given size
+     * Resizes file to a given size, index blocks of the file kept in the block map pool are
+     * forgotten
      */
     [[nodiscard]] std::expected<void, FsError> resizeFile(
         inode_index_t inode_index, Inode& inode, size_t new_size);
@@ -43,9 +114,34 @@ public:
  * Iterator for traversing data blocks of a file with optional resizing.
  */
 class BlockIndexIterator {
+    /** Number of unused reserved blocks freed with one call to the block manager */
+    static constexpr size_t UNUSED_FREE_BATCH = 64;
+
 public:
+    /**
+     * @param block_maps pool to borrow index block buffers from, the iterator keeps its own
+     * buffers when it is nullptr or has no free slot
+     * @param inode_index inode the slots are tagged with, used only with block_maps
+     */
     BlockIndexIterator(size_t index, Inode& inode, IBlockDevice& block_device,
-        IBlockManager& block_manager, bool should_resize);
+        IBlockManager& block_manager, bool should_resize, BlockMapPool* block_maps = nullptr,
+        inode_index_t inode_index = 0);
+
+    /**
+     * Frees blocks that were reserved ahead but not used, gives borrowed slots back.
+     */
+    ~BlockIndexIterator();
+
+    BlockIndexIterator(const BlockIndexIterator&) = delete;
+    BlockIndexIterator& operator=(const BlockIndexIterator&) = delete;
+
+    /**
+     * Hint that data blocks up to end_index (exclusive) will be requested.
+     *
+     * Blocks the file doesn't have yet are then reserved ahead as contiguous runs, placed right
+     * after the last block of the file when possible.
+     */
+    void expectBlocks(size_t end_index);
 
     /**
      * Returns the next data block index of the file.
@@ -67,6 +163,14 @@ public:
     [[nodiscard]] std::expected<block_index_t, FsError> nextWithIndirectBlocksAdded(
         static_vector<block_index_t>& undirected_blocks_addeed);
 
+    /**
+     * Cuts extents of an extent mapped file to its first end blocks, frees extent blocks that
+     * are no longer needed. Data blocks are not freed.
+     *
+     * Does not update inode in inode manager.
+     */
+    [[nodiscard]] std::expected<void, FsError> trimExtents(size_t end);
+
 private:
     size_t _index;
     Inode& _inode;
@@ -78,14 +182,58 @@ private:
     static_vector<block_index_t> _index_block_1;
     static_vector<block_index_t> _index_block_2;
     static_vector<block_index_t> _index_block_3;
+    BlockMapPool* _block_maps;
+    /** Slots borrowed for each depth of the block map, nullptr where own buffers are used */
+    std::array<BlockMapPool::Slot*, BlockMapPool::LEVELS> _slots {};
     bool _finished = false;
     bool _should_resize;
     size_t _occupied_blocks;
 
+    /** Blocks reserved ahead, handed out one by one by _findAndReserveBlock */
+    block_index_t _run_next = 0;
+    size_t _run_left = 0;
+    /** Blocks still expected to be allocated, see expectBlocks() */
+    size_t _expected_blocks = 0;
+    /** Last block returned or allocated, new blocks are placed after it */
+    std::optional<block_index_t> _last_block;
+
+    /** Position in the chain of the extent block held by _index_block_1, if any */
+    std::optional<size_t> _extent_block_number;
+    /** Block number of the extent block held by _index_block_1 */
+    block_index_t _extent_block_index = 0;
+    /** Whether extents left past the file end by failed writes were cut off */
+    bool _extents_trimmed = false;
+    /** Number of blocks covered by extents, valid once they are trimmed */
+    size_t _extents_end = 0;
+    /** Extent of the last lookup, sequential lookups start there */
+    size_t _extent_hint = 0;
+
+    [[nodiscard]] std::expected<block_index_t, FsError> _nextBlock(
+        static_vector<block_index_t>& indirect_blocks_added);
+
+    /** Block tag of the borrowed slot backing buf, nullptr if buf is an own buffer */
+    std::optional<block_index_t>* _tagOf(const static_vector<block_index_t>& buf);
+
     [[nodiscard]] std::expected<void, FsError> _readIndexBlock(
         block_index_t index, static_vector<block_index_t>& buf);
     [[nodiscard]] std::expected<void, FsError> _writeIndexBlock(
         block_index_t index, const static_vector<block_index_t>& indices);
 
+    [[nodiscard]] std::expected<block_index_t, FsError> _nextExtentBlock();
+    /** Extent with given number, loads the extent block when needed */
+    [[nodiscard]] std::expected<Extent*, FsError> _extentAt(size_t number);
+    [[nodiscard]] std::expected<Extent*, FsError> _findExtent(size_t index);
+    /** Adds block to the end of the file, extending the last extent when adjacent */
+    [[nodiscard]] std::expected<void, FsError> _appendToExtents(block_index_t block);
+    /** Number of extents in one extent block, its last index links the next block */
+    size_t _extentsPerBlock() const;
+    /** Number of extent blocks in the chain of a file with given number of extents */
+    size_t _extentBlocksFor(size_t extents) const;
+    /** Loads extent block with given position in the chain into _index_block_1 */
+    [[nodiscard]] std::expected<void, FsError> _loadExtentBlock(size_t number);
+    /** Frees count blocks of the extent chain, starting with the one at position first */
+    [[nodiscard]] std::expected<void, FsError> _freeExtentBlocks(size_t first, size_t count);
+
     [[nodiscard]] std::expected<block_index_t, FsError> _findAndReserveBlock();
+    block_index_t _allocationGoal() const;
 };
\ No newline at end of file
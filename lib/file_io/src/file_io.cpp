@@ -1,16 +1,94 @@
 #include "ppfs/file_io/file_io.hpp"
+#include <algorithm>
 #include <cstring>
 
-FileIO::FileIO(
-    IBlockDevice& block_device, IBlockManager& block_manager, IInodeManager& inode_manager)
+/**
+ * Frees blocks with one batch, falling back to freeing them one by one when the batch fails,
+ * so that a single already free block doesn't leak the rest. Returns the first error.
+ */
+static std::expected<void, FsError> freeBlocksOrEach(
+    IBlockManager& block_manager, static_vector<block_index_t>& blocks)
+{
+    auto batch_res = block_manager.freeBlocks(blocks);
+    if (batch_res.has_value()) {
+        return {};
+    }
+    for (auto block : blocks) {
+        (void)block_manager.free(block);
+    }
+    return batch_res;
+}
+
+BlockMapPool::Slot* BlockMapPool::borrow(inode_index_t inode, size_t level)
+{
+    if (!_mutex.lock().has_value())
+        return nullptr;
+    Slot* chosen = nullptr;
+    for (auto& slot : _slots) {
+        if (slot.borrowed)
+            continue;
+        if (slot.inode == inode && slot.level == level) {
+            chosen = &slot;
+            break;
+        }
+        if (chosen == nullptr || slot.last_use < chosen->last_use)
+            chosen = &slot;
+    }
+    if (chosen != nullptr) {
+        if (chosen->inode != inode || chosen->level != level) {
+            chosen->inode = inode;
+            chosen->level = level;
+            chosen->block.reset();
+        }
+        chosen->borrowed = true;
+        chosen->last_use = ++_uses;
+    }
+    (void)_mutex.unlock();
+    return chosen;
+}
+
+void BlockMapPool::giveBack(Slot* slot)
+{
+    if (!_mutex.lock().has_value())
+        return;
+    slot->borrowed = false;
+    (void)_mutex.unlock();
+}
+
+void BlockMapPool::invalidate(inode_index_t inode)
+{
+    // Without the mutex no slot could be borrowed, so none holds an index block
+    if (!_mutex.lock().has_value())
+        return;
+    for (auto& slot : _slots) {
+        if (!slot.borrowed && slot.inode == inode)
+            slot.block.reset();
+    }
+    (void)_mutex.unlock();
+}
+
+void BlockMapPool::invalidateAll()
+{
+    if (!_mutex.lock().has_value())
+        return;
+    for (auto& slot : _slots) {
+        if (!slot.borrowed)
+            slot.block.reset();
+    }
+    (void)_mutex.unlock();
+}
+
+FileIO::FileIO(IBlockDevice& block_device, IBlockManager& block_manager,
+    IInodeManager& inode_manager, BlockMapPool* block_maps)
     : _block_device(block_device)
     , _block_manager(block_manager)
     , _inode_manager(inode_manager)
+    , _block_maps(block_maps)
 {
 }
 
 std::expected<void, FsError> FileIO::readFile(inode_index_t inode_index, Inode& inode,
-    size_t offset, size_t bytes_to_read, static_vector<uint8_t>& data)
+    size_t offset, size_t bytes_to_read, static_vector<uint8_t>& data, bool cache_index_blocks)
 {
     if (offset + bytes_to_read > inode.file_size) {
         if (offset >= inode.file_size)
@@ -21,86 +99,121 @@ std::expected<void, FsError> FileIO::readFile(inode_index_t inode_index, Inode&
         return std::unexpected(FsError::FileIO_InvalidRequest);
     data.resize(0);
 
-    size_t block_number = offset / _block_device.dataSize();
-    size_t offset_in_block = offset % _block_device.dataSize();
+    size_t data_size = _block_device.dataSize();
+    size_t block_number = offset / data_size;
+    size_t offset_in_block = offset % data_size;
 
-    BlockIndexIterator indexIterator(block_number, inode, _block_device, _block_manager, false);
+    BlockIndexIterator indexIterator(block_number, inode, _block_device, _block_manager, false,
+        cache_index_blocks ? _block_maps : nullptr, inode_index);
 
+    // Blocks are read in batches, so that the block device can merge adjacent ones
+    std::array<BlockExtent, MAX_BATCH_EXTENTS> extents_buffer;
     while (bytes_to_read) {
-        auto next_block = indexIterator.next();
-        if (!next_block.has_value())
-            return std::unexpected(next_block.error());
-        static_vector<uint8_t> buf(data.end(), bytes_to_read, bytes_to_read);
-        auto read_res = _block_device.readBlock(
-            DataLocation(*next_block, offset_in_block), bytes_to_read, buf);
+        static_vector<BlockExtent> extents(extents_buffer.data(), MAX_BATCH_EXTENTS);
+        size_t batch_bytes = 0;
+        while (extents.size() < MAX_BATCH_EXTENTS && batch_bytes < bytes_to_read) {
+            auto next_block = indexIterator.next();
+            if (!next_block.has_value())
+                return std::unexpected(next_block.error());
+            size_t length = std::min(data_size - offset_in_block, bytes_to_read - batch_bytes);
+            extents.push_back(BlockExtent(DataLocation(*next_block, offset_in_block), length));
+            batch_bytes += length;
+            offset_in_block = 0;
+        }
+
+        static_vector<uint8_t> buf(data.end(), batch_bytes);
+        auto read_res = _block_device.readBlocks(extents, buf);
         if (!read_res.has_value())
             return std::unexpected(read_res.error());
         data.resize(data.size() + buf.size());
-
-        offset_in_block = 0;
         bytes_to_read -= buf.size();
     }
     return {};
 }
 
 std::expected<size_t, FsError> FileIO::writeFile(inode_index_t inode_index, Inode& inode,
-    size_t offset, const static_vector<uint8_t>& bytes_to_write)
+    size_t offset, const static_vector<uint8_t>& bytes_to_write, bool cache_index_blocks)
 {
+    size_t data_size = _block_device.dataSize();
     size_t written_bytes = 0;
-    size_t block_number = offset / _block_device.dataSize();
-    size_t offset_in_block = offset % _block_device.dataSize();
+    size_t block_number = offset / data_size;
+    size_t offset_in_block = offset % data_size;
 
-    BlockIndexIterator indexIterator(block_number, inode, _block_device, _block_manager, true);
-    while (true) {
-        auto next_block = indexIterator.next();
-        if (!next_block.has_value()) {
-            // We wrote some bytes already, so we need to update file size
-            if (inode.file_size < offset + written_bytes) {
-                inode.file_size = offset + written_bytes;
-                auto inode_res = _inode_manager.update(inode_index, inode);
-                if (!inode_res.has_value()) {
-                    return std::unexpected(inode_res.error());
+    BlockIndexIterator indexIterator(block_number, inode, _block_device, _block_manager, true,
+        cache_index_blocks ? _block_maps : nullptr, inode_index);
+    // Index blocks this write changes are kept in sync only in the slots it borrowed
+    if (_block_maps != nullptr)
+        _block_maps->invalidate(inode_index);
+    indexIterator.expectBlocks((offset + bytes_to_write.size() + data_size - 1) / data_size);
+    std::array<BlockExtent, MAX_BATCH_EXTENTS> extents_buffer;
+    do {
+        // Collect a batch of blocks, allocating new ones if the file grows
+        static_vector<BlockExtent> extents(extents_buffer.data(), MAX_BATCH_EXTENTS);
+        size_t batch_bytes = 0;
+        std::optional<FsError> iterator_error;
+        do {
+            auto next_block = indexIterator.next();
+            if (!next_block.has_value()) {
+                iterator_error = next_block.error();
+                break;
+            }
+            size_t length = std::min(
+                data_size - offset_in_block, bytes_to_write.size() - written_bytes - batch_bytes);
+            extents.push_back(BlockExtent(DataLocation(*next_block, offset_in_block), length));
+            batch_bytes += length;
+            offset_in_block = 0;
+        } while (extents.size() < MAX_BATCH_EXTENTS
+            && written_bytes + batch_bytes < bytes_to_write.size());
+
+        if (!extents.empty()) {
+            static_vector<std::uint8_t> buf(
+                const_cast<uint8_t*>(bytes_to_write.data()) + written_bytes, batch_bytes,
+                batch_bytes);
+            auto write_res = _block_device.writeBlocks(extents, buf);
+            if (!write_res.has_value()) {
+                // If we failed to write to new blocks, we should free them
+                size_t extent_start = offset + written_bytes;
+                for (const auto& extent : extents) {
+                    if (inode.file_size <= extent_start - extent.location.offset)
+                        _block_manager.free(extent.location.block_index);
+                    extent_start += extent.length;
+                }
+
+                // We wrote some bytes already, so we need to update file size
+                if (inode.file_size < offset + written_bytes) {
+                    inode.file_size = offset + written_bytes;
+                    _inode_manager.update(inode_index, inode);
                 }
+
+                return std::unexpected(write_res.error());
             }
-            return std::unexpected(next_block.error());
+            written_bytes += write_res.value();
         }
-        static_vector<std::uint8_t> buf(const_cast<uint8_t*>(bytes_to_write.data()) + written_bytes,
-            bytes_to_write.size() - written_bytes, bytes_to_write.size() - written_bytes);
-        auto write_res = _block_device.writeBlock(buf, DataLocation(*next_block, offset_in_block));
-        if (!write_res.has_value()) {
-            // If we failed to write to a new block, we should free it
-            if (inode.file_size <= offset + written_bytes)
-                _block_manager.free(*next_block);
 
+        if (iterator_error.has_value()) {
             // We wrote some bytes already, so we need to update file size
             if (inode.file_size < offset + written_bytes) {
                 inode.file_size = offset + written_bytes;
-                _inode_manager.update(inode_index, inode);
+                auto inode_res = _inode_manager.update(inode_index, inode);
+                if (!inode_res.has_value()) {
+                    return std::unexpected(inode_res.error());
+                }
             }
-
-            return std::unexpected(write_res.error());
+            return std::unexpected(*iterator_error);
         }
+    } while (written_bytes != bytes_to_write.size());
 
-        offset_in_block = 0;
-        written_bytes += write_res.value();
-
-        if (written_bytes != bytes_to_write.size())
-            continue;
-
-        if (inode.file_size >= offset + written_bytes) {
-            return written_bytes;
-        }
-
-        inode.file_size = offset + written_bytes;
-        auto inode_res = _inode_manager.update(inode_index, inode);
-        if (!inode_res.has_value()) {
-            return std::unexpected(inode_res.error());
-        };
-
+    if (inode.file_size >= offset + written_bytes) {
         return written_bytes;
     }
 
-    return std::unexpected(FsError::FileIO_InternalError);
+    inode.file_size = offset + written_bytes;
+    auto inode_res = _inode_manager.update(inode_index, inode);
+    if (!inode_res.has_value()) {
+        return std::unexpected(inode_res.error());
+    };
+
+    return written_bytes;
 }
 
 std::expected<void, FsError> FileIO::resizeFile(
@@ -108,11 +221,15 @@ std::expected<void, FsError> FileIO::resizeFile(
 {
     if (new_size == inode.file_size)
         return {};
+    if (_block_maps != nullptr)
+        _block_maps->invalidate(inode_index);
 
     if (new_size > inode.file_size) {
         BlockIndexIterator indexIterator(
             (inode.file_size + _block_device.dataSize() - 1) / _block_device.dataSize(), inode,
             _block_device, _block_manager, true);
+        indexIterator.expectBlocks(
+            (new_size + _block_device.dataSize() - 1) / _block_device.dataSize());
         size_t bytes_to_allocate = new_size - inode.file_size;
         // Check if we can resize part of file without allocating new blocks
         auto remaining_in_block = inode.file_size % _block_device.dataSize();
@@ -168,23 +285,50 @@ std::expected<void, FsError> FileIO::resizeFile(
 
     size_t blocks_to_free = (old_size + _block_device.dataSize() - 1) / _block_device.dataSize()
         - (inode.file_size + _block_device.dataSize() - 1) / _block_device.dataSize();
+
+    // Freed blocks are collected, so that each bitmap block is written once per batch. Freeing
+    // goes on after an error, the first one is returned once the inode is consistent again.
+    std::array<block_index_t, MAX_FREE_BATCH> free_buffer;
+    static_vector<block_index_t> to_free(free_buffer.data(), MAX_FREE_BATCH);
+    std::expected<void, FsError> free_res;
     for (size_t i = 0; i < blocks_to_free; i++) {
         std::array<block_index_t, 3> indirect_blocks_added_buffer;
         static_vector<block_index_t> indirect_blocks_added(indirect_blocks_added_buffer.data(), 3);
         auto next_block = indexIterator.nextWithIndirectBlocksAdded(indirect_blocks_added);
         if (!next_block.has_value()) {
+            (void)freeBlocksOrEach(_block_manager, to_free);
             return std::unexpected(next_block.error());
         }
+        if (to_free.size() + indirect_blocks_added.size() + 1 > to_free.capacity()) {
+            auto batch_res = freeBlocksOrEach(_block_manager, to_free);
+            if (!batch_res.has_value() && free_res.has_value())
+                free_res = batch_res;
+            to_free.resize(0);
+        }
         for (auto& index : indirect_blocks_added) {
-            _block_manager.free(index);
+            to_free.push_back(index);
         }
-        _block_manager.free(next_block.value());
+        to_free.push_back(next_block.value());
     }
-    return {};
+    auto batch_res = freeBlocksOrEach(_block_manager, to_free);
+    if (!batch_res.has_value() && free_res.has_value())
+        free_res = batch_res;
+
+    if (inode.extent_mapped) {
+        auto trim_res = indexIterator.trimExtents(
+            (new_size + _block_device.dataSize() - 1) / _block_device.dataSize());
+        if (!trim_res.has_value())
+            return std::unexpected(trim_res.error());
+        auto update_res = _inode_manager.update(inode_index, inode);
+        if (!update_res.has_value())
+            return std::unexpected(update_res.error());
+    }
+    return free_res;
 }
 
 BlockIndexIterator::BlockIndexIterator(size_t index, Inode& inode, IBlockDevice& block_device,
-    IBlockManager& block_manager, bool should_resize)
+    IBlockManager& block_manager, bool should_resize, BlockMapPool* block_maps,
+    inode_index_t inode_index)
     : _index(index)
     , _block_device(block_device)
     , _block_manager(block_manager)
@@ -192,15 +336,73 @@ BlockIndexIterator::BlockIndexIterator(size_t index, Inode& inode, IBlockDevice&
     , _index_block_1(_index_block_1_buffer.data(), MAX_BLOCK_SIZE / sizeof(block_index_t))
     , _index_block_2(_index_block_2_buffer.data(), MAX_BLOCK_SIZE / sizeof(block_index_t))
     , _index_block_3(_index_block_3_buffer.data(), MAX_BLOCK_SIZE / sizeof(block_index_t))
+    , _block_maps(block_maps)
     , _should_resize(should_resize)
 {
     _occupied_blocks = _inode.file_size % _block_device.dataSize() == 0
         ? _inode.file_size / _block_device.dataSize()
         : _inode.file_size / _block_device.dataSize() + 1;
+    if (_block_maps == nullptr)
+        return;
+
+    // Slots are borrowed only for depths the file already has, so small files leave them free
+    size_t indexes_per_block = _block_device.dataSize() / sizeof(block_index_t);
+    std::array<bool, BlockMapPool::LEVELS> has_level {
+        _occupied_blocks > 12,
+        _occupied_blocks > 12 + indexes_per_block,
+        _occupied_blocks > 12 + indexes_per_block + indexes_per_block * indexes_per_block,
+    };
+    if (_inode.extent_mapped)
+        has_level = { _inode.extent_count > Inode::INLINE_EXTENTS, false, false };
+    std::array<static_vector<block_index_t>*, BlockMapPool::LEVELS> buffers {
+        &_index_block_1,
+        &_index_block_2,
+        &_index_block_3,
+    };
+    for (size_t level = 0; level < BlockMapPool::LEVELS; level++) {
+        if (!has_level[level])
+            continue;
+        _slots[level] = _block_maps->borrow(inode_index, level);
+        if (_slots[level] != nullptr)
+            *buffers[level] = static_vector<block_index_t>(
+                _slots[level]->indices.data(), MAX_BLOCK_SIZE / sizeof(block_index_t));
+    }
+}
+
+BlockIndexIterator::~BlockIndexIterator()
+{
+    std::array<block_index_t, UNUSED_FREE_BATCH> unused_buffer;
+    while (_run_left > 0) {
+        static_vector<block_index_t> unused(unused_buffer.data(), UNUSED_FREE_BATCH);
+        for (; _run_left > 0 && unused.size() < UNUSED_FREE_BATCH; _run_left--) {
+            unused.push_back(_run_next++);
+        }
+        (void)freeBlocksOrEach(_block_manager, unused);
+    }
+    for (auto slot : _slots) {
+        if (slot != nullptr)
+            _block_maps->giveBack(slot);
+    }
+}
+
+void BlockIndexIterator::expectBlocks(size_t end_index)
+{
+    size_t first_new = std::max(_index, _occupied_blocks);
+    _expected_blocks = end_index > first_new ? end_index - first_new : 0;
 }
 
 std::expected<block_index_t, FsError> BlockIndexIterator::nextWithIndirectBlocksAdded(
     static_vector<block_index_t>& indirect_blocks_added)
+{
+    auto res = _nextBlock(indirect_blocks_added);
+    if (res.has_value()) {
+        _last_block = res.value();
+    }
+    return res;
+}
+
+std::expected<block_index_t, FsError> BlockIndexIterator::_nextBlock(
+    static_vector<block_index_t>& indirect_blocks_added)
 {
     if (indirect_blocks_added.capacity() < 3)
         return std::unexpected(FsError::FileIO_InvalidRequest);
@@ -213,6 +415,9 @@ std::expected<block_index_t, FsError> BlockIndexIterator::nextWithIndirectBlocks
         return std::unexpected(FsError::FileIO_OutOfBounds);
     }
 
+    if (_inode.extent_mapped)
+        return _nextExtentBlock();
+
     // direct blocks
     if (_index < 12) {
         if (_index >= _occupied_blocks) {
@@ -462,11 +667,29 @@ std::expected<block_index_t, FsError> BlockIndexIterator::next()
     return res.value();
 }
 
+std::optional<block_index_t>* BlockIndexIterator::_tagOf(const static_vector<block_index_t>& buf)
+{
+    for (auto slot : _slots) {
+        if (slot != nullptr && buf.data() == slot->indices.data())
+            return &slot->block;
+    }
+    return nullptr;
+}
+
 std::expected<void, FsError> BlockIndexIterator::_readIndexBlock(
     block_index_t index, static_vector<block_index_t>& buf)
 {
     size_t indexes_per_block = _block_device.dataSize() / sizeof(block_index_t);
 
+    auto tag = _tagOf(buf);
+    if (tag != nullptr && *tag == index) {
+        buf.resize(indexes_per_block);
+        return {};
+    }
+    // Buffer is overwritten now, so it holds no block until the read succeeds
+    if (tag != nullptr)
+        tag->reset();
+
     static_vector<uint8_t> temp_buff(
         reinterpret_cast<uint8_t*>(buf.data()), indexes_per_block * sizeof(block_index_t), 0);
     auto read_res = _block_device.readBlock(
@@ -476,6 +699,8 @@ std::expected<void, FsError> BlockIndexIterator::_readIndexBlock(
         return std::unexpected(read_res.error());
 
     buf.resize(indexes_per_block);
+    if (tag != nullptr)
+        *tag = index;
     return {};
 }
 
@@ -489,22 +714,328 @@ std::expected<void, FsError> BlockIndexIterator::_writeIndexBlock(
         reinterpret_cast<uint8_t*>(const_cast<block_index_t*>(indices.data())), bytes_to_write,
         bytes_to_write);
 
+    // Buffer differs from the disk until the write succeeds
+    auto tag = _tagOf(indices);
+    if (tag != nullptr)
+        tag->reset();
+
     auto res = _block_device.writeBlock(bytes, DataLocation(index, 0));
 
     if (!res.has_value())
         return std::unexpected(res.error());
 
+    if (tag != nullptr && bytes_to_write == indexes_per_block * sizeof(block_index_t))
+        *tag = index;
+    return {};
+}
+
+std::expected<block_index_t, FsError> BlockIndexIterator::_nextExtentBlock()
+{
+    if (_index < _occupied_blocks) {
+        auto extent_res = _findExtent(_index);
+        if (!extent_res.has_value())
+            return std::unexpected(extent_res.error());
+        auto extent = extent_res.value();
+        return extent->physical_start + (_index++ - extent->logical_start);
+    }
+
+    if (!_extents_trimmed) {
+        auto trim_res = trimExtents(_occupied_blocks);
+        if (!trim_res.has_value())
+            return std::unexpected(trim_res.error());
+    }
+
+    // Writes past the end allocate the blocks in between too, extents have no gaps
+    block_index_t block;
+    do {
+        auto index_res = _findAndReserveBlock();
+        if (!index_res.has_value())
+            return std::unexpected(index_res.error());
+        block = index_res.value();
+        auto append_res = _appendToExtents(block);
+        if (!append_res.has_value()) {
+            (void)_block_manager.free(block);
+            return std::unexpected(append_res.error());
+        }
+    } while (_extents_end <= _index);
+    _index++;
+    return block;
+}
+
+std::expected<void, FsError> BlockIndexIterator::trimExtents(size_t end)
+{
+    size_t old_count = _inode.extent_count;
+    size_t kept = 0;
+    if (old_count > 0 && end > 0) {
+        auto last_res = _extentAt(old_count - 1);
+        if (!last_res.has_value())
+            return std::unexpected(last_res.error());
+        auto last = last_res.value();
+        kept = old_count;
+        if (last->logical_start + last->length > end) {
+            // Extents have no gaps, the one holding the last kept block becomes the last one
+            auto keep_res = _findExtent(end - 1);
+            if (!keep_res.has_value())
+                return std::unexpected(keep_res.error());
+            last = keep_res.value();
+            kept = _extent_hint + 1;
+            if (last->logical_start + last->length > end) {
+                last->length = end - last->logical_start;
+                if (_extent_hint >= Inode::INLINE_EXTENTS) {
+                    auto write_res = _writeIndexBlock(_extent_block_index, _index_block_1);
+                    if (!write_res.has_value())
+                        return std::unexpected(write_res.error());
+                }
+            }
+        }
+        _extents_end = last->logical_start + last->length;
+        _last_block = last->physical_start + last->length - 1;
+    }
+    _inode.extent_count = kept;
+    if (kept == 0)
+        _extents_end = 0;
+    _extents_trimmed = true;
+
+    size_t old_blocks = _extentBlocksFor(old_count);
+    size_t new_blocks = _extentBlocksFor(kept);
+    if (new_blocks < old_blocks)
+        return _freeExtentBlocks(new_blocks, old_blocks - new_blocks);
+    return {};
+}
+
+std::expected<Extent*, FsError> BlockIndexIterator::_extentAt(size_t number)
+{
+    if (number < Inode::INLINE_EXTENTS)
+        return &_inode.extents[number];
+
+    size_t in_blocks = number - Inode::INLINE_EXTENTS;
+    auto load_res = _loadExtentBlock(in_blocks / _extentsPerBlock());
+    if (!load_res.has_value())
+        return std::unexpected(load_res.error());
+    return reinterpret_cast<Extent*>(_index_block_1.data()) + in_blocks % _extentsPerBlock();
+}
+
+std::expected<Extent*, FsError> BlockIndexIterator::_findExtent(size_t index)
+{
+    auto contains = [index](const Extent* extent) {
+        return index >= extent->logical_start && index < extent->logical_start + extent->length;
+    };
+
+    // Sequential access stays in the same extent or moves to the next one
+    for (size_t number = _extent_hint;
+        number < std::min<size_t>(_extent_hint + 2, _inode.extent_count); number++) {
+        auto extent_res = _extentAt(number);
+        if (!extent_res.has_value())
+            return std::unexpected(extent_res.error());
+        if (contains(extent_res.value())) {
+            _extent_hint = number;
+            return extent_res.value();
+        }
+    }
+
+    size_t low = 0;
+    size_t high = _inode.extent_count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        auto extent_res = _extentAt(middle);
+        if (!extent_res.has_value())
+            return std::unexpected(extent_res.error());
+        auto extent = extent_res.value();
+        if (contains(extent)) {
+            _extent_hint = middle;
+            return extent;
+        }
+        if (index < extent->logical_start)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return std::unexpected(FsError::FileIO_InternalError);
+}
+
+std::expected<void, FsError> BlockIndexIterator::_appendToExtents(block_index_t block)
+{
+    auto count = _inode.extent_count;
+    if (count > 0) {
+        auto last_res = _extentAt(count - 1);
+        if (!last_res.has_value())
+            return std::unexpected(last_res.error());
+        auto last = last_res.value();
+        if (last->physical_start + last->length == block) {
+            last->length++;
+            _extents_end++;
+            if (count > Inode::INLINE_EXTENTS)
+                return _writeIndexBlock(_extent_block_index, _index_block_1);
+            return {};
+        }
+    }
+
+    Extent extent { .logical_start = static_cast<std::uint32_t>(_extents_end),
+        .physical_start = block,
+        .length = 1 };
+    if (count < Inode::INLINE_EXTENTS) {
+        _inode.extents[count] = extent;
+        _inode.extent_count++;
+        _extents_end++;
+        return {};
+    }
+
+    size_t in_blocks = count - Inode::INLINE_EXTENTS;
+    size_t number = in_blocks / _extentsPerBlock();
+    std::optional<block_index_t> new_extent_block;
+    if (in_blocks % _extentsPerBlock() == 0) {
+        // Extent blocks are kept away from data, so that they don't split the runs
+        auto run_res = _block_manager.reserveRun(0, 1);
+        if (!run_res.has_value())
+            return std::unexpected(run_res.error());
+        new_extent_block = run_res.value().start;
+        if (number == 0) {
+            _inode.extent_block = new_extent_block.value();
+        } else {
+            // Full chain gets one more block, linked from its last one
+            auto link_res = _loadExtentBlock(number - 1);
+            if (link_res.has_value()) {
+                _index_block_1[_index_block_1.size() - 1] = new_extent_block.value();
+                link_res = _writeIndexBlock(_extent_block_index, _index_block_1);
+            }
+            if (!link_res.has_value()) {
+                (void)_block_manager.free(new_extent_block.value());
+                _extent_block_number.reset();
+                return std::unexpected(link_res.error());
+            }
+        }
+        _index_block_1.resize(_block_device.dataSize() / sizeof(block_index_t));
+        _extent_block_number = number;
+        _extent_block_index = new_extent_block.value();
+    } else {
+        auto load_res = _loadExtentBlock(number);
+        if (!load_res.has_value())
+            return std::unexpected(load_res.error());
+    }
+
+    reinterpret_cast<Extent*>(_index_block_1.data())[in_blocks % _extentsPerBlock()] = extent;
+    auto write_res = _writeIndexBlock(_extent_block_index, _index_block_1);
+    if (!write_res.has_value()) {
+        if (new_extent_block.has_value())
+            (void)_block_manager.free(new_extent_block.value());
+        _extent_block_number.reset();
+        return std::unexpected(write_res.error());
+    }
+    _inode.extent_count++;
+    _extents_end++;
     return {};
 }
 
+size_t BlockIndexIterator::_extentsPerBlock() const
+{
+    return (_block_device.dataSize() - sizeof(block_index_t)) / sizeof(Extent);
+}
+
+size_t BlockIndexIterator::_extentBlocksFor(size_t extents) const
+{
+    if (extents <= Inode::INLINE_EXTENTS)
+        return 0;
+    return (extents - Inode::INLINE_EXTENTS + _extentsPerBlock() - 1) / _extentsPerBlock();
+}
+
+std::expected<void, FsError> BlockIndexIterator::_loadExtentBlock(size_t number)
+{
+    if (_extent_block_number == number)
+        return {};
+
+    // Chain is linked forward only, going back starts again from the inode
+    size_t current = 0;
+    block_index_t block = _inode.extent_block;
+    if (_extent_block_number.has_value() && _extent_block_number.value() < number) {
+        current = _extent_block_number.value() + 1;
+        block = _index_block_1[_index_block_1.size() - 1];
+    }
+    _extent_block_number.reset();
+    while (true) {
+        auto read_res = _readIndexBlock(block, _index_block_1);
+        if (!read_res.has_value())
+            return std::unexpected(read_res.error());
+        if (current == number)
+            break;
+        block = _index_block_1[_index_block_1.size() - 1];
+        current++;
+    }
+    _extent_block_number = number;
+    _extent_block_index = block;
+    return {};
+}
+
+std::expected<void, FsError> BlockIndexIterator::_freeExtentBlocks(size_t first, size_t count)
+{
+    block_index_t block = _inode.extent_block;
+    if (first > 0) {
+        auto load_res = _loadExtentBlock(first - 1);
+        if (!load_res.has_value())
+            return std::unexpected(load_res.error());
+        block = _index_block_1[_index_block_1.size() - 1];
+    }
+
+    std::array<block_index_t, UNUSED_FREE_BATCH> batch_buffer;
+    static_vector<block_index_t> batch(batch_buffer.data(), UNUSED_FREE_BATCH);
+    std::expected<void, FsError> free_res;
+    for (size_t i = 0; i < count; i++) {
+        batch.push_back(block);
+        // Link to the next block is read before the block is freed
+        if (i + 1 < count) {
+            _extent_block_number.reset();
+            auto read_res = _readIndexBlock(block, _index_block_1);
+            if (!read_res.has_value()) {
+                free_res = std::unexpected(read_res.error());
+                break;
+            }
+            block = _index_block_1[_index_block_1.size() - 1];
+        }
+        if (batch.size() == UNUSED_FREE_BATCH) {
+            auto batch_res = freeBlocksOrEach(_block_manager, batch);
+            if (!batch_res.has_value() && free_res.has_value())
+                free_res = batch_res;
+            batch.resize(0);
+        }
+    }
+    auto batch_res = freeBlocksOrEach(_block_manager, batch);
+    if (!batch_res.has_value() && free_res.has_value())
+        free_res = batch_res;
+
+    // Freed blocks may be reused for anything, the buffer must not be taken for them
+    _extent_block_number.reset();
+    if (auto tag = _tagOf(_index_block_1); tag != nullptr)
+        tag->reset();
+    return free_res;
+}
+
+block_index_t BlockIndexIterator::_allocationGoal() const
+{
+    if (_last_block.has_value())
+        return _last_block.value() + 1;
+    // Extent mapped files have no block pointers, their end is known once extents are trimmed
+    if (_inode.extent_mapped)
+        return 0;
+    // Nothing was visited yet, appending to a small file continues after its last direct block
+    if (_occupied_blocks > 0 && _occupied_blocks <= 12)
+        return _inode.direct_blocks[_occupied_blocks - 1] + 1;
+    return 0;
+}
+
 std::expected<block_index_t, FsError> BlockIndexIterator::_findAndReserveBlock()
 {
-    auto index_res = _block_manager.getFree();
-    if (!index_res.has_value()) {
-        return index_res;
-    }
-    auto reserve_res = _block_manager.reserve(index_res.value());
-    if (!reserve_res.has_value())
-        return std::unexpected(reserve_res.error());
-    return index_res;
+    if (_run_left == 0) {
+        auto run_res
+            = _block_manager.reserveRun(_allocationGoal(), std::max<size_t>(_expected_blocks, 1));
+        if (!run_res.has_value())
+            return std::unexpected(run_res.error());
+        _run_next = run_res.value().start;
+        _run_left = run_res.value().count;
+    }
+
+    block_index_t block = _run_next++;
+    _run_left--;
+    if (_expected_blocks > 0)
+        _expected_blocks--;
+    _last_block = block;
+    return block;
 }
@@ -16,9 +16,11 @@
  * Validates that required fields (total_size, block_size) are present.
  *
  * @param path path to the configuration file
+ * @param require_layout whether fields needed to format are required, mounting only takes
+ * runtime options like cache_policy and reads the layout from disk
  * @return FsConfig on success, FsError on failure
  */
-std::expected<FsConfig, FsError> load_fs_config(std::string_view path);
+std::expected<FsConfig, FsError> load_fs_config(std::string_view path, bool require_layout = true);
 
 /**
  * Prints an example configuration file to stdout.
@@ -106,6 +106,32 @@ struct IFilesystem {
         file_descriptor_t fd, const static_vector<std::uint8_t>& buffer)
         = 0;
 
+    /**
+     * Read bytes from given offset in file, the position of the descriptor is not changed
+     *
+     * @param fd file descriptor of a file to read from
+     * @param offset byte offset in file to start reading from
+     * @param bytes_to_read number of bytes to read
+     * @param data buffer to fill with read data, must have sufficient capacity
+     * @return void on success, error otherwise
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> readAt(file_descriptor_t fd,
+        size_t offset, std::size_t bytes_to_read, static_vector<std::uint8_t>& data)
+        = 0;
+
+    /**
+     * Write data from buffer at given offset in file, the position of the descriptor is not
+     * changed. Files opened for appending are written at their end.
+     *
+     * @param fd file descriptor of file to write to
+     * @param offset byte offset in file to start writing at, at most the file size
+     * @param buffer data to write
+     * @return number of written bytes, error otherwise
+     */
+    [[nodiscard]] virtual std::expected<size_t, FsError> writeAt(
+        file_descriptor_t fd, size_t offset, const static_vector<std::uint8_t>& buffer)
+        = 0;
+
     /**
      * Seek to position in file
      *
@@ -157,6 +183,13 @@ struct IFilesystem {
      */
     [[nodiscard]] virtual std::expected<FileStat, FsError> getFileStat(std::string_view path) = 0;
 
+    /**
+     * Write all data kept in memory to the disk
+     *
+     * @return void on success, error otherwise
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> sync() = 0;
+
     /**
      * Check if filesystem has been initialized and is ready for operations
      *
@@ -2,6 +2,7 @@
 #include "ppfs/directory_manager/directory.hpp"
 #include "ppfs/filesystem/ifilesystem.hpp"
 #include "ppfs/inode_manager/inode.hpp"
+#include <optional>
 
 struct FileAttributes {
     size_t size;
@@ -49,6 +50,22 @@ public:
         inode_index_t inode, static_vector<DirectoryEntry>& buf, size_t offset, size_t size)
         = 0;
 
+    /**
+     * Read entries of a directory together with their attributes
+     *
+     * @param inode inode of the directory
+     * @param buf buffer to fill with directory entries, must have sufficient capacity
+     * @param attributes buffer to fill with attributes in the order of entries, empty for
+     * entries whose inode could not be read, must have sufficient capacity
+     * @param offset entry offset to start reading from
+     * @param size maximum number of entries to read (0 = all remaining entries)
+     * @return void on success, error otherwise
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> getDirectoryEntriesWithAttributes(
+        inode_index_t inode, static_vector<DirectoryEntry>& buf,
+        static_vector<std::optional<FileAttributes>>& attributes, size_t offset, size_t size)
+        = 0;
+
     /**
      * Create new directory
      *
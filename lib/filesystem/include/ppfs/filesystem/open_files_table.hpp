@@ -1,29 +1,38 @@
 #pragma once
+#include "ppfs/common/ppfs_mutex.hpp"
 #include "ppfs/common/types.hpp"
 #include "ppfs/filesystem/types.hpp"
 
 #include <array>
+#include <atomic>
 #include <expected>
 #include <optional>
+#include <utility>
 
 /**
  * Represents an open file with its inode, current position, and access mode.
  */
 struct OpenFile {
     inode_index_t inode;
-    std::size_t position;
+    /** Changed under the descriptor lock, read by truncate which only holds the inode lock */
+    std::atomic<std::size_t> position;
     OpenMode mode;
 };
 
 /**
  * Table managing open files with concurrent access handling.
+ *
+ * Slots are guarded by an internal mutex. Contents of an OpenFile returned by get are not,
+ * callers serialize access to one descriptor themselves. If the internal mutex could not be
+ * created, isInitialized is false and every operation fails.
+ *
  * @tparam MAX Maximum number of simultaneously open files.
  */
 template <std::size_t MAX> class OpenFilesTable {
     std::array<std::optional<OpenFile>, MAX> _table;
+    PpFSMutex _mutex;
 
-public:
-    std::optional<OpenFile*> get(file_descriptor_t fd)
+    std::optional<OpenFile*> _get(file_descriptor_t fd)
     {
         if (fd >= MAX) {
             return {};
@@ -35,7 +44,7 @@ public:
         return {};
     }
 
-    std::optional<OpenFile*> get(inode_index_t inode)
+    std::optional<OpenFile*> _get(inode_index_t inode)
     {
         for (int i = 0; i < MAX; ++i) {
             auto& entry = _table[i];
@@ -46,7 +55,8 @@ public:
         return {};
     }
 
-    [[nodiscard]] std::expected<file_descriptor_t, FsError> open(inode_index_t inode, OpenMode mode)
+    [[nodiscard]] std::expected<file_descriptor_t, FsError> _open(
+        inode_index_t inode, OpenMode mode)
     {
         // Check if already open in exclusive/protected mode and save a free spot
         std::optional<int> free_spot;
@@ -72,13 +82,13 @@ public:
         }
 
         if (free_spot.has_value()) {
-            _table[free_spot.value()] = OpenFile { inode, 0, mode };
+            _table[free_spot.value()].emplace(inode, 0, mode);
             return free_spot.value();
         }
         return std::unexpected(FsError::PpFS_OpenFilesTableFull);
     }
 
-    [[nodiscard]] std::expected<void, FsError> close(file_descriptor_t fd)
+    [[nodiscard]] std::expected<void, FsError> _close(file_descriptor_t fd)
     {
         if (fd >= MAX) {
             return std::unexpected(FsError::PpFS_OutOfBounds);
@@ -91,19 +101,101 @@ public:
         return std::unexpected(FsError::PpFS_NotFound);
     }
 
+public:
+    // A failed init leaves the mutex unusable, which isInitialized reports
+    OpenFilesTable() { (void)_mutex.init(); }
+
+    /** Whether the internal mutex was created, PpFS refuses to mount otherwise */
+    bool isInitialized() const { return _mutex.isInitialized(); }
+
+    /**
+     * Looks up an open descriptor.
+     *
+     * The slot is reset by close, so the returned pointer is only valid while the caller holds
+     * the lock of that descriptor.
+     */
+    std::optional<OpenFile*> get(file_descriptor_t fd)
+    {
+        if (!_mutex.lock().has_value()) {
+            return {};
+        }
+        auto open_file = _get(fd);
+        (void)_mutex.unlock();
+        return open_file;
+    }
+
+    /**
+     * Copies inode and mode of an open descriptor, for callers that don't hold its lock and so
+     * must not keep the slot.
+     */
+    std::optional<std::pair<inode_index_t, OpenMode>> describe(file_descriptor_t fd)
+    {
+        if (!_mutex.lock().has_value()) {
+            return {};
+        }
+        std::optional<std::pair<inode_index_t, OpenMode>> description;
+        auto open_file = _get(fd);
+        if (open_file.has_value()) {
+            description.emplace(open_file.value()->inode, open_file.value()->mode);
+        }
+        (void)_mutex.unlock();
+        return description;
+    }
+
+    /**
+     * Looks up any descriptor open on inode. Other descriptors are not locked by the caller, so
+     * the result is only meant to tell whether the inode is open.
+     */
+    std::optional<OpenFile*> get(inode_index_t inode)
+    {
+        if (!_mutex.lock().has_value()) {
+            return {};
+        }
+        auto open_file = _get(inode);
+        (void)_mutex.unlock();
+        return open_file;
+    }
+
+    [[nodiscard]] std::expected<file_descriptor_t, FsError> open(inode_index_t inode, OpenMode mode)
+    {
+        auto lock_res = _mutex.lock();
+        if (!lock_res.has_value()) {
+            return std::unexpected(lock_res.error());
+        }
+        auto open_res = _open(inode, mode);
+        (void)_mutex.unlock();
+        return open_res;
+    }
+
+    [[nodiscard]] std::expected<void, FsError> close(file_descriptor_t fd)
+    {
+        auto lock_res = _mutex.lock();
+        if (!lock_res.has_value()) {
+            return lock_res;
+        }
+        auto close_res = _close(fd);
+        (void)_mutex.unlock();
+        return close_res;
+    }
+
     [[nodiscard]] bool checkIfCanResize(inode_index_t inode, size_t size)
     {
+        if (!_mutex.lock().has_value()) {
+            return false;
+        }
+        bool can_resize = true;
         for (int i = 0; i < MAX; ++i) {
             auto& entry = _table[i];
             if (entry.has_value() && entry->inode == inode) {
                 if (entry->mode & OpenMode::Exclusive)
-                    return false;
+                    can_resize = false;
 
-                if (!(entry->mode & OpenMode::Append) && entry->position > size)
-                    return false;
+                if (!(entry->mode & OpenMode::Append) && entry->position.load() > size)
+                    can_resize = false;
             }
         }
+        (void)_mutex.unlock();
 
-        return true;
+        return can_resize;
     }
 };
@@ -1,4 +1,5 @@
 #pragma once
+#include "ppfs/common/mutex_wrapper.hpp"
 #include "ppfs/common/ppfs_mutex.hpp"
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/filesystem/ifilesystem.hpp"
@@ -8,6 +9,7 @@
 #include <variant>
 
 #include "ppfs/block_manager/block_manager.hpp"
+#include "ppfs/blockdevice/caching_block_device.hpp"
 #include "ppfs/blockdevice/crc_block_device.hpp"
 #include "ppfs/blockdevice/hamming_block_device.hpp"
 #include "ppfs/blockdevice/iblock_device.hpp"
@@ -24,6 +26,16 @@
 
 static constexpr size_t MAX_OPEN_FILES = 32;
 
+#ifndef PPFS_INODE_LOCKS
+/** Number of reader/writer locks guarding file data, inodes share them by index modulo */
+#    define PPFS_INODE_LOCKS 64
+#endif
+
+#ifndef PPFS_BITMAP_MIRROR_BITS
+/** Bits of bitmap kept in memory, shared by the inode and the block bitmap */
+#    define PPFS_BITMAP_MIRROR_BITS (1 << 18)
+#endif
+
 /**
  * ParityPartyFS - A fault-tolerant filesystem with configurable error correction.
  *
@@ -31,12 +43,23 @@ static constexpr size_t MAX_OPEN_FILES = 32;
  * - Multiple error correction schemes (None, CRC, Hamming, Parity, Reed-Solomon)
  * - Inode-based file and directory management
  * - Block allocation and management
- * - Concurrent file access with mutex protection
+ * - Concurrent file access with fine-grained locking
  * - Superblock redundancy for metadata protection
  * - File descriptor-based API similar to POSIX
  *
  * The filesystem must be formatted with format() before use and initialized
  * with init() to set up internal structures. All operations are thread-safe.
+ *
+ * Locks are always taken in this order, so they can't deadlock:
+ * - namespace lock, exclusive while directories change, shared while paths are resolved,
+ * - descriptor lock, serializing operations on one open file descriptor,
+ * - inode lock, exclusive while file data changes, shared while it is read, a thread holds
+ *   at most one,
+ * - internal locks of the open files table, inode manager, block manager and caches.
+ * Reads and writes of open files only take the last three, so reads of different files run in
+ * parallel. readAt() leaves the descriptor alone and skips its lock as well. It checks the
+ * descriptor again once it holds the inode lock, and removal frees a file only under its
+ * exclusive inode lock, so the file can't be freed under a running readAt().
  */
 class PpFS : public virtual IFilesystem {
 protected:
@@ -46,7 +69,11 @@ protected:
     std::variant<std::monostate, RawBlockDevice, CrcBlockDevice, HammingBlockDevice,
         ParityBlockDevice, ReedSolomonBlockDevice>
         _blockDeviceStorage;
+    /** Declared after the wrapped device, so dirty blocks are written back before it's gone */
+    std::variant<std::monostate, CachingBlockDevice> _cacheStorage;
     IBlockDevice* _blockDevice = nullptr;
+    CachePolicy _cachePolicy;
+    static_vector<CachingBlockDevice::Entry> _cacheEntries;
 
     std::variant<std::monostate, SuperBlockManager> _superBlockManagerStorage;
     SuperBlockManager* _superBlockManager = nullptr;
@@ -62,24 +89,76 @@ protected:
 
     std::variant<std::monostate, FileIO> _fileIOStorage;
     FileIO* _fileIO = nullptr;
+    /** Index blocks decoded by reads and writes through descriptors, shared by all files */
+    BlockMapPool _blockMaps;
 
     inode_index_t _root = 0;
     SuperBlock _superBlock;
 
-    PpFSMutex _mutex;
+    /**
+     * Mirrors of both bitmaps, the inode bitmap takes what it needs and the block bitmap the
+     * rest. A bitmap that doesn't fit stays on disk.
+     */
+    std::array<std::uint64_t, Bitmap::mirrorWords(PPFS_BITMAP_MIRROR_BITS)> _bitmapMirror;
+
+    static constexpr size_t INODE_LOCKS = PPFS_INODE_LOCKS;
+
+    PpFSSharedMutex _namespaceLock;
+    std::array<PpFSMutex, MAX_OPEN_FILES> _descriptorLocks;
+    std::array<PpFSSharedMutex, INODE_LOCKS> _inodeLocks;
     OpenFilesTable<MAX_OPEN_FILES> _openFilesTable;
 
+    [[nodiscard]] std::expected<void, FsError> _initLocks();
+    static_vector<std::uint64_t> _inodeBitmapMirror();
+    static_vector<std::uint64_t> _blockBitmapMirror();
+    PpFSSharedMutex& _inodeLock(inode_index_t inode);
+
+    /** Runs f holding the lock of descriptor fd. */
+    template <typename T, typename Func>
+    std::expected<T, FsError> _descriptorWrapper(file_descriptor_t fd, Func f)
+    {
+        if (!isInitialized()) {
+            return std::unexpected(FsError::PpFS_NotInitialized);
+        }
+        if (fd < 0 || fd >= static_cast<file_descriptor_t>(MAX_OPEN_FILES)) {
+            return std::unexpected(FsError::PpFS_NotFound);
+        }
+        return mutex_wrapper<T>(_descriptorLocks[fd], f);
+    }
+
+    /** Runs f holding the lock of descriptor fd and the lock of its inode. */
+    template <typename T, typename Func>
+    std::expected<T, FsError> _fileWrapper(file_descriptor_t fd, bool exclusive, Func f)
+    {
+        return _descriptorWrapper<T>(fd, [&]() -> std::expected<T, FsError> {
+            auto open_file = _openFilesTable.get(fd);
+            if (!open_file.has_value()) {
+                return std::unexpected(FsError::PpFS_NotFound);
+            }
+            auto& inode_lock = _inodeLock(open_file.value()->inode);
+            if (exclusive) {
+                return mutex_wrapper<T>(inode_lock, f);
+            }
+            return shared_mutex_wrapper<T>(inode_lock, f);
+        });
+    }
+
     [[nodiscard]] std::expected<inode_index_t, FsError> _getParentInodeFromPath(
         std::string_view path) const;
     [[nodiscard]] std::expected<inode_index_t, FsError> _getInodeFromPath(std::string_view path);
     [[nodiscard]] std::expected<inode_index_t, FsError> _getInodeFromParent(
         inode_index_t parent_inode, std::string_view path) const;
+    /** Null-terminated last component of path, as directory manager takes names */
+    static std::array<char, 128> _entryName(std::string_view path);
     bool _isPathValid(std::string_view path);
     [[nodiscard]] std::expected<void, FsError> _checkIfInUseRecursive(inode_index_t inode);
     [[nodiscard]] std::expected<void, FsError> _removeRecursive(
-        inode_index_t parent, inode_index_t inode);
+        inode_index_t parent, inode_index_t inode, const char* name);
     [[nodiscard]] std::expected<void, FsError> _createAppropriateBlockDevice(size_t block_size,
         ECCType eccType, std::uint64_t polynomial, std::uint32_t correctable_bytes);
+    /** Pins inode of a newly opened file, closes the descriptor again on failure. */
+    [[nodiscard]] std::expected<void, FsError> _pinOpenInode(
+        file_descriptor_t fd, inode_index_t inode);
 
     [[nodiscard]] std::expected<void, FsError> _unprotectedCreate(std::string_view path);
     [[nodiscard]] std::expected<file_descriptor_t, FsError> _unprotectedOpen(
@@ -91,8 +170,19 @@ protected:
         file_descriptor_t fd, std::size_t bytes_to_read, static_vector<std::uint8_t>& data);
     [[nodiscard]] std::expected<size_t, FsError> _unprotectedWrite(
         file_descriptor_t fd, const static_vector<std::uint8_t>& buffer);
+    [[nodiscard]] std::expected<size_t, FsError> _unprotectedWriteAt(
+        file_descriptor_t fd, size_t offset, const static_vector<std::uint8_t>& buffer);
     [[nodiscard]] std::expected<void, FsError> _unprotectedSeek(
         file_descriptor_t fd, size_t position);
+    /** Reads an open file at offset, used by read() and readAt(). */
+    [[nodiscard]] std::expected<void, FsError> _readOpenFile(inode_index_t inode_index,
+        OpenMode mode, size_t offset, std::size_t bytes_to_read, static_vector<std::uint8_t>& data);
+    /**
+     * Writes an open file at offset, or at its end in append mode, used by write() and
+     * writeAt(). On success offset is moved past the written data.
+     */
+    [[nodiscard]] std::expected<size_t, FsError> _writeOpenFile(
+        OpenFile& open_file, size_t& offset, const static_vector<std::uint8_t>& buffer);
     [[nodiscard]] std::expected<void, FsError> _unprotectedCreateDirectory(std::string_view path);
     [[nodiscard]] std::expected<void, FsError> _unprotectedReadDirectory(
         std::string_view path, static_vector<DirectoryEntry>& entries);
@@ -101,14 +191,22 @@ protected:
     [[nodiscard]] virtual std::expected<std::size_t, FsError> _unprotectedGetFileCount() const;
     [[nodiscard]] virtual std::expected<FileStat, FsError> _unprotectedGetFileStat(
         std::string_view path);
+    [[nodiscard]] std::expected<void, FsError> _unprotectedSync();
+    [[nodiscard]] std::expected<InodeCacheStats, FsError> _unprotectedGetInodeCacheStats() const;
 
 public:
     /**
      * Constructs a PpFS instance.
      * @param disk Underlying disk device for storage.
      * @param logger Optional logger for error tracking and diagnostics.
+     * @param cache_policy Caching of decoded blocks used by init(), format() takes it from
+     * FsConfig.
+     * @param cache_entries Storage of the block cache, must outlive PpFS. Blocks are cached only
+     * if the policy isn't None and it holds at least one entry.
      */
-    PpFS(IDisk& disk, std::shared_ptr<Logger> logger = nullptr);
+    PpFS(IDisk& disk, std::shared_ptr<Logger> logger = nullptr,
+        CachePolicy cache_policy = CachePolicy::None,
+        static_vector<CachingBlockDevice::Entry> cache_entries = {});
 
     /**
      * Initializes the filesystem from existing structures on disk.
@@ -206,6 +304,37 @@ public:
     [[nodiscard]] virtual std::expected<size_t, FsError> write(
         file_descriptor_t fd, const static_vector<std::uint8_t>& buffer) override;
 
+    /**
+     * Reads data from an open file at a given offset.
+     *
+     * Unlike seek() followed by read(), the descriptor position is not used nor changed, so
+     * concurrent positional reads through one descriptor do not interfere. They only share the
+     * inode lock, and each borrows its own slots of the shared BlockMapPool, falling back to
+     * decoding index blocks itself when all slots are in use.
+     *
+     * @param fd File descriptor from open().
+     * @param offset Byte offset from beginning of file.
+     * @param bytes_to_read Number of bytes to read.
+     * @param data Output buffer (must have sufficient capacity).
+     * @return void on success, error otherwise.
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> readAt(file_descriptor_t fd,
+        size_t offset, std::size_t bytes_to_read, static_vector<std::uint8_t>& data) override;
+
+    /**
+     * Writes data to an open file at a given offset.
+     *
+     * The descriptor position is not used nor changed. Files opened in append mode are
+     * written at their end regardless of offset.
+     *
+     * @param fd File descriptor from open().
+     * @param offset Byte offset from beginning of file, at most the file size.
+     * @param buffer Data to write.
+     * @return Number of bytes written on success, error otherwise.
+     */
+    [[nodiscard]] virtual std::expected<size_t, FsError> writeAt(file_descriptor_t fd,
+        size_t offset, const static_vector<std::uint8_t>& buffer) override;
+
     /**
      * Changes the current read/write position in a file.
      *
@@ -264,6 +393,22 @@ public:
     [[nodiscard]] virtual std::expected<FileStat, FsError> getFileStat(
         std::string_view path) override;
 
+    /**
+     * Writes everything kept in memory to the disk.
+     *
+     * Flushes cached inodes, blocks held by a write-back cache and finally the disk itself.
+     *
+     * @return void on success, error otherwise.
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> sync() override;
+
+    /**
+     * Returns hit and miss counters of the inode cache, for monitoring.
+     *
+     * @return counters on success, error otherwise.
+     */
+    [[nodiscard]] std::expected<InodeCacheStats, FsError> getInodeCacheStats();
+
     /**
      * Checks if the filesystem has been initialized.
      *
@@ -8,7 +8,8 @@
  */
 class PpFSLowLevel : virtual public IFilesystemLowLevel, public PpFS {
 public:
-    PpFSLowLevel(IDisk& disk);
+    PpFSLowLevel(IDisk& disk, CachePolicy cache_policy = CachePolicy::None,
+        static_vector<CachingBlockDevice::Entry> cache_entries = {});
     /**
      * This method returns attribues of a file
      * specified by a given inode.
@@ -22,6 +23,15 @@ public:
     [[nodiscard]] virtual std::expected<void, FsError> getDirectoryEntries(inode_index_t inode,
         static_vector<DirectoryEntry>& buf, size_t offset, size_t size) override;
 
+    /**
+     * Inodes of the entries are fetched in batches, so each inode table block is decoded once
+     * for all entries whose inodes it holds.
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> getDirectoryEntriesWithAttributes(
+        inode_index_t inode, static_vector<DirectoryEntry>& buf,
+        static_vector<std::optional<FileAttributes>>& attributes, size_t offset,
+        size_t size) override;
+
     [[nodiscard]] virtual std::expected<inode_index_t, FsError> createDirectoryByParent(
         inode_index_t parent, std::string_view name) override;
 
@@ -38,6 +48,11 @@ public:
         inode_index_t inode, size_t new_size) override;
 
 private:
+    /** Number of inodes fetched at once when listing attributes of directory entries. */
+    static constexpr size_t ATTRIBUTES_BATCH = 32;
+
+    FileAttributes _attributesOf(const Inode& inode) const;
+
     [[nodiscard]] std::expected<FileAttributes, FsError> _unprotectedGetAttributes(
         inode_index_t inode_index);
 
@@ -47,6 +62,10 @@ private:
     [[nodiscard]] std::expected<void, FsError> _unprotectedGetDirectoryEntries(
         inode_index_t inode, static_vector<DirectoryEntry>& buf, size_t offset, size_t size);
 
+    [[nodiscard]] std::expected<void, FsError> _unprotectedGetDirectoryEntriesWithAttributes(
+        inode_index_t inode, static_vector<DirectoryEntry>& buf,
+        static_vector<std::optional<FileAttributes>>& attributes, size_t offset, size_t size);
+
     [[nodiscard]] std::expected<inode_index_t, FsError> _unprotectedCreateDirectoryByParent(
         inode_index_t parent, std::string_view name);
 
@@ -1,5 +1,7 @@
 #pragma once
+#include "ppfs/blockdevice/cache_policy.hpp"
 #include "ppfs/blockdevice/ecc_type.hpp"
+#include "ppfs/common/allocation_policy.hpp"
 #include "ppfs/common/types.hpp"
 #include "ppfs/ecc_helpers/crc_polynomial.hpp"
 
@@ -41,6 +43,17 @@ struct FileStat {
     bool is_directory = false;
 };
 
+/**
+ * Counters of the inode cache.
+ */
+struct InodeCacheStats {
+    /** Inode reads served from memory */
+    std::size_t hits = 0;
+
+    /** Inode reads that went to the disk */
+    std::size_t misses = 0;
+};
+
 /**
  * Configuration parameters for filesystem initialization.
  */
@@ -67,4 +80,21 @@ struct FsConfig {
 
     /** Enable journaling */
     bool use_journal = false;
+
+    /** Caching of decoded blocks, not stored on disk. */
+    CachePolicy cache_policy = CachePolicy::None;
+
+    /** Where searches for free blocks and inodes start. */
+    AllocationPolicy allocation_policy = AllocationPolicy::FirstFit;
+
+    /** Pad the inode table so no inode crosses a block, trades some space for single block
+     * inode reads and writes. */
+    bool align_inodes = false;
+
+    /** Map data of new files and directories with extents instead of block pointers, fewer
+     * index blocks are read for large contiguous files. */
+    bool extent_mapped_files = false;
+
+    /** Give large directories an on-disk hash index, so lookups don't scan all entries. */
+    bool indexed_directories = false;
 };
@@ -15,7 +15,7 @@ std::string trim(const std::string& s)
     return s.substr(first, (last - first + 1));
 }
 
-std::expected<FsConfig, FsError> load_fs_config(std::string_view path)
+std::expected<FsConfig, FsError> load_fs_config(std::string_view path, bool require_layout)
 {
     std::ifstream file(path.data());
     if (!file.is_open()) {
@@ -66,6 +66,12 @@ std::expected<FsConfig, FsError> load_fs_config(std::string_view path)
                 cfg.rs_correctable_bytes = std::stoul(value);
             } else if (key == "use_journal") {
                 cfg.use_journal = (value == "true" || value == "1");
+            } else if (key == "align_inodes") {
+                cfg.align_inodes = (value == "true" || value == "1");
+            } else if (key == "extent_mapped_files") {
+                cfg.extent_mapped_files = (value == "true" || value == "1");
+            } else if (key == "indexed_directories") {
+                cfg.indexed_directories = (value == "true" || value == "1");
             } else if (key == "ecc_type") {
                 seen.ecc_type = true;
                 if (value == "none")
@@ -80,6 +86,24 @@ std::expected<FsConfig, FsError> load_fs_config(std::string_view path)
                     cfg.ecc_type = ECCType::Hamming;
                 else
                     return std::unexpected(FsError::Config_InvalidValue);
+            } else if (key == "cache_policy") {
+                if (value == "none")
+                    cfg.cache_policy = CachePolicy::None;
+                else if (value == "write_through")
+                    cfg.cache_policy = CachePolicy::WriteThrough;
+                else if (value == "write_back")
+                    cfg.cache_policy = CachePolicy::WriteBack;
+                else
+                    return std::unexpected(FsError::Config_InvalidValue);
+            } else if (key == "allocation_policy") {
+                if (value == "first_fit")
+                    cfg.allocation_policy = AllocationPolicy::FirstFit;
+                else if (value == "next_fit")
+                    cfg.allocation_policy = AllocationPolicy::NextFit;
+                else if (value == "thread_groups")
+                    cfg.allocation_policy = AllocationPolicy::ThreadGroups;
+                else
+                    return std::unexpected(FsError::Config_InvalidValue);
             } else if (key == "crc_polynomial") {
                 seen.crc_polynomial = true;
                 cfg.crc_polynomial = CrcPolynomial::MsgImplicit(std::stoull(value, nullptr, 0));
@@ -93,6 +117,9 @@ std::expected<FsConfig, FsError> load_fs_config(std::string_view path)
         }
     }
 
+    if (!require_layout)
+        return cfg;
+
     if (!seen.total_size || !seen.block_size || !seen.average_file_size || !seen.ecc_type)
         return std::unexpected(FsError::Config_MissingField);
 
@@ -122,9 +149,19 @@ void print_fs_config_usage(std::ostream& os)
 
           "# ---------------- boolean fields ----------------\n"
           "use_journal = false             # bool: enable journaling (true or false, default: "
-          "false)\n\n"
+          "false)\n"
+          "align_inodes = false            # bool: keep every inode within one block (true or "
+          "false, default: false)\n"
+          "extent_mapped_files = false     # bool: map file data with extents (true or false, "
+          "default: false)\n"
+          "indexed_directories = false     # bool: hash index for large directories (true or "
+          "false, default: false)\n\n"
 
           "# ---------------- enum fields ----------------\n"
           "ecc_type = crc                  # ECCType: none | crc | reed_solomon | parity | "
-          "hamming\n";
+          "hamming\n"
+          "cache_policy = none             # CachePolicy: none | write_through | write_back "
+          "(default: none)\n"
+          "allocation_policy = first_fit   # AllocationPolicy: first_fit | next_fit | "
+          "thread_groups (default: first_fit)\n";
 }
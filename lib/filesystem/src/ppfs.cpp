@@ -2,11 +2,12 @@
 #include "ppfs/common/math_helpers.hpp"
 #include "ppfs/common/ppfs_mutex.hpp"
 #include "ppfs/common/static_vector.hpp"
-#include "ppfs/filesystem/mutex_wrapper.hpp"
+#include "ppfs/common/mutex_wrapper.hpp"
 #include <array>
 #include <cstring>
 #include <numeric>
 
+#include "ppfs/blockdevice/caching_block_device.hpp"
 #include "ppfs/blockdevice/crc_block_device.hpp"
 #include "ppfs/blockdevice/hamming_block_device.hpp"
 #include "ppfs/blockdevice/iblock_device.hpp"
@@ -16,25 +17,80 @@
 
 #include <mutex>
 
-PpFS::PpFS(IDisk& disk, std::shared_ptr<Logger> logger)
+PpFS::PpFS(IDisk& disk, std::shared_ptr<Logger> logger, CachePolicy cache_policy,
+    static_vector<CachingBlockDevice::Entry> cache_entries)
     : _disk(disk)
     , _logger(logger)
+    , _cachePolicy(cache_policy)
+    , _cacheEntries(cache_entries)
 {
 }
 
 bool PpFS::isInitialized() const
 {
     return _blockDevice && _inodeManager && _blockManager && _directoryManager && _fileIO
-        && _superBlockManager && _mutex.isInitialized();
+        && _superBlockManager && _namespaceLock.isInitialized();
 }
 std::expected<std::size_t, FsError> PpFS::getFileCount()
 {
-    return mutex_wrapper<std::size_t>(_mutex, [&]() { return _unprotectedGetFileCount(); });
+    return shared_mutex_wrapper<std::size_t>(
+        _namespaceLock, [&]() { return _unprotectedGetFileCount(); });
+}
+
+std::expected<void, FsError> PpFS::_initLocks()
+{
+    // Components create their own mutexes when constructed
+    auto cache = std::get_if<CachingBlockDevice>(&_cacheStorage);
+    if (!_openFilesTable.isInitialized() || (cache != nullptr && !cache->isInitialized())
+        || !std::get<InodeManager>(_inodeManagerStorage).isInitialized()
+        || !std::get<BlockManager>(_blockManagerStorage).isInitialized()
+        || !std::get<DirectoryManager>(_directoryManagerStorage).isInitialized()) {
+        return std::unexpected(FsError::Mutex_InitFailed);
+    }
+    auto namespace_init = _namespaceLock.init();
+    if (!namespace_init.has_value()) {
+        return namespace_init;
+    }
+    for (auto& lock : _descriptorLocks) {
+        auto init_res = lock.init();
+        if (!init_res.has_value()) {
+            return init_res;
+        }
+    }
+    for (auto& lock : _inodeLocks) {
+        auto init_res = lock.init();
+        if (!init_res.has_value()) {
+            return init_res;
+        }
+    }
+    return {};
+}
+
+PpFSSharedMutex& PpFS::_inodeLock(inode_index_t inode) { return _inodeLocks[inode % INODE_LOCKS]; }
+
+static_vector<std::uint64_t> PpFS::_inodeBitmapMirror()
+{
+    size_t words = Bitmap::mirrorWords(_superBlock.total_inodes);
+    if (words > _bitmapMirror.size()) {
+        words = 0;
+    }
+    return static_vector<std::uint64_t>(_bitmapMirror.data(), words);
+}
+
+static_vector<std::uint64_t> PpFS::_blockBitmapMirror()
+{
+    size_t used = _inodeBitmapMirror().capacity();
+    return static_vector<std::uint64_t>(_bitmapMirror.data() + used, _bitmapMirror.size() - used);
 }
 
 std::expected<void, FsError> PpFS::_createAppropriateBlockDevice(
     size_t block_size, ECCType eccType, std::uint64_t polynomial, std::uint32_t correctable_bytes)
 {
+    // Old inode and block caches write back into the old device before it is replaced
+    _inodeManager = nullptr;
+    _inodeManagerStorage.emplace<std::monostate>();
+    _cacheStorage.emplace<std::monostate>();
+
     switch (eccType) {
     case ECCType::None: {
         _blockDeviceStorage.emplace<RawBlockDevice>(block_size, _disk);
@@ -66,6 +122,11 @@ std::expected<void, FsError> PpFS::_createAppropriateBlockDevice(
     default:
         return std::unexpected(FsError::PpFS_InvalidRequest);
     }
+
+    if (_cachePolicy != CachePolicy::None && _cacheEntries.capacity() > 0) {
+        _cacheStorage.emplace<CachingBlockDevice>(*_blockDevice, _cachePolicy, _cacheEntries);
+        _blockDevice = &std::get<CachingBlockDevice>(_cacheStorage);
+    }
     return {};
 }
 
@@ -89,24 +150,36 @@ std::expected<void, FsError> PpFS::init()
     }
 
     // Create inode manager
-    _inodeManagerStorage.emplace<InodeManager>(*_blockDevice, _superBlock);
+    _inodeManagerStorage.emplace<InodeManager>(*_blockDevice, _superBlock, _inodeBitmapMirror());
     _inodeManager = &std::get<InodeManager>(_inodeManagerStorage);
 
     // Create block manager
-    _blockManagerStorage.emplace<BlockManager>(_superBlock, *_blockDevice);
+    _blockManagerStorage.emplace<BlockManager>(_superBlock, *_blockDevice, _blockBitmapMirror());
     _blockManager = &std::get<BlockManager>(_blockManagerStorage);
 
+    // Bitmaps are read now rather than by the first allocation
+    auto inode_bitmap_res = _inodeManager->loadBitmap();
+    if (!inode_bitmap_res.has_value()) {
+        return inode_bitmap_res;
+    }
+    auto block_bitmap_res = _blockManager->loadBitmap();
+    if (!block_bitmap_res.has_value()) {
+        return block_bitmap_res;
+    }
+
     // Create file IO
-    _fileIOStorage.emplace<FileIO>(*_blockDevice, *_blockManager, *_inodeManager);
+    _blockMaps.invalidateAll();
+    _fileIOStorage.emplace<FileIO>(*_blockDevice, *_blockManager, *_inodeManager, &_blockMaps);
     _fileIO = &std::get<FileIO>(_fileIOStorage);
 
     // Create directory manager
-    _directoryManagerStorage.emplace<DirectoryManager>(*_blockDevice, *_inodeManager, *_fileIO);
+    _directoryManagerStorage.emplace<DirectoryManager>(
+        *_blockDevice, *_inodeManager, *_fileIO, _superBlock.indexed_directories);
     _directoryManager = &std::get<DirectoryManager>(_directoryManagerStorage);
 
-    auto mutex_init = _mutex.init();
-    if (!mutex_init.has_value()) {
-        return mutex_init;
+    auto locks_init = _initLocks();
+    if (!locks_init.has_value()) {
+        return locks_init;
     }
 
     return {};
@@ -128,6 +201,7 @@ std::expected<void, FsError> PpFS::format(FsConfig options)
     }
 
     // Create block device with appropriate ECC
+    _cachePolicy = options.cache_policy;
     auto bd_res = _createAppropriateBlockDevice(options.block_size, options.ecc_type,
         options.crc_polynomial.getExplicitPolynomial(), options.rs_correctable_bytes);
     if (!bd_res.has_value()) {
@@ -147,13 +221,17 @@ std::expected<void, FsError> PpFS::format(FsConfig options)
         return std::unexpected(FsError::NotImplemented);
     }
 
+    sb.inodes_block_aligned = options.align_inodes;
+    sb.extent_mapped_files = options.extent_mapped_files;
+    sb.indexed_directories = options.indexed_directories;
     sb.block_bitmap_address
-        = sb.inode_table_address + divCeil((sb.total_inodes * sizeof(Inode)), data_block_size);
+        = sb.inode_table_address + InodeManager::tableBlocks(sb, data_block_size);
     sb.first_data_blocks_address = sb.block_bitmap_address
         + divCeil(divCeil((size_t)(sb.total_blocks), 8UL), data_block_size);
     sb.last_data_block_address = sb.total_blocks - divCeil(sizeof(SuperBlock), data_block_size);
     sb.block_size = options.block_size;
     sb.ecc_type = options.ecc_type;
+    sb.allocation_policy = options.allocation_policy;
     if (sb.ecc_type == ECCType::Crc)
         sb.crc_polynomial = options.crc_polynomial.getExplicitPolynomial();
     if (sb.ecc_type == ECCType::ReedSolomon)
@@ -180,7 +258,7 @@ std::expected<void, FsError> PpFS::format(FsConfig options)
     _superBlock = sb;
 
     // Create and format inode manager
-    _inodeManagerStorage.emplace<InodeManager>(*_blockDevice, _superBlock);
+    _inodeManagerStorage.emplace<InodeManager>(*_blockDevice, _superBlock, _inodeBitmapMirror());
     _inodeManager = &std::get<InodeManager>(_inodeManagerStorage);
     auto format_inode_res = _inodeManager->format();
     if (!format_inode_res.has_value()) {
@@ -188,7 +266,7 @@ std::expected<void, FsError> PpFS::format(FsConfig options)
     }
 
     // Create and format block manager
-    _blockManagerStorage.emplace<BlockManager>(_superBlock, *_blockDevice);
+    _blockManagerStorage.emplace<BlockManager>(_superBlock, *_blockDevice, _blockBitmapMirror());
     _blockManager = &std::get<BlockManager>(_blockManagerStorage);
     auto format_block_res = _blockManager->format();
     if (!format_block_res.has_value()) {
@@ -196,70 +274,120 @@ std::expected<void, FsError> PpFS::format(FsConfig options)
     }
 
     // Create file IO
-    _fileIOStorage.emplace<FileIO>(*_blockDevice, *_blockManager, *_inodeManager);
+    _blockMaps.invalidateAll();
+    _fileIOStorage.emplace<FileIO>(*_blockDevice, *_blockManager, *_inodeManager, &_blockMaps);
     _fileIO = &std::get<FileIO>(_fileIOStorage);
 
     // Create directory manager
-    _directoryManagerStorage.emplace<DirectoryManager>(*_blockDevice, *_inodeManager, *_fileIO);
+    _directoryManagerStorage.emplace<DirectoryManager>(
+        *_blockDevice, *_inodeManager, *_fileIO, _superBlock.indexed_directories);
     _directoryManager = &std::get<DirectoryManager>(_directoryManagerStorage);
 
-    auto mutex_init = _mutex.init();
-    if (!mutex_init.has_value()) {
-        return mutex_init;
+    auto locks_init = _initLocks();
+    if (!locks_init.has_value()) {
+        return locks_init;
     }
 
     return {};
 }
 std::expected<void, FsError> PpFS::create(std::string_view path)
 {
-    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedCreate(path); });
+    return mutex_wrapper<void>(_namespaceLock, [&]() { return _unprotectedCreate(path); });
 }
 std::expected<file_descriptor_t, FsError> PpFS::open(std::string_view path, OpenMode mode)
 {
-    return mutex_wrapper<file_descriptor_t>(_mutex, [&]() { return _unprotectedOpen(path, mode); });
+    return shared_mutex_wrapper<file_descriptor_t>(
+        _namespaceLock, [&]() { return _unprotectedOpen(path, mode); });
 }
 std::expected<void, FsError> PpFS::close(file_descriptor_t fd)
 {
-    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedClose(fd); });
+    if (fd < 0 || fd >= static_cast<file_descriptor_t>(MAX_OPEN_FILES)) {
+        // Has no lock, the table reports it as out of bounds
+        return _unprotectedClose(fd);
+    }
+    return _descriptorWrapper<void>(fd, [&]() { return _unprotectedClose(fd); });
 }
 std::expected<void, FsError> PpFS::remove(std::string_view path, bool recursive)
 {
-    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedRemove(path, recursive); });
+    return mutex_wrapper<void>(
+        _namespaceLock, [&]() { return _unprotectedRemove(path, recursive); });
 }
 std::expected<void, FsError> PpFS::read(
     file_descriptor_t fd, std::size_t bytes_to_read, static_vector<std::uint8_t>& data)
 {
-    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedRead(fd, bytes_to_read, data); });
+    return _fileWrapper<void>(
+        fd, false, [&]() { return _unprotectedRead(fd, bytes_to_read, data); });
 }
 std::expected<size_t, FsError> PpFS::write(
     file_descriptor_t fd, const static_vector<std::uint8_t>& buffer)
 {
-    return mutex_wrapper<size_t>(_mutex, [&]() { return _unprotectedWrite(fd, buffer); });
+    return _fileWrapper<size_t>(fd, true, [&]() { return _unprotectedWrite(fd, buffer); });
+}
+std::expected<void, FsError> PpFS::readAt(file_descriptor_t fd, size_t offset,
+    std::size_t bytes_to_read, static_vector<std::uint8_t>& data)
+{
+    if (!isInitialized()) {
+        return std::unexpected(FsError::PpFS_NotInitialized);
+    }
+    auto open_file = _openFilesTable.describe(fd);
+    if (!open_file.has_value()) {
+        return std::unexpected(FsError::PpFS_NotFound);
+    }
+    inode_index_t inode = open_file.value().first;
+    return shared_mutex_wrapper<void>(_inodeLock(inode), [&]() -> std::expected<void, FsError> {
+        // Descriptor may have been closed and its file removed before the lock was taken
+        auto current = _openFilesTable.describe(fd);
+        if (!current.has_value() || current.value().first != inode) {
+            return std::unexpected(FsError::PpFS_NotFound);
+        }
+        return _readOpenFile(inode, current.value().second, offset, bytes_to_read, data);
+    });
+}
+std::expected<size_t, FsError> PpFS::writeAt(
+    file_descriptor_t fd, size_t offset, const static_vector<std::uint8_t>& buffer)
+{
+    return _fileWrapper<size_t>(
+        fd, true, [&]() { return _unprotectedWriteAt(fd, offset, buffer); });
 }
 std::expected<void, FsError> PpFS::seek(file_descriptor_t fd, size_t position)
 {
-    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedSeek(fd, position); });
+    return _fileWrapper<void>(fd, false, [&]() { return _unprotectedSeek(fd, position); });
 }
 std::expected<void, FsError> PpFS::createDirectory(std::string_view path)
 {
-    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedCreateDirectory(path); });
+    return mutex_wrapper<void>(_namespaceLock, [&]() { return _unprotectedCreateDirectory(path); });
 }
 std::expected<void, FsError> PpFS::readDirectory(
     std::string_view path, static_vector<DirectoryEntry>& entries)
 {
-    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedReadDirectory(path, entries); });
+    return shared_mutex_wrapper<void>(
+        _namespaceLock, [&]() { return _unprotectedReadDirectory(path, entries); });
 }
 
 std::expected<void, FsError> PpFS::readDirectory(file_descriptor_t fd, std::uint32_t elements,
     std::uint32_t offset, static_vector<DirectoryEntry>& entries)
 {
-    return mutex_wrapper<void>(
-        _mutex, [&]() { return _unprotectedReadDirectory(fd, elements, offset, entries); });
+    return shared_mutex_wrapper<void>(_namespaceLock, [&]() {
+        return _descriptorWrapper<void>(
+            fd, [&]() { return _unprotectedReadDirectory(fd, elements, offset, entries); });
+    });
 }
 
 std::expected<FileStat, FsError> PpFS::getFileStat(std::string_view path)
 {
-    return mutex_wrapper<FileStat>(_mutex, [&]() { return _unprotectedGetFileStat(path); });
+    return shared_mutex_wrapper<FileStat>(
+        _namespaceLock, [&]() { return _unprotectedGetFileStat(path); });
+}
+
+std::expected<void, FsError> PpFS::sync()
+{
+    return shared_mutex_wrapper<void>(_namespaceLock, [&]() { return _unprotectedSync(); });
+}
+
+std::expected<InodeCacheStats, FsError> PpFS::getInodeCacheStats()
+{
+    return shared_mutex_wrapper<InodeCacheStats>(
+        _namespaceLock, [&]() { return _unprotectedGetInodeCacheStats(); });
 }
 
 std::expected<void, FsError> PpFS::_unprotectedCreate(std::string_view path)
@@ -347,18 +475,22 @@ std::expected<inode_index_t, FsError> PpFS::_getParentInodeFromPath(std::string_
     }
 }
 
-std::expected<inode_index_t, FsError> PpFS::_getInodeFromParent(
-    inode_index_t parent_inode, std::string_view path) const
+std::array<char, 128> PpFS::_entryName(std::string_view path)
 {
     size_t last_slash = path.find_last_of('/');
     std::string_view name = path.substr(last_slash + 1);
 
-    // Create null-terminated string from string_view for getInodeByName
     std::array<char, 128> name_buffer;
     size_t name_len = std::min(name.size(), name_buffer.size() - 1);
     std::memcpy(name_buffer.data(), name.data(), name_len);
     name_buffer[name_len] = '\0';
+    return name_buffer;
+}
 
+std::expected<inode_index_t, FsError> PpFS::_getInodeFromParent(
+    inode_index_t parent_inode, std::string_view path) const
+{
+    auto name_buffer = _entryName(path);
     auto inode_res = _directoryManager->getInodeByName(parent_inode, name_buffer.data());
     if (!inode_res.has_value()) {
         return std::unexpected(inode_res.error());
@@ -417,9 +549,21 @@ std::expected<file_descriptor_t, FsError> PpFS::_unprotectedOpen(
     if (!open_res.has_value()) {
         return std::unexpected(open_res.error());
     }
+    auto pin_res = _pinOpenInode(open_res.value(), inode);
+    if (!pin_res.has_value()) {
+        return std::unexpected(pin_res.error());
+    }
 
     if (mode & OpenMode::Truncate) {
-        auto truncate_res = _fileIO->resizeFile(inode, inode_data, 0);
+        // Other descriptors of the file may be reading it
+        auto truncate_res
+            = mutex_wrapper<void>(_inodeLock(inode), [&]() -> std::expected<void, FsError> {
+            // A writer may have grown the file since inode_data was read
+            auto current_res = _inodeManager->get(inode);
+            if (!current_res.has_value())
+                return std::unexpected(current_res.error());
+            return _fileIO->resizeFile(inode, current_res.value(), 0);
+        });
         if (!truncate_res.has_value()) {
             return std::unexpected(truncate_res.error());
         }
@@ -433,13 +577,53 @@ std::expected<void, FsError> PpFS::_unprotectedClose(file_descriptor_t fd)
     if (!isInitialized()) {
         return std::unexpected(FsError::PpFS_NotInitialized);
     }
+    auto open_file = _openFilesTable.get(fd);
+    inode_index_t inode = open_file.has_value() ? open_file.value()->inode : 0;
+
     auto close_res = _openFilesTable.close(fd);
     if (!close_res.has_value()) {
         return std::unexpected(close_res.error());
     }
+    _inodeManager->unpin(inode);
+    return _inodeManager->flush(inode);
+}
+
+std::expected<void, FsError> PpFS::_pinOpenInode(file_descriptor_t fd, inode_index_t inode)
+{
+    auto pin_res = _inodeManager->pin(inode);
+    if (!pin_res.has_value()) {
+        (void)_openFilesTable.close(fd);
+        return std::unexpected(pin_res.error());
+    }
     return {};
 }
 
+std::expected<void, FsError> PpFS::_unprotectedSync()
+{
+    if (!isInitialized()) {
+        return std::unexpected(FsError::PpFS_NotInitialized);
+    }
+    auto inode_res = _inodeManager->flush();
+    if (!inode_res.has_value()) {
+        return std::unexpected(inode_res.error());
+    }
+    if (auto cache = std::get_if<CachingBlockDevice>(&_cacheStorage); cache != nullptr) {
+        auto cache_res = cache->flush();
+        if (!cache_res.has_value()) {
+            return std::unexpected(cache_res.error());
+        }
+    }
+    return _disk.flush();
+}
+
+std::expected<InodeCacheStats, FsError> PpFS::_unprotectedGetInodeCacheStats() const
+{
+    if (!isInitialized()) {
+        return std::unexpected(FsError::PpFS_NotInitialized);
+    }
+    return InodeCacheStats { .hits = _inodeManager->hits(), .misses = _inodeManager->misses() };
+}
+
 std::expected<void, FsError> PpFS::_checkIfInUseRecursive(inode_index_t inode)
 {
     auto inode_res = _inodeManager->get(inode);
@@ -473,7 +657,8 @@ std::expected<void, FsError> PpFS::_checkIfInUseRecursive(inode_index_t inode)
     return {};
 }
 
-std::expected<void, FsError> PpFS::_removeRecursive(inode_index_t parent, inode_index_t inode)
+std::expected<void, FsError> PpFS::_removeRecursive(
+    inode_index_t parent, inode_index_t inode, const char* name)
 {
     auto inode_res = _inodeManager->get(inode);
     if (!inode_res.has_value()) {
@@ -488,28 +673,37 @@ std::expected<void, FsError> PpFS::_removeRecursive(inode_index_t parent, inode_
             return std::unexpected(entries_res.error());
         }
         for (size_t i = 0; i < entries.size(); ++i) {
-            auto remove_res = _removeRecursive(inode, entries[i].inode);
+            auto remove_res
+                = _removeRecursive(inode, entries[i].inode, entries[i].name.data());
             if (!remove_res.has_value()) {
                 return std::unexpected(remove_res.error());
             }
         }
     }
 
-    auto file_io_res = _fileIO->resizeFile(inode, inode_data, 0);
-    if (!file_io_res.has_value()) {
-        return std::unexpected(file_io_res.error());
-    }
+    // readAt() holds only the shared inode lock, blocks must not be freed under it
+    return mutex_wrapper<void>(_inodeLock(inode), [&]() -> std::expected<void, FsError> {
+        // Read under the lock, removing entries of a directory made its old block list stale
+        auto current_res = _inodeManager->get(inode);
+        if (!current_res.has_value()) {
+            return std::unexpected(current_res.error());
+        }
+        auto file_io_res = _fileIO->resizeFile(inode, current_res.value(), 0);
+        if (!file_io_res.has_value()) {
+            return std::unexpected(file_io_res.error());
+        }
 
-    auto remove_entry_res = _directoryManager->removeEntry(parent, inode);
-    if (!remove_entry_res.has_value()) {
-        return std::unexpected(remove_entry_res.error());
-    }
+        auto remove_entry_res = _directoryManager->removeEntry(parent, name);
+        if (!remove_entry_res.has_value()) {
+            return std::unexpected(remove_entry_res.error());
+        }
 
-    auto remove_inode_res = _inodeManager->remove(inode);
-    if (!remove_inode_res.has_value()) {
-        return std::unexpected(remove_inode_res.error());
-    }
-    return {};
+        auto remove_inode_res = _inodeManager->remove(inode);
+        if (!remove_inode_res.has_value()) {
+            return std::unexpected(remove_inode_res.error());
+        }
+        return {};
+    });
 }
 
 std::expected<void, FsError> PpFS::_unprotectedRemove(std::string_view path, bool recursive)
@@ -550,7 +744,7 @@ std::expected<void, FsError> PpFS::_unprotectedRemove(std::string_view path, boo
         return std::unexpected(check_in_use_res.error());
     }
 
-    auto remove_res = _removeRecursive(parent_inode, inode);
+    auto remove_res = _removeRecursive(parent_inode, inode, _entryName(path).data());
     if (!remove_res.has_value()) {
         return std::unexpected(remove_res.error());
     }
@@ -570,11 +764,24 @@ std::expected<void, FsError> PpFS::_unprotectedRead(
     }
     OpenFile* open_file = open_table_res.value();
 
-    if (open_file->mode & OpenMode::Append) {
+    auto read_res = _readOpenFile(open_file->inode, open_file->mode, open_file->position,
+        bytes_to_read, data);
+    if (!read_res.has_value()) {
+        return std::unexpected(read_res.error());
+    }
+    open_file->position += data.size();
+
+    return {};
+}
+
+std::expected<void, FsError> PpFS::_readOpenFile(inode_index_t inode_index, OpenMode mode,
+    size_t offset, std::size_t bytes_to_read, static_vector<std::uint8_t>& data)
+{
+    if (mode & OpenMode::Append) {
         return std::unexpected(FsError::PpFS_InvalidRequest);
     }
 
-    auto inode_res = _inodeManager->get(open_file->inode);
+    auto inode_res = _inodeManager->get(inode_index);
     if (!inode_res.has_value()) {
         return std::unexpected(inode_res.error());
     }
@@ -588,14 +795,7 @@ std::expected<void, FsError> PpFS::_unprotectedRead(
         return std::unexpected(FsError::PpFS_InvalidRequest);
     }
 
-    auto read_res
-        = _fileIO->readFile(open_file->inode, inode, open_file->position, bytes_to_read, data);
-    if (!read_res.has_value()) {
-        return std::unexpected(read_res.error());
-    }
-    open_file->position += data.size();
-
-    return {};
+    return _fileIO->readFile(inode_index, inode, offset, bytes_to_read, data, true);
 }
 
 std::expected<size_t, FsError> PpFS::_unprotectedWrite(
@@ -612,11 +812,40 @@ std::expected<size_t, FsError> PpFS::_unprotectedWrite(
     }
     OpenFile* open_file = open_table_res.value();
 
-    if (open_file->mode & OpenMode::Protected) {
+    size_t offset = open_file->position;
+    auto write_res = _writeOpenFile(*open_file, offset, buffer);
+    if (!write_res.has_value()) {
+        return std::unexpected(write_res.error());
+    }
+
+    open_file->position = offset;
+
+    return write_res.value();
+}
+
+std::expected<size_t, FsError> PpFS::_unprotectedWriteAt(
+    file_descriptor_t fd, size_t offset, const static_vector<std::uint8_t>& buffer)
+{
+    if (!isInitialized()) {
+        return std::unexpected(FsError::PpFS_NotInitialized);
+    }
+
+    auto open_table_res = _openFilesTable.get(fd);
+    if (!open_table_res.has_value()) {
+        return std::unexpected(FsError::PpFS_NotFound);
+    }
+
+    return _writeOpenFile(*open_table_res.value(), offset, buffer);
+}
+
+std::expected<size_t, FsError> PpFS::_writeOpenFile(
+    OpenFile& open_file, size_t& offset, const static_vector<std::uint8_t>& buffer)
+{
+    if (open_file.mode & OpenMode::Protected) {
         return std::unexpected(FsError::PpFS_InvalidRequest);
     }
 
-    auto inode_res = _inodeManager->get(open_file->inode);
+    auto inode_res = _inodeManager->get(open_file.inode);
     if (!inode_res.has_value()) {
         return std::unexpected(inode_res.error());
     }
@@ -626,17 +855,18 @@ std::expected<size_t, FsError> PpFS::_unprotectedWrite(
         return std::unexpected(FsError::PpFS_InvalidRequest);
     }
 
-    size_t offset = open_file->position;
-    if (open_file->mode & OpenMode::Append) {
+    if (open_file.mode & OpenMode::Append) {
         offset = inode.file_size;
+    } else if (offset > inode.file_size) {
+        return std::unexpected(FsError::PpFS_OutOfBounds);
     }
 
-    auto write_res = _fileIO->writeFile(open_file->inode, inode, offset, buffer);
+    auto write_res = _fileIO->writeFile(open_file.inode, inode, offset, buffer, true);
     if (!write_res.has_value()) {
         return std::unexpected(write_res.error());
     }
 
-    open_file->position = offset + write_res.value();
+    offset += write_res.value();
 
     return write_res.value();
 }
@@ -744,7 +974,9 @@ std::expected<FileStat, FsError> PpFS::_unprotectedGetFileStat(std::string_view
     FileStat stat {};
     stat.size = inode_data.file_size;
     if (inode_data.type == InodeType::Directory) {
-        stat.number_of_entries = inode_data.file_size / sizeof(DirectoryEntry);
+        // Indexed directories keep the index reference in a hidden first entry
+        stat.number_of_entries
+            = inode_data.file_size / sizeof(DirectoryEntry) - (inode_data.hashed_index ? 1 : 0);
         stat.is_directory = true;
     }
 
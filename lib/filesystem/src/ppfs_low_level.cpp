@@ -1,65 +1,78 @@
 #include "ppfs/filesystem/ppfs_low_level.hpp"
 #include "ppfs/common/static_vector.hpp"
-#include "ppfs/filesystem/mutex_wrapper.hpp"
+#include "ppfs/common/mutex_wrapper.hpp"
 #include <array>
 #include <cstring>
 
-PpFSLowLevel::PpFSLowLevel(IDisk& disk)
-    : PpFS(disk)
+PpFSLowLevel::PpFSLowLevel(
+    IDisk& disk, CachePolicy cache_policy, static_vector<CachingBlockDevice::Entry> cache_entries)
+    : PpFS(disk, nullptr, cache_policy, cache_entries)
 {
 }
 
 std::expected<FileAttributes, FsError> PpFSLowLevel::getAttributes(inode_index_t inode_index)
 {
-    return mutex_wrapper<FileAttributes>(
-        _mutex, [&]() { return _unprotectedGetAttributes(inode_index); });
+    return shared_mutex_wrapper<FileAttributes>(
+        _namespaceLock, [&]() { return _unprotectedGetAttributes(inode_index); });
 }
 
 std::expected<inode_index_t, FsError> PpFSLowLevel::lookup(
     inode_index_t parent_index, std::string_view name)
 {
-    return mutex_wrapper<inode_index_t>(
-        _mutex, [&]() { return _unprotectedLookup(parent_index, name); });
+    return shared_mutex_wrapper<inode_index_t>(
+        _namespaceLock, [&]() { return _unprotectedLookup(parent_index, name); });
 }
 
 std::expected<void, FsError> PpFSLowLevel::getDirectoryEntries(
     inode_index_t inode, static_vector<DirectoryEntry>& buf, size_t offset, size_t size)
 {
-    return mutex_wrapper<void>(
-        _mutex, [&]() { return _unprotectedGetDirectoryEntries(inode, buf, offset, size); });
+    return shared_mutex_wrapper<void>(_namespaceLock,
+        [&]() { return _unprotectedGetDirectoryEntries(inode, buf, offset, size); });
+}
+
+std::expected<void, FsError> PpFSLowLevel::getDirectoryEntriesWithAttributes(inode_index_t inode,
+    static_vector<DirectoryEntry>& buf, static_vector<std::optional<FileAttributes>>& attributes,
+    size_t offset, size_t size)
+{
+    return shared_mutex_wrapper<void>(_namespaceLock, [&]() {
+        return _unprotectedGetDirectoryEntriesWithAttributes(inode, buf, attributes, offset, size);
+    });
 }
 
 std::expected<inode_index_t, FsError> PpFSLowLevel::createDirectoryByParent(
     inode_index_t parent, std::string_view name)
 {
     return mutex_wrapper<inode_index_t>(
-        _mutex, [&]() { return _unprotectedCreateDirectoryByParent(parent, name); });
+        _namespaceLock, [&]() { return _unprotectedCreateDirectoryByParent(parent, name); });
 }
 
 std::expected<void, FsError> PpFSLowLevel::removeByNameAndParent(
     inode_index_t parent, std::string_view name, bool recursive)
 {
-    return mutex_wrapper<void>(
-        _mutex, [&]() { return _unprotectedRemoveByNameAndParent(parent, name, recursive); });
+    return mutex_wrapper<void>(_namespaceLock,
+        [&]() { return _unprotectedRemoveByNameAndParent(parent, name, recursive); });
 }
 
 std::expected<file_descriptor_t, FsError> PpFSLowLevel::openByInode(
     inode_index_t inode, OpenMode mode)
 {
-    return mutex_wrapper<file_descriptor_t>(
-        _mutex, [&]() { return _unprotectedOpenByInode(inode, mode); });
+    return shared_mutex_wrapper<file_descriptor_t>(
+        _namespaceLock, [&]() { return _unprotectedOpenByInode(inode, mode); });
 }
 
 std::expected<inode_index_t, FsError> PpFSLowLevel::createWithParentInode(
     std::string_view name, inode_index_t parent)
 {
     return mutex_wrapper<file_descriptor_t>(
-        _mutex, [&]() { return _unprotectedCreateWithParentInode(name, parent); });
+        _namespaceLock, [&]() { return _unprotectedCreateWithParentInode(name, parent); });
 }
 
 std::expected<void, FsError> PpFSLowLevel::truncate(inode_index_t inode, size_t new_size)
 {
-    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedTruncate(inode, new_size); });
+    return shared_mutex_wrapper<void>(_namespaceLock, [&]() {
+        return mutex_wrapper<void>(
+            _inodeLock(inode), [&]() { return _unprotectedTruncate(inode, new_size); });
+    });
 }
 
 std::expected<FileAttributes, FsError> PpFSLowLevel::_unprotectedGetAttributes(
@@ -74,10 +87,15 @@ std::expected<FileAttributes, FsError> PpFSLowLevel::_unprotectedGetAttributes(
     if (!inode_res.has_value())
         return std::unexpected(inode_res.error());
 
+    return _attributesOf(inode_res.value());
+}
+
+FileAttributes PpFSLowLevel::_attributesOf(const Inode& inode) const
+{
     return FileAttributes {
-        .size = inode_res.value().file_size,
+        .size = inode.file_size,
         .block_size = _blockDevice->dataSize(),
-        .type = inode_res.value().type,
+        .type = inode.type,
     };
 }
 
@@ -126,6 +144,43 @@ std::expected<void, FsError> PpFSLowLevel::_unprotectedGetDirectoryEntries(
         inode, static_cast<std::uint32_t>(size), static_cast<std::uint32_t>(offset), buf);
 }
 
+std::expected<void, FsError> PpFSLowLevel::_unprotectedGetDirectoryEntriesWithAttributes(
+    inode_index_t inode, static_vector<DirectoryEntry>& buf,
+    static_vector<std::optional<FileAttributes>>& attributes, size_t offset, size_t size)
+{
+    auto entries_res = _unprotectedGetDirectoryEntries(inode, buf, offset, size);
+    if (!entries_res.has_value()) {
+        return std::unexpected(entries_res.error());
+    }
+    if (attributes.capacity() < buf.size()) {
+        return std::unexpected(FsError::PpFS_InvalidRequest);
+    }
+    attributes.resize(0);
+
+    std::array<inode_index_t, ATTRIBUTES_BATCH> indices_buffer;
+    std::array<std::optional<Inode>, ATTRIBUTES_BATCH> inodes_buffer;
+    for (size_t first = 0; first < buf.size(); first += ATTRIBUTES_BATCH) {
+        static_vector<inode_index_t> indices(indices_buffer.data(), ATTRIBUTES_BATCH);
+        for (size_t i = first; i < buf.size() && indices.size() < ATTRIBUTES_BATCH; i++) {
+            (void)indices.push_back(buf[i].inode);
+        }
+
+        static_vector<std::optional<Inode>> inodes(inodes_buffer.data(), ATTRIBUTES_BATCH);
+        auto get_res = _inodeManager->getMany(indices, inodes);
+        if (!get_res.has_value()) {
+            return std::unexpected(get_res.error());
+        }
+        for (const auto& entry_inode : inodes) {
+            std::optional<FileAttributes> entry_attributes;
+            if (entry_inode.has_value()) {
+                entry_attributes = _attributesOf(entry_inode.value());
+            }
+            (void)attributes.push_back(entry_attributes);
+        }
+    }
+    return {};
+}
+
 std::expected<file_descriptor_t, FsError> PpFSLowLevel::_unprotectedOpenByInode(
     inode_index_t inode, OpenMode mode)
 {
@@ -144,6 +199,10 @@ std::expected<file_descriptor_t, FsError> PpFSLowLevel::_unprotectedOpenByInode(
     if (!open_res.has_value()) {
         return std::unexpected(open_res.error());
     }
+    auto pin_res = _pinOpenInode(open_res.value(), inode);
+    if (!pin_res.has_value()) {
+        return std::unexpected(pin_res.error());
+    }
 
     return open_res.value();
 }
@@ -205,7 +264,7 @@ std::expected<void, FsError> PpFSLowLevel::_unprotectedRemoveByNameAndParent(
         return std::unexpected(check_in_use_res.error());
     }
 
-    auto remove_res = _removeRecursive(parent, inode);
+    auto remove_res = _removeRecursive(parent, inode, _entryName(name).data());
     if (!remove_res.has_value()) {
         return std::unexpected(remove_res.error());
     }
@@ -1,13 +1,17 @@
 #pragma once
+#include "ppfs/common/static_vector.hpp"
 #include "ppfs/common/types.hpp"
 #include "ppfs/disk/idisk.hpp"
 #include "ppfs/inode_manager/inode.hpp"
 
 #include <expected>
+#include <optional>
 /**
  * Interface containing inode operations
  */
 struct IInodeManager {
+    virtual ~IInodeManager() = default;
+
     /**
      * Creates new inode.
      *
@@ -37,6 +41,33 @@ struct IInodeManager {
      */
     [[nodiscard]] virtual std::expected<Inode, FsError> get(inode_index_t inode) = 0;
 
+    /**
+     * Read data of several inodes.
+     *
+     * A failed read of one inode does not stop the others. Implementations may decode each
+     * inode table block only once for all requested inodes it holds.
+     *
+     * @param indices indexes of inodes to read
+     * @param inodes buffer for data in the order of indices, empty for inodes that could not be
+     * read, must have sufficient capacity
+     * @return void on success, error otherwise
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> getMany(
+        const static_vector<inode_index_t>& indices, static_vector<std::optional<Inode>>& inodes)
+    {
+        inodes.resize(0);
+        for (auto index : indices) {
+            auto get_res = get(index);
+            std::optional<Inode> inode;
+            if (get_res.has_value())
+                inode = get_res.value();
+            auto push_res = inodes.push_back(inode);
+            if (!push_res.has_value())
+                return push_res;
+        }
+        return {};
+    }
+
     /**
      * Calculate number of free inodes
      *
@@ -47,6 +78,8 @@ struct IInodeManager {
     /**
      * Update inode data on disc.
      *
+     * Implementations may keep the new data in memory until flush.
+     *
      * @param inode index of inode to update
      * @return void on success, error otherwise
      */
@@ -54,6 +87,36 @@ struct IInodeManager {
         inode_index_t inode_index, const Inode& inode)
         = 0;
 
+    /**
+     * Write inodes kept in memory by update to disk.
+     *
+     * @return void on success, error otherwise
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> flush() { return {}; }
+
+    /**
+     * Write one inode kept in memory by update to disk.
+     *
+     * @param inode index of inode to write
+     * @return void on success, error otherwise
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> flush(inode_index_t) { return {}; }
+
+    /**
+     * Keep inode in memory until unpin, for example while the file is open.
+     *
+     * @param inode index of inode to keep
+     * @return void on success, error otherwise
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> pin(inode_index_t) { return {}; }
+
+    /**
+     * Undo one pin of an inode.
+     *
+     * @param inode index of inode
+     */
+    virtual void unpin(inode_index_t) { }
+
     /**
      * Format inode table and bitmap. Creates root directory inode at index 0.
      *
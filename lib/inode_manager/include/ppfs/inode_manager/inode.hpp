@@ -9,33 +9,74 @@ enum class InodeType : std::uint8_t {
     Directory,
 };
 
+/**
+ * Run of consecutive data blocks of an extent mapped file.
+ */
+struct __attribute__((packed)) Extent {
+    /** Index of the first block within the file */
+    std::uint32_t logical_start;
+    /** First block on the block device */
+    block_index_t physical_start;
+    /** Number of blocks in the run */
+    std::uint32_t length;
+};
+
 /**
  * Structure representing one entry in inode table.
  *
  * Inode is assumed to have allocated enough data blocks to contain all data. All unoccupied block
  * pointers have undefined values. Time values are unix time in milliseconds.
+ *
+ * Data blocks are either referenced by block pointers, or with extent_mapped set, by extents
+ * sorted by logical start that cover the file without gaps. First INLINE_EXTENTS extents are
+ * stored in the inode, the rest in a chain of extent blocks starting at extent_block, which is
+ * used only when there are more. Last block index of every extent block links the next one.
  */
 struct __attribute__((packed)) Inode {
+    static constexpr size_t INLINE_EXTENTS = 4;
+
     std::uint64_t time_creation;
     std::uint64_t time_modified;
 
-    /**
-     * First 12 block pointers are stored directly in the inode.
-     */
-    std::array<block_index_t, 12> direct_blocks;
-    /**
-     * Points to block with pointers to data blocks
-     */
-    block_index_t indirect_block;
-    /**
-     * Points to block with pointers to indirect blocks
-     */
-    block_index_t doubly_indirect_block;
-    /**
-     * Points to block with pointers to doubly indirect blocks
-     */
-    block_index_t trebly_indirect_block;
+    union {
+        struct __attribute__((packed)) {
+            /**
+             * First 12 block pointers are stored directly in the inode.
+             */
+            std::array<block_index_t, 12> direct_blocks;
+            /**
+             * Points to block with pointers to data blocks
+             */
+            block_index_t indirect_block;
+            /**
+             * Points to block with pointers to indirect blocks
+             */
+            block_index_t doubly_indirect_block;
+            /**
+             * Points to block with pointers to doubly indirect blocks
+             */
+            block_index_t trebly_indirect_block;
+        };
+        struct __attribute__((packed)) {
+            /**
+             * First extents of an extent mapped file
+             */
+            std::array<Extent, INLINE_EXTENTS> extents;
+            /**
+             * Number of extents, including those in extent blocks
+             */
+            std::uint32_t extent_count;
+            /**
+             * Points to the first block with extents following the inline ones
+             */
+            block_index_t extent_block;
+        };
+    };
 
     std::uint32_t file_size = 0;
-    InodeType type;
-};
\ No newline at end of file
+    InodeType type : 6;
+    /** Set for directories with a hashed index, see DirectoryManager */
+    bool hashed_index : 1 = false;
+    /** Set for inodes using extents, older inodes have this bit zero */
+    bool extent_mapped : 1 = false;
+};
@@ -1,29 +1,152 @@
 #pragma once
+#include "ppfs/bitmap/allocation_cursor.hpp"
 #include "ppfs/bitmap/bitmap.hpp"
+#include "ppfs/common/ppfs_mutex.hpp"
 #include "ppfs/inode_manager/iinode_manager.hpp"
 #include "ppfs/super_block_manager/super_block.hpp"
 
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef PPFS_INODE_CACHE_ENTRIES
+/** Number of inodes kept in memory by InodeManager, has to be more than open files */
+#    define PPFS_INODE_CACHE_ENTRIES 64
+#endif
+
 /**
  * Manages inode allocation, deallocation, and storage.
+ *
+ * Recently used inodes are cached in a fixed pool inside the object, evicted with CLOCK.
+ * update only changes the cached copy, which is written to disk by flush, on eviction or when
+ * the manager is destroyed. Pinned inodes are never evicted.
+ *
+ * All public methods hold an internal mutex, so the manager can be shared between threads. It
+ * also serves as the allocator lock of the inode bitmap.
  */
 class InodeManager : public IInodeManager {
+public:
+    static constexpr size_t CACHE_ENTRIES = PPFS_INODE_CACHE_ENTRIES;
+
+    /** Number of inodes getMany groups by table block at a time. */
+    static constexpr size_t GET_MANY_BATCH = 64;
+
+private:
+    struct CacheEntry {
+        inode_index_t index;
+        bool valid = false;
+        bool dirty = false;
+        bool referenced = false;
+        std::uint32_t pins = 0;
+        Inode inode;
+    };
+
     IBlockDevice& _block_device;
     SuperBlock& _superblock;
     Bitmap _bitmap;
+    AllocationCursor _cursor;
+    std::array<CacheEntry, CACHE_ENTRIES> _cache;
+    size_t _clock_hand = 0;
+    size_t _hits = 0;
+    size_t _misses = 0;
+    /** Decoded inode table block shared by the inodes of one getMany batch. */
+    std::array<std::uint8_t, MAX_BLOCK_SIZE> _table_block;
+    mutable PpFSMutex _mutex;
 
     DataLocation _getInodeLocation(inode_index_t inode);
     [[nodiscard]] std::expected<void, FsError> _writeInode(inode_index_t index, const Inode& inode);
     [[nodiscard]] std::expected<Inode, FsError> _readInode(inode_index_t index);
     [[nodiscard]] std::expected<void, FsError> _createRootInode();
 
+    /** Returns cached entry of inode or nullptr. */
+    CacheEntry* _find(inode_index_t index);
+
+    /**
+     * Picks a free entry or evicts an unpinned one, dirty victim is written first.
+     * @return entry, nullptr if every entry is pinned
+     */
+    [[nodiscard]] std::expected<CacheEntry*, FsError> _allocate();
+
+    /** Caches inode just read from disk, skipped if every entry is pinned. */
+    void _cacheRead(inode_index_t index, const Inode& inode);
+
+    /** Writes dirty entry to disk. */
+    [[nodiscard]] std::expected<void, FsError> _writeBack(CacheEntry& entry);
+
+    /** Makes a new inode extent mapped if the superblock asks for it. */
+    void _applyMapping(Inode& inode);
+
+    /** Checks inode is taken in the bitmap. */
+    [[nodiscard]] std::expected<void, FsError> _checkTaken(inode_index_t inode);
+
+    [[nodiscard]] std::expected<inode_index_t, FsError> _unprotectedCreate(Inode& inode);
+    [[nodiscard]] std::expected<void, FsError> _unprotectedRemove(inode_index_t inode);
+    [[nodiscard]] std::expected<Inode, FsError> _unprotectedGet(inode_index_t inode);
+    [[nodiscard]] std::expected<void, FsError> _unprotectedGetMany(
+        const static_vector<inode_index_t>& indices, static_vector<std::optional<Inode>>& inodes);
+    [[nodiscard]] std::expected<unsigned int, FsError> _unprotectedNumFree();
+    [[nodiscard]] std::expected<void, FsError> _unprotectedUpdate(
+        inode_index_t inode_index, const Inode& inode);
+    [[nodiscard]] std::expected<void, FsError> _unprotectedFormat();
+    [[nodiscard]] std::expected<void, FsError> _unprotectedFlush();
+    [[nodiscard]] std::expected<void, FsError> _unprotectedFlush(inode_index_t inode);
+    [[nodiscard]] std::expected<void, FsError> _unprotectedPin(inode_index_t inode);
+    void _unprotectedUnpin(inode_index_t inode);
+
 public:
-    InodeManager(IBlockDevice& block_device, SuperBlock& superblock);
+    /**
+     * @param bitmap_mirror buffer for the in-memory copy of the inode bitmap, see Bitmap
+     */
+    InodeManager(IBlockDevice& block_device, SuperBlock& superblock,
+        static_vector<std::uint64_t> bitmap_mirror = {});
+
+    /** Writes dirty inodes, errors are ignored. */
+    ~InodeManager() override;
+
+    InodeManager(const InodeManager&) = delete;
+    InodeManager& operator=(const InodeManager&) = delete;
+
+    /** Whether the internal mutex was created, every operation fails otherwise */
+    bool isInitialized() const { return _mutex.isInitialized(); }
 
     [[nodiscard]] virtual std::expected<inode_index_t, FsError> create(Inode& inode) override;
     [[nodiscard]] virtual std::expected<void, FsError> remove(inode_index_t inode) override;
     [[nodiscard]] virtual std::expected<Inode, FsError> get(inode_index_t inode) override;
+
+    /**
+     * Cached inodes are answered from memory. The rest are grouped by inode table block, and
+     * each block is read and decoded once for all of them.
+     */
+    [[nodiscard]] virtual std::expected<void, FsError> getMany(
+        const static_vector<inode_index_t>& indices,
+        static_vector<std::optional<Inode>>& inodes) override;
     [[nodiscard]] virtual std::expected<unsigned int, FsError> numFree() override;
+
+    /** Loads the inode bitmap mirror, so that the first allocation doesn't have to */
+    [[nodiscard]] std::expected<void, FsError> loadBitmap();
     [[nodiscard]] virtual std::expected<void, FsError> update(
         inode_index_t inode_index, const Inode& inode) override;
     [[nodiscard]] virtual std::expected<void, FsError> format() override;
+    [[nodiscard]] virtual std::expected<void, FsError> flush() override;
+    [[nodiscard]] virtual std::expected<void, FsError> flush(inode_index_t inode) override;
+    [[nodiscard]] virtual std::expected<void, FsError> pin(inode_index_t inode) override;
+    virtual void unpin(inode_index_t inode) override;
+
+    /** Number of get calls served from the cache. */
+    size_t hits() const;
+
+    /** Number of get calls that had to read the inode from disk. */
+    size_t misses() const;
+
+    /**
+     * Number of blocks taken by the inode table of superblock.
+     *
+     * Packed table stores inodes back to back. Block aligned table stores as many whole inodes
+     * as fit in a block and pads the rest, an inode bigger than a block starts a new block.
+     *
+     * @param superblock superblock with total_inodes and inodes_block_aligned set
+     * @param data_size usable bytes in one block
+     */
+    static size_t tableBlocks(const SuperBlock& superblock, size_t data_size);
 };
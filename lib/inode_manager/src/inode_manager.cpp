@@ -1,22 +1,217 @@
 #include "ppfs/inode_manager/inode_manager.hpp"
+#include "ppfs/common/math_helpers.hpp"
+#include "ppfs/common/mutex_wrapper.hpp"
 #include "ppfs/common/static_vector.hpp"
+#include <algorithm>
+#include <cstring>
 
-InodeManager::InodeManager(IBlockDevice& block_device, SuperBlock& superblock)
+InodeManager::InodeManager(IBlockDevice& block_device, SuperBlock& superblock,
+    static_vector<std::uint64_t> bitmap_mirror)
     : _block_device(block_device)
     , _superblock(superblock)
-    , _bitmap(Bitmap(block_device, superblock.inode_bitmap_address, superblock.total_inodes))
+    , _bitmap(Bitmap(
+          block_device, superblock.inode_bitmap_address, superblock.total_inodes, bitmap_mirror))
+    , _cursor(superblock.allocation_policy, superblock.total_inodes)
 {
+    (void)_mutex.init();
+}
+
+InodeManager::~InodeManager() { (void)flush(); }
+
+std::expected<inode_index_t, FsError> InodeManager::create(Inode& inode)
+{
+    return mutex_wrapper<inode_index_t>(_mutex, [&]() { return _unprotectedCreate(inode); });
+}
+
+std::expected<void, FsError> InodeManager::remove(inode_index_t inode)
+{
+    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedRemove(inode); });
+}
+
+std::expected<Inode, FsError> InodeManager::get(inode_index_t inode)
+{
+    return mutex_wrapper<Inode>(_mutex, [&]() { return _unprotectedGet(inode); });
+}
+
+std::expected<void, FsError> InodeManager::getMany(
+    const static_vector<inode_index_t>& indices, static_vector<std::optional<Inode>>& inodes)
+{
+    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedGetMany(indices, inodes); });
+}
+
+std::expected<unsigned int, FsError> InodeManager::numFree()
+{
+    return mutex_wrapper<unsigned int>(_mutex, [&]() { return _unprotectedNumFree(); });
+}
+
+std::expected<void, FsError> InodeManager::loadBitmap()
+{
+    return mutex_wrapper<void>(_mutex, [&]() { return _bitmap.load(); });
+}
+
+std::expected<void, FsError> InodeManager::update(inode_index_t inode_index, const Inode& inode)
+{
+    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedUpdate(inode_index, inode); });
+}
+
+std::expected<void, FsError> InodeManager::format()
+{
+    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedFormat(); });
+}
+
+std::expected<void, FsError> InodeManager::flush()
+{
+    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedFlush(); });
+}
+
+std::expected<void, FsError> InodeManager::flush(inode_index_t inode)
+{
+    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedFlush(inode); });
+}
+
+std::expected<void, FsError> InodeManager::pin(inode_index_t inode)
+{
+    return mutex_wrapper<void>(_mutex, [&]() { return _unprotectedPin(inode); });
+}
+
+void InodeManager::unpin(inode_index_t inode)
+{
+    (void)mutex_wrapper<void>(_mutex, [&]() {
+        _unprotectedUnpin(inode);
+        return std::expected<void, FsError> {};
+    });
+}
+
+size_t InodeManager::hits() const
+{
+    auto hits = mutex_wrapper<size_t>(_mutex, [&]() { return _hits; });
+    return hits.value_or(0);
+}
+
+size_t InodeManager::misses() const
+{
+    auto misses = mutex_wrapper<size_t>(_mutex, [&]() { return _misses; });
+    return misses.value_or(0);
+}
+
+void InodeManager::_cacheRead(inode_index_t index, const Inode& inode)
+{
+    // getMany may be asked for the same inode twice
+    if (_find(index) != nullptr) {
+        return;
+    }
+    auto entry_res = _allocate();
+    if (entry_res.has_value() && entry_res.value() != nullptr) {
+        *entry_res.value() = CacheEntry { .index = index, .valid = true, .inode = inode };
+    }
+}
+
+InodeManager::CacheEntry* InodeManager::_find(inode_index_t index)
+{
+    for (auto& entry : _cache) {
+        if (entry.valid && entry.index == index) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+std::expected<InodeManager::CacheEntry*, FsError> InodeManager::_allocate()
+{
+    for (auto& entry : _cache) {
+        if (!entry.valid) {
+            return &entry;
+        }
+    }
+
+    // Every unpinned entry gets a second chance, two rounds always find a victim if there is one
+    for (size_t step = 0; step < 2 * CACHE_ENTRIES; step++) {
+        auto& entry = _cache[_clock_hand];
+        _clock_hand = (_clock_hand + 1) % CACHE_ENTRIES;
+        if (entry.pins > 0) {
+            continue;
+        }
+        if (entry.referenced) {
+            entry.referenced = false;
+            continue;
+        }
+        auto write_res = _writeBack(entry);
+        if (!write_res.has_value()) {
+            return std::unexpected(write_res.error());
+        }
+        entry.valid = false;
+        return &entry;
+    }
+    return nullptr;
+}
+
+std::expected<void, FsError> InodeManager::_writeBack(CacheEntry& entry)
+{
+    if (!entry.dirty) {
+        return {};
+    }
+    auto write_res = _writeInode(entry.index, entry.inode);
+    if (!write_res.has_value()) {
+        return std::unexpected(write_res.error());
+    }
+    entry.dirty = false;
+    return {};
+}
+
+void InodeManager::_applyMapping(Inode& inode)
+{
+    if (!_superblock.extent_mapped_files)
+        return;
+    inode.extent_mapped = true;
+    inode.extent_count = 0;
+}
+
+std::expected<void, FsError> InodeManager::_checkTaken(inode_index_t inode)
+{
+    auto is_free = _bitmap.getBit(inode);
+    if (!is_free.has_value()) {
+        return std::unexpected(is_free.error());
+    }
+    if (is_free.value()) {
+        return std::unexpected(FsError::InodeManager_NotFound);
+    }
+    return {};
 }
 
 DataLocation InodeManager::_getInodeLocation(inode_index_t inode)
 {
+    auto data_size = _block_device.dataSize();
     DataLocation result;
-    result.block_index
-        = _superblock.inode_table_address + inode * sizeof(Inode) / _block_device.dataSize();
-    result.offset = inode * sizeof(Inode) % _block_device.dataSize();
+    if (!_superblock.inodes_block_aligned) {
+        result.block_index = _superblock.inode_table_address + inode * sizeof(Inode) / data_size;
+        result.offset = inode * sizeof(Inode) % data_size;
+        return result;
+    }
+
+    auto per_block = data_size / sizeof(Inode);
+    if (per_block == 0) {
+        result.block_index
+            = _superblock.inode_table_address + inode * divCeil(sizeof(Inode), data_size);
+        result.offset = 0;
+        return result;
+    }
+    result.block_index = _superblock.inode_table_address + inode / per_block;
+    result.offset = inode % per_block * sizeof(Inode);
     return result;
 }
 
+size_t InodeManager::tableBlocks(const SuperBlock& superblock, size_t data_size)
+{
+    if (!superblock.inodes_block_aligned) {
+        return divCeil(superblock.total_inodes * sizeof(Inode), data_size);
+    }
+    auto per_block = data_size / sizeof(Inode);
+    if (per_block == 0) {
+        return superblock.total_inodes * divCeil(sizeof(Inode), data_size);
+    }
+    return divCeil(superblock.total_inodes, per_block);
+}
+
 std::expected<void, FsError> InodeManager::_writeInode(inode_index_t index, const Inode& inode)
 {
     // TODO: When we switch to static memory, optimise this
@@ -88,9 +283,9 @@ std::expected<Inode, FsError> InodeManager::_readInode(inode_index_t index)
     return inode;
 }
 
-std::expected<inode_index_t, FsError> InodeManager::create(Inode& inode)
+std::expected<inode_index_t, FsError> InodeManager::_unprotectedCreate(Inode& inode)
 {
-    auto result = _bitmap.getFirstEq(1); // one means free
+    auto result = _cursor.find(_bitmap, 1); // one means free
     if (!result.has_value()) {
         if (result.error() == FsError::Bitmap_NotFound) {
             return std::unexpected(FsError::InodeManager_NoMoreFreeInodes);
@@ -98,6 +293,7 @@ std::expected<inode_index_t, FsError> InodeManager::create(Inode& inode)
         return std::unexpected(result.error());
     }
     auto node_id = result.value();
+    _applyMapping(inode);
 
     auto write_res = _writeInode(node_id, inode);
 
@@ -109,57 +305,211 @@ std::expected<inode_index_t, FsError> InodeManager::create(Inode& inode)
     if (!setbit_res.has_value()) {
         return std::unexpected(setbit_res.error());
     }
+    _cursor.advance(node_id);
+
+    // New inodes are usually opened right after creation
+    auto entry_res = _allocate();
+    if (entry_res.has_value() && entry_res.value() != nullptr) {
+        *entry_res.value() = CacheEntry { .index = node_id, .valid = true, .inode = inode };
+    }
     return node_id;
 }
 
-std::expected<void, FsError> InodeManager::remove(inode_index_t inode)
+std::expected<void, FsError> InodeManager::_unprotectedRemove(inode_index_t inode)
 {
-    auto is_free = _bitmap.getBit(inode);
-    if (!is_free.has_value()) {
-        return std::unexpected(is_free.error());
+    // Checked and written by the bitmap in one go, one means free
+    static_vector<std::uint32_t> bits(&inode, 1, 1);
+    auto set_res = _bitmap.setBits(bits, 1, true);
+    if (!set_res.has_value()) {
+        if (set_res.error() == FsError::Bitmap_AlreadySet) {
+            return std::unexpected(FsError::InodeManager_AlreadyFree);
+        }
+        return std::unexpected(set_res.error());
     }
-    if (is_free.value()) {
-        return std::unexpected(FsError::InodeManager_AlreadyFree);
+
+    // Changes of a removed inode don't have to reach the disk
+    if (auto entry = _find(inode); entry != nullptr) {
+        *entry = CacheEntry {};
     }
-    return _bitmap.setBit(inode, 1);
+    return {};
 }
 
-std::expected<Inode, FsError> InodeManager::get(inode_index_t inode)
+std::expected<Inode, FsError> InodeManager::_unprotectedGet(inode_index_t inode)
 {
-    auto is_free = _bitmap.getBit(inode);
-    if (!is_free.has_value()) {
-        return std::unexpected(is_free.error());
+    if (auto check_res = _checkTaken(inode); !check_res.has_value()) {
+        return std::unexpected(check_res.error());
     }
-    if (is_free.value()) {
-        return std::unexpected(FsError::InodeManager_NotFound);
+
+    if (auto entry = _find(inode); entry != nullptr) {
+        _hits++;
+        entry->referenced = true;
+        return entry->inode;
     }
+    _misses++;
 
-    return _readInode(inode);
+    auto read_res = _readInode(inode);
+    if (!read_res.has_value()) {
+        return std::unexpected(read_res.error());
+    }
+    _cacheRead(inode, read_res.value());
+    return read_res.value();
 }
 
-std::expected<unsigned int, FsError> InodeManager::numFree() { return _bitmap.count(1); }
+std::expected<void, FsError> InodeManager::_unprotectedGetMany(
+    const static_vector<inode_index_t>& indices, static_vector<std::optional<Inode>>& inodes)
+{
+    auto resize_res = inodes.resize(indices.size());
+    if (!resize_res.has_value()) {
+        return std::unexpected(resize_res.error());
+    }
 
-std::expected<void, FsError> InodeManager::update(inode_index_t inode_index, const Inode& inode)
+    auto data_size = _block_device.dataSize();
+    for (size_t first = 0; first < indices.size(); first += GET_MANY_BATCH) {
+        size_t last = std::min(indices.size(), first + GET_MANY_BATCH);
+
+        // Cached inodes are answered right away, the rest are read from disk below
+        std::bitset<GET_MANY_BATCH> pending;
+        for (size_t i = first; i < last; i++) {
+            inodes[i] = std::nullopt;
+            if (!_checkTaken(indices[i]).has_value()) {
+                continue;
+            }
+            if (auto entry = _find(indices[i]); entry != nullptr) {
+                _hits++;
+                entry->referenced = true;
+                inodes[i] = entry->inode;
+                continue;
+            }
+            _misses++;
+            pending.set(i - first);
+        }
+
+        for (size_t i = first; i < last; i++) {
+            if (!pending.test(i - first)) {
+                continue;
+            }
+            auto location = _getInodeLocation(indices[i]);
+            if (location.offset + sizeof(Inode) > data_size) {
+                // Inode spans two blocks, it is read on its own
+                pending.reset(i - first);
+                auto read_res = _readInode(indices[i]);
+                if (read_res.has_value()) {
+                    inodes[i] = read_res.value();
+                    _cacheRead(indices[i], read_res.value());
+                }
+                continue;
+            }
+
+            // One decode of the block serves every pending inode it holds
+            static_vector<std::uint8_t> block(_table_block.data(), data_size);
+            auto read_res = _block_device.readBlock(
+                DataLocation(location.block_index, 0), data_size, block);
+            for (size_t j = i; j < last; j++) {
+                if (!pending.test(j - first)) {
+                    continue;
+                }
+                auto other = _getInodeLocation(indices[j]);
+                if (other.block_index != location.block_index
+                    || other.offset + sizeof(Inode) > data_size) {
+                    continue;
+                }
+                pending.reset(j - first);
+                if (!read_res.has_value() || block.size() < other.offset + sizeof(Inode)) {
+                    continue;
+                }
+                Inode inode;
+                std::memcpy(&inode, block.data() + other.offset, sizeof(Inode));
+                inodes[j] = inode;
+                _cacheRead(indices[j], inode);
+            }
+        }
+    }
+    return {};
+}
+
+std::expected<unsigned int, FsError> InodeManager::_unprotectedNumFree()
 {
-    auto is_free = _bitmap.getBit(inode_index);
-    if (!is_free.has_value()) {
-        return std::unexpected(is_free.error());
+    return _bitmap.count(1);
+}
+
+std::expected<void, FsError> InodeManager::_unprotectedUpdate(
+    inode_index_t inode_index, const Inode& inode)
+{
+    if (auto check_res = _checkTaken(inode_index); !check_res.has_value()) {
+        return std::unexpected(check_res.error());
     }
-    if (is_free.value()) {
-        return std::unexpected(FsError::InodeManager_NotFound);
+
+    auto entry = _find(inode_index);
+    if (entry == nullptr) {
+        auto entry_res = _allocate();
+        if (!entry_res.has_value()) {
+            return std::unexpected(entry_res.error());
+        }
+        entry = entry_res.value();
+        if (entry == nullptr) {
+            // Everything is pinned, the inode goes straight to disk
+            return _writeInode(inode_index, inode);
+        }
+        *entry = CacheEntry { .index = inode_index, .valid = true };
     }
+    entry->inode = inode;
+    entry->dirty = true;
+    entry->referenced = true;
+    return {};
+}
 
-    auto write_res = _writeInode(inode_index, inode);
+std::expected<void, FsError> InodeManager::_unprotectedFlush()
+{
+    for (auto& entry : _cache) {
+        if (!entry.valid) {
+            continue;
+        }
+        auto write_res = _writeBack(entry);
+        if (!write_res.has_value()) {
+            return std::unexpected(write_res.error());
+        }
+    }
+    return {};
+}
 
-    if (!write_res.has_value()) {
-        return std::unexpected(write_res.error());
+std::expected<void, FsError> InodeManager::_unprotectedFlush(inode_index_t inode)
+{
+    auto entry = _find(inode);
+    if (entry == nullptr) {
+        return {};
     }
+    return _writeBack(*entry);
+}
 
+std::expected<void, FsError> InodeManager::_unprotectedPin(inode_index_t inode)
+{
+    auto entry = _find(inode);
+    if (entry == nullptr) {
+        auto get_res = _unprotectedGet(inode);
+        if (!get_res.has_value()) {
+            return std::unexpected(get_res.error());
+        }
+        entry = _find(inode);
+        if (entry == nullptr) {
+            // Cache is full of pinned inodes, the inode is simply read from disk every time
+            return {};
+        }
+    }
+    entry->pins++;
     return {};
 }
 
-std::expected<void, FsError> InodeManager::format()
+void InodeManager::_unprotectedUnpin(inode_index_t inode)
+{
+    auto entry = _find(inode);
+    if (entry != nullptr && entry->pins > 0) {
+        entry->pins--;
+    }
+}
+
+std::expected<void, FsError> InodeManager::_unprotectedFormat()
 {
+    _cache.fill(CacheEntry {});
     auto set_res = _bitmap.setAll(1);
     if (!set_res.has_value()) {
         return std::unexpected(set_res.error());
@@ -178,6 +528,7 @@ std::expected<void, FsError> InodeManager::_createRootInode()
     }
 
     Inode root { .file_size = 0, .type = InodeType::Directory };
+    _applyMapping(root);
 
     auto write_res = _writeInode(0, root);
 
@@ -7,13 +7,26 @@ using namespace low_level_fuse;
 
 /**
  * FUSE adapter for PpFS providing userspace filesystem functionality.
+ *
+ * Callbacks run on the worker threads of fuse_session_loop_mt. They keep no state of
+ * their own besides the PpFSLowLevel reference, all synchronisation is done by PpFS.
  */
 class FusePpFS : public FuseWrapper<FusePpFS> {
 private:
+    /** Number of directory entries fetched from PpFS at once by readdir and readdirplus. */
+    static constexpr size_t READDIR_BATCH = 32;
+
     PpFSLowLevel& _ppfs;
 
     [[nodiscard]] std::expected<void, FsError> _get_stats(fuse_ino_t ino, struct stat* stbuf);
+    static void _fill_stats(fuse_ino_t ino, const FileAttributes& attributes, struct stat* stbuf);
+    /** Lists directory from offset off, with attributes and lookups of entries if plus is set. */
+    void _read_directory(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, bool plus);
     static int _map_fs_error_to_errno(FsError err);
+    /** Buffer of the calling worker thread, reused between requests and grown on demand. */
+    static uint8_t* _thread_buffer(size_t size);
+    void _write_at(
+        fuse_req_t req, uint8_t* data, size_t size, off_t off, struct fuse_file_info* fi);
 
 public:
     FusePpFS(PpFSLowLevel& ppfs);
@@ -25,11 +38,16 @@ public:
     static void lookup(fuse_req_t req, fuse_ino_t parent, const char* name);
     static void readdir(
         fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi);
+    static void readdirplus(
+        fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi);
     static void mkdir(fuse_req_t req, fuse_ino_t parent, const char* name, mode_t mode);
     static void open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi);
     static void write(fuse_req_t req, fuse_ino_t ino, const char* buf, size_t size, off_t off,
         struct fuse_file_info* fi);
+    static void write_buf(fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec* bufv, off_t off,
+        struct fuse_file_info* fi);
     static void release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi);
+    static void fsync(fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info* fi);
     static void mknod(fuse_req_t req, fuse_ino_t parent, const char* name, mode_t mode, dev_t rdev);
     static void unlink(fuse_req_t req, fuse_ino_t parent, const char* name);
     static void rmdir(fuse_req_t req, fuse_ino_t parent, const char* name);
@@ -1,6 +1,9 @@
 #include "ppfs/low_level_fuse/fuse_ppfs.hpp"
 #include "ppfs/common/static_vector.hpp"
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <memory>
 #include <new>
 
 #define HANDLE_EXPECTED_ERROR(req, result_expr)                                                    \
@@ -115,57 +118,13 @@ void FusePpFS::lookup(fuse_req_t req, fuse_ino_t parent, const char* name)
 void FusePpFS::readdir(
     fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi)
 {
-    const auto ptr = this_(req);
-
-    char* buf = (char*)malloc(size);
-    if (!buf) {
-        fuse_reply_err(req, ENOMEM);
-        return;
-    }
-
-    inode_index_t ppfs_inode = ino - 1;
-
-    DirectoryEntry* entries_buffer = new (std::nothrow) DirectoryEntry[size];
-    if (!entries_buffer) {
-        free(buf);
-        fuse_reply_err(req, ENOMEM);
-        return;
-    }
-
-    static_vector<DirectoryEntry> entries(entries_buffer, size);
-    auto entries_res = ptr->_ppfs.getDirectoryEntries(ppfs_inode, entries, off, size);
-    HANDLE_EXPECTED_ERROR(req, entries_res);
-
-    size_t total_size = 0;
-
-    size_t current_vector_index = (size_t)off;
-
-    for (size_t i = current_vector_index; i < entries.size(); ++i) {
-        if (total_size >= size)
-            break;
-
-        DirectoryEntry& entry = entries[i];
-        struct stat entry_st;
-
-        if (!(ptr->_get_stats(entry.inode + 1, &entry_st)).has_value()) {
-            continue;
-        }
-
-        off_t next_offset = (off_t)i + 1;
-
-        size_t entry_size = fuse_add_direntry(
-            req, buf + total_size, size - total_size, entry.name.data(), &entry_st, next_offset);
-
-        if (entry_size > size - total_size) {
-            break;
-        }
-
-        total_size += entry_size;
-    }
+    this_(req)->_read_directory(req, ino, size, off, false);
+}
 
-    delete[] entries_buffer;
-    fuse_reply_buf(req, buf, total_size);
-    free(buf);
+void FusePpFS::readdirplus(
+    fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info* fi)
+{
+    this_(req)->_read_directory(req, ino, size, off, true);
 }
 
 void FusePpFS::mkdir(fuse_req_t req, fuse_ino_t parent, const char* name, mode_t mode)
@@ -227,26 +186,38 @@ void FusePpFS::write(fuse_req_t req, fuse_ino_t ino, const char* buf, size_t siz
 {
     const auto ptr = this_(req);
 
-    if (!(fi->flags & O_APPEND)) {
-        auto seek_res = ptr->_ppfs.seek(fi->fh, off);
-        HANDLE_EXPECTED_ERROR(req, seek_res);
+    // PpFS only reads the buffer, so the request data is written in place
+    ptr->_write_at(req, reinterpret_cast<uint8_t*>(const_cast<char*>(buf)), size, off, fi);
+}
+
+void FusePpFS::write_buf(
+    fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec* bufv, off_t off, struct fuse_file_info* fi)
+{
+    const auto ptr = this_(req);
+
+    const struct fuse_buf& first = bufv->buf[0];
+    if (bufv->count == 1 && !(first.flags & FUSE_BUF_IS_FD)) {
+        ptr->_write_at(req, static_cast<uint8_t*>(first.mem), first.size, off, fi);
+        return;
     }
 
-    uint8_t* write_buffer = new (std::nothrow) uint8_t[size];
-    if (!write_buffer) {
+    // Data spliced from /dev/fuse sits in a pipe, it is copied out once into the worker buffer
+    size_t size = fuse_buf_size(bufv);
+    uint8_t* data = _thread_buffer(size);
+    if (!data) {
         fuse_reply_err(req, ENOMEM);
         return;
     }
 
-    std::memcpy(write_buffer, buf, size);
-    static_vector<uint8_t> to_write(write_buffer, size, size);
-    auto write_res = ptr->_ppfs.write(fi->fh, to_write);
-
-    delete[] write_buffer;
-
-    HANDLE_EXPECTED_ERROR(req, write_res);
+    struct fuse_bufvec dst = FUSE_BUFVEC_INIT(size);
+    dst.buf[0].mem = data;
+    ssize_t copied = fuse_buf_copy(&dst, bufv, static_cast<fuse_buf_copy_flags>(0));
+    if (copied < 0) {
+        fuse_reply_err(req, -copied);
+        return;
+    }
 
-    fuse_reply_write(req, write_res.value());
+    ptr->_write_at(req, data, copied, off, fi);
 }
 
 void FusePpFS::read(
@@ -254,22 +225,21 @@ void FusePpFS::read(
 {
     const auto ptr = this_(req);
 
-    auto seek_res = ptr->_ppfs.seek(fi->fh, off);
-    HANDLE_EXPECTED_ERROR(req, seek_res);
-
-    uint8_t* read_buffer = new (std::nothrow) uint8_t[size];
+    uint8_t* read_buffer = _thread_buffer(size);
     if (!read_buffer) {
         fuse_reply_err(req, ENOMEM);
         return;
     }
 
     static_vector<uint8_t> read_data(read_buffer, size);
-    auto read_res = ptr->_ppfs.read(fi->fh, size, read_data);
-
-    size_t bytes_read = read_data.size();
-    fuse_reply_buf(req, reinterpret_cast<const char*>(read_data.data()), bytes_read);
+    auto read_res = ptr->_ppfs.readAt(fi->fh, off, size, read_data);
+    // Reading at or past the end of the file replies with no data
+    if (!read_res.has_value() && read_res.error() != FsError::FileIO_OutOfBounds) {
+        fuse_reply_err(req, _map_fs_error_to_errno(read_res.error()));
+        return;
+    }
 
-    delete[] read_buffer;
+    fuse_reply_buf(req, reinterpret_cast<const char*>(read_data.data()), read_data.size());
 }
 
 void FusePpFS::release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi)
@@ -282,6 +252,17 @@ void FusePpFS::release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info* fi
     fuse_reply_err(req, 0);
 }
 
+void FusePpFS::fsync(fuse_req_t req, fuse_ino_t ino, int datasync, struct fuse_file_info* fi)
+{
+    const auto ptr = this_(req);
+
+    // Inodes are cached too, so datasync writes the same as a full sync
+    auto sync_res = ptr->_ppfs.sync();
+    HANDLE_EXPECTED_ERROR(req, sync_res);
+
+    fuse_reply_err(req, 0);
+}
+
 void FusePpFS::mknod(fuse_req_t req, fuse_ino_t parent, const char* name, mode_t mode, dev_t rdev)
 {
     const auto ptr = this_(req);
@@ -364,6 +345,86 @@ void FusePpFS::truncate(fuse_req_t req, fuse_ino_t ino, off_t new_size, struct f
     fuse_reply_err(req, 0);
 }
 
+void FusePpFS::_write_at(
+    fuse_req_t req, uint8_t* data, size_t size, off_t off, struct fuse_file_info* fi)
+{
+    static_vector<uint8_t> to_write(data, size, size);
+    // Descriptors opened with O_APPEND are written at their end by PpFS
+    auto write_res = _ppfs.writeAt(fi->fh, off, to_write);
+    HANDLE_EXPECTED_ERROR(req, write_res);
+
+    fuse_reply_write(req, write_res.value());
+}
+
+uint8_t* FusePpFS::_thread_buffer(size_t size)
+{
+    thread_local std::unique_ptr<uint8_t[]> buffer;
+    thread_local size_t capacity = 0;
+
+    if (!buffer || capacity < size) {
+        // Starts at the default max_read/max_write, so a worker usually allocates only once
+        size_t new_capacity = std::max<size_t>(size, 128 * 1024);
+        buffer.reset(new (std::nothrow) uint8_t[new_capacity]);
+        capacity = buffer ? new_capacity : 0;
+    }
+    return buffer.get();
+}
+
+void FusePpFS::_read_directory(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, bool plus)
+{
+    char* buf = reinterpret_cast<char*>(_thread_buffer(size));
+    if (!buf) {
+        fuse_reply_err(req, ENOMEM);
+        return;
+    }
+
+    inode_index_t ppfs_inode = ino - 1;
+    std::array<DirectoryEntry, READDIR_BATCH> entries_buffer;
+    std::array<std::optional<FileAttributes>, READDIR_BATCH> attributes_buffer;
+    size_t total_size = 0;
+    bool full = false;
+
+    // Entries are read in batches starting at off, until the reply buffer is full
+    while (!full) {
+        static_vector<DirectoryEntry> entries(entries_buffer.data(), READDIR_BATCH);
+        static_vector<std::optional<FileAttributes>> attributes(
+            attributes_buffer.data(), READDIR_BATCH);
+        auto entries_res = _ppfs.getDirectoryEntriesWithAttributes(
+            ppfs_inode, entries, attributes, off, READDIR_BATCH);
+        HANDLE_EXPECTED_ERROR(req, entries_res);
+
+        for (size_t i = 0; i < entries.size(); ++i) {
+            off_t next_offset = off + (off_t)i + 1;
+            if (!attributes[i].has_value())
+                continue;
+
+            struct fuse_entry_param e;
+            std::memset(&e, 0, sizeof(e));
+            e.ino = entries[i].inode + 1;
+            e.attr_timeout = 5.0;
+            e.entry_timeout = 5.0;
+            _fill_stats(e.ino, attributes[i].value(), &e.attr);
+
+            size_t entry_size = plus
+                ? fuse_add_direntry_plus(req, buf + total_size, size - total_size,
+                      entries[i].name.data(), &e, next_offset)
+                : fuse_add_direntry(req, buf + total_size, size - total_size,
+                      entries[i].name.data(), &e.attr, next_offset);
+            if (entry_size > size - total_size) {
+                full = true;
+                break;
+            }
+            total_size += entry_size;
+        }
+
+        if (entries.size() < READDIR_BATCH)
+            break;
+        off += entries.size();
+    }
+
+    fuse_reply_buf(req, buf, total_size);
+}
+
 std::expected<void, FsError> FusePpFS::_get_stats(fuse_ino_t ino, struct stat* stbuf)
 {
     inode_index_t ppfs_inode = ino - 1;
@@ -372,7 +433,12 @@ std::expected<void, FsError> FusePpFS::_get_stats(fuse_ino_t ino, struct stat* s
     if (!attr_res.has_value())
         return std::unexpected(attr_res.error());
 
-    const auto& attributes = attr_res.value();
+    _fill_stats(ino, attr_res.value(), stbuf);
+    return {};
+}
+
+void FusePpFS::_fill_stats(fuse_ino_t ino, const FileAttributes& attributes, struct stat* stbuf)
+{
     stbuf->st_size = attributes.size;
 
     stbuf->st_ino = ino;
@@ -391,7 +457,6 @@ std::expected<void, FsError> FusePpFS::_get_stats(fuse_ino_t ino, struct stat* s
     stbuf->st_mode = mode;
     stbuf->st_blksize = attributes.block_size;
     stbuf->st_blocks = (stbuf->st_size + attributes.block_size - 1) / attributes.block_size;
-    return {};
 }
 
 void FusePpFS::setattr(
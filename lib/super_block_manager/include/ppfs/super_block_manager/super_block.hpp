@@ -1,11 +1,25 @@
 #pragma once
 #include "ppfs/blockdevice/ecc_type.hpp"
+#include "ppfs/common/allocation_policy.hpp"
 #include "ppfs/common/types.hpp"
 
+#include <cstddef>
 #include <cstdint>
 
+/** Layout version written by format */
+inline constexpr std::uint8_t SUPER_BLOCK_VERSION = 2;
+
+/** On-disk size of the superblock, new fields take reserved bytes so copies never move */
+inline constexpr std::size_t SUPER_BLOCK_SIZE = 64;
+
+/** On-disk size of a version 1 superblock, which ends right after ecc_type */
+inline constexpr std::size_t SUPER_BLOCK_V1_SIZE = 53;
+
 /**
  * On-disk superblock containing filesystem metadata.
+ *
+ * Version 1 images have no version byte and store their copies SUPER_BLOCK_V1_SIZE bytes apart.
+ * They are mounted with every field after ecc_type at its default.
  */
 struct __attribute__((packed)) SuperBlock {
     std::uint8_t signature[4] = { 'P', 'P', 'F', 'S' }; ///< Filesystem signature "PPFS"
@@ -21,4 +35,14 @@ struct __attribute__((packed)) SuperBlock {
     std::uint64_t crc_polynomial; ///< CRC polynomial (if ecc_type is CRC)
     std::uint32_t rs_correctable_bytes; ///< Reed-Solomon correctable bytes (if ecc_type is RS)
     ECCType ecc_type; ///< Error correction type used
+    std::uint8_t version = SUPER_BLOCK_VERSION; ///< Layout version of the image
+    AllocationPolicy allocation_policy; ///< Where searches for free blocks and inodes start
+    bool inodes_block_aligned; ///< Inodes never cross blocks, otherwise the table is packed
+    bool extent_mapped_files; ///< New inodes map their data with extents instead of pointers
+    bool indexed_directories; ///< Large directories get a hashed index of names
+    std::uint8_t reserved[6] = {}; ///< Zero, room for future fields
 };
+
+static_assert(sizeof(SuperBlock) == SUPER_BLOCK_SIZE, "superblock layout must not change size");
+static_assert(offsetof(SuperBlock, version) == SUPER_BLOCK_V1_SIZE,
+    "version 1 fields must keep their offsets");
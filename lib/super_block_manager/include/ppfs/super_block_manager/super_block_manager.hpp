@@ -34,6 +34,9 @@ struct VotingResult {
  *
  * We assume there is only one class instance, so cached superblock
  * is the most recent one.
+ *
+ * Copies of version 1 images are SUPER_BLOCK_V1_SIZE bytes long, they are recognized when the
+ * current layout does not match and are repaired in their own layout.
  */
 class SuperBlockManager : public ISuperBlockManager {
     IDisk& _disk; /**< Underlying disk */
@@ -67,6 +70,12 @@ private:
     std::optional<SuperBlock> _superBlock; /**< Cached copy of the superblock */
     block_index_t _endByte; /**< Index where super blocks written at the beginning end */
     block_index_t _startByte; /**< Index where super blocks written at the end start */
+    std::size_t _copySize; /**< On-disk size of one copy, smaller on version 1 images */
+
+    /**
+     * Sets the size of copies and the addresses derived from it.
+     */
+    void _setCopySize(std::size_t copy_size);
 
     /**
      * Writes cached superblock to disk.
@@ -79,7 +88,13 @@ private:
     [[nodiscard]] std::expected<void, FsError> _readFromDisk();
 
     /**
-     * Performs bit voting on multiple copies of superblock data.
+     * Reads all three copies as if they were copy_size bytes long and votes on them.
+     */
+    [[nodiscard]] std::expected<VotingResult, FsError> _readCopies(std::size_t copy_size);
+
+    /**
+     * Performs bit voting on three consecutive copies of copy_size bytes each. Fields past
+     * copy_size are left at their defaults.
      */
-    VotingResult _performBitVoting(const static_vector<SuperBlock> copies);
+    VotingResult _performBitVoting(const static_vector<uint8_t>& copies, std::size_t copy_size);
 };
@@ -14,8 +14,14 @@ SuperBlockManager::SuperBlockManager(IDisk& disk)
     : _disk(disk)
     , _superBlock({})
 {
-    _endByte = 2 * sizeof(SuperBlock);
-    _startByte = _disk.size() - sizeof(SuperBlock);
+    _setCopySize(SUPER_BLOCK_SIZE);
+}
+
+void SuperBlockManager::_setCopySize(std::size_t copy_size)
+{
+    _copySize = copy_size;
+    _endByte = 2 * copy_size;
+    _startByte = _disk.size() - copy_size;
 }
 
 std::expected<SuperBlock, FsError> SuperBlockManager::get()
@@ -35,6 +41,7 @@ std::expected<SuperBlock, FsError> SuperBlockManager::get()
 std::expected<void, FsError> SuperBlockManager::put(SuperBlock new_super_block)
 {
     _superBlock = new_super_block;
+    _setCopySize(SUPER_BLOCK_SIZE);
 
     auto write_res = _writeToDisk(true, true);
 
@@ -53,9 +60,9 @@ std::expected<BlockRange, FsError> SuperBlockManager::getFreeBlocksIndexes()
     }
 
     block_index_t firstFreeBlock
-        = (2 * sizeof(SuperBlock) + _superBlock->block_size - 1) / _superBlock->block_size;
+        = (2 * _copySize + _superBlock->block_size - 1) / _superBlock->block_size;
     block_index_t lastFreeBlock = (_disk.size() / _superBlock->block_size)
-        - (sizeof(SuperBlock) + _superBlock->block_size - 1) / _superBlock->block_size;
+        - (_copySize + _superBlock->block_size - 1) / _superBlock->block_size;
     return BlockRange { firstFreeBlock, lastFreeBlock };
 }
 
@@ -69,75 +76,98 @@ std::expected<void, FsError> SuperBlockManager::_writeToDisk(bool writeAtBeginni
 
     // write at the beggining
 
-    std::array<SuperBlock, 2> sb_buffer;
-    static_vector<SuperBlock> sb_data(sb_buffer.data(), 2);
-    sb_data.push_back(_superBlock.value());
-    sb_data.push_back(_superBlock.value());
+    std::array<uint8_t, 2 * SUPER_BLOCK_SIZE> sb_buffer;
+    std::memcpy(sb_buffer.data(), &_superBlock.value(), _copySize);
+    std::memcpy(sb_buffer.data() + _copySize, &_superBlock.value(), _copySize);
 
     if (writeAtBeginning) {
-        auto write_res = _disk.write(0,
-            static_vector<uint8_t>((uint8_t*)sb_data.data(), sb_data.size() * sizeof(SuperBlock),
-                sb_data.size() * sizeof(SuperBlock)));
+        auto write_res = _disk.write(
+            0, static_vector<uint8_t>(sb_buffer.data(), 2 * _copySize, 2 * _copySize));
         if (!write_res.has_value())
             return std::unexpected(write_res.error());
     }
 
     // write at the end
     if (writeAtEnd) {
-        sb_data.resize(1);
-        auto write_res = _disk.write(_startByte,
-            static_vector<uint8_t>(
-                (uint8_t*)sb_data.data(), sizeof(SuperBlock), sizeof(SuperBlock)));
+        auto write_res = _disk.write(
+            _startByte, static_vector<uint8_t>(sb_buffer.data(), _copySize, _copySize));
         if (!write_res.has_value())
             return std::unexpected(write_res.error());
     }
     return {};
 }
 
-std::expected<void, FsError> SuperBlockManager::_readFromDisk()
+std::expected<VotingResult, FsError> SuperBlockManager::_readCopies(std::size_t copy_size)
 {
-    size_t read = 0;
-    std::array<SuperBlock, 3> buffer;
+    std::array<uint8_t, 3 * SUPER_BLOCK_SIZE> buffer;
 
     // read from the beginning
-    static_vector<uint8_t> temp1((uint8_t*)buffer.data(), 2 * sizeof(SuperBlock));
-    auto read_res = _disk.read(0, 2 * sizeof(SuperBlock), temp1);
+    static_vector<uint8_t> temp1(buffer.data(), 2 * copy_size);
+    auto read_res = _disk.read(0, 2 * copy_size, temp1);
     if (!read_res.has_value())
         return std::unexpected(read_res.error());
 
     // read from the end
-
-    static_vector<uint8_t> temp2(
-        (uint8_t*)buffer.data() + 2 * sizeof(SuperBlock), sizeof(SuperBlock));
-    read_res = _disk.read(_startByte, sizeof(SuperBlock), temp2);
+    static_vector<uint8_t> temp2(buffer.data() + 2 * copy_size, copy_size);
+    read_res = _disk.read(_disk.size() - copy_size, copy_size, temp2);
     if (!read_res.has_value())
         return std::unexpected(read_res.error());
 
-    auto voting_res = _performBitVoting(static_vector<SuperBlock>(buffer.data(), 3));
+    return _performBitVoting(
+        static_vector<uint8_t>(buffer.data(), 3 * copy_size, 3 * copy_size), copy_size);
+}
+
+std::expected<void, FsError> SuperBlockManager::_readFromDisk()
+{
+    auto current_res = _readCopies(SUPER_BLOCK_SIZE);
+    if (!current_res.has_value())
+        return std::unexpected(current_res.error());
+    auto voting_res = current_res.value();
 
     // Check if the disk is formatted by verifying the signature
-    if (std::memcmp(voting_res.finalData.signature, "PPFS", 4) != 0) {
-        return std::unexpected(FsError::PpFS_DiskNotFormatted);
+    bool formatted = std::memcmp(voting_res.finalData.signature, "PPFS", 4) == 0;
+    if (!formatted || voting_res.finalData.version != SUPER_BLOCK_VERSION) {
+        // A version 1 image has the signature of its second copy where the version byte is now
+        auto v1_res = _readCopies(SUPER_BLOCK_V1_SIZE);
+        if (!v1_res.has_value())
+            return std::unexpected(v1_res.error());
+        if (std::memcmp(v1_res->finalData.signature, "PPFS", 4) == 0) {
+            voting_res = v1_res.value();
+            voting_res.finalData.version = 1;
+            voting_res.finalData.allocation_policy = AllocationPolicy::FirstFit;
+            voting_res.finalData.inodes_block_aligned = false;
+            voting_res.finalData.extent_mapped_files = false;
+            voting_res.finalData.indexed_directories = false;
+            _setCopySize(SUPER_BLOCK_V1_SIZE);
+        } else if (formatted) {
+            // Checked before repairing copies, so images of another layout are never overwritten
+            return std::unexpected(FsError::SuperBlockManager_UnsupportedVersion);
+        } else {
+            return std::unexpected(FsError::PpFS_DiskNotFormatted);
+        }
+    }
+    if (!isValidAllocationPolicy(voting_res.finalData.allocation_policy)) {
+        return std::unexpected(FsError::SuperBlockManager_InvalidValue);
     }
 
+    // Damaged copies are rewritten from the voted superblock
+    _superBlock = voting_res.finalData;
     auto write_res = _writeToDisk(voting_res.damaged1 || voting_res.damaged2, voting_res.damaged3);
     if (!write_res.has_value()) {
+        _superBlock.reset();
         return std::unexpected(write_res.error());
     }
 
-    _superBlock = voting_res.finalData;
-
     return {};
 }
 
-VotingResult SuperBlockManager::_performBitVoting(const static_vector<SuperBlock> copies)
+VotingResult SuperBlockManager::_performBitVoting(
+    const static_vector<uint8_t>& copies, std::size_t copy_size)
 {
-    size_t numBytes = sizeof(SuperBlock);
+    size_t numBytes = copy_size;
     size_t numBits = numBytes * 8;
-    SuperBlock sb;
+    SuperBlock sb {};
 
-    static_vector<uint8_t> copies_bytes(
-        static_vector<uint8_t>((uint8_t*)copies.data(), copies.size() * sizeof(SuperBlock)));
     static_vector<uint8_t> resultBytes((uint8_t*)&sb, numBytes, numBytes);
 
     bool damaged1 = false;
@@ -145,9 +175,9 @@ VotingResult SuperBlockManager::_performBitVoting(const static_vector<SuperBlock
     bool damaged3 = false;
 
     for (size_t bit = 0; bit < numBits; bit++) {
-        bool b1 = BitHelpers::getBit(copies_bytes, bit);
-        bool b2 = BitHelpers::getBit(copies_bytes, bit + numBits);
-        bool b3 = BitHelpers::getBit(copies_bytes, bit + numBits * 2);
+        bool b1 = BitHelpers::getBit(copies, bit);
+        bool b2 = BitHelpers::getBit(copies, bit + numBits);
+        bool b3 = BitHelpers::getBit(copies, bit + numBits * 2);
 
         int sum = b1 + b2 + b3;
         bool majority = (sum >= 2);
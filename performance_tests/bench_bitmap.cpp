@@ -0,0 +1,48 @@
+#include "ppfs/bitmap/bitmap.hpp"
+#include "ppfs/blockdevice/hamming_block_device.hpp"
+#include "ppfs/disk/stack_disk.hpp"
+
+#include <array>
+#include <benchmark/benchmark.h>
+#include <random>
+
+/**
+ * Searches for a free bit in a 90% full bitmap of 32768 bits (block bitmap of the default 4MB
+ * disk with 128 byte blocks) stored on a Hamming device. Free bits are spread randomly, so the
+ * search without mirror has to decode several blocks.
+ */
+static void BM_Bitmap_FindFree(benchmark::State& state)
+{
+    constexpr size_t BITS = 32768;
+    bool use_mirror = state.range(0) != 0;
+    static StackDisk disk;
+    HammingBlockDevice device(7, disk);
+    static std::array<std::uint64_t, Bitmap::mirrorWords(BITS)> mirror;
+    Bitmap bitmap(device, 0, BITS,
+        use_mirror ? static_vector<std::uint64_t>(mirror.data(), mirror.size())
+                   : static_vector<std::uint64_t> {});
+
+    if (!bitmap.setAll(true).has_value()) {
+        state.SkipWithError("setAll failed");
+        return;
+    }
+    std::mt19937 rng(1);
+    for (size_t bit = 0; bit < BITS; bit++) {
+        if (rng() % 10 == 0 && !bitmap.setBit(bit, false).has_value()) {
+            state.SkipWithError("setBit failed");
+            return;
+        }
+    }
+
+    // Mark the found bit used and free a random one, so fullness stays at 90%
+    for (auto _ : state) {
+        auto found = bitmap.getFirstEq(false);
+        if (!found.has_value() || !bitmap.setBit(found.value(), true).has_value()
+            || !bitmap.setBit(rng() % BITS, false).has_value()) {
+            state.SkipWithError("bitmap operation failed");
+            break;
+        }
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK(BM_Bitmap_FindFree)->Arg(0)->Arg(1)->ArgName("mirror");
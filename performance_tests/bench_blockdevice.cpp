@@ -9,6 +9,7 @@
 #include <array>
 #include <benchmark/benchmark.h>
 #include <cmath>
+#include <random>
 template <class... Args> static void BM_BlockDevice_Read(benchmark::State& state, Args&&... args)
 {
     size_t block_size = 256;
@@ -57,6 +58,52 @@ BENCHMARK_CAPTURE(BM_BlockDevice_Read, rs_test, std::string("rs"))
     ->RangeMultiplier(2)
     ->Range(1, 256);
 
+static void BM_ReedSolomon_ReadWithErrors(benchmark::State& state)
+{
+    size_t block_size = 256;
+    StackDisk disk;
+    auto rs = ReedSolomonBlockDevice(disk, block_size, 16);
+    auto errors = static_cast<size_t>(state.range(0));
+
+    std::array<std::uint8_t, 4096> data_buffer;
+    std::mt19937 rng(1);
+    for (auto& byte : data_buffer) {
+        byte = static_cast<std::uint8_t>(rng());
+    }
+    static_vector<std::uint8_t> data(data_buffer.data(), data_buffer.size(), rs.dataSize());
+    if (!rs.writeBlock(data, { 0, 0 }).has_value()) {
+        state.SkipWithError("writeBlock failed");
+        return;
+    }
+
+    // Corrupt distinct bytes of the encoded block
+    std::array<std::uint8_t, 4096> corrupted_buffer;
+    static_vector<std::uint8_t> corrupted(corrupted_buffer.data(), corrupted_buffer.size());
+    if (!disk.read(0, rs.rawBlockSize(), corrupted).has_value()) {
+        state.SkipWithError("disk read failed");
+        return;
+    }
+    for (size_t i = 0; i < errors; i++) {
+        corrupted[(i * 97) % rs.rawBlockSize()] ^= static_cast<std::uint8_t>(1 + rng() % 255);
+    }
+
+    std::array<std::uint8_t, 4096> read_buffer;
+    static_vector<std::uint8_t> read_data(read_buffer.data(), read_buffer.size());
+    for (auto _ : state) {
+        // Corrected block is written back on read, so errors are injected again every iteration
+        if (!disk.write(0, corrupted).has_value()) {
+            state.SkipWithError("disk write failed");
+        }
+        auto ret = rs.readBlock({ 0, 0 }, rs.dataSize(), read_data);
+        if (!ret.has_value()) {
+            state.SkipWithError("readBlock failed");
+        }
+        benchmark::DoNotOptimize(read_data);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_ReedSolomon_ReadWithErrors)->DenseRange(0, 16, 2);
+
 template <class... Args> static void BM_BlockDevice_Write(benchmark::State& state, Args&&... args)
 {
     size_t block_size = 256;
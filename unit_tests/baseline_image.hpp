@@ -0,0 +1,256 @@
+#pragma once
+
+#include "ppfs/common/static_vector.hpp"
+#include "ppfs/disk/idisk.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Image formatted before the superblock was versioned, written by the code of that time.
+ *
+ * The 4 MiB image uses block_size 128, average_file_size 1024 and CRC with the default
+ * polynomial. It holds /docs/readme with 1000 bytes, byte i being i * 7 + 3, and empty files
+ * /big/file0 to /big/file19. Only its non-zero runs are stored.
+ */
+struct BaselineImageRun {
+    std::size_t address;
+    std::size_t offset;
+    std::size_t length;
+};
+inline constexpr std::size_t BASELINE_IMAGE_SIZE = 4194304;
+inline constexpr std::size_t BASELINE_IMAGE_README_SIZE = 1000;
+inline constexpr std::size_t BASELINE_IMAGE_BIG_FILES = 20;
+
+inline constexpr std::array<BaselineImageRun, 56> BASELINE_IMAGE_RUNS { {
+    { 0, 0, 106 },
+    { 131, 106, 637 },
+    { 784, 743, 10 },
+    { 845, 753, 4 },
+    { 865, 757, 6 },
+    { 892, 763, 4 },
+    { 929, 767, 5 },
+    { 950, 772, 34 },
+    { 1010, 806, 90 },
+    { 1148, 896, 4 },
+    { 343296, 900, 5 },
+    { 343420, 905, 4 },
+    { 347648, 909, 8 },
+    { 347772, 917, 15 },
+    { 347900, 932, 14 },
+    { 348028, 946, 4 },
+    { 348160, 950, 1032 },
+    { 349308, 1982, 4 },
+    { 349440, 1986, 9 },
+    { 349564, 1995, 17 },
+    { 349692, 2012, 21 },
+    { 349820, 2033, 25 },
+    { 349948, 2058, 4 },
+    { 349968, 2062, 9 },
+    { 350076, 2071, 4 },
+    { 350100, 2075, 9 },
+    { 350204, 2084, 4 },
+    { 350232, 2088, 9 },
+    { 350332, 2097, 4 },
+    { 350364, 2101, 9 },
+    { 350460, 2110, 4 },
+    { 350496, 2114, 9 },
+    { 350588, 2123, 4 },
+    { 350628, 2127, 9 },
+    { 350716, 2136, 4 },
+    { 350760, 2140, 10 },
+    { 350844, 2150, 4 },
+    { 350892, 2154, 10 },
+    { 350972, 2164, 132 },
+    { 351152, 2296, 10 },
+    { 351228, 2306, 4 },
+    { 351284, 2310, 10 },
+    { 351356, 2320, 4 },
+    { 351416, 2324, 10 },
+    { 351484, 2334, 4 },
+    { 351548, 2338, 10 },
+    { 351612, 2348, 4 },
+    { 351680, 2352, 10 },
+    { 351740, 2362, 4 },
+    { 351812, 2366, 10 },
+    { 351868, 2376, 4 },
+    { 351944, 2380, 10 },
+    { 351996, 2390, 4 },
+    { 352076, 2394, 10 },
+    { 352124, 2404, 4 },
+    { 4194251, 2408, 53 },
+} };
+
+inline constexpr std::array<std::uint8_t, 2461> BASELINE_IMAGE_BYTES {
+    0x50, 0x50, 0x46, 0x53, 0x00, 0x80, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x7a, 0x0a, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x9c, 0x0a, 0x00, 0x00,
+    0xff, 0x7f, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x99, 0x06, 0xc0, 0x32, 0x01, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x50, 0x50, 0x46, 0x53, 0x00, 0x80, 0x00, 0x00, 0x00, 0x10, 0x00,
+    0x00, 0x7a, 0x0a, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x9c, 0x0a, 0x00, 0x00, 0xff, 0x7f, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x99, 0x06, 0xc0,
+    0x32, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xd0, 0xbd, 0xc0, 0x58, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0x7a, 0xd8, 0x98, 0x08, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0x7a, 0xd8, 0x98, 0x08, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0x7a, 0xd8, 0x98, 0x08, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0x7a, 0xd8, 0x98, 0x08, 0x9c, 0x0a, 0x00, 0x00, 0x9d, 0x0a, 0x00, 0x00, 0xa9,
+    0x0a, 0x01, 0x00, 0x00, 0x01, 0x9e, 0x0a, 0x00, 0x00, 0x9f, 0x0a, 0xf5, 0x72, 0xaa, 0x2a, 0x80,
+    0x00, 0x00, 0x00, 0x01, 0xa0, 0x0a, 0x00, 0x00, 0xa1, 0x0a, 0x00, 0x00, 0xa2, 0x0a, 0x00, 0x00,
+    0xa3, 0x0a, 0x00, 0x00, 0xa4, 0x0a, 0x00, 0x00, 0xa5, 0x0a, 0x00, 0x00, 0xa6, 0x0a, 0x00, 0x00,
+    0xa7, 0x0a, 0x00, 0x00, 0xa8, 0x0a, 0xe8, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xca, 0xbf, 0xe3, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xaa,
+    0x0a, 0x00, 0x00, 0xab, 0x0a, 0x00, 0x00, 0xac, 0x0a, 0x00, 0x00, 0xad, 0x0a, 0x00, 0x00, 0xae,
+    0x0a, 0x00, 0x00, 0xaf, 0x0a, 0x00, 0x00, 0xb0, 0x0a, 0x00, 0x00, 0xb1, 0x0a, 0x00, 0x00, 0xb2,
+    0x0a, 0x00, 0x00, 0xb3, 0x0a, 0x00, 0x00, 0xb4, 0x0a, 0x00, 0x00, 0xb5, 0x0a, 0x00, 0x00, 0xb6,
+    0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x01,
+    0xd5, 0x94, 0xe3, 0x32, 0xff, 0xff, 0xff, 0xff, 0xf0, 0xdb, 0x12, 0x32, 0x1e, 0x01, 0x00, 0x00,
+    0x00, 0x64, 0x6f, 0x63, 0x73, 0x64, 0x77, 0xb1, 0x8e, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00,
+    0x00, 0x62, 0x69, 0x67, 0x79, 0xc8, 0x37, 0xe2, 0x02, 0x00, 0x00, 0x00, 0x72, 0x65, 0x61, 0x64,
+    0x6d, 0x65, 0x4b, 0xee, 0x6f, 0x68, 0x03, 0x0a, 0x11, 0x18, 0x1f, 0x26, 0x2d, 0x34, 0x3b, 0x42,
+    0x49, 0x50, 0x57, 0x5e, 0x65, 0x6c, 0x73, 0x7a, 0x81, 0x88, 0x8f, 0x96, 0x9d, 0xa4, 0xab, 0xb2,
+    0xb9, 0xc0, 0xc7, 0xce, 0xd5, 0xdc, 0xe3, 0xea, 0xf1, 0xf8, 0xff, 0x06, 0x0d, 0x14, 0x1b, 0x22,
+    0x29, 0x30, 0x37, 0x3e, 0x45, 0x4c, 0x53, 0x5a, 0x61, 0x68, 0x6f, 0x76, 0x7d, 0x84, 0x8b, 0x92,
+    0x99, 0xa0, 0xa7, 0xae, 0xb5, 0xbc, 0xc3, 0xca, 0xd1, 0xd8, 0xdf, 0xe6, 0xed, 0xf4, 0xfb, 0x02,
+    0x09, 0x10, 0x17, 0x1e, 0x25, 0x2c, 0x33, 0x3a, 0x41, 0x48, 0x4f, 0x56, 0x5d, 0x64, 0x6b, 0x72,
+    0x79, 0x80, 0x87, 0x8e, 0x95, 0x9c, 0xa3, 0xaa, 0xb1, 0xb8, 0xbf, 0xc6, 0xcd, 0xd4, 0xdb, 0xe2,
+    0xe9, 0xf0, 0xf7, 0xfe, 0x05, 0x0c, 0x13, 0x1a, 0x21, 0x28, 0x2f, 0x36, 0x3d, 0x44, 0x4b, 0x52,
+    0x59, 0x60, 0x5b, 0xe8, 0xe2, 0x6c, 0x67, 0x6e, 0x75, 0x7c, 0x83, 0x8a, 0x91, 0x98, 0x9f, 0xa6,
+    0xad, 0xb4, 0xbb, 0xc2, 0xc9, 0xd0, 0xd7, 0xde, 0xe5, 0xec, 0xf3, 0xfa, 0x01, 0x08, 0x0f, 0x16,
+    0x1d, 0x24, 0x2b, 0x32, 0x39, 0x40, 0x47, 0x4e, 0x55, 0x5c, 0x63, 0x6a, 0x71, 0x78, 0x7f, 0x86,
+    0x8d, 0x94, 0x9b, 0xa2, 0xa9, 0xb0, 0xb7, 0xbe, 0xc5, 0xcc, 0xd3, 0xda, 0xe1, 0xe8, 0xef, 0xf6,
+    0xfd, 0x04, 0x0b, 0x12, 0x19, 0x20, 0x27, 0x2e, 0x35, 0x3c, 0x43, 0x4a, 0x51, 0x58, 0x5f, 0x66,
+    0x6d, 0x74, 0x7b, 0x82, 0x89, 0x90, 0x97, 0x9e, 0xa5, 0xac, 0xb3, 0xba, 0xc1, 0xc8, 0xcf, 0xd6,
+    0xdd, 0xe4, 0xeb, 0xf2, 0xf9, 0x00, 0x07, 0x0e, 0x15, 0x1c, 0x23, 0x2a, 0x31, 0x38, 0x3f, 0x46,
+    0x4d, 0x54, 0x5b, 0x62, 0x69, 0x70, 0x77, 0x7e, 0x85, 0x8c, 0x93, 0x9a, 0xa1, 0xa8, 0xaf, 0xb6,
+    0xbd, 0xc4, 0xe8, 0x43, 0xcb, 0xae, 0xcb, 0xd2, 0xd9, 0xe0, 0xe7, 0xee, 0xf5, 0xfc, 0x03, 0x0a,
+    0x11, 0x18, 0x1f, 0x26, 0x2d, 0x34, 0x3b, 0x42, 0x49, 0x50, 0x57, 0x5e, 0x65, 0x6c, 0x73, 0x7a,
+    0x81, 0x88, 0x8f, 0x96, 0x9d, 0xa4, 0xab, 0xb2, 0xb9, 0xc0, 0xc7, 0xce, 0xd5, 0xdc, 0xe3, 0xea,
+    0xf1, 0xf8, 0xff, 0x06, 0x0d, 0x14, 0x1b, 0x22, 0x29, 0x30, 0x37, 0x3e, 0x45, 0x4c, 0x53, 0x5a,
+    0x61, 0x68, 0x6f, 0x76, 0x7d, 0x84, 0x8b, 0x92, 0x99, 0xa0, 0xa7, 0xae, 0xb5, 0xbc, 0xc3, 0xca,
+    0xd1, 0xd8, 0xdf, 0xe6, 0xed, 0xf4, 0xfb, 0x02, 0x09, 0x10, 0x17, 0x1e, 0x25, 0x2c, 0x33, 0x3a,
+    0x41, 0x48, 0x4f, 0x56, 0x5d, 0x64, 0x6b, 0x72, 0x79, 0x80, 0x87, 0x8e, 0x95, 0x9c, 0xa3, 0xaa,
+    0xb1, 0xb8, 0xbf, 0xc6, 0xcd, 0xd4, 0xdb, 0xe2, 0xe9, 0xf0, 0xf7, 0xfe, 0x05, 0x0c, 0x13, 0x1a,
+    0x21, 0x28, 0x5f, 0xf2, 0xe8, 0xde, 0x2f, 0x36, 0x3d, 0x44, 0x4b, 0x52, 0x59, 0x60, 0x67, 0x6e,
+    0x75, 0x7c, 0x83, 0x8a, 0x91, 0x98, 0x9f, 0xa6, 0xad, 0xb4, 0xbb, 0xc2, 0xc9, 0xd0, 0xd7, 0xde,
+    0xe5, 0xec, 0xf3, 0xfa, 0x01, 0x08, 0x0f, 0x16, 0x1d, 0x24, 0x2b, 0x32, 0x39, 0x40, 0x47, 0x4e,
+    0x55, 0x5c, 0x63, 0x6a, 0x71, 0x78, 0x7f, 0x86, 0x8d, 0x94, 0x9b, 0xa2, 0xa9, 0xb0, 0xb7, 0xbe,
+    0xc5, 0xcc, 0xd3, 0xda, 0xe1, 0xe8, 0xef, 0xf6, 0xfd, 0x04, 0x0b, 0x12, 0x19, 0x20, 0x27, 0x2e,
+    0x35, 0x3c, 0x43, 0x4a, 0x51, 0x58, 0x5f, 0x66, 0x6d, 0x74, 0x7b, 0x82, 0x89, 0x90, 0x97, 0x9e,
+    0xa5, 0xac, 0xb3, 0xba, 0xc1, 0xc8, 0xcf, 0xd6, 0xdd, 0xe4, 0xeb, 0xf2, 0xf9, 0x00, 0x07, 0x0e,
+    0x15, 0x1c, 0x23, 0x2a, 0x31, 0x38, 0x3f, 0x46, 0x4d, 0x54, 0x5b, 0x62, 0x69, 0x70, 0x77, 0x7e,
+    0x85, 0x8c, 0xb7, 0x34, 0xf0, 0xcc, 0x93, 0x9a, 0xa1, 0xa8, 0xaf, 0xb6, 0xbd, 0xc4, 0xcb, 0xd2,
+    0xd9, 0xe0, 0xe7, 0xee, 0xf5, 0xfc, 0x03, 0x0a, 0x11, 0x18, 0x1f, 0x26, 0x2d, 0x34, 0x3b, 0x42,
+    0x49, 0x50, 0x57, 0x5e, 0x65, 0x6c, 0x73, 0x7a, 0x81, 0x88, 0x8f, 0x96, 0x9d, 0xa4, 0xab, 0xb2,
+    0xb9, 0xc0, 0xc7, 0xce, 0xd5, 0xdc, 0xe3, 0xea, 0xf1, 0xf8, 0xff, 0x06, 0x0d, 0x14, 0x1b, 0x22,
+    0x29, 0x30, 0x37, 0x3e, 0x45, 0x4c, 0x53, 0x5a, 0x61, 0x68, 0x6f, 0x76, 0x7d, 0x84, 0x8b, 0x92,
+    0x99, 0xa0, 0xa7, 0xae, 0xb5, 0xbc, 0xc3, 0xca, 0xd1, 0xd8, 0xdf, 0xe6, 0xed, 0xf4, 0xfb, 0x02,
+    0x09, 0x10, 0x17, 0x1e, 0x25, 0x2c, 0x33, 0x3a, 0x41, 0x48, 0x4f, 0x56, 0x5d, 0x64, 0x6b, 0x72,
+    0x79, 0x80, 0x87, 0x8e, 0x95, 0x9c, 0xa3, 0xaa, 0xb1, 0xb8, 0xbf, 0xc6, 0xcd, 0xd4, 0xdb, 0xe2,
+    0xe9, 0xf0, 0x15, 0xdf, 0xc2, 0x94, 0xf7, 0xfe, 0x05, 0x0c, 0x13, 0x1a, 0x21, 0x28, 0x2f, 0x36,
+    0x3d, 0x44, 0x4b, 0x52, 0x59, 0x60, 0x67, 0x6e, 0x75, 0x7c, 0x83, 0x8a, 0x91, 0x98, 0x9f, 0xa6,
+    0xad, 0xb4, 0xbb, 0xc2, 0xc9, 0xd0, 0xd7, 0xde, 0xe5, 0xec, 0xf3, 0xfa, 0x01, 0x08, 0x0f, 0x16,
+    0x1d, 0x24, 0x2b, 0x32, 0x39, 0x40, 0x47, 0x4e, 0x55, 0x5c, 0x63, 0x6a, 0x71, 0x78, 0x7f, 0x86,
+    0x8d, 0x94, 0x9b, 0xa2, 0xa9, 0xb0, 0xb7, 0xbe, 0xc5, 0xcc, 0xd3, 0xda, 0xe1, 0xe8, 0xef, 0xf6,
+    0xfd, 0x04, 0x0b, 0x12, 0x19, 0x20, 0x27, 0x2e, 0x35, 0x3c, 0x43, 0x4a, 0x51, 0x58, 0x5f, 0x66,
+    0x6d, 0x74, 0x7b, 0x82, 0x89, 0x90, 0x97, 0x9e, 0xa5, 0xac, 0xb3, 0xba, 0xc1, 0xc8, 0xcf, 0xd6,
+    0xdd, 0xe4, 0xeb, 0xf2, 0xf9, 0x00, 0x07, 0x0e, 0x15, 0x1c, 0x23, 0x2a, 0x31, 0x38, 0x3f, 0x46,
+    0x4d, 0x54, 0xba, 0x34, 0xb6, 0x20, 0x5b, 0x62, 0x69, 0x70, 0x77, 0x7e, 0x85, 0x8c, 0x93, 0x9a,
+    0xa1, 0xa8, 0xaf, 0xb6, 0xbd, 0xc4, 0xcb, 0xd2, 0xd9, 0xe0, 0xe7, 0xee, 0xf5, 0xfc, 0x03, 0x0a,
+    0x11, 0x18, 0x1f, 0x26, 0x2d, 0x34, 0x3b, 0x42, 0x49, 0x50, 0x57, 0x5e, 0x65, 0x6c, 0x73, 0x7a,
+    0x81, 0x88, 0x8f, 0x96, 0x9d, 0xa4, 0xab, 0xb2, 0xb9, 0xc0, 0xc7, 0xce, 0xd5, 0xdc, 0xe3, 0xea,
+    0xf1, 0xf8, 0xff, 0x06, 0x0d, 0x14, 0x1b, 0x22, 0x29, 0x30, 0x37, 0x3e, 0x45, 0x4c, 0x53, 0x5a,
+    0x61, 0x68, 0x6f, 0x76, 0x7d, 0x84, 0x8b, 0x92, 0x99, 0xa0, 0xa7, 0xae, 0xb5, 0xbc, 0xc3, 0xca,
+    0xd1, 0xd8, 0xdf, 0xe6, 0xed, 0xf4, 0xfb, 0x02, 0x09, 0x10, 0x17, 0x1e, 0x25, 0x2c, 0x33, 0x3a,
+    0x41, 0x48, 0x4f, 0x56, 0x5d, 0x64, 0x6b, 0x72, 0x79, 0x80, 0x87, 0x8e, 0x95, 0x9c, 0xa3, 0xaa,
+    0xb1, 0xb8, 0x40, 0xed, 0x11, 0x10, 0xbf, 0xc6, 0xcd, 0xd4, 0xdb, 0xe2, 0xe9, 0xf0, 0xf7, 0xfe,
+    0x05, 0x0c, 0x13, 0x1a, 0x21, 0x28, 0x2f, 0x36, 0x3d, 0x44, 0x4b, 0x52, 0x59, 0x60, 0x67, 0x6e,
+    0x75, 0x7c, 0x83, 0x8a, 0x91, 0x98, 0x9f, 0xa6, 0xad, 0xb4, 0xbb, 0xc2, 0xc9, 0xd0, 0xd7, 0xde,
+    0xe5, 0xec, 0xf3, 0xfa, 0x01, 0x08, 0x0f, 0x16, 0x1d, 0x24, 0x2b, 0x32, 0x39, 0x40, 0x47, 0x4e,
+    0x55, 0x5c, 0x63, 0x6a, 0x71, 0x78, 0x7f, 0x86, 0x8d, 0x94, 0x9b, 0xa2, 0xa9, 0xb0, 0xb7, 0xbe,
+    0xc5, 0xcc, 0xd3, 0xda, 0xe1, 0xe8, 0xef, 0xf6, 0xfd, 0x04, 0x0b, 0x12, 0x19, 0x20, 0x27, 0x2e,
+    0x35, 0x3c, 0x43, 0x4a, 0x51, 0x58, 0x5f, 0x66, 0x6d, 0x74, 0x7b, 0x82, 0x89, 0x90, 0x97, 0x9e,
+    0xa5, 0xac, 0xb3, 0xba, 0xc1, 0xc8, 0xcf, 0xd6, 0xdd, 0xe4, 0xeb, 0xf2, 0xf9, 0x00, 0x07, 0x0e,
+    0x15, 0x1c, 0x55, 0xfe, 0xe0, 0x4e, 0x23, 0x2a, 0x31, 0x38, 0x3f, 0x46, 0x4d, 0x54, 0x4b, 0x27,
+    0xe0, 0x08, 0x04, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65, 0x30, 0xe9, 0x63, 0x78, 0x6e, 0x00,
+    0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65, 0x31, 0x78, 0xb1, 0x05, 0x28,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65,
+    0x32, 0xb9, 0xe5, 0x2a, 0x76, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x07, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65, 0x33, 0xe7, 0xfc, 0x7f, 0xd0, 0x08, 0x00,
+    0x00, 0x00, 0x66, 0x69, 0x6c, 0x65, 0x34, 0x9f, 0xa3, 0xfb, 0x6a, 0x09, 0x00, 0x00, 0x00, 0x66,
+    0x69, 0x6c, 0x65, 0x35, 0x2c, 0x60, 0x72, 0x22, 0x0a, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65,
+    0x36, 0xf5, 0x65, 0xeb, 0x28, 0x0b, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65, 0x37, 0xe3, 0xd3,
+    0x66, 0x62, 0x0c, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65, 0x38, 0x0a, 0x25, 0x08, 0x54, 0x0d,
+    0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65, 0x39, 0x12, 0x05, 0x5b, 0x9e, 0x0e, 0x00, 0x00, 0x00,
+    0x66, 0x69, 0x6c, 0x65, 0x31, 0x30, 0x74, 0xbf, 0x30, 0xce, 0x0f, 0x00, 0x00, 0x00, 0x66, 0x69,
+    0x6c, 0x65, 0x31, 0x31, 0xae, 0x50, 0x19, 0x96, 0xb7, 0x0a, 0x00, 0x00, 0xb8, 0x0a, 0x00, 0x00,
+    0xb9, 0x0a, 0x00, 0x00, 0xba, 0x0a, 0x00, 0x00, 0xbb, 0x0a, 0x00, 0x00, 0xbc, 0x0a, 0x00, 0x00,
+    0xbd, 0x0a, 0x00, 0x00, 0xbe, 0x0a, 0x00, 0x00, 0xbf, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x19, 0xbf, 0xca, 0x7a, 0x75, 0x55, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x92, 0xb4, 0xca, 0x7a, 0x75, 0x55, 0x00, 0x00, 0xe8, 0xd7, 0x26, 0x6e, 0xfc, 0x7f, 0x00, 0x00,
+    0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xd2, 0xb9, 0xca, 0x7a, 0x75, 0x55, 0x00, 0x00, 0x2f, 0xa1, 0x26, 0x6e, 0xfc, 0x7f, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0xbf, 0x5c, 0xa3, 0x1e, 0x10, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65,
+    0x31, 0x32, 0x32, 0x4a, 0x5c, 0x9a, 0x11, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65, 0x31, 0x33,
+    0x0f, 0x33, 0x48, 0x0c, 0x12, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65, 0x31, 0x34, 0x9b, 0x23,
+    0x62, 0x3e, 0x13, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65, 0x31, 0x35, 0x18, 0x2c, 0x75, 0x38,
+    0x14, 0x00, 0x00, 0x00, 0x66, 0x69, 0x6c, 0x65, 0x31, 0x36, 0x83, 0xe9, 0x27, 0xfc, 0x15, 0x00,
+    0x00, 0x00, 0x66, 0x69, 0x6c, 0x65, 0x31, 0x37, 0xf3, 0x04, 0xdd, 0xe2, 0x16, 0x00, 0x00, 0x00,
+    0x66, 0x69, 0x6c, 0x65, 0x31, 0x38, 0x4b, 0x89, 0xa6, 0x76, 0x17, 0x00, 0x00, 0x00, 0x66, 0x69,
+    0x6c, 0x65, 0x31, 0x39, 0x4d, 0x48, 0xd6, 0xf8, 0x50, 0x50, 0x46, 0x53, 0x00, 0x80, 0x00, 0x00,
+    0x00, 0x10, 0x00, 0x00, 0x7a, 0x0a, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x9c, 0x0a, 0x00, 0x00, 0xff, 0x7f, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00,
+    0x99, 0x06, 0xc0, 0x32, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+};
+
+/**
+ * Writes the image to a zeroed disk of BASELINE_IMAGE_SIZE bytes.
+ */
+inline std::expected<void, FsError> writeBaselineImage(IDisk& disk)
+{
+    std::array<std::uint8_t, BASELINE_IMAGE_BYTES.size()> buffer = BASELINE_IMAGE_BYTES;
+    for (const auto& run : BASELINE_IMAGE_RUNS) {
+        static_vector<std::uint8_t> data(buffer.data() + run.offset, run.length, run.length);
+        auto write_res = disk.write(run.address, data);
+        if (!write_res.has_value()) {
+            return std::unexpected(write_res.error());
+        }
+    }
+    return {};
+}
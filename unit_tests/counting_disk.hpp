@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ppfs/disk/idisk.hpp"
+
+/**
+ * Disk wrapper that counts operations passed to the underlying disk.
+ */
+struct CountingDisk : public IDisk {
+    IDisk& disk;
+    size_t reads = 0;
+    size_t writes = 0;
+
+    explicit CountingDisk(IDisk& disk)
+        : disk(disk)
+    {
+    }
+
+    [[nodiscard]] std::expected<void, FsError> read(
+        size_t address, size_t size, static_vector<uint8_t>& data) override
+    {
+        reads++;
+        return disk.read(address, size, data);
+    }
+
+    [[nodiscard]] std::expected<size_t, FsError> write(
+        size_t address, const static_vector<uint8_t>& data) override
+    {
+        writes++;
+        return disk.write(address, data);
+    }
+
+    size_t size() override { return disk.size(); }
+};
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <array>
 #include <gtest/gtest.h>
+#include <random>
 
 TEST(Bitmap, Compiles)
 {
@@ -257,3 +258,186 @@ TEST(Bitmap, Count_setBitChangesCount)
     ASSERT_TRUE(count3.has_value());
     EXPECT_EQ(count3.value(), 0);
 }
+
+TEST(Bitmap, MirrorMatchesDiskBitmap)
+{
+    StackDisk<16> mirrored_disk;
+    StackDisk<16> plain_disk;
+    RawBlockDevice mirrored_device(128, mirrored_disk);
+    RawBlockDevice plain_device(128, plain_disk);
+    constexpr size_t BITS = 3000; // Not a multiple of word or block
+    std::array<std::uint64_t, Bitmap::mirrorWords(BITS)> mirror;
+    Bitmap mirrored(mirrored_device, 2, BITS, { mirror.data(), mirror.size() });
+    Bitmap plain(plain_device, 2, BITS);
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<unsigned int> index(0, BITS - 1);
+    ASSERT_TRUE(mirrored.setAll(true).has_value());
+    ASSERT_TRUE(plain.setAll(true).has_value());
+    for (int i = 0; i < 4000; i++) {
+        auto bit = index(rng);
+        bool value = (rng() % 4) == 0;
+        ASSERT_TRUE(mirrored.setBit(bit, value).has_value());
+        ASSERT_TRUE(plain.setBit(bit, value).has_value());
+        if (i % 100 == 0) {
+            EXPECT_EQ(mirrored.getFirstEq(false), plain.getFirstEq(false));
+            EXPECT_EQ(mirrored.getFirstEq(true), plain.getFirstEq(true));
+            EXPECT_EQ(mirrored.count(true).value(), plain.count(true).value());
+        }
+    }
+
+    // Bytes on disk are the same, so a fresh bitmap loads the same mirror
+    std::array<std::uint64_t, Bitmap::mirrorWords(BITS)> reloaded_mirror;
+    Bitmap reloaded(mirrored_device, 2, BITS, { reloaded_mirror.data(), reloaded_mirror.size() });
+    for (unsigned int bit = 0; bit < BITS; bit++) {
+        ASSERT_EQ(reloaded.getBit(bit).value(), plain.getBit(bit).value()) << "Index: " << bit;
+    }
+    EXPECT_EQ(reloaded.count(false).value(), plain.count(false).value());
+}
+
+TEST(Bitmap, MirrorFindsBitsPastFirstSummaryWord)
+{
+    StackDisk disk;
+    RawBlockDevice device(1024, disk);
+    constexpr size_t BITS = 64 * 64 * 3 + 10;
+    std::array<std::uint64_t, Bitmap::mirrorWords(BITS)> mirror;
+    Bitmap bm(device, 0, BITS, { mirror.data(), mirror.size() });
+
+    ASSERT_TRUE(bm.setAll(true).has_value());
+    EXPECT_EQ(bm.getFirstEq(false).error(), FsError::Bitmap_NotFound);
+    ASSERT_TRUE(bm.setBit(BITS - 1, false).has_value());
+    EXPECT_EQ(bm.getFirstEq(false).value(), BITS - 1);
+    ASSERT_TRUE(bm.setBit(64 * 64 + 5, false).has_value());
+    EXPECT_EQ(bm.getFirstEq(false).value(), 64 * 64 + 5);
+    EXPECT_EQ(bm.count(false).value(), 2);
+}
+
+TEST(Bitmap, FindsFromStartAndMeasuresRuns)
+{
+    StackDisk disk;
+    RawBlockDevice device(1024, disk);
+    std::array<std::uint64_t, Bitmap::mirrorWords(300)> mirror;
+    for (bool use_mirror : { false, true }) {
+        Bitmap bm(device, 0, 300,
+            use_mirror ? static_vector<std::uint64_t>(mirror.data(), mirror.size())
+                       : static_vector<std::uint64_t> {});
+        ASSERT_TRUE(bm.setAll(true).has_value());
+        for (unsigned int bit = 70; bit < 200; bit++) {
+            ASSERT_TRUE(bm.setBit(bit, false).has_value());
+        }
+
+        EXPECT_EQ(bm.getFirstEq(false, 0).value(), 70);
+        EXPECT_EQ(bm.getFirstEq(false, 150).value(), 150);
+        EXPECT_EQ(bm.getFirstEq(false, 200).error(), FsError::Bitmap_NotFound);
+        EXPECT_EQ(bm.getFirstEq(true, 70).value(), 200);
+
+        EXPECT_EQ(bm.runLength(false, 70, 1000).value(), 130);
+        EXPECT_EQ(bm.runLength(false, 100, 16).value(), 16);
+        EXPECT_EQ(bm.runLength(false, 10, 16).value(), 0);
+        EXPECT_EQ(bm.runLength(true, 200, 1000).value(), 100);
+    }
+}
+
+struct WriteCountingDevice : public RawBlockDevice {
+    using RawBlockDevice::RawBlockDevice;
+    int writes = 0;
+
+    std::expected<size_t, FsError> writeBlock(
+        const static_vector<uint8_t>& data, DataLocation data_location) override
+    {
+        writes++;
+        return RawBlockDevice::writeBlock(data, data_location);
+    }
+};
+
+TEST(Bitmap, SetBitsMatchesSetBit)
+{
+    StackDisk<16> batched_disk;
+    StackDisk<16> single_disk;
+    RawBlockDevice batched_device(64, batched_disk);
+    RawBlockDevice single_device(64, single_disk);
+    constexpr size_t BITS = 64 * 8 * 5 + 3;
+
+    std::array<std::uint64_t, Bitmap::mirrorWords(BITS)> batched_mirror;
+    std::array<std::uint64_t, Bitmap::mirrorWords(BITS)> single_mirror;
+    std::array<std::uint64_t, Bitmap::mirrorWords(BITS)> reloaded_mirror;
+    auto mirror = [](auto& buffer, bool use_mirror) {
+        return use_mirror ? static_vector<std::uint64_t>(buffer.data(), buffer.size())
+                          : static_vector<std::uint64_t> {};
+    };
+
+    for (bool use_mirror : { false, true }) {
+        Bitmap batched(batched_device, 0, BITS, mirror(batched_mirror, use_mirror));
+        Bitmap single(single_device, 0, BITS, mirror(single_mirror, use_mirror));
+        ASSERT_TRUE(batched.setAll(false).has_value());
+        ASSERT_TRUE(single.setAll(false).has_value());
+
+        std::mt19937 rng(11);
+        std::array<std::uint32_t, 100> bits_buffer;
+        for (int round = 0; round < 20; round++) {
+            bool value = round % 3 != 2;
+            static_vector<std::uint32_t> bits(bits_buffer.data(), bits_buffer.size(), 40);
+            for (auto& bit : bits) {
+                bit = rng() % BITS;
+                ASSERT_TRUE(single.setBit(bit, value).has_value());
+            }
+            ASSERT_TRUE(batched.setBits(bits, value).has_value());
+            EXPECT_TRUE(std::is_sorted(bits.begin(), bits.end()));
+            EXPECT_EQ(batched.count(true).value(), single.count(true).value());
+        }
+
+        Bitmap reloaded(batched_device, 0, BITS, mirror(reloaded_mirror, use_mirror));
+        for (unsigned int bit = 0; bit < BITS; bit++) {
+            ASSERT_EQ(reloaded.getBit(bit).value(), single.getBit(bit).value()) << "Index: " << bit;
+        }
+    }
+}
+
+TEST(Bitmap, SetBitsWritesEachBlockOnce)
+{
+    StackDisk<16> disk;
+    WriteCountingDevice device(64, disk);
+    std::array<std::uint64_t, Bitmap::mirrorWords(64 * 8 * 4)> mirror;
+    Bitmap bm(device, 0, 64 * 8 * 4, { mirror.data(), mirror.size() });
+    ASSERT_TRUE(bm.setAll(false).has_value());
+
+    std::array<std::uint32_t, 6> bits_buffer { 1000, 3, 700, 5, 1001, 4 };
+    static_vector<std::uint32_t> bits(bits_buffer.data(), bits_buffer.size(), bits_buffer.size());
+    device.writes = 0;
+    ASSERT_TRUE(bm.setBits(bits, true, true).has_value());
+    EXPECT_EQ(device.writes, 2);
+    EXPECT_EQ(bm.count(true).value(), 6);
+}
+
+TEST(Bitmap, SetBitsFlipOnlyChangesNothingOnConflict)
+{
+    StackDisk<16> disk;
+    WriteCountingDevice device(64, disk);
+    std::array<std::uint64_t, Bitmap::mirrorWords(64 * 8 * 4)> mirror;
+    for (bool use_mirror : { false, true }) {
+        Bitmap bm(device, 0, 64 * 8 * 4,
+            use_mirror ? static_vector<std::uint64_t>(mirror.data(), mirror.size())
+                       : static_vector<std::uint64_t> {});
+        ASSERT_TRUE(bm.setAll(false).has_value());
+        ASSERT_TRUE(bm.setBit(900, true).has_value());
+
+        std::array<std::uint32_t, 3> bits_buffer { 10, 600, 900 };
+        static_vector<std::uint32_t> bits(bits_buffer.data(), 3, 3);
+        device.writes = 0;
+        EXPECT_EQ(bm.setBits(bits, true, true).error(), FsError::Bitmap_AlreadySet);
+        EXPECT_EQ(device.writes, 0);
+        EXPECT_FALSE(bm.getBit(10).value());
+        EXPECT_EQ(bm.count(true).value(), 1);
+
+        // Repeated bit can't be flipped twice
+        std::array<std::uint32_t, 2> twice_buffer { 20, 20 };
+        static_vector<std::uint32_t> twice(twice_buffer.data(), 2, 2);
+        EXPECT_EQ(bm.setBits(twice, true, true).error(), FsError::Bitmap_AlreadySet);
+        EXPECT_TRUE(bm.setBits(twice, true).has_value());
+        EXPECT_EQ(bm.count(true).value(), 2);
+
+        std::array<std::uint32_t, 1> outside_buffer { 64 * 8 * 4 };
+        static_vector<std::uint32_t> outside(outside_buffer.data(), 1, 1);
+        EXPECT_EQ(bm.setBits(outside, true).error(), FsError::Bitmap_IndexOutOfRange);
+    }
+}
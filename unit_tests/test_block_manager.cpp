@@ -5,6 +5,11 @@
 #include "ppfs/disk/stack_disk.hpp"
 #include <array>
 #include <gtest/gtest.h>
+#include <latch>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
 
 TEST(BlockManager, Compiles)
 {
@@ -155,3 +160,211 @@ TEST(BlockManager, Counts)
     ASSERT_TRUE(free_ret.has_value());
     EXPECT_EQ(free_ret.value(), 6);
 }
+
+TEST(BlockManager, ReservesRunAtGoal)
+{
+    StackDisk disk;
+    RawBlockDevice device(512, disk);
+    SuperBlock super_block {
+        .block_bitmap_address = 1, .first_data_blocks_address = 2, .last_data_block_address = 65
+    };
+    BlockManager block_manager(super_block, device);
+    ASSERT_TRUE(block_manager.format().has_value());
+
+    auto run_ret = block_manager.reserveRun(10, 8);
+    ASSERT_TRUE(run_ret.has_value());
+    EXPECT_EQ(run_ret->start, 10);
+    EXPECT_EQ(run_ret->count, 8);
+    for (block_index_t block = 10; block < 18; block++) {
+        EXPECT_EQ(block_manager.reserve(block).error(), FsError::BlockManager_AlreadyTaken);
+    }
+    EXPECT_EQ(block_manager.numFree().value(), 56);
+
+    // Goal outside of the data blocks falls back to the first one
+    run_ret = block_manager.reserveRun(0, 2);
+    ASSERT_TRUE(run_ret.has_value());
+    EXPECT_EQ(run_ret->start, 2);
+    EXPECT_EQ(run_ret->count, 2);
+}
+
+TEST(BlockManager, ReserveRunWithoutDataBlocksFails)
+{
+    StackDisk disk;
+    RawBlockDevice device(512, disk);
+    SuperBlock super_block {
+        .block_bitmap_address = 1, .first_data_blocks_address = 2, .last_data_block_address = 1
+    };
+    BlockManager block_manager(super_block, device);
+
+    EXPECT_EQ(block_manager.reserveRun(0, 4).error(), FsError::BlockManager_NoMoreFreeBlocks);
+}
+
+TEST(BlockManager, ReservesRunSkippingFragments)
+{
+    StackDisk disk;
+    RawBlockDevice device(512, disk);
+    SuperBlock super_block {
+        .block_bitmap_address = 1, .first_data_blocks_address = 2, .last_data_block_address = 65
+    };
+    BlockManager block_manager(super_block, device);
+    ASSERT_TRUE(block_manager.format().has_value());
+    ASSERT_TRUE(block_manager.reserve(12).has_value());
+    ASSERT_TRUE(block_manager.reserve(15).has_value());
+
+    // Gaps 10-11 and 13-14 are too small, so the run starts after block 15
+    auto run_ret = block_manager.reserveRun(10, 4);
+    ASSERT_TRUE(run_ret.has_value());
+    EXPECT_EQ(run_ret->start, 16);
+    EXPECT_EQ(run_ret->count, 4);
+}
+
+TEST(BlockManager, ReservesRunWrapsAround)
+{
+    StackDisk disk;
+    RawBlockDevice device(512, disk);
+    SuperBlock super_block {
+        .block_bitmap_address = 1, .first_data_blocks_address = 2, .last_data_block_address = 17
+    };
+    BlockManager block_manager(super_block, device);
+    ASSERT_TRUE(block_manager.format().has_value());
+    for (block_index_t block = 12; block <= 17; block++) {
+        ASSERT_TRUE(block_manager.reserve(block).has_value());
+    }
+
+    auto run_ret = block_manager.reserveRun(14, 3);
+    ASSERT_TRUE(run_ret.has_value());
+    EXPECT_EQ(run_ret->start, 2);
+    EXPECT_EQ(run_ret->count, 3);
+}
+
+TEST(BlockManager, ReservesShorterRunWhenFragmented)
+{
+    StackDisk disk;
+    RawBlockDevice device(512, disk);
+    SuperBlock super_block {
+        .block_bitmap_address = 1, .first_data_blocks_address = 2, .last_data_block_address = 17
+    };
+    BlockManager block_manager(super_block, device);
+    ASSERT_TRUE(block_manager.format().has_value());
+    for (block_index_t block = 2; block <= 17; block += 3) {
+        ASSERT_TRUE(block_manager.reserve(block).has_value());
+    }
+
+    auto run_ret = block_manager.reserveRun(6, 5);
+    ASSERT_TRUE(run_ret.has_value());
+    EXPECT_EQ(run_ret->start, 6);
+    EXPECT_EQ(run_ret->count, 2);
+
+    // Nothing is left after taking every free block
+    while (block_manager.numFree().value() > 0) {
+        ASSERT_TRUE(block_manager.reserveRun(2, 16).has_value());
+    }
+    EXPECT_EQ(block_manager.reserveRun(2, 1).error(), FsError::BlockManager_NoMoreFreeBlocks);
+}
+
+TEST(BlockManager, FreesAndReservesManyBlocks)
+{
+    StackDisk disk;
+    RawBlockDevice device(512, disk);
+    SuperBlock super_block {
+        .block_bitmap_address = 1, .first_data_blocks_address = 2, .last_data_block_address = 65
+    };
+    BlockManager block_manager(super_block, device);
+    ASSERT_TRUE(block_manager.format().has_value());
+
+    std::array<block_index_t, 4> blocks_buffer { 40, 2, 65, 10 };
+    static_vector<block_index_t> blocks(blocks_buffer.data(), 4, 4);
+    ASSERT_TRUE(block_manager.reserveBlocks(blocks).has_value());
+    EXPECT_EQ(block_manager.numFree().value(), 60);
+    EXPECT_EQ(block_manager.reserve(65).error(), FsError::BlockManager_AlreadyTaken);
+    // Caller's indices stay absolute
+    EXPECT_EQ(blocks[0], 2);
+    EXPECT_EQ(blocks[3], 65);
+
+    EXPECT_EQ(block_manager.reserveBlocks(blocks).error(), FsError::BlockManager_AlreadyTaken);
+    ASSERT_TRUE(block_manager.freeBlocks(blocks).has_value());
+    EXPECT_EQ(block_manager.numFree().value(), 64);
+    EXPECT_EQ(block_manager.freeBlocks(blocks).error(), FsError::BlockManager_AlreadyFree);
+}
+
+TEST(BlockManager, FirstFitReusesLowBlocks)
+{
+    StackDisk disk;
+    RawBlockDevice device(512, disk);
+    SuperBlock super_block {
+        .block_bitmap_address = 1, .first_data_blocks_address = 2, .last_data_block_address = 9
+    };
+    BlockManager block_manager(super_block, device);
+    ASSERT_TRUE(block_manager.format().has_value());
+
+    ASSERT_TRUE(block_manager.reserve(block_manager.getFree().value()).has_value());
+    ASSERT_TRUE(block_manager.reserve(block_manager.getFree().value()).has_value());
+    ASSERT_TRUE(block_manager.free(2).has_value());
+    EXPECT_EQ(block_manager.getFree().value(), 2);
+}
+
+TEST(BlockManager, NextFitContinuesAfterLastAllocation)
+{
+    StackDisk disk;
+    RawBlockDevice device(512, disk);
+    SuperBlock super_block { .block_bitmap_address = 1,
+        .first_data_blocks_address = 2,
+        .last_data_block_address = 9,
+        .allocation_policy = AllocationPolicy::NextFit };
+    BlockManager block_manager(super_block, device);
+    ASSERT_TRUE(block_manager.format().has_value());
+
+    ASSERT_TRUE(block_manager.reserve(block_manager.getFree().value()).has_value());
+    ASSERT_TRUE(block_manager.reserve(block_manager.getFree().value()).has_value());
+    ASSERT_TRUE(block_manager.free(2).has_value());
+    EXPECT_EQ(block_manager.getFree().value(), 4);
+
+    // Runs without a goal start at the cursor too
+    auto run_ret = block_manager.reserveRun(0, 3);
+    ASSERT_TRUE(run_ret.has_value());
+    EXPECT_EQ(run_ret->start, 4);
+    EXPECT_EQ(block_manager.getFree().value(), 7);
+
+    // Past the last block the search wraps around
+    ASSERT_TRUE(block_manager.reserveRun(0, 3).has_value());
+    EXPECT_EQ(block_manager.getFree().value(), 2);
+}
+
+TEST(BlockManager, ThreadGroupsSpreadThreads)
+{
+    StackDisk disk;
+    RawBlockDevice device(512, disk);
+    SuperBlock super_block { .block_bitmap_address = 1,
+        .first_data_blocks_address = 2,
+        .last_data_block_address = 1025,
+        .allocation_policy = AllocationPolicy::ThreadGroups };
+    BlockManager block_manager(super_block, device);
+    ASSERT_TRUE(block_manager.format().has_value());
+
+    // Each thread allocates from its own group, the main thread's group is taken first
+    auto first = block_manager.reserveRun(0, 4);
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ((first->start - 2) % (1024 / AllocationCursor::ALLOCATION_GROUPS), 0);
+    auto next = block_manager.reserveRun(0, 4);
+    ASSERT_TRUE(next.has_value());
+    EXPECT_EQ(next->start, first->start + 4);
+
+    // Threads live at the same time, so their handles differ
+    std::set<block_index_t> groups;
+    std::mutex mutex;
+    std::latch started(16);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 16; i++) {
+        threads.emplace_back([&] {
+            started.arrive_and_wait();
+            std::lock_guard lock(mutex);
+            auto run = block_manager.reserveRun(0, 1);
+            ASSERT_TRUE(run.has_value());
+            groups.insert((run->start - 2) / (1024 / AllocationCursor::ALLOCATION_GROUPS));
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_GT(groups.size(), 1);
+}
@@ -0,0 +1,258 @@
+#include "counting_disk.hpp"
+#include "ppfs/blockdevice/caching_block_device.hpp"
+#include "ppfs/blockdevice/hamming_block_device.hpp"
+#include "ppfs/blockdevice/raw_block_device.hpp"
+#include "ppfs/common/static_vector.hpp"
+#include "ppfs/disk/stack_disk.hpp"
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <gtest/gtest.h>
+
+namespace {
+
+void fill(std::array<uint8_t, 1024>& buffer, uint8_t seed)
+{
+    for (size_t i = 0; i < buffer.size(); i++)
+        buffer[i] = static_cast<uint8_t>(i * 31 + seed);
+}
+
+/** Storage of the cache under test, the cache drops what a previous test left in it */
+static_vector<CachingBlockDevice::Entry> cacheEntries()
+{
+    static std::array<CachingBlockDevice::Entry, CachingBlockDevice::DEFAULT_CAPACITY> entries;
+    return { entries.data(), entries.size() };
+}
+
+/** Runs a callback after vectored reads, while the cache doesn't hold its lock */
+struct HookedBlockDevice : public RawBlockDevice {
+    using RawBlockDevice::RawBlockDevice;
+    std::function<void()> after_read;
+
+    std::expected<void, FsError> readBlocks(
+        const static_vector<BlockExtent>& extents, static_vector<uint8_t>& data) override
+    {
+        auto read_res = RawBlockDevice::readBlocks(extents, data);
+        if (after_read) {
+            auto hook = std::move(after_read);
+            after_read = nullptr;
+            hook();
+        }
+        return read_res;
+    }
+};
+
+}
+
+TEST(CachingBlockDevice, RepeatedReadsHitCache)
+{
+    StackDisk stack_disk;
+    CountingDisk disk(stack_disk);
+    HammingBlockDevice hamming(8, disk);
+    CachingBlockDevice cache(hamming, CachePolicy::WriteThrough, cacheEntries());
+    EXPECT_EQ(cache.dataSize(), hamming.dataSize());
+    EXPECT_EQ(cache.numOfBlocks(), hamming.numOfBlocks());
+
+    std::array<uint8_t, 1024> buffer;
+    static_vector<uint8_t> data(buffer.data(), buffer.size());
+    ASSERT_TRUE(cache.readBlock(DataLocation(3, 0), 10, data).has_value());
+    size_t reads = disk.reads;
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(cache.readBlock(DataLocation(3, i), 10, data).has_value());
+        EXPECT_EQ(data.size(), 10);
+    }
+    EXPECT_EQ(disk.reads, reads);
+    EXPECT_EQ(cache.misses(), 1);
+    EXPECT_EQ(cache.hits(), 5);
+}
+
+TEST(CachingBlockDevice, WriteThroughKeepsDeviceAndCacheCoherent)
+{
+    StackDisk stack_disk;
+    CountingDisk disk(stack_disk);
+    HammingBlockDevice hamming(8, disk);
+    CachingBlockDevice cache(hamming, CachePolicy::WriteThrough, cacheEntries());
+
+    std::array<uint8_t, 1024> write_buffer;
+    fill(write_buffer, 1);
+    static_vector<uint8_t> write_data(write_buffer.data(), write_buffer.size(), 20);
+    std::array<uint8_t, 1024> read_buffer;
+    static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+
+    ASSERT_TRUE(cache.readBlock(DataLocation(2, 0), cache.dataSize(), read_data).has_value());
+    size_t writes = disk.writes;
+    ASSERT_TRUE(cache.writeBlock(write_data, DataLocation(2, 7)).has_value());
+    EXPECT_EQ(disk.writes, writes + 1);
+
+    ASSERT_TRUE(cache.readBlock(DataLocation(2, 7), 20, read_data).has_value());
+    EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), write_buffer.begin()));
+    ASSERT_TRUE(hamming.readBlock(DataLocation(2, 7), 20, read_data).has_value());
+    EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), write_buffer.begin()));
+}
+
+TEST(CachingBlockDevice, WriteBackDefersWritesUntilFlush)
+{
+    StackDisk stack_disk;
+    CountingDisk disk(stack_disk);
+    HammingBlockDevice hamming(8, disk);
+    CachingBlockDevice cache(hamming, CachePolicy::WriteBack, cacheEntries());
+
+    std::array<uint8_t, 1024> write_buffer;
+    fill(write_buffer, 2);
+    static_vector<uint8_t> write_data(write_buffer.data(), write_buffer.size(), cache.dataSize());
+
+    // Whole block doesn't need the old content, partial writes modify the cached copy
+    ASSERT_TRUE(cache.writeBlock(write_data, DataLocation(4, 0)).has_value());
+    write_data.resize(5);
+    ASSERT_TRUE(cache.writeBlock(write_data, DataLocation(4, 100)).has_value());
+    EXPECT_EQ(disk.reads, 0);
+    EXPECT_EQ(disk.writes, 0);
+
+    ASSERT_TRUE(cache.flush().has_value());
+    EXPECT_EQ(disk.writes, 1);
+    ASSERT_TRUE(cache.flush().has_value());
+    EXPECT_EQ(disk.writes, 1);
+
+    std::array<uint8_t, 1024> read_buffer;
+    static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+    ASSERT_TRUE(hamming.readBlock(DataLocation(4, 100), 5, read_data).has_value());
+    EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), write_buffer.begin()));
+    ASSERT_TRUE(hamming.readBlock(DataLocation(4, 0), 100, read_data).has_value());
+    EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), write_buffer.begin()));
+}
+
+TEST(CachingBlockDevice, EvictionWritesBackDirtyBlocks)
+{
+    StackDisk disk;
+    RawBlockDevice raw(128, disk);
+    std::array<uint8_t, 1024> read_buffer;
+    static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+
+    {
+        CachingBlockDevice cache(raw, CachePolicy::WriteBack, cacheEntries());
+        std::array<uint8_t, 1024> write_buffer;
+        for (size_t block = 0; block < 2 * CachingBlockDevice::DEFAULT_CAPACITY; block++) {
+            fill(write_buffer, static_cast<uint8_t>(block));
+            static_vector<uint8_t> write_data(write_buffer.data(), write_buffer.size(), 128);
+            ASSERT_TRUE(cache.writeBlock(write_data, DataLocation(block, 0)).has_value());
+        }
+        // Half of the blocks no longer fit and were written to the device
+        size_t on_disk = 0;
+        for (size_t block = 0; block < 2 * CachingBlockDevice::DEFAULT_CAPACITY; block++) {
+            fill(write_buffer, static_cast<uint8_t>(block));
+            ASSERT_TRUE(raw.readBlock(DataLocation(block, 0), 128, read_data).has_value());
+            on_disk += std::equal(read_data.begin(), read_data.end(), write_buffer.begin());
+        }
+        EXPECT_EQ(on_disk, CachingBlockDevice::DEFAULT_CAPACITY);
+    }
+
+    // Destructor flushed the rest
+    std::array<uint8_t, 1024> expected;
+    for (size_t block = 0; block < 2 * CachingBlockDevice::DEFAULT_CAPACITY; block++) {
+        fill(expected, static_cast<uint8_t>(block));
+        ASSERT_TRUE(raw.readBlock(DataLocation(block, 0), 128, read_data).has_value());
+        EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), expected.begin()));
+    }
+}
+
+TEST(CachingBlockDevice, VectoredTransfersMixCachedAndUncachedBlocks)
+{
+    StackDisk stack_disk;
+    CountingDisk disk(stack_disk);
+    RawBlockDevice raw(128, disk);
+    CachingBlockDevice cache(raw, CachePolicy::WriteBack, cacheEntries());
+
+    std::array<uint8_t, 1024> write_buffer;
+    fill(write_buffer, 3);
+    static_vector<uint8_t> write_data(write_buffer.data(), write_buffer.size(), 128);
+    ASSERT_TRUE(cache.writeBlock(write_data, DataLocation(6, 0)).has_value());
+
+    std::array<BlockExtent, 3> extents_buffer { BlockExtent({ 5, 0 }, 128),
+        BlockExtent({ 6, 0 }, 128), BlockExtent({ 7, 0 }, 128) };
+    static_vector<BlockExtent> extents(extents_buffer.data(), 3, 3);
+    fill(write_buffer, 4);
+    write_data.resize(3 * 128);
+    auto written = cache.writeBlocks(extents, write_data);
+    ASSERT_TRUE(written.has_value());
+    EXPECT_EQ(written.value(), 3 * 128);
+    // Uncached blocks went straight to the device, cached one stays dirty
+    EXPECT_EQ(disk.writes, 2);
+    EXPECT_EQ(cache.hits(), 1);
+
+    std::array<uint8_t, 1024> read_buffer;
+    static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+    ASSERT_TRUE(cache.readBlocks(extents, read_data).has_value());
+    ASSERT_EQ(read_data.size(), 3 * 128);
+    EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), write_buffer.begin()));
+
+    ASSERT_TRUE(cache.flush().has_value());
+    ASSERT_TRUE(raw.readBlocks(extents, read_data).has_value());
+    EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), write_buffer.begin()));
+}
+
+TEST(CachingBlockDevice, InvalidateDropsStaleCopy)
+{
+    StackDisk disk;
+    RawBlockDevice raw(128, disk);
+    CachingBlockDevice cache(raw, CachePolicy::WriteThrough, cacheEntries());
+
+    std::array<uint8_t, 1024> read_buffer;
+    static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+    ASSERT_TRUE(cache.readBlock(DataLocation(1, 0), 128, read_data).has_value());
+
+    // Block changed behind the cache, e.g. by a scrubber
+    std::array<uint8_t, 1024> write_buffer;
+    fill(write_buffer, 5);
+    static_vector<uint8_t> write_data(write_buffer.data(), write_buffer.size(), 128);
+    ASSERT_TRUE(raw.writeBlock(write_data, DataLocation(1, 0)).has_value());
+
+    ASSERT_TRUE(cache.readBlock(DataLocation(1, 0), 128, read_data).has_value());
+    EXPECT_FALSE(std::equal(read_data.begin(), read_data.end(), write_buffer.begin()));
+
+    cache.invalidate(1);
+    ASSERT_TRUE(cache.readBlock(DataLocation(1, 0), 128, read_data).has_value());
+    EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), write_buffer.begin()));
+}
+
+TEST(CachingBlockDevice, VectoredReadSeesBlocksWrittenDuringDecode)
+{
+    StackDisk disk;
+    HookedBlockDevice raw(128, disk);
+    std::array<BlockExtent, 2> extents_buffer { BlockExtent({ 5, 0 }, 128),
+        BlockExtent({ 6, 0 }, 128) };
+    static_vector<BlockExtent> extents(extents_buffer.data(), 2, 2);
+    std::array<uint8_t, 1024> write_buffer;
+    fill(write_buffer, 9);
+    static_vector<uint8_t> write_data(write_buffer.data(), write_buffer.size(), 128);
+    std::array<uint8_t, 1024> read_buffer;
+    static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+
+    // Written block stays dirty in the cache
+    {
+        CachingBlockDevice cache(raw, CachePolicy::WriteBack, cacheEntries());
+        raw.after_read
+            = [&]() { ASSERT_TRUE(cache.writeBlock(write_data, { 6, 0 }).has_value()); };
+        ASSERT_TRUE(cache.readBlocks(extents, read_data).has_value());
+        ASSERT_EQ(read_data.size(), 2 * 128);
+        EXPECT_TRUE(std::equal(read_data.begin() + 128, read_data.end(), write_buffer.begin()));
+        cache.invalidateAll();
+    }
+
+    // Written block is evicted and written back before the read takes the lock again
+    {
+        fill(write_buffer, 10);
+        CachingBlockDevice cache(raw, CachePolicy::WriteBack, cacheEntries());
+        raw.after_read = [&]() {
+            ASSERT_TRUE(cache.writeBlock(write_data, { 5, 0 }).has_value());
+            std::array<uint8_t, 128> other_buffer;
+            static_vector<uint8_t> other(other_buffer.data(), other_buffer.size());
+            for (block_index_t block = 10; block < 10 + CachingBlockDevice::DEFAULT_CAPACITY;
+                block++) {
+                ASSERT_TRUE(cache.readBlock({ block, 0 }, 128, other).has_value());
+            }
+        };
+        ASSERT_TRUE(cache.readBlocks(extents, read_data).has_value());
+        ASSERT_EQ(read_data.size(), 2 * 128);
+        EXPECT_TRUE(std::equal(read_data.begin(), read_data.begin() + 128, write_buffer.begin()));
+    }
+}
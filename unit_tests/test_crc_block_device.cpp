@@ -2,9 +2,12 @@
 #include "ppfs/common/bit_helpers.hpp"
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/disk/stack_disk.hpp"
+#include "ppfs/ecc_helpers/crc_engine.hpp"
 
+#include <algorithm>
 #include <array>
 #include <gtest/gtest.h>
+#include <random>
 #include <vector>
 
 TEST(CrcPolynomial, ExplicitImplicitDifference)
@@ -70,6 +73,53 @@ TEST(CrcPolynomial, division2)
     EXPECT_FALSE(remainder[2]);
 }
 
+// Check bits the way bit-serial division calculates them: data followed by degree zero bits
+static std::uint64_t divisionCheckBits(CrcPolynomial& poly, const static_vector<uint8_t>& data)
+{
+    std::array<bool, MAX_BLOCK_SIZE * 8> bits_buffer;
+    static_vector<bool> bits(bits_buffer.data(), MAX_BLOCK_SIZE * 8);
+    BitHelpers::blockToBits(data, bits);
+    size_t original_size = bits.size();
+    bits.resize(original_size + poly.getDegree());
+    std::fill(bits.begin() + original_size, bits.end(), false);
+
+    std::array<bool, MAX_CRC_POLYNOMIAL_SIZE> remainder_buffer;
+    static_vector<bool> remainder(remainder_buffer.data(), MAX_CRC_POLYNOMIAL_SIZE);
+    poly.divide(bits, remainder);
+    std::uint64_t result = 0;
+    for (size_t i = 0; i < remainder.size(); i++) {
+        result = (result << 1) | remainder[i];
+    }
+    return result;
+}
+
+TEST(CrcEngine, MatchesDivision)
+{
+    std::array polys = { CrcPolynomial::MsgExplicit(0b1011), CrcPolynomial::MsgImplicit(0xea),
+        CrcPolynomial::MsgImplicit(0xc1acf), CrcPolynomial::MsgImplicit(0x9960034c),
+        CrcPolynomial::MsgExplicit(0x8000000000000053) };
+    std::array<size_t, 9> sizes = { 1, 2, 7, 8, 63, 64, 129, 255, MAX_BLOCK_SIZE - 8 };
+    std::mt19937 rng(42);
+
+    std::array<uint8_t, MAX_BLOCK_SIZE> data_buffer;
+    for (auto& poly : polys) {
+        CrcEngine table(poly, false);
+        CrcEngine fast(poly);
+        EXPECT_FALSE(table.usesClmul());
+        for (auto size : sizes) {
+            static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), size);
+            for (auto& byte : data) {
+                byte = static_cast<uint8_t>(rng());
+            }
+            auto expected = divisionCheckBits(poly, data);
+            EXPECT_EQ(table.checkBits(data), expected)
+                << "degree " << poly.getDegree() << ", size " << size;
+            EXPECT_EQ(fast.checkBits(data), expected)
+                << "degree " << poly.getDegree() << ", size " << size;
+        }
+    }
+}
+
 TEST(CrcBlockDevice, Compiles)
 {
     StackDisk disk;
@@ -87,7 +87,7 @@ TEST(DirectoryManager, RemoveFirstOfMultipleEntries)
     ASSERT_TRUE(dm.addEntry(dir, b).has_value());
     ASSERT_TRUE(dm.addEntry(dir, c).has_value());
 
-    auto rm_res = dm.removeEntry(dir, 1);
+    auto rm_res = dm.removeEntry(dir, "A");
     ASSERT_TRUE(rm_res.has_value()) << "Removing file failed: " << toString(rm_res.error());
 
     std::array<DirectoryEntry, 100> entries_buffer;
@@ -184,7 +184,7 @@ TEST(DirectoryManager, RemoveNonexistentEntryFails)
 
     ASSERT_TRUE(dm.addEntry(dir, e).has_value());
 
-    auto res = dm.removeEntry(dir, 999);
+    auto res = dm.removeEntry(dir, "missing");
     ASSERT_FALSE(res.has_value());
     ASSERT_EQ(res.error(), FsError::DirectoryManager_NotFound);
 }
@@ -365,7 +365,7 @@ TEST(DirectoryManager, GetInodeByNameAfterRemoval)
     EXPECT_EQ(res2.value(), 60);
 
     // Remove file1
-    ASSERT_TRUE(dm.removeEntry(dir, 50).has_value());
+    ASSERT_TRUE(dm.removeEntry(dir, "file1").has_value());
 
     // file1 should not be found
     auto res3 = dm.getInodeByName(dir, "file1");
@@ -377,3 +377,257 @@ TEST(DirectoryManager, GetInodeByNameAfterRemoval)
     ASSERT_TRUE(res4.has_value());
     EXPECT_EQ(res4.value(), 60);
 }
+
+TEST(DirectoryManager, IndexedDirectoryFindsEntries)
+{
+    StackDisk disk;
+    RawBlockDevice dev(1024, disk);
+    SuperBlock superblock {
+        .total_inodes = 4,
+        .block_bitmap_address = 2,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .first_data_blocks_address = 3,
+        .last_data_block_address = 1024,
+        .block_size = 1024,
+    };
+    InodeManager im(dev, superblock);
+    BlockManager bm(superblock, dev);
+    FileIO fio(dev, bm, im);
+    DirectoryManager dm(dev, im, fio, true);
+
+    ASSERT_TRUE(im.format());
+    inode_index_t dir = 0; // root directory inode
+
+    // Enough entries for the index to be created and grown once
+    constexpr size_t count = 2 * DirectoryManager::INDEX_MIN_ENTRIES + 50;
+    for (size_t i = 0; i < count; i++) {
+        DirectoryEntry entry { .inode = static_cast<inode_index_t>(100 + i) };
+        snprintf(entry.name.data(), entry.name.size(), "entry_%zu", i);
+        auto add_res = dm.addEntry(dir, entry);
+        ASSERT_TRUE(add_res.has_value()) << toString(add_res.error());
+    }
+    EXPECT_TRUE(im.get(dir).value().hashed_index);
+
+    for (size_t i = 0; i < count; i++) {
+        std::array<char, 32> name;
+        snprintf(name.data(), name.size(), "entry_%zu", i);
+        auto res = dm.getInodeByName(dir, name.data());
+        ASSERT_TRUE(res.has_value()) << name.data();
+        EXPECT_EQ(res.value(), 100 + i);
+    }
+    auto missing = dm.getInodeByName(dir, "entry_missing");
+    ASSERT_FALSE(missing.has_value());
+    EXPECT_EQ(missing.error(), FsError::PpFS_NotFound);
+
+    // The hidden reference to the index is not listed
+    std::array<DirectoryEntry, count> entries_buffer;
+    static_vector<DirectoryEntry> entries(entries_buffer.data(), entries_buffer.size());
+    ASSERT_TRUE(dm.getEntries(dir, 0, 0, entries).has_value());
+    ASSERT_EQ(entries.size(), count);
+    for (size_t i = 0; i < entries.size(); i++) {
+        EXPECT_NE(entries[i].name[0], '\0');
+    }
+}
+
+TEST(DirectoryManager, IndexedDirectoryFindsCollidingNames)
+{
+    StackDisk disk;
+    RawBlockDevice dev(1024, disk);
+    SuperBlock superblock {
+        .total_inodes = 4,
+        .block_bitmap_address = 2,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .first_data_blocks_address = 3,
+        .last_data_block_address = 1024,
+        .block_size = 1024,
+    };
+    InodeManager im(dev, superblock);
+    BlockManager bm(superblock, dev);
+    FileIO fio(dev, bm, im);
+    DirectoryManager dm(dev, im, fio, true);
+
+    ASSERT_TRUE(im.format());
+    inode_index_t dir = 0; // root directory inode
+
+    // Many names probe from the last slot of every table size and some from the last slot of
+    // its first half, so that probes run past the parts the table is built in
+    constexpr size_t count = 2 * DirectoryManager::INDEX_MIN_ENTRIES + 50;
+    constexpr size_t at_end = 100;
+    constexpr size_t at_half = 40;
+    std::array<std::array<char, 32>, count> names;
+    size_t num_end = 0, num_half = 0, num_other = 0;
+    for (size_t i = 0; num_end + num_half + num_other < count; i++) {
+        std::array<char, 32> name;
+        snprintf(name.data(), name.size(), "entry_%zu", i);
+        std::uint32_t home = hashEntryName(name.data()) & 4095;
+        if (home == 4095 && num_end < at_end) {
+            names[num_end++] = name;
+        } else if (home == 1023 && num_half < at_half) {
+            names[at_end + num_half++] = name;
+        } else if (home != 4095 && home != 1023 && num_other < count - at_end - at_half) {
+            names[at_end + at_half + num_other++] = name;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        DirectoryEntry entry { .inode = static_cast<inode_index_t>(100 + i) };
+        std::copy(names[i].begin(), names[i].end(), entry.name.begin());
+        auto add_res = dm.addEntry(dir, entry);
+        ASSERT_TRUE(add_res.has_value()) << toString(add_res.error());
+    }
+    EXPECT_TRUE(im.get(dir).value().hashed_index);
+
+    // Lookups through a new manager go to the index instead of the name cache
+    DirectoryManager fresh(dev, im, fio, true);
+    for (size_t i = 0; i < count; i++) {
+        auto res = fresh.getInodeByName(dir, names[i].data());
+        ASSERT_TRUE(res.has_value()) << names[i].data();
+        EXPECT_EQ(res.value(), 100 + i);
+    }
+}
+
+TEST(DirectoryManager, IndexedDirectoryHandlesRemovals)
+{
+    StackDisk disk;
+    RawBlockDevice dev(1024, disk);
+    SuperBlock superblock {
+        .total_inodes = 4,
+        .block_bitmap_address = 2,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .first_data_blocks_address = 3,
+        .last_data_block_address = 1024,
+        .block_size = 1024,
+    };
+    InodeManager im(dev, superblock);
+    BlockManager bm(superblock, dev);
+    FileIO fio(dev, bm, im);
+    DirectoryManager dm(dev, im, fio, true);
+
+    ASSERT_TRUE(im.format());
+    inode_index_t dir = 0; // root directory inode
+    auto free_inodes = im.numFree().value();
+
+    constexpr size_t count = DirectoryManager::INDEX_MIN_ENTRIES + 20;
+    for (size_t i = 0; i < count; i++) {
+        DirectoryEntry entry { .inode = static_cast<inode_index_t>(100 + i) };
+        snprintf(entry.name.data(), entry.name.size(), "entry_%zu", i);
+        ASSERT_TRUE(dm.addEntry(dir, entry).has_value());
+    }
+
+    // Every third entry goes away, moving last entries into the gaps
+    for (size_t i = 0; i < count; i += 3) {
+        std::array<char, 32> name;
+        snprintf(name.data(), name.size(), "entry_%zu", i);
+        ASSERT_TRUE(dm.removeEntry(dir, name.data()).has_value());
+    }
+    for (size_t i = 0; i < count; i++) {
+        std::array<char, 32> name;
+        snprintf(name.data(), name.size(), "entry_%zu", i);
+        auto res = dm.getInodeByName(dir, name.data());
+        if (i % 3 == 0) {
+            EXPECT_FALSE(res.has_value()) << name.data();
+        } else {
+            ASSERT_TRUE(res.has_value()) << name.data();
+            EXPECT_EQ(res.value(), 100 + i);
+        }
+    }
+
+    // Emptied directory drops its index
+    for (size_t i = 0; i < count; i++) {
+        if (i % 3 != 0) {
+            std::array<char, 32> name;
+            snprintf(name.data(), name.size(), "entry_%zu", i);
+            ASSERT_TRUE(dm.removeEntry(dir, name.data()).has_value());
+        }
+    }
+    auto dir_inode = im.get(dir).value();
+    EXPECT_FALSE(dir_inode.hashed_index);
+    EXPECT_EQ(dir_inode.file_size, 0);
+    EXPECT_EQ(im.numFree().value(), free_inodes);
+}
+
+TEST(DirectoryManager, DentryCacheAnswersRepeatedLookups)
+{
+    StackDisk disk;
+    RawBlockDevice dev(1024, disk);
+    SuperBlock superblock {
+        .total_inodes = 1,
+        .block_bitmap_address = 2,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .first_data_blocks_address = 3,
+        .last_data_block_address = 1024,
+        .block_size = 1024,
+    };
+    InodeManager im(dev, superblock);
+    BlockManager bm(superblock, dev);
+    FileIO fio(dev, bm, im);
+    DirectoryManager dm(dev, im, fio);
+
+    ASSERT_TRUE(im.format());
+    inode_index_t dir = 0;
+
+    // Negative entry has to be dropped once the name is added
+    auto missing = dm.getInodeByName(dir, "file");
+    ASSERT_FALSE(missing.has_value());
+    EXPECT_EQ(missing.error(), FsError::PpFS_NotFound);
+
+    DirectoryEntry entry;
+    entry.inode = 7;
+    strcpy(entry.name.data(), "file");
+    ASSERT_TRUE(dm.addEntry(dir, entry).has_value());
+
+    size_t misses = dm.dentryMisses();
+    for (int i = 0; i < 3; i++) {
+        auto res = dm.getInodeByName(dir, "file");
+        ASSERT_TRUE(res.has_value());
+        EXPECT_EQ(res.value(), 7);
+    }
+    EXPECT_EQ(dm.dentryMisses(), misses);
+    EXPECT_GE(dm.dentryHits(), 3);
+
+    ASSERT_TRUE(dm.removeEntry(dir, "file").has_value());
+    auto removed = dm.getInodeByName(dir, "file");
+    ASSERT_FALSE(removed.has_value());
+    EXPECT_EQ(removed.error(), FsError::PpFS_NotFound);
+}
+
+TEST(DirectoryManager, DentryCacheEvictsWhenFull)
+{
+    StackDisk disk;
+    RawBlockDevice dev(1024, disk);
+    SuperBlock superblock {
+        .total_inodes = 1,
+        .block_bitmap_address = 2,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .first_data_blocks_address = 3,
+        .last_data_block_address = 1024,
+        .block_size = 1024,
+    };
+    InodeManager im(dev, superblock);
+    BlockManager bm(superblock, dev);
+    FileIO fio(dev, bm, im);
+    DirectoryManager dm(dev, im, fio);
+
+    ASSERT_TRUE(im.format());
+    inode_index_t dir = 0;
+
+    size_t count = DentryCache::ENTRIES * 2;
+    for (size_t i = 0; i < count; i++) {
+        DirectoryEntry entry;
+        entry.inode = static_cast<inode_index_t>(i + 1);
+        snprintf(entry.name.data(), entry.name.size(), "file%zu", i);
+        ASSERT_TRUE(dm.addEntry(dir, entry).has_value());
+    }
+    for (size_t i = 0; i < count; i++) {
+        std::array<char, 32> name;
+        snprintf(name.data(), name.size(), "file%zu", i);
+        auto res = dm.getInodeByName(dir, name.data());
+        ASSERT_TRUE(res.has_value()) << name.data();
+        EXPECT_EQ(res.value(), i + 1);
+    }
+}
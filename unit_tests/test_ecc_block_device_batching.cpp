@@ -0,0 +1,137 @@
+#include "counting_disk.hpp"
+#include "ppfs/blockdevice/crc_block_device.hpp"
+#include "ppfs/blockdevice/hamming_block_device.hpp"
+#include "ppfs/blockdevice/parity_block_device.hpp"
+#include "ppfs/blockdevice/rs_block_device.hpp"
+#include "ppfs/common/static_vector.hpp"
+#include "ppfs/disk/stack_disk.hpp"
+
+#include <algorithm>
+#include <array>
+#include <gtest/gtest.h>
+
+// Helper: xor a byte on the disk with mask
+static void corruptByte(IDisk& disk, size_t address, uint8_t mask)
+{
+    std::array<uint8_t, 1> buffer;
+    static_vector<uint8_t> bytes(buffer.data(), 1);
+    ASSERT_TRUE(disk.read(address, 1, bytes).has_value());
+    bytes[0] ^= mask;
+    ASSERT_TRUE(disk.write(address, bytes).has_value());
+}
+
+/**
+ * Builds a device under test and damages a written block in a way the device can correct.
+ */
+template <typename Device> struct EccDeviceFactory;
+
+template <> struct EccDeviceFactory<CrcBlockDevice> {
+    static CrcBlockDevice make(IDisk& disk)
+    {
+        return CrcBlockDevice(CrcPolynomial::MsgImplicit(0xea), disk, 256);
+    }
+    // CRC only detects errors
+    static void damage(IDisk&, size_t) { }
+};
+
+template <> struct EccDeviceFactory<ParityBlockDevice> {
+    static ParityBlockDevice make(IDisk& disk) { return ParityBlockDevice(256, disk); }
+    // Parity only detects errors
+    static void damage(IDisk&, size_t) { }
+};
+
+template <> struct EccDeviceFactory<HammingBlockDevice> {
+    static HammingBlockDevice make(IDisk& disk) { return HammingBlockDevice(8, disk); }
+    static void damage(IDisk& disk, size_t address) { corruptByte(disk, address, 0x10); }
+};
+
+template <> struct EccDeviceFactory<ReedSolomonBlockDevice> {
+    static ReedSolomonBlockDevice make(IDisk& disk) { return ReedSolomonBlockDevice(disk, 255, 4); }
+    static void damage(IDisk& disk, size_t address) { corruptByte(disk, address, 0x5a); }
+};
+
+template <typename Device> class EccBlockDeviceBatching : public ::testing::Test { };
+
+using EccBlockDevices = ::testing::Types<CrcBlockDevice, ParityBlockDevice, HammingBlockDevice,
+    ReedSolomonBlockDevice>;
+TYPED_TEST_SUITE(EccBlockDeviceBatching, EccBlockDevices);
+
+TYPED_TEST(EccBlockDeviceBatching, VectoredWriteAndRead)
+{
+    StackDisk disk;
+    auto device = EccDeviceFactory<TypeParam>::make(disk);
+
+    size_t data_size = device.dataSize();
+    for (unsigned int i = 0; i < 6; i++)
+        ASSERT_TRUE(device.formatBlock(i).has_value());
+
+    // Blocks 0-2 are consecutive and go to disk together, block 5 is separate
+    std::array<BlockExtent, 4> extents_buffer { BlockExtent({ 0, 3 }, 50),
+        BlockExtent({ 1, 0 }, data_size), BlockExtent({ 2, 0 }, data_size),
+        BlockExtent({ 5, 10 }, 20) };
+    static_vector<BlockExtent> extents(extents_buffer.data(), 4, 4);
+    size_t total = 50 + 2 * data_size + 20;
+
+    std::array<uint8_t, 1024> data_buffer;
+    for (size_t i = 0; i < total; i++)
+        data_buffer[i] = static_cast<uint8_t>(i * 7 + 1);
+    static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), total);
+    auto written = device.writeBlocks(extents, data);
+    ASSERT_TRUE(written.has_value());
+    EXPECT_EQ(written.value(), total);
+
+    // Error inside of a batch is corrected as well
+    EccDeviceFactory<TypeParam>::damage(disk, device.rawBlockSize() + 100);
+
+    std::array<uint8_t, 1024> read_buffer;
+    static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+    ASSERT_TRUE(device.readBlocks(extents, read_data).has_value());
+    ASSERT_EQ(read_data.size(), total);
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), read_data.begin()));
+
+    // Single block reads see the same bytes
+    ASSERT_TRUE(device.readBlock({ 5, 10 }, 20, read_data).has_value());
+    EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), data.end() - 20));
+}
+
+TYPED_TEST(EccBlockDeviceBatching, WholeBlockWriteSkipsRead)
+{
+    StackDisk stack_disk;
+    CountingDisk disk(stack_disk);
+    auto device = EccDeviceFactory<TypeParam>::make(disk);
+    size_t data_size = device.dataSize();
+
+    std::array<uint8_t, 1024> data_buffer;
+    for (size_t i = 0; i < data_buffer.size(); i++)
+        data_buffer[i] = static_cast<uint8_t>(i * 13 + 5);
+    static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), data_size);
+
+    auto written = device.writeBlock(data, DataLocation(1, 0));
+    ASSERT_TRUE(written.has_value());
+    EXPECT_EQ(written.value(), data_size);
+    EXPECT_EQ(disk.reads, 0);
+    EXPECT_EQ(disk.writes, 1);
+
+    // Three whole consecutive blocks go to disk with a single write
+    std::array<BlockExtent, 3> extents_buffer { BlockExtent({ 2, 0 }, data_size),
+        BlockExtent({ 3, 0 }, data_size), BlockExtent({ 4, 0 }, data_size) };
+    static_vector<BlockExtent> extents(extents_buffer.data(), 3, 3);
+    data.resize(3 * data_size);
+    ASSERT_TRUE(device.writeBlocks(extents, data).has_value());
+    EXPECT_EQ(disk.reads, 0);
+    EXPECT_EQ(disk.writes, 2);
+
+    // Partial write still has to read the block
+    static_vector<uint8_t> part(data_buffer.data(), 10, 10);
+    ASSERT_TRUE(device.writeBlock(part, DataLocation(1, 5)).has_value());
+    EXPECT_EQ(disk.reads, 1);
+
+    std::array<uint8_t, 1024> read_buffer;
+    static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+    ASSERT_TRUE(device.readBlock({ 1, 0 }, data_size, read_data).has_value());
+    EXPECT_TRUE(std::equal(read_data.begin(), read_data.begin() + 5, data.begin()));
+    EXPECT_TRUE(std::equal(read_data.begin() + 5, read_data.begin() + 15, part.begin()));
+    EXPECT_TRUE(std::equal(read_data.begin() + 15, read_data.end(), data.begin() + 15));
+    ASSERT_TRUE(device.readBlock({ 4, 0 }, data_size, read_data).has_value());
+    EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), data.begin() + 2 * data_size));
+}
@@ -1,4 +1,5 @@
 #include "array"
+#include <algorithm>
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/disk/file_disk.hpp"
 
@@ -117,3 +118,70 @@ TEST(FileDisk, DataPersistsAfterReopen)
 
     unlink(path.c_str());
 }
+
+TEST(FileDisk, FlushSucceedsWhenOpen)
+{
+    FileDisk closed;
+    EXPECT_FALSE(closed.flush().has_value());
+
+    auto path = make_temp_file();
+    FileDisk disk;
+    ASSERT_TRUE(disk.create(path, 16).has_value());
+    EXPECT_TRUE(disk.flush().has_value());
+
+    unlink(path.c_str());
+}
+
+TEST(FileDisk, DirectRequiresAlignedSize)
+{
+    auto path = make_temp_file();
+    FileDisk disk;
+
+    auto res = disk.create(path, FileDisk::DIRECT_ALIGNMENT + 100, true);
+    ASSERT_FALSE(res.has_value());
+    EXPECT_EQ(res.error(), FsError::Disk_InvalidRequest);
+
+    unlink(path.c_str());
+}
+
+TEST(FileDisk, DirectUnalignedWritesAndReads)
+{
+    auto path = make_temp_file();
+    constexpr size_t DISK_SIZE = 32 * FileDisk::DIRECT_ALIGNMENT;
+
+    {
+        FileDisk disk;
+        auto create_res = disk.create(path, DISK_SIZE, true);
+        if (!create_res.has_value()) {
+            unlink(path.c_str());
+            GTEST_SKIP() << "O_DIRECT not supported on this filesystem";
+        }
+
+        // Crosses page boundaries and is larger than one bounce buffer
+        static std::array<uint8_t, 70000> src;
+        for (size_t i = 0; i < src.size(); i++)
+            src[i] = static_cast<uint8_t>(i * 11 + 3);
+        static_vector<uint8_t> write_data(src.data(), src.size(), src.size());
+        auto write_res = disk.write(1000, write_data);
+        ASSERT_TRUE(write_res.has_value());
+        EXPECT_EQ(write_res.value(), src.size());
+
+        static std::array<uint8_t, 70002> dst;
+        static_vector<uint8_t> read_data(dst.data(), dst.size());
+        ASSERT_TRUE(disk.read(999, dst.size(), read_data).has_value());
+        EXPECT_EQ(dst[0], 0);
+        EXPECT_EQ(dst[dst.size() - 1], 0);
+        EXPECT_TRUE(std::equal(src.begin(), src.end(), dst.begin() + 1));
+        EXPECT_TRUE(disk.flush().has_value());
+    }
+
+    FileDisk disk;
+    ASSERT_TRUE(disk.open(path).has_value());
+    std::array<uint8_t, 2> dst;
+    static_vector<uint8_t> read_data(dst.data(), dst.size());
+    ASSERT_TRUE(disk.read(1000, 2, read_data).has_value());
+    EXPECT_EQ(dst[0], 3);
+    EXPECT_EQ(dst[1], 14);
+
+    unlink(path.c_str());
+}
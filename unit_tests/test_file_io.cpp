@@ -410,7 +410,7 @@ TEST(FileIO, ResizeHugeFileToZero)
     SuperBlock superblock {
         .total_inodes = 10,
         .block_bitmap_address = 16,
-        .first_data_blocks_address = 18,
+        .first_data_blocks_address = 20,
         .last_data_block_address = 1024,
 
     };
@@ -447,3 +447,268 @@ TEST(FileIO, ResizeHugeFileToZero)
     ASSERT_TRUE(num_free_res.has_value()) << "numFree failed";
     ASSERT_EQ(block_manager.numFree().value(), free_blocks);
 }
+
+TEST(FileIO, ShrinkFreesRemainingBlocksWhenOneIsAlreadyFree)
+{
+    StackDisk disk;
+    RawBlockDevice block_device(32, disk);
+    SuperBlock superblock {
+        .total_inodes = 10,
+        .block_bitmap_address = 16,
+        .first_data_blocks_address = 20,
+        .last_data_block_address = 1024,
+    };
+    BlockManager block_manager(superblock, block_device);
+    FakeInodeManager inode_manager;
+    FileIO file_io(block_device, block_manager, inode_manager);
+
+    Inode inode {};
+    auto free_blocks = block_manager.numFree().value();
+
+    std::array<uint8_t, 32 * 4> data_buffer {};
+    static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), data_buffer.size());
+    ASSERT_TRUE(file_io.writeFile(0, inode, 0, data).has_value());
+    ASSERT_TRUE(block_manager.free(inode.direct_blocks[1]).has_value());
+
+    auto resize_res = file_io.resizeFile(0, inode, 0);
+    ASSERT_FALSE(resize_res.has_value());
+    EXPECT_EQ(resize_res.error(), FsError::BlockManager_AlreadyFree);
+    EXPECT_EQ(inode.file_size, 0);
+    EXPECT_EQ(block_manager.numFree().value(), free_blocks);
+}
+
+TEST(FileIO, AllocatesContiguousBlocksForInterleavedFiles)
+{
+    StackDisk disk;
+    RawBlockDevice block_device(128, disk);
+    SuperBlock superblock {
+        .total_inodes = 10,
+        .block_bitmap_address = 16,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .first_data_blocks_address = 18,
+        .last_data_block_address = 1024,
+        .block_size = 128,
+    };
+    BlockManager block_manager(superblock, block_device);
+    FakeInodeManager inode_manager;
+    FileIO file_io(block_device, block_manager, inode_manager);
+    ASSERT_TRUE(block_manager.format().has_value());
+
+    std::array<uint8_t, 128 * 6> data_buffer;
+    data_buffer.fill(7);
+    static_vector<uint8_t> one_block(data_buffer.data(), data_buffer.size(), 128);
+    static_vector<uint8_t> six_blocks(data_buffer.data(), data_buffer.size(), 128 * 6);
+
+    // Both files start in neighbouring blocks, later appends must not interleave them
+    Inode first {}, second {};
+    ASSERT_TRUE(file_io.writeFile(0, first, 0, one_block).has_value());
+    ASSERT_TRUE(file_io.writeFile(1, second, 0, one_block).has_value());
+    ASSERT_TRUE(file_io.writeFile(0, first, 128, six_blocks).has_value());
+    ASSERT_TRUE(file_io.writeFile(1, second, 128, six_blocks).has_value());
+
+    for (int i = 2; i <= 6; i++) {
+        EXPECT_EQ(first.direct_blocks[i], first.direct_blocks[i - 1] + 1);
+        EXPECT_EQ(second.direct_blocks[i], second.direct_blocks[i - 1] + 1);
+    }
+    EXPECT_EQ(block_manager.numFree().value(), block_manager.numTotal().value() - 14);
+}
+
+struct ReadCountingDevice : public RawBlockDevice {
+    using RawBlockDevice::RawBlockDevice;
+    int reads = 0;
+
+    std::expected<void, FsError> readBlock(
+        DataLocation data_location, size_t bytes_to_read, static_vector<uint8_t>& data) override
+    {
+        reads++;
+        return RawBlockDevice::readBlock(data_location, bytes_to_read, data);
+    }
+};
+
+TEST(FileIO, BlockMapPoolSkipsIndexBlockReads)
+{
+    StackDisk disk;
+    ReadCountingDevice block_device(128, disk);
+    SuperBlock superblock {
+        .total_inodes = 10,
+        .block_bitmap_address = 16,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .first_data_blocks_address = 30,
+        .last_data_block_address = 2024,
+        .block_size = 128,
+    };
+    BlockManager block_manager(superblock, block_device);
+    FakeInodeManager inode_manager;
+    BlockMapPool block_maps;
+    FileIO file_io(block_device, block_manager, inode_manager, &block_maps);
+
+    // File reaching into the doubly indirect blocks
+    Inode inode {};
+    constexpr size_t file_blocks = 12 + 32 + 64;
+    std::array<uint8_t, 128 * file_blocks> data_buffer;
+    static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), data_buffer.size());
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = uint8_t(i % 251);
+    ASSERT_TRUE(file_io.writeFile(0, inode, 0, data).has_value());
+
+    std::array<uint8_t, 128> read_buffer;
+    auto readBlockAt = [&](size_t block, bool cache_index_blocks) {
+        static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+        block_device.reads = 0;
+        auto read_res
+            = file_io.readFile(0, inode, block * 128, 128, read_data, cache_index_blocks);
+        EXPECT_TRUE(read_res.has_value());
+        EXPECT_EQ(read_data[0], uint8_t(block * 128 % 251));
+        return block_device.reads;
+    };
+
+    // Without the pool, both index blocks on the way are decoded every time
+    EXPECT_EQ(readBlockAt(12 + 32 + 40, false), 2);
+    EXPECT_EQ(readBlockAt(12 + 32 + 41, false), 2);
+
+    EXPECT_EQ(readBlockAt(12 + 32 + 40, true), 2);
+    EXPECT_EQ(readBlockAt(12 + 32 + 41, true), 0);
+    EXPECT_EQ(readBlockAt(12 + 32 + 40, true), 0);
+    // Moving to the next leaf decodes only the leaf
+    EXPECT_EQ(readBlockAt(12 + 32 + 8, true), 1);
+
+    ASSERT_TRUE(file_io.resizeFile(0, inode, 128 * (file_blocks - 1)).has_value());
+    EXPECT_EQ(readBlockAt(12 + 32 + 8, true), 2);
+
+    // Writing the file without the pool forgets its index blocks kept there
+    ASSERT_TRUE(file_io.writeFile(0, inode, 0, data).has_value());
+    EXPECT_EQ(readBlockAt(12 + 32 + 8, true), 2);
+}
+
+TEST(FileIO, ExtentMappedFileNeedsNoIndexBlocks)
+{
+    StackDisk disk;
+    ReadCountingDevice block_device(128, disk);
+    SuperBlock superblock {
+        .total_inodes = 10,
+        .block_bitmap_address = 16,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .first_data_blocks_address = 30,
+        .last_data_block_address = 2024,
+        .block_size = 128,
+    };
+    BlockManager block_manager(superblock, block_device);
+    FakeInodeManager inode_manager;
+    FileIO file_io(block_device, block_manager, inode_manager);
+    ASSERT_TRUE(block_manager.format().has_value());
+    auto free_before = block_manager.numFree().value();
+
+    Inode inode { .extent_count = 0, .extent_mapped = true };
+    constexpr size_t file_blocks = 12 + 32 + 64;
+    std::array<uint8_t, 128 * file_blocks> data_buffer;
+    static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), data_buffer.size());
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = uint8_t(i % 251);
+    ASSERT_TRUE(file_io.writeFile(0, inode, 0, data).has_value());
+
+    // One run needs one extent and no index blocks at all
+    EXPECT_EQ(inode.extent_count, 1);
+    EXPECT_EQ(inode.extents[0].length, file_blocks);
+    EXPECT_EQ(block_manager.numFree().value(), free_before - file_blocks);
+
+    std::array<uint8_t, 128 * file_blocks> read_buffer;
+    static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+    block_device.reads = 0;
+    ASSERT_TRUE(file_io.readFile(0, inode, 0, data.size(), read_data).has_value());
+    EXPECT_EQ(block_device.reads, 0);
+    EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), data.begin()));
+
+    ASSERT_TRUE(file_io.resizeFile(0, inode, 0).has_value());
+    EXPECT_EQ(inode.extent_count, 0);
+    EXPECT_EQ(block_manager.numFree().value(), free_before);
+}
+
+TEST(FileIO, ExtentMappedFileSpillsIntoExtentBlock)
+{
+    StackDisk disk;
+    RawBlockDevice block_device(128, disk);
+    SuperBlock superblock {
+        .total_inodes = 10,
+        .block_bitmap_address = 16,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .first_data_blocks_address = 18,
+        .last_data_block_address = 1024,
+        .block_size = 128,
+    };
+    BlockManager block_manager(superblock, block_device);
+    FakeInodeManager inode_manager;
+    FileIO file_io(block_device, block_manager, inode_manager);
+    ASSERT_TRUE(block_manager.format().has_value());
+    auto free_before = block_manager.numFree().value();
+
+    // Interleaved single block appends give every block its own extent
+    Inode first { .extent_count = 0, .extent_mapped = true };
+    Inode second { .extent_count = 0, .extent_mapped = true };
+    std::array<uint8_t, 128> data_buffer;
+    for (uint8_t i = 0; i < 10; i++) {
+        data_buffer.fill(i);
+        static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), data_buffer.size());
+        ASSERT_TRUE(file_io.writeFile(0, first, i * 128, data).has_value());
+        ASSERT_TRUE(file_io.writeFile(1, second, i * 128, data).has_value());
+    }
+    EXPECT_EQ(first.extent_count, 10);
+    // Data blocks of both files and one extent block each
+    EXPECT_EQ(block_manager.numFree().value(), free_before - 22);
+
+    for (uint8_t i = 0; i < 10; i++) {
+        static_vector<uint8_t> read_data(data_buffer.data(), data_buffer.size());
+        ASSERT_TRUE(file_io.readFile(0, first, i * 128, 128, read_data).has_value());
+        EXPECT_EQ(read_data[0], i);
+        EXPECT_EQ(read_data[127], i);
+    }
+
+    // Extent block holds (128 - 4) / 12 extents, more of them continue in chained blocks
+    for (uint8_t i = 10; i < 40; i++) {
+        data_buffer.fill(i);
+        static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), data_buffer.size());
+        ASSERT_TRUE(file_io.writeFile(0, first, i * 128, data).has_value());
+        ASSERT_TRUE(file_io.writeFile(1, second, i * 128, data).has_value());
+    }
+    EXPECT_EQ(first.extent_count, 40);
+    EXPECT_EQ(block_manager.numFree().value(), free_before - 2 * (40 + 4));
+
+    for (uint8_t i = 0; i < 40; i++) {
+        static_vector<uint8_t> read_data(data_buffer.data(), data_buffer.size());
+        ASSERT_TRUE(file_io.readFile(0, first, i * 128, 128, read_data).has_value());
+        EXPECT_EQ(read_data[0], i);
+        EXPECT_EQ(read_data[127], i);
+    }
+
+    // Shrinking into the middle of the chain frees only the blocks past the last extent
+    ASSERT_TRUE(file_io.resizeFile(0, first, 25 * 128).has_value());
+    EXPECT_EQ(first.extent_count, 25);
+    EXPECT_EQ(block_manager.numFree().value(), free_before - (25 + 3) - (40 + 4));
+
+    // Growing again links a new block to the shortened chain
+    for (uint8_t i = 25; i < 35; i++) {
+        data_buffer.fill(i + 100);
+        static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), data_buffer.size());
+        ASSERT_TRUE(file_io.writeFile(0, first, i * 128, data).has_value());
+        ASSERT_TRUE(file_io.writeFile(1, second, (i + 15) * 128, data).has_value());
+    }
+    EXPECT_EQ(first.extent_count, 35);
+    for (uint8_t i = 0; i < 35; i++) {
+        static_vector<uint8_t> read_data(data_buffer.data(), data_buffer.size());
+        ASSERT_TRUE(file_io.readFile(0, first, i * 128, 128, read_data).has_value());
+        EXPECT_EQ(read_data[0], i < 25 ? i : i + 100);
+    }
+
+    // Shrinking back into the inode frees the whole chain
+    ASSERT_TRUE(file_io.resizeFile(0, first, 3 * 128 + 5).has_value());
+    EXPECT_EQ(first.extent_count, 4);
+    ASSERT_TRUE(file_io.resizeFile(1, second, 0).has_value());
+    EXPECT_EQ(block_manager.numFree().value(), free_before - 4);
+
+    static_vector<uint8_t> read_data(data_buffer.data(), data_buffer.size());
+    ASSERT_TRUE(file_io.readFile(0, first, 2 * 128, 128, read_data).has_value());
+    EXPECT_EQ(read_data[0], 2);
+}
@@ -172,3 +172,105 @@ TEST(ConfigLoader, HandlesCommentsAndEmptyLines)
     EXPECT_EQ(cfg.ecc_type, ECCType::Crc);
     EXPECT_FALSE(cfg.use_journal);
 }
+
+TEST(ConfigLoader, CachePolicy)
+{
+    auto path = write_temp_config(R"(
+        total_size = 1048576
+        average_file_size = 4096
+        block_size = 512
+        ecc_type = hamming
+        cache_policy = write_back
+    )");
+
+    auto res = load_fs_config(path);
+
+    ASSERT_TRUE(res.has_value()) << "Error: " << toString(res.error());
+    EXPECT_EQ(res->cache_policy, CachePolicy::WriteBack);
+
+    path = write_temp_config(R"(
+        total_size = 1048576
+        average_file_size = 4096
+        block_size = 512
+        ecc_type = none
+        cache_policy = sometimes
+    )");
+    res = load_fs_config(path);
+    ASSERT_FALSE(res.has_value());
+    EXPECT_EQ(res.error(), FsError::Config_InvalidValue);
+}
+
+TEST(ConfigLoader, RuntimeOptionsWithoutLayout)
+{
+    auto path = write_temp_config(R"(
+        cache_policy = write_back
+    )");
+
+    auto res = load_fs_config(path, false);
+
+    ASSERT_TRUE(res.has_value()) << "Error: " << toString(res.error());
+    EXPECT_EQ(res->cache_policy, CachePolicy::WriteBack);
+
+    res = load_fs_config(path);
+    ASSERT_FALSE(res.has_value());
+    EXPECT_EQ(res.error(), FsError::Config_MissingField);
+}
+
+TEST(ConfigLoader, AllocationPolicy)
+{
+    auto path = write_temp_config(R"(
+        total_size = 1048576
+        average_file_size = 4096
+        block_size = 512
+        ecc_type = none
+        allocation_policy = next_fit
+    )");
+
+    auto res = load_fs_config(path);
+
+    ASSERT_TRUE(res.has_value()) << "Error: " << toString(res.error());
+    EXPECT_EQ(res->allocation_policy, AllocationPolicy::NextFit);
+
+    path = write_temp_config(R"(
+        total_size = 1048576
+        average_file_size = 4096
+        block_size = 512
+        ecc_type = none
+        allocation_policy = best_fit
+    )");
+    res = load_fs_config(path);
+    ASSERT_FALSE(res.has_value());
+    EXPECT_EQ(res.error(), FsError::Config_InvalidValue);
+}
+
+TEST(ConfigLoader, AlignInodes)
+{
+    auto path = write_temp_config(R"(
+        total_size = 1048576
+        average_file_size = 4096
+        block_size = 512
+        ecc_type = none
+        align_inodes = true
+    )");
+
+    auto res = load_fs_config(path);
+
+    ASSERT_TRUE(res.has_value()) << "Error: " << toString(res.error());
+    EXPECT_TRUE(res->align_inodes);
+}
+
+TEST(ConfigLoader, IndexedDirectories)
+{
+    auto path = write_temp_config(R"(
+        total_size = 1048576
+        average_file_size = 4096
+        block_size = 512
+        ecc_type = none
+        indexed_directories = true
+    )");
+
+    auto res = load_fs_config(path);
+
+    ASSERT_TRUE(res.has_value()) << "Error: " << toString(res.error());
+    EXPECT_TRUE(res->indexed_directories);
+}
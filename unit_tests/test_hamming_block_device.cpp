@@ -1,6 +1,9 @@
 #include "ppfs/blockdevice/hamming_block_device.hpp"
+#include "ppfs/common/bit_helpers.hpp"
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/disk/stack_disk.hpp"
+#include "ppfs/ecc_helpers/hamming_codec.hpp"
+#include <algorithm>
 #include <array>
 #include <gtest/gtest.h>
 #include <random>
@@ -141,3 +144,83 @@ TEST(HammingBlockDevice, MultipleRandomSingleBitCorrections)
         ASSERT_EQ(decoded, msg);
     }
 }
+
+// Helper: bit by bit encoder following HammingDataBitsIterator layout
+void referenceEncode(
+    const static_vector<uint8_t>& data, static_vector<uint8_t>& block, size_t data_size)
+{
+    size_t block_size = block.size();
+    bool odd = false;
+    unsigned int parity_xor = 0;
+    HammingDataBitsIterator it(block_size, data_size);
+    for (unsigned int i = 0; i < data_size * 8; i++) {
+        bool bit = BitHelpers::getBit(data, i);
+        unsigned int index = *it.next();
+        if (bit) {
+            odd = !odd;
+            parity_xor ^= index;
+        }
+        BitHelpers::setBit(block, index, bit);
+    }
+    for (unsigned int index = 1; index < block_size * 8; index <<= 1) {
+        bool bit = parity_xor & index;
+        odd ^= bit;
+        BitHelpers::setBit(block, index, bit);
+    }
+    BitHelpers::setBit(block, 0, odd);
+}
+
+TEST(HammingCodec, MatchesBitByBitLayout)
+{
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    for (int power = 3; power <= 12; power++) {
+        for (bool allow_bmi2 : { false, true }) {
+            HammingCodec codec(power, allow_bmi2);
+            size_t block_size = codec.blockSize();
+            size_t data_size = codec.dataSize();
+
+            std::array<uint8_t, MAX_BLOCK_SIZE> data_buffer;
+            static_vector<uint8_t> data(data_buffer.data(), MAX_BLOCK_SIZE, data_size);
+            std::array<uint8_t, MAX_BLOCK_SIZE> expected_buffer;
+            static_vector<uint8_t> expected(expected_buffer.data(), MAX_BLOCK_SIZE, block_size);
+            std::array<uint8_t, MAX_BLOCK_SIZE> block_buffer;
+            static_vector<uint8_t> block(block_buffer.data(), MAX_BLOCK_SIZE, block_size);
+            std::array<uint8_t, MAX_BLOCK_SIZE> extracted_buffer;
+            static_vector<uint8_t> extracted(extracted_buffer.data(), MAX_BLOCK_SIZE);
+
+            for (auto& b : data)
+                b = static_cast<uint8_t>(byte(gen));
+            // Unused bits must be kept as they were
+            for (size_t i = 0; i < block_size; i++)
+                expected[i] = block[i] = static_cast<uint8_t>(byte(gen));
+
+            referenceEncode(data, expected, data_size);
+            codec.encode(data, block);
+            ASSERT_TRUE(std::equal(block.begin(), block.end(), expected.begin()))
+                << "power " << power;
+
+            codec.extract(block, extracted);
+            ASSERT_EQ(extracted.size(), data_size);
+            EXPECT_TRUE(std::equal(extracted.begin(), extracted.end(), data.begin()));
+
+            auto clean = codec.findError(block);
+            ASSERT_TRUE(clean.has_value());
+            EXPECT_FALSE(clean->has_value());
+
+            HammingDataBitsIterator it(block_size, data_size);
+            for (size_t skip = randomBit(data_size * 8); skip > 0; skip--)
+                it.next();
+            unsigned int index = *it.next();
+            BitHelpers::setBit(block, index, !BitHelpers::getBit(block, index));
+            auto single = codec.findError(block);
+            ASSERT_TRUE(single.has_value());
+            ASSERT_TRUE(single->has_value());
+            EXPECT_EQ(**single, index);
+
+            BitHelpers::setBit(block, 0, !BitHelpers::getBit(block, 0));
+            EXPECT_FALSE(codec.findError(block).has_value());
+        }
+    }
+}
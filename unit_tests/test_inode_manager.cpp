@@ -1,3 +1,4 @@
+#include "counting_disk.hpp"
 #include "ppfs/blockdevice/raw_block_device.hpp"
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/disk/stack_disk.hpp"
@@ -203,4 +204,247 @@ TEST(InodeManager, WorksForMultipleInodes)
     ASSERT_TRUE(free_count_res.has_value())
         << "Failed to count free inodes: " << toString(free_count_res.error());
     ASSERT_EQ(free_count_res.value(), 1000 - 512 - 1); // minus root inode
-}
\ No newline at end of file
+}
+TEST(InodeManager, NextFitDoesNotReuseFreedInodesRightAway)
+{
+    StackDisk disk;
+    RawBlockDevice device(128, disk);
+    SuperBlock superblock { .total_inodes = 8,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .block_size = 128,
+        .allocation_policy = AllocationPolicy::NextFit };
+    InodeManager inode_manager(device, superblock);
+    ASSERT_TRUE(inode_manager.format().has_value());
+
+    Inode inode {};
+    EXPECT_EQ(inode_manager.create(inode).value(), 1);
+    EXPECT_EQ(inode_manager.create(inode).value(), 2);
+    ASSERT_TRUE(inode_manager.remove(1).has_value());
+    EXPECT_EQ(inode_manager.create(inode).value(), 3);
+
+    // Search wraps around once the end is reached
+    for (inode_index_t expected = 4; expected < 8; expected++) {
+        EXPECT_EQ(inode_manager.create(inode).value(), expected);
+    }
+    EXPECT_EQ(inode_manager.create(inode).value(), 1);
+    EXPECT_EQ(inode_manager.create(inode).error(), FsError::InodeManager_NoMoreFreeInodes);
+}
+
+TEST(InodeManager, WritesUpdatesOnFlush)
+{
+    StackDisk disk;
+    RawBlockDevice device(128, disk);
+    SuperBlock superblock {
+        .total_inodes = 8, .inode_bitmap_address = 0, .inode_table_address = 1, .block_size = 128
+    };
+    InodeManager inode_manager(device, superblock);
+    ASSERT_TRUE(inode_manager.format().has_value());
+
+    Inode inode {};
+    auto create_res = inode_manager.create(inode);
+    ASSERT_TRUE(create_res.has_value());
+    inode.file_size = 77;
+    ASSERT_TRUE(inode_manager.update(create_res.value(), inode).has_value());
+
+    // Another manager sees only what is on disk
+    {
+        InodeManager on_disk(device, superblock);
+        EXPECT_EQ(on_disk.get(create_res.value()).value().file_size, 0);
+    }
+    EXPECT_EQ(inode_manager.get(create_res.value()).value().file_size, 77);
+
+    ASSERT_TRUE(inode_manager.flush(create_res.value()).has_value());
+    InodeManager on_disk(device, superblock);
+    EXPECT_EQ(on_disk.get(create_res.value()).value().file_size, 77);
+}
+
+TEST(InodeManager, CountsHitsAndMisses)
+{
+    StackDisk disk;
+    RawBlockDevice device(128, disk);
+    SuperBlock superblock {
+        .total_inodes = 8, .inode_bitmap_address = 0, .inode_table_address = 1, .block_size = 128
+    };
+    {
+        InodeManager inode_manager(device, superblock);
+        ASSERT_TRUE(inode_manager.format().has_value());
+    }
+
+    InodeManager inode_manager(device, superblock);
+    ASSERT_TRUE(inode_manager.get(0).has_value());
+    ASSERT_TRUE(inode_manager.get(0).has_value());
+    ASSERT_TRUE(inode_manager.get(0).has_value());
+    EXPECT_EQ(inode_manager.misses(), 1);
+    EXPECT_EQ(inode_manager.hits(), 2);
+}
+
+TEST(InodeManager, WritesDirtyInodesOnEviction)
+{
+    constexpr size_t inode_count = InodeManager::CACHE_ENTRIES * 2;
+    StackDisk disk;
+    RawBlockDevice device(128, disk);
+    SuperBlock superblock { .total_inodes = inode_count + 1,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .block_size = 128 };
+    InodeManager inode_manager(device, superblock);
+    ASSERT_TRUE(inode_manager.format().has_value());
+
+    Inode inode {};
+    for (size_t i = 1; i <= inode_count; i++) {
+        ASSERT_EQ(inode_manager.create(inode).value(), i);
+    }
+    for (size_t i = 1; i <= inode_count; i++) {
+        inode.file_size = i;
+        ASSERT_TRUE(inode_manager.update(i, inode).has_value());
+    }
+
+    // At most a cache worth of updates may still be only in memory
+    {
+        InodeManager on_disk(device, superblock);
+        size_t written = 0;
+        for (size_t i = 1; i <= inode_count; i++) {
+            written += on_disk.get(i).value().file_size == i;
+        }
+        EXPECT_GE(written, inode_count - InodeManager::CACHE_ENTRIES);
+    }
+
+    ASSERT_TRUE(inode_manager.flush().has_value());
+    InodeManager on_disk(device, superblock);
+    for (size_t i = 1; i <= inode_count; i++) {
+        EXPECT_EQ(on_disk.get(i).value().file_size, i);
+    }
+}
+
+TEST(InodeManager, KeepsPinnedInodesCached)
+{
+    constexpr size_t inode_count = InodeManager::CACHE_ENTRIES * 2;
+    StackDisk disk;
+    RawBlockDevice device(128, disk);
+    SuperBlock superblock { .total_inodes = inode_count + 1,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .block_size = 128 };
+    InodeManager inode_manager(device, superblock);
+    ASSERT_TRUE(inode_manager.format().has_value());
+
+    Inode inode {};
+    for (size_t i = 1; i <= inode_count; i++) {
+        ASSERT_EQ(inode_manager.create(inode).value(), i);
+    }
+    ASSERT_TRUE(inode_manager.pin(1).has_value());
+    for (size_t i = 2; i <= inode_count; i++) {
+        ASSERT_TRUE(inode_manager.get(i).has_value());
+    }
+
+    auto hits = inode_manager.hits();
+    ASSERT_TRUE(inode_manager.get(1).has_value());
+    EXPECT_EQ(inode_manager.hits(), hits + 1);
+    inode_manager.unpin(1);
+
+    // With every entry pinned updates go straight to disk
+    for (size_t i = 1; i <= InodeManager::CACHE_ENTRIES; i++) {
+        ASSERT_TRUE(inode_manager.pin(i).has_value());
+    }
+    inode.file_size = 5;
+    ASSERT_TRUE(inode_manager.update(inode_count, inode).has_value());
+    InodeManager on_disk(device, superblock);
+    EXPECT_EQ(on_disk.get(inode_count).value().file_size, 5);
+}
+
+TEST(InodeManager, AlignedLayoutKeepsInodesWithinBlocks)
+{
+    constexpr size_t per_block = 128 / sizeof(Inode);
+    StackDisk disk;
+    RawBlockDevice device(128, disk);
+    SuperBlock superblock { .total_inodes = 3 * per_block,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .block_size = 128,
+        .inodes_block_aligned = true };
+    EXPECT_EQ(InodeManager::tableBlocks(superblock, 128), 3);
+
+    {
+        InodeManager inode_manager(device, superblock);
+        ASSERT_TRUE(inode_manager.format().has_value());
+        Inode inode {};
+        for (size_t i = 1; i < 3 * per_block; i++) {
+            inode.file_size = i;
+            ASSERT_EQ(inode_manager.create(inode).value(), i);
+        }
+    }
+
+    // First inode of the second table block starts at its first byte
+    Inode on_disk;
+    static_vector<uint8_t> data(reinterpret_cast<uint8_t*>(&on_disk), sizeof(Inode));
+    ASSERT_TRUE(disk.read(2 * 128, sizeof(Inode), data).has_value());
+    EXPECT_EQ(on_disk.file_size, per_block);
+
+    InodeManager inode_manager(device, superblock);
+    for (size_t i = 1; i < 3 * per_block; i++) {
+        EXPECT_EQ(inode_manager.get(i).value().file_size, i);
+    }
+}
+
+TEST(InodeManager, GetManyDecodesEachTableBlockOnce)
+{
+    constexpr size_t per_block = 512 / sizeof(Inode);
+    constexpr size_t taken = 3 * per_block;
+    StackDisk stack_disk;
+    CountingDisk disk(stack_disk);
+    RawBlockDevice device(512, disk);
+    SuperBlock superblock { .total_inodes = 4 * per_block,
+        .inode_bitmap_address = 0,
+        .inode_table_address = 1,
+        .block_size = 512,
+        .inodes_block_aligned = true };
+
+    {
+        InodeManager inode_manager(device, superblock);
+        ASSERT_TRUE(inode_manager.format().has_value());
+        Inode inode {};
+        for (size_t i = 1; i < taken; i++) {
+            inode.file_size = i;
+            ASSERT_EQ(inode_manager.create(inode).value(), i);
+        }
+    }
+
+    // Blocks are visited out of order, and the last index is not taken
+    std::array<inode_index_t, taken + 1> indices_buffer;
+    for (size_t i = 0; i < taken; i++) {
+        indices_buffer[i] = (i % 3) * per_block + i / 3;
+    }
+    indices_buffer[taken] = taken;
+    static_vector<inode_index_t> indices(
+        indices_buffer.data(), indices_buffer.size(), indices_buffer.size());
+
+    size_t get_reads;
+    {
+        InodeManager inode_manager(device, superblock);
+        size_t before = disk.reads;
+        for (auto index : indices) {
+            (void)inode_manager.get(index);
+        }
+        get_reads = disk.reads - before;
+    }
+
+    InodeManager inode_manager(device, superblock);
+    std::array<std::optional<Inode>, taken + 1> inodes_buffer;
+    static_vector<std::optional<Inode>> inodes(inodes_buffer.data(), inodes_buffer.size());
+    size_t before = disk.reads;
+    ASSERT_TRUE(inode_manager.getMany(indices, inodes).has_value());
+    EXPECT_EQ(get_reads - (disk.reads - before), taken - 3);
+    EXPECT_EQ(inode_manager.misses(), taken);
+
+    ASSERT_EQ(inodes.size(), indices.size());
+    for (size_t i = 0; i < taken; i++) {
+        ASSERT_TRUE(inodes[i].has_value());
+        EXPECT_EQ(inodes[i]->file_size, indices[i]);
+    }
+    EXPECT_FALSE(inodes[taken].has_value());
+
+    // Second batch is answered from the cache
+    ASSERT_TRUE(inode_manager.getMany(indices, inodes).has_value());
+    EXPECT_EQ(inode_manager.hits(), std::min(taken, InodeManager::CACHE_ENTRIES));
+}
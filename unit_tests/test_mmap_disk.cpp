@@ -0,0 +1,132 @@
+#include "ppfs/common/static_vector.hpp"
+#include "ppfs/disk/file_disk.hpp"
+#include "ppfs/disk/mmap_disk.hpp"
+
+#include <array>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+
+static std::string make_temp_file()
+{
+    char tmpl[] = "/tmp/mmapdisk-test-XXXXXX";
+    int fd = mkstemp(tmpl);
+    EXPECT_NE(fd, -1);
+    close(fd);
+    return std::string(tmpl);
+}
+
+TEST(MmapDisk, CreateAndSize)
+{
+    auto path = make_temp_file();
+    MmapDisk disk;
+
+    auto res = disk.create(path, 8192, { .populate = true, .advice = MmapAdvice::Random });
+    ASSERT_TRUE(res.has_value());
+    EXPECT_EQ(disk.size(), 8192);
+
+    unlink(path.c_str());
+}
+
+TEST(MmapDisk, ReadFailsWhenNotOpen)
+{
+    MmapDisk disk;
+    std::array<uint8_t, 4> buf;
+    static_vector data(buf.data(), buf.size());
+
+    auto read_res = disk.read(0, 4, data);
+    ASSERT_FALSE(read_res.has_value());
+    EXPECT_EQ(read_res.error(), FsError::Disk_IOError);
+}
+
+TEST(MmapDisk, WritesReadsAndViews)
+{
+    auto path = make_temp_file();
+    MmapDisk disk;
+    ASSERT_TRUE(disk.create(path, 16).has_value());
+
+    std::array<uint8_t, 4> src = { 1, 2, 3, 4 };
+    static_vector<uint8_t> write_data(src.data(), src.size(), src.size());
+    auto write_res = disk.write(10, write_data);
+    ASSERT_TRUE(write_res.has_value());
+    EXPECT_EQ(write_res.value(), src.size());
+
+    std::array<uint8_t, 4> dst;
+    static_vector read_data(dst.data(), dst.size());
+    ASSERT_TRUE(disk.read(10, dst.size(), read_data).has_value());
+    EXPECT_EQ(dst, src);
+
+    unlink(path.c_str());
+}
+
+TEST(MmapDisk, OutOfBounds)
+{
+    auto path = make_temp_file();
+    MmapDisk disk;
+    ASSERT_TRUE(disk.create(path, 8).has_value());
+
+    std::array<uint8_t, 4> buf;
+    static_vector data(buf.data(), buf.size());
+    auto read_res = disk.read(6, 4, data);
+    EXPECT_FALSE(read_res.has_value());
+    EXPECT_EQ(read_res.error(), FsError::Disk_OutOfBounds);
+
+    std::array<uint8_t, 4> src = { 1, 2, 3, 4 };
+    static_vector write_data(src.data(), src.size(), src.size());
+    auto write_res = disk.write(6, write_data);
+    EXPECT_FALSE(write_res.has_value());
+    EXPECT_EQ(write_res.error(), FsError::Disk_OutOfBounds);
+
+    unlink(path.c_str());
+}
+
+TEST(MmapDisk, FlushedDataIsVisibleThroughFile)
+{
+    auto path = make_temp_file();
+    MmapDisk disk;
+    ASSERT_TRUE(disk.create(path, 3 * 4096, { .sync_writes = true }).has_value());
+
+    std::array<uint8_t, 3> src = { 9, 8, 7 };
+    static_vector<uint8_t> write_data(src.data(), src.size(), src.size());
+    ASSERT_TRUE(disk.write(5000, write_data).has_value());
+    ASSERT_TRUE(disk.flush(5000, 3).has_value());
+
+    FileDisk file_disk;
+    ASSERT_TRUE(file_disk.open(path).has_value());
+    std::array<uint8_t, 3> dst;
+    static_vector read_data(dst.data(), dst.size());
+    ASSERT_TRUE(file_disk.read(5000, dst.size(), read_data).has_value());
+    EXPECT_EQ(dst, src);
+
+    unlink(path.c_str());
+}
+
+TEST(MmapDisk, DataPersistsAfterReopen)
+{
+    auto path = make_temp_file();
+
+    {
+        MmapDisk disk;
+        ASSERT_TRUE(disk.create(path, 16).has_value());
+
+        std::array<uint8_t, 3> src = { 9, 8, 7 };
+        static_vector<uint8_t> write_data(src.data(), src.size(), src.size());
+        ASSERT_TRUE(disk.write(4, write_data).has_value());
+    }
+
+    {
+        MmapDisk disk;
+        ASSERT_TRUE(disk.open(path, { .advice = MmapAdvice::Sequential }).has_value());
+        EXPECT_EQ(disk.size(), 16);
+
+        std::array<uint8_t, 3> dst;
+        static_vector read_data(dst.data(), dst.size());
+        ASSERT_TRUE(disk.read(4, dst.size(), read_data).has_value());
+        EXPECT_EQ(dst[0], 9);
+        EXPECT_EQ(dst[1], 8);
+        EXPECT_EQ(dst[2], 7);
+    }
+
+    unlink(path.c_str());
+}
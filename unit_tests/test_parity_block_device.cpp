@@ -1,6 +1,7 @@
 #include "ppfs/blockdevice/parity_block_device.hpp"
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/disk/stack_disk.hpp"
+#include <algorithm>
 #include <array>
 #include <bit>
 #include <gtest/gtest.h>
@@ -1,9 +1,13 @@
+#include "baseline_image.hpp"
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/directory_manager/directory.hpp"
 #include "ppfs/disk/stack_disk.hpp"
 #include "ppfs/filesystem/ppfs.hpp"
+#include <algorithm>
 #include <array>
 #include <gtest/gtest.h>
+#include <thread>
+#include <vector>
 
 TEST(PpFS, Compiles)
 {
@@ -1607,6 +1611,115 @@ TEST(PpFS, WriteSeekWriteRead_Succeeds)
     }
 }
 
+TEST(PpFS, WriteAtReadAt_LeavePositionUnchanged)
+{
+    StackDisk disk;
+    PpFS fs(disk);
+
+    FsConfig config;
+    config.total_size = 4096;
+    config.block_size = 128;
+    config.average_file_size = 256;
+    auto format_res = fs.format(config);
+    ASSERT_TRUE(format_res.has_value());
+
+    ASSERT_TRUE(fs.create("/file.txt").has_value());
+    auto open_res = fs.open("/file.txt");
+    ASSERT_TRUE(open_res.has_value()) << "Open file failed: " << toString(open_res.error());
+    file_descriptor_t fd = open_res.value();
+
+    std::array<uint8_t, 200> write_buf;
+    for (size_t i = 0; i < write_buf.size(); i++)
+        write_buf[i] = static_cast<uint8_t>(i);
+    static_vector<uint8_t> write_data(write_buf.data(), write_buf.size(), write_buf.size());
+    auto write_res = fs.writeAt(fd, 0, write_data);
+    ASSERT_TRUE(write_res.has_value()) << "WriteAt failed: " << toString(write_res.error());
+    ASSERT_EQ(write_res.value(), write_buf.size());
+
+    // Overwrite across the block boundary
+    std::array<uint8_t, 10> patch_buf;
+    patch_buf.fill(0xAA);
+    static_vector<uint8_t> patch(patch_buf.data(), patch_buf.size(), patch_buf.size());
+    ASSERT_TRUE(fs.writeAt(fd, 123, patch).has_value());
+
+    std::array<uint8_t, 20> read_buf;
+    static_vector<uint8_t> read_data(read_buf.data(), read_buf.size());
+    auto read_res = fs.readAt(fd, 120, read_buf.size(), read_data);
+    ASSERT_TRUE(read_res.has_value()) << "ReadAt failed: " << toString(read_res.error());
+    ASSERT_EQ(read_data.size(), read_buf.size());
+    for (size_t i = 0; i < read_data.size(); i++) {
+        uint8_t expected = (i >= 3 && i < 13) ? 0xAA : static_cast<uint8_t>(120 + i);
+        ASSERT_EQ(read_data[i], expected) << "Mismatch at index " << i;
+    }
+
+    // The descriptor position is still at the start of the file
+    std::array<uint8_t, 5> head_buf;
+    static_vector<uint8_t> head(head_buf.data(), head_buf.size());
+    ASSERT_TRUE(fs.read(fd, head_buf.size(), head).has_value());
+    for (size_t i = 0; i < head.size(); i++)
+        ASSERT_EQ(head[i], i);
+
+    ASSERT_TRUE(fs.close(fd).has_value());
+}
+
+TEST(PpFS, WriteAt_Fails_OutOfBounds)
+{
+    StackDisk disk;
+    PpFS fs(disk);
+
+    FsConfig config;
+    config.total_size = 4096;
+    config.block_size = 128;
+    config.average_file_size = 256;
+    auto format_res = fs.format(config);
+    ASSERT_TRUE(format_res.has_value());
+
+    ASSERT_TRUE(fs.create("/file.txt").has_value());
+    auto open_res = fs.open("/file.txt");
+    ASSERT_TRUE(open_res.has_value()) << "Open file failed: " << toString(open_res.error());
+    file_descriptor_t fd = open_res.value();
+
+    std::array<uint8_t, 5> write_buf = { 1, 2, 3, 4, 5 };
+    static_vector<uint8_t> write_data(write_buf.data(), write_buf.size(), write_buf.size());
+    auto write_res = fs.writeAt(fd, 10, write_data);
+    ASSERT_FALSE(write_res.has_value());
+    ASSERT_EQ(write_res.error(), FsError::PpFS_OutOfBounds);
+
+    std::array<uint8_t, 5> read_buf;
+    static_vector<uint8_t> read_data(read_buf.data(), read_buf.size());
+    ASSERT_FALSE(fs.readAt(fd, 0, read_buf.size(), read_data).has_value());
+
+    ASSERT_TRUE(fs.close(fd).has_value());
+}
+
+TEST(PpFS, WriteAt_AppendMode_WritesAtEnd)
+{
+    StackDisk disk;
+    PpFS fs(disk);
+
+    FsConfig config;
+    config.total_size = 4096;
+    config.block_size = 128;
+    config.average_file_size = 256;
+    auto format_res = fs.format(config);
+    ASSERT_TRUE(format_res.has_value());
+
+    ASSERT_TRUE(fs.create("/file.txt").has_value());
+    auto open_res = fs.open("/file.txt", OpenMode::Append);
+    ASSERT_TRUE(open_res.has_value()) << "Open file failed: " << toString(open_res.error());
+    file_descriptor_t fd = open_res.value();
+
+    std::array<uint8_t, 5> write_buf = { 1, 2, 3, 4, 5 };
+    static_vector<uint8_t> write_data(write_buf.data(), write_buf.size(), write_buf.size());
+    ASSERT_TRUE(fs.writeAt(fd, 0, write_data).has_value());
+    ASSERT_TRUE(fs.writeAt(fd, 0, write_data).has_value());
+    ASSERT_TRUE(fs.close(fd).has_value());
+
+    auto stat_res = fs.getFileStat("/file.txt");
+    ASSERT_TRUE(stat_res.has_value());
+    EXPECT_EQ(stat_res.value().size, 2 * write_buf.size());
+}
+
 TEST(PpFS, Write_Fails_Protected)
 {
     StackDisk disk;
@@ -1833,3 +1946,512 @@ TEST(PpFS, ThreeFoldersWork)
     ASSERT_TRUE(fs.createDirectory("/user2").has_value());
     ASSERT_TRUE(fs.create("/user2/0"));
 }
+
+TEST(PpFS, WriteBackCacheKeepsDataAcrossRemount)
+{
+    StackDisk disk;
+    std::array<uint8_t, 600> write_buffer;
+    for (size_t i = 0; i < write_buffer.size(); i++)
+        write_buffer[i] = static_cast<uint8_t>(i * 7);
+
+    {
+        static std::array<CachingBlockDevice::Entry, CachingBlockDevice::DEFAULT_CAPACITY>
+            cache_entries;
+        PpFS fs(disk, nullptr, CachePolicy::None, { cache_entries.data(), cache_entries.size() });
+        ASSERT_TRUE(fs.format(FsConfig {
+                                  .total_size = disk.size(),
+                                  .average_file_size = 1024,
+                                  .block_size = 256,
+                                  .ecc_type = ECCType::Hamming,
+                                  .cache_policy = CachePolicy::WriteBack,
+                              })
+                .has_value());
+        ASSERT_TRUE(fs.create("/file").has_value());
+        auto fd = fs.open("/file");
+        ASSERT_TRUE(fd.has_value());
+        static_vector<uint8_t> data(write_buffer.data(), write_buffer.size(), write_buffer.size());
+        auto write_res = fs.write(fd.value(), data);
+        ASSERT_TRUE(write_res.has_value());
+        ASSERT_EQ(write_res.value(), write_buffer.size());
+        ASSERT_TRUE(fs.close(fd.value()).has_value());
+    }
+
+    // Dirty blocks were written back when the first instance was destroyed
+    PpFS fs(disk);
+    ASSERT_TRUE(fs.init().has_value());
+    auto fd = fs.open("/file");
+    ASSERT_TRUE(fd.has_value());
+    std::array<uint8_t, 600> read_buffer;
+    static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+    ASSERT_TRUE(fs.read(fd.value(), read_buffer.size(), read_data).has_value());
+    ASSERT_EQ(read_data.size(), write_buffer.size());
+    EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), write_buffer.begin()));
+}
+
+TEST(PpFS, AllocationPoliciesKeepFilesReadable)
+{
+    for (auto policy : { AllocationPolicy::FirstFit, AllocationPolicy::NextFit,
+             AllocationPolicy::ThreadGroups }) {
+        StackDisk disk;
+        std::array<uint8_t, 700> write_buffer;
+        for (size_t i = 0; i < write_buffer.size(); i++)
+            write_buffer[i] = static_cast<uint8_t>(i * 3);
+        {
+            PpFS fs(disk);
+            ASSERT_TRUE(fs.format(FsConfig {
+                                      .total_size = disk.size(),
+                                      .average_file_size = 1024,
+                                      .block_size = 256,
+                                      .ecc_type = ECCType::None,
+                                      .allocation_policy = policy,
+                                  })
+                    .has_value());
+            for (auto path : { "/a", "/b", "/c" }) {
+                ASSERT_TRUE(fs.create(path).has_value());
+                auto fd = fs.open(path);
+                ASSERT_TRUE(fd.has_value());
+                static_vector<uint8_t> data(
+                    write_buffer.data(), write_buffer.size(), write_buffer.size());
+                ASSERT_EQ(fs.write(fd.value(), data).value(), write_buffer.size());
+                ASSERT_TRUE(fs.close(fd.value()).has_value());
+            }
+            ASSERT_TRUE(fs.remove("/b").has_value());
+        }
+
+        // Policy comes back from the superblock
+        SuperBlockManager super_block_manager(disk);
+        EXPECT_EQ(super_block_manager.get().value().allocation_policy, policy);
+
+        PpFS fs(disk);
+        ASSERT_TRUE(fs.init().has_value());
+        for (auto path : { "/a", "/c" }) {
+            auto fd = fs.open(path);
+            ASSERT_TRUE(fd.has_value());
+            std::array<uint8_t, 700> read_buffer;
+            static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+            ASSERT_TRUE(fs.read(fd.value(), read_buffer.size(), read_data).has_value());
+            EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), write_buffer.begin()));
+            ASSERT_TRUE(fs.close(fd.value()).has_value());
+        }
+    }
+}
+
+TEST(PpFS, SyncWritesInodesOfOpenFiles)
+{
+    StackDisk disk;
+    PpFS fs(disk);
+    ASSERT_TRUE(fs.format(FsConfig {
+                              .total_size = disk.size(),
+                              .average_file_size = 1024,
+                              .block_size = 256,
+                          })
+            .has_value());
+    ASSERT_TRUE(fs.create("/file").has_value());
+    auto fd = fs.open("/file");
+    ASSERT_TRUE(fd.has_value());
+    std::array<uint8_t, 300> write_buffer {};
+    static_vector<uint8_t> data(write_buffer.data(), write_buffer.size(), write_buffer.size());
+    ASSERT_TRUE(fs.write(fd.value(), data).has_value());
+    ASSERT_TRUE(fs.sync().has_value());
+
+    // Second instance reads the disk while the file is still open in the first one
+    PpFS other(disk);
+    ASSERT_TRUE(other.init().has_value());
+    auto stat_res = other.getFileStat("/file");
+    ASSERT_TRUE(stat_res.has_value());
+    EXPECT_EQ(stat_res.value().size, write_buffer.size());
+
+    auto stats = fs.getInodeCacheStats();
+    ASSERT_TRUE(stats.has_value());
+    EXPECT_GT(stats.value().hits, 0);
+    ASSERT_TRUE(fs.close(fd.value()).has_value());
+}
+
+TEST(PpFS, AlignedInodesKeepFilesReadable)
+{
+    StackDisk disk;
+    std::array<uint8_t, 500> write_buffer;
+    for (size_t i = 0; i < write_buffer.size(); i++)
+        write_buffer[i] = static_cast<uint8_t>(i * 5);
+    {
+        PpFS fs(disk);
+        ASSERT_TRUE(fs.format(FsConfig {
+                                  .total_size = disk.size(),
+                                  .average_file_size = 1024,
+                                  .block_size = 256,
+                                  .ecc_type = ECCType::ReedSolomon,
+                                  .rs_correctable_bytes = 8,
+                                  .align_inodes = true,
+                              })
+                .has_value());
+        for (auto path : { "/a", "/b", "/c" }) {
+            ASSERT_TRUE(fs.create(path).has_value());
+            auto fd = fs.open(path);
+            ASSERT_TRUE(fd.has_value());
+            static_vector<uint8_t> data(
+                write_buffer.data(), write_buffer.size(), write_buffer.size());
+            ASSERT_EQ(fs.write(fd.value(), data).value(), write_buffer.size());
+            ASSERT_TRUE(fs.close(fd.value()).has_value());
+        }
+    }
+
+    SuperBlockManager super_block_manager(disk);
+    EXPECT_TRUE(super_block_manager.get().value().inodes_block_aligned);
+
+    PpFS fs(disk);
+    ASSERT_TRUE(fs.init().has_value());
+    for (auto path : { "/a", "/b", "/c" }) {
+        auto fd = fs.open(path);
+        ASSERT_TRUE(fd.has_value());
+        std::array<uint8_t, 500> read_buffer;
+        static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+        ASSERT_TRUE(fs.read(fd.value(), read_buffer.size(), read_data).has_value());
+        EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), write_buffer.begin()));
+        ASSERT_TRUE(fs.close(fd.value()).has_value());
+    }
+}
+
+TEST(PpFS, WritesThroughOneDescriptorAreSeenByAnother)
+{
+    StackDisk disk;
+    PpFS fs(disk);
+    ASSERT_TRUE(fs.format(FsConfig {
+                              .total_size = disk.size(),
+                              .average_file_size = 1024,
+                              .block_size = 128,
+                          })
+            .has_value());
+    ASSERT_TRUE(fs.create("/file").has_value());
+    auto writer = fs.open("/file");
+    auto reader = fs.open("/file");
+    ASSERT_TRUE(writer.has_value());
+    ASSERT_TRUE(reader.has_value());
+
+    // Every round adds blocks behind the indirect block the reader has cached
+    std::array<uint8_t, 128> buffer;
+    for (uint8_t round = 0; round < 30; round++) {
+        buffer.fill(round);
+        static_vector<uint8_t> data(buffer.data(), buffer.size(), buffer.size());
+        ASSERT_TRUE(fs.write(writer.value(), data).has_value());
+
+        static_vector<uint8_t> read_data(buffer.data(), buffer.size());
+        buffer.fill(0xFF);
+        ASSERT_TRUE(fs.read(reader.value(), buffer.size(), read_data).has_value());
+        ASSERT_EQ(read_data.size(), buffer.size());
+        EXPECT_EQ(read_data[0], round);
+    }
+}
+
+TEST(PpFS, ExtentMappedFilesKeepDataAcrossRemount)
+{
+    StackDisk disk;
+    std::array<uint8_t, 5000> write_buffer;
+    for (size_t i = 0; i < write_buffer.size(); i++)
+        write_buffer[i] = static_cast<uint8_t>(i * 11);
+    {
+        PpFS fs(disk);
+        ASSERT_TRUE(fs.format(FsConfig {
+                                  .total_size = disk.size(),
+                                  .average_file_size = 1024,
+                                  .block_size = 256,
+                                  .ecc_type = ECCType::Crc,
+                                  .extent_mapped_files = true,
+                              })
+                .has_value());
+        ASSERT_TRUE(fs.createDirectory("/dir").has_value());
+        for (auto path : { "/dir/a", "/dir/b", "/c" }) {
+            ASSERT_TRUE(fs.create(path).has_value());
+            auto fd = fs.open(path);
+            ASSERT_TRUE(fd.has_value());
+            static_vector<uint8_t> data(
+                write_buffer.data(), write_buffer.size(), write_buffer.size());
+            ASSERT_EQ(fs.write(fd.value(), data).value(), write_buffer.size());
+            ASSERT_TRUE(fs.close(fd.value()).has_value());
+        }
+        ASSERT_TRUE(fs.remove("/dir/b").has_value());
+    }
+
+    SuperBlockManager super_block_manager(disk);
+    EXPECT_TRUE(super_block_manager.get().value().extent_mapped_files);
+
+    PpFS fs(disk);
+    ASSERT_TRUE(fs.init().has_value());
+    for (auto path : { "/dir/a", "/c" }) {
+        auto fd = fs.open(path);
+        ASSERT_TRUE(fd.has_value());
+        std::array<uint8_t, 5000> read_buffer;
+        static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+        ASSERT_TRUE(fs.read(fd.value(), read_buffer.size(), read_data).has_value());
+        ASSERT_EQ(read_data.size(), write_buffer.size());
+        EXPECT_TRUE(std::equal(read_data.begin(), read_data.end(), write_buffer.begin()));
+        ASSERT_TRUE(fs.close(fd.value()).has_value());
+    }
+}
+
+TEST(PpFS, IndexedDirectoriesKeepEntriesAcrossRemount)
+{
+    StackDisk disk;
+    constexpr size_t count = DirectoryManager::INDEX_MIN_ENTRIES + 44;
+    {
+        PpFS fs(disk);
+        ASSERT_TRUE(fs.format(FsConfig {
+                                  .total_size = disk.size(),
+                                  .average_file_size = 1024,
+                                  .block_size = 512,
+                                  .ecc_type = ECCType::Crc,
+                                  .indexed_directories = true,
+                              })
+                .has_value());
+        ASSERT_TRUE(fs.createDirectory("/dir").has_value());
+        for (size_t i = 0; i < count; i++) {
+            std::string path = "/dir/file_" + std::to_string(i);
+            ASSERT_TRUE(fs.create(path).has_value()) << path;
+        }
+        for (size_t i = 0; i < count; i += 4) {
+            std::string path = "/dir/file_" + std::to_string(i);
+            ASSERT_TRUE(fs.remove(path).has_value()) << path;
+        }
+        auto stat = fs.getFileStat("/dir");
+        ASSERT_TRUE(stat.has_value());
+        EXPECT_EQ(stat->number_of_entries, count - count / 4);
+    }
+
+    SuperBlockManager super_block_manager(disk);
+    EXPECT_TRUE(super_block_manager.get().value().indexed_directories);
+
+    PpFS fs(disk);
+    ASSERT_TRUE(fs.init().has_value());
+    for (size_t i = 0; i < count; i++) {
+        std::string path = "/dir/file_" + std::to_string(i);
+        EXPECT_EQ(fs.getFileStat(path).has_value(), i % 4 != 0) << path;
+    }
+
+    std::array<DirectoryEntry, count> entries_buffer;
+    static_vector<DirectoryEntry> entries(entries_buffer.data(), entries_buffer.size());
+    ASSERT_TRUE(fs.readDirectory("/dir", entries).has_value());
+    EXPECT_EQ(entries.size(), count - count / 4);
+}
+
+TEST(PpFS, MountsImageOfFirstSuperBlockVersion)
+{
+    StackDisk disk;
+    ASSERT_EQ(disk.size(), BASELINE_IMAGE_SIZE);
+    ASSERT_TRUE(writeBaselineImage(disk).has_value());
+
+    std::array<uint8_t, 1024> data_buffer;
+    {
+        PpFS fs(disk);
+        ASSERT_TRUE(fs.init().has_value());
+
+        auto fd = fs.open("/docs/readme", OpenMode::Normal);
+        ASSERT_TRUE(fd.has_value());
+        static_vector<uint8_t> data(data_buffer.data(), data_buffer.size());
+        ASSERT_TRUE(fs.read(fd.value(), data_buffer.size(), data).has_value());
+        ASSERT_EQ(data.size(), BASELINE_IMAGE_README_SIZE);
+        for (size_t i = 0; i < data.size(); i++)
+            ASSERT_EQ(data[i], static_cast<uint8_t>(i * 7 + 3)) << i;
+        ASSERT_TRUE(fs.close(fd.value()).has_value());
+
+        std::array<DirectoryEntry, BASELINE_IMAGE_BIG_FILES + 1> entries_buffer;
+        static_vector<DirectoryEntry> entries(entries_buffer.data(), entries_buffer.size());
+        ASSERT_TRUE(fs.readDirectory("/big", entries).has_value());
+        EXPECT_EQ(entries.size(), BASELINE_IMAGE_BIG_FILES);
+
+        // Changes are written in the layout of the image
+        ASSERT_TRUE(fs.create("/docs/notes").has_value());
+        fd = fs.open("/docs/notes", OpenMode::Normal);
+        ASSERT_TRUE(fd.has_value());
+        std::fill(data_buffer.begin(), data_buffer.end(), 0x5a);
+        static_vector<uint8_t> notes(data_buffer.data(), data_buffer.size(), 300);
+        ASSERT_TRUE(fs.write(fd.value(), notes).has_value());
+        ASSERT_TRUE(fs.close(fd.value()).has_value());
+        ASSERT_TRUE(fs.remove("/big/file3").has_value());
+    }
+
+    SuperBlockManager super_block_manager(disk);
+    auto super_block = super_block_manager.get();
+    ASSERT_TRUE(super_block.has_value());
+    EXPECT_EQ(super_block->version, 1);
+    EXPECT_EQ(super_block->allocation_policy, AllocationPolicy::FirstFit);
+    EXPECT_FALSE(super_block->inodes_block_aligned);
+    EXPECT_FALSE(super_block->extent_mapped_files);
+    EXPECT_FALSE(super_block->indexed_directories);
+
+    PpFS fs(disk);
+    ASSERT_TRUE(fs.init().has_value());
+    auto readme = fs.getFileStat("/docs/readme");
+    ASSERT_TRUE(readme.has_value());
+    EXPECT_EQ(readme->size, BASELINE_IMAGE_README_SIZE);
+    auto fd = fs.open("/docs/notes", OpenMode::Normal);
+    ASSERT_TRUE(fd.has_value());
+    static_vector<uint8_t> data(data_buffer.data(), data_buffer.size());
+    ASSERT_TRUE(fs.read(fd.value(), data_buffer.size(), data).has_value());
+    ASSERT_EQ(data.size(), 300);
+    EXPECT_TRUE(std::all_of(data.begin(), data.end(), [](uint8_t b) { return b == 0x5a; }));
+    EXPECT_FALSE(fs.getFileStat("/big/file3").has_value());
+    EXPECT_TRUE(fs.getFileStat("/big/file19").has_value());
+}
+
+TEST(PpFS, DirectoriesOfFirstSuperBlockVersionAreScannedLinearly)
+{
+    StackDisk disk;
+    ASSERT_TRUE(writeBaselineImage(disk).has_value());
+
+    // Growing past the index threshold does not index a directory of an image without indexes
+    constexpr size_t count = DirectoryManager::INDEX_MIN_ENTRIES + 44;
+    {
+        PpFS fs(disk);
+        ASSERT_TRUE(fs.init().has_value());
+        for (size_t i = 0; i < count; i++) {
+            std::string path = "/big/new_" + std::to_string(i);
+            ASSERT_TRUE(fs.create(path).has_value()) << path;
+        }
+        auto stat = fs.getFileStat("/big");
+        ASSERT_TRUE(stat.has_value());
+        EXPECT_EQ(stat->number_of_entries, BASELINE_IMAGE_BIG_FILES + count);
+        EXPECT_EQ(stat->size, stat->number_of_entries * sizeof(DirectoryEntry));
+    }
+
+    PpFS fs(disk);
+    ASSERT_TRUE(fs.init().has_value());
+    for (size_t i = 0; i < BASELINE_IMAGE_BIG_FILES; i++) {
+        std::string path = "/big/file" + std::to_string(i);
+        EXPECT_TRUE(fs.getFileStat(path).has_value()) << path;
+    }
+    for (size_t i = 0; i < count; i++) {
+        std::string path = "/big/new_" + std::to_string(i);
+        EXPECT_TRUE(fs.getFileStat(path).has_value()) << path;
+    }
+    auto stat = fs.getFileStat("/big");
+    ASSERT_TRUE(stat.has_value());
+    EXPECT_EQ(stat->size, stat->number_of_entries * sizeof(DirectoryEntry));
+}
+
+TEST(PpFS, ConcurrentReadsAndWritesOfDifferentFiles)
+{
+    StackDisk disk;
+    static std::array<CachingBlockDevice::Entry, CachingBlockDevice::DEFAULT_CAPACITY>
+        cache_entries;
+    PpFS fs(disk, nullptr, CachePolicy::None, { cache_entries.data(), cache_entries.size() });
+    ASSERT_TRUE(fs.format(FsConfig {
+                              .total_size = disk.size(),
+                              .average_file_size = 1024,
+                              .block_size = 256,
+                              .ecc_type = ECCType::Crc,
+                              .cache_policy = CachePolicy::WriteBack,
+                          })
+            .has_value());
+    ASSERT_TRUE(fs.createDirectory("/data").has_value());
+
+    static constexpr int FILES = 4;
+    static constexpr size_t FILE_SIZE = 2000;
+    for (int f = 0; f < FILES; f++) {
+        std::string path = "/data/read" + std::to_string(f);
+        ASSERT_TRUE(fs.create(path).has_value());
+        auto fd = fs.open(path);
+        ASSERT_TRUE(fd.has_value());
+        std::array<uint8_t, FILE_SIZE> buffer;
+        for (size_t i = 0; i < FILE_SIZE; i++)
+            buffer[i] = static_cast<uint8_t>(i * (f + 3));
+        static_vector<uint8_t> data(buffer.data(), buffer.size(), buffer.size());
+        ASSERT_TRUE(fs.write(fd.value(), data).has_value());
+        ASSERT_TRUE(fs.close(fd.value()).has_value());
+    }
+
+    std::vector<std::thread> threads;
+    for (int f = 0; f < FILES; f++) {
+        threads.emplace_back([&fs, f] {
+            auto fd = fs.open("/data/read" + std::to_string(f));
+            ASSERT_TRUE(fd.has_value());
+            for (int round = 0; round < 10; round++) {
+                ASSERT_TRUE(fs.seek(fd.value(), 0).has_value());
+                std::array<uint8_t, FILE_SIZE> buffer;
+                static_vector<uint8_t> data(buffer.data(), buffer.size());
+                ASSERT_TRUE(fs.read(fd.value(), FILE_SIZE, data).has_value());
+                ASSERT_EQ(data.size(), FILE_SIZE);
+                for (size_t i = 0; i < FILE_SIZE; i++)
+                    ASSERT_EQ(data[i], static_cast<uint8_t>(i * (f + 3)));
+            }
+            ASSERT_TRUE(fs.close(fd.value()).has_value());
+        });
+        threads.emplace_back([&fs, f] {
+            std::string path = "/write" + std::to_string(f);
+            ASSERT_TRUE(fs.create(path).has_value());
+            auto fd = fs.open(path);
+            ASSERT_TRUE(fd.has_value());
+            std::array<uint8_t, 100> buffer;
+            buffer.fill(static_cast<uint8_t>(f));
+            static_vector<uint8_t> data(buffer.data(), buffer.size(), buffer.size());
+            for (int round = 0; round < 10; round++)
+                ASSERT_TRUE(fs.write(fd.value(), data).has_value());
+            ASSERT_TRUE(fs.close(fd.value()).has_value());
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    for (int f = 0; f < FILES; f++) {
+        auto stat = fs.getFileStat("/write" + std::to_string(f));
+        ASSERT_TRUE(stat.has_value());
+        EXPECT_EQ(stat.value().size, 1000);
+    }
+    auto root = fs.getFileStat("/");
+    ASSERT_TRUE(root.has_value());
+    EXPECT_EQ(root.value().number_of_entries, FILES + 1);
+}
+
+TEST(PpFS, ConcurrentReadsAtOffsetsThroughOneDescriptor)
+{
+    StackDisk disk;
+    PpFS fs(disk);
+    ASSERT_TRUE(fs.format(FsConfig {
+                              .total_size = disk.size(),
+                              .average_file_size = 1024,
+                              .block_size = 256,
+                              .ecc_type = ECCType::Crc,
+                          })
+            .has_value());
+    ASSERT_TRUE(fs.create("/shared").has_value());
+    auto fd = fs.open("/shared");
+    ASSERT_TRUE(fd.has_value());
+
+    static constexpr size_t FILE_SIZE = 8000;
+    static constexpr size_t CHUNK = 500;
+    std::array<uint8_t, FILE_SIZE> file;
+    for (size_t i = 0; i < FILE_SIZE; i++)
+        file[i] = static_cast<uint8_t>(i * 13 + i / 256);
+    static_vector<uint8_t> file_data(file.data(), file.size(), file.size());
+    ASSERT_TRUE(fs.write(fd.value(), file_data).has_value());
+
+    // Positional reads share the descriptor with a thread reading from its position
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&fs, &file, fd = fd.value(), t] {
+            for (int round = 0; round < 20; round++) {
+                size_t offset = ((t * 20 + round) * 311) % (FILE_SIZE - CHUNK);
+                std::array<uint8_t, CHUNK> buffer;
+                static_vector<uint8_t> data(buffer.data(), buffer.size());
+                ASSERT_TRUE(fs.readAt(fd, offset, CHUNK, data).has_value());
+                ASSERT_EQ(data.size(), CHUNK);
+                for (size_t i = 0; i < CHUNK; i++)
+                    ASSERT_EQ(data[i], file[offset + i]) << offset + i;
+            }
+        });
+    }
+    threads.emplace_back([&fs, &file, fd = fd.value()] {
+        for (int round = 0; round < 5; round++) {
+            ASSERT_TRUE(fs.seek(fd, 0).has_value());
+            for (size_t offset = 0; offset < FILE_SIZE; offset += CHUNK) {
+                std::array<uint8_t, CHUNK> buffer;
+                static_vector<uint8_t> data(buffer.data(), buffer.size());
+                ASSERT_TRUE(fs.read(fd, CHUNK, data).has_value());
+                ASSERT_EQ(data.size(), CHUNK);
+                for (size_t i = 0; i < CHUNK; i++)
+                    ASSERT_EQ(data[i], file[offset + i]) << offset + i;
+            }
+        }
+    });
+    for (auto& thread : threads)
+        thread.join();
+    ASSERT_TRUE(fs.close(fd.value()).has_value());
+}
@@ -3,6 +3,9 @@
 #include "ppfs/filesystem/ppfs_low_level.hpp"
 #include <array>
 #include <gtest/gtest.h>
+#include <optional>
+#include <thread>
+#include <vector>
 
 static std::unique_ptr<PpFSLowLevel> prepareFS(IDisk& disk)
 {
@@ -103,6 +106,37 @@ TEST(PpFS, DirEntriesAfterFileCreate)
         << "Name: " << std::string(entries[0].name.data()) << std::endl;
 }
 
+TEST(PpFSLowLevel, GetDirectoryEntriesWithAttributesFromOffset)
+{
+    StackDisk disk;
+    auto ppfs = prepareFS(disk);
+
+    constexpr size_t count = 40;
+    for (size_t i = 0; i < count; i++) {
+        std::string name = "f" + std::to_string(i);
+        auto created = i % 4 == 0 ? ppfs->createDirectoryByParent(0, name)
+                                  : ppfs->createWithParentInode(name, 0);
+        ASSERT_TRUE(created.has_value());
+    }
+
+    std::array<DirectoryEntry, count> entries_buffer;
+    std::array<std::optional<FileAttributes>, count> attributes_buffer;
+    static_vector<DirectoryEntry> entries(entries_buffer.data(), entries_buffer.size());
+    static_vector<std::optional<FileAttributes>> attributes(
+        attributes_buffer.data(), attributes_buffer.size());
+    auto res = ppfs->getDirectoryEntriesWithAttributes(0, entries, attributes, 3, 0);
+    ASSERT_TRUE(res.has_value());
+    ASSERT_EQ(entries.size(), count - 3);
+    ASSERT_EQ(attributes.size(), entries.size());
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        EXPECT_EQ(std::string_view(entries[i].name.data()), "f" + std::to_string(i + 3));
+        ASSERT_TRUE(attributes[i].has_value());
+        EXPECT_EQ(attributes[i]->type,
+            (i + 3) % 4 == 0 ? InodeType::Directory : InodeType::File);
+    }
+}
+
 TEST(PpFS, CreateDirectorySimple)
 {
     StackDisk disk;
@@ -275,3 +309,113 @@ TEST(PpFS, RecursiveRemove)
     auto check = ppfs->lookup(0, "folder");
     ASSERT_FALSE(check.has_value());
 }
+
+TEST(PpFSLowLevel, ConcurrentRequestsLikeFuseWorkers)
+{
+    StackDisk disk;
+    static std::array<CachingBlockDevice::Entry, CachingBlockDevice::DEFAULT_CAPACITY>
+        cache_entries;
+    PpFSLowLevel fs(disk, CachePolicy::WriteBack, { cache_entries.data(), cache_entries.size() });
+    ASSERT_TRUE(fs.format(FsConfig {
+                              .total_size = disk.size(),
+                              .average_file_size = 1024,
+                              .block_size = 256,
+                              .ecc_type = ECCType::Crc,
+                          })
+            .has_value());
+    auto dir = fs.createDirectoryByParent(0, "jobs");
+    ASSERT_TRUE(dir.has_value());
+
+    static constexpr int JOBS = 4;
+    static constexpr size_t CHUNK = 300;
+    static constexpr int ROUNDS = 8;
+    inode_index_t parent = dir.value();
+
+    std::vector<std::thread> threads;
+    for (int job = 0; job < JOBS; job++) {
+        // Every job creates its own file, then rewrites and reads it back like a fio job
+        threads.emplace_back([&fs, parent, job] {
+            std::string name = "job" + std::to_string(job);
+            ASSERT_TRUE(fs.createWithParentInode(name, parent).has_value());
+            auto inode = fs.lookup(parent, name);
+            ASSERT_TRUE(inode.has_value());
+            auto fd = fs.openByInode(inode.value(), OpenMode::Normal);
+            ASSERT_TRUE(fd.has_value());
+
+            std::array<uint8_t, CHUNK> out;
+            std::array<uint8_t, CHUNK> in;
+            for (int round = 0; round < ROUNDS; round++) {
+                out.fill(static_cast<uint8_t>(job * ROUNDS + round));
+                static_vector<uint8_t> to_write(out.data(), out.size(), out.size());
+                ASSERT_TRUE(fs.seek(fd.value(), round * CHUNK).has_value());
+                ASSERT_TRUE(fs.write(fd.value(), to_write).has_value());
+
+                static_vector<uint8_t> read_back(in.data(), in.size());
+                ASSERT_TRUE(fs.seek(fd.value(), round * CHUNK).has_value());
+                ASSERT_TRUE(fs.read(fd.value(), CHUNK, read_back).has_value());
+                ASSERT_EQ(read_back.size(), CHUNK);
+                for (size_t i = 0; i < CHUNK; i++)
+                    ASSERT_EQ(read_back[i], out[i]);
+
+                auto attrs = fs.getAttributes(inode.value());
+                ASSERT_TRUE(attrs.has_value());
+                ASSERT_EQ(attrs->size, (round + 1) * CHUNK);
+            }
+            ASSERT_TRUE(fs.close(fd.value()).has_value());
+            ASSERT_TRUE(fs.truncate(inode.value(), CHUNK).has_value());
+        });
+        // Metadata traffic on the same directory, as from stat and ls
+        threads.emplace_back([&fs, parent, job] {
+            std::string name = "tmp" + std::to_string(job);
+            for (int round = 0; round < ROUNDS; round++) {
+                ASSERT_TRUE(fs.createWithParentInode(name, parent).has_value());
+                ASSERT_TRUE(fs.lookup(parent, name).has_value());
+                ASSERT_TRUE(fs.getAttributes(parent).has_value());
+                ASSERT_TRUE(fs.removeByNameAndParent(parent, name).has_value());
+                ASSERT_FALSE(fs.lookup(parent, name).has_value());
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    std::array<DirectoryEntry, JOBS + 1> entries_buffer;
+    static_vector<DirectoryEntry> entries(entries_buffer.data(), entries_buffer.size());
+    ASSERT_TRUE(fs.getDirectoryEntries(parent, entries, 0, 0).has_value());
+    ASSERT_EQ(entries.size(), JOBS);
+    for (const auto& entry : entries) {
+        auto attrs = fs.getAttributes(entry.inode);
+        ASSERT_TRUE(attrs.has_value());
+        EXPECT_EQ(attrs->size, CHUNK);
+    }
+}
+
+TEST(PpFSLowLevel, TruncateWhileDescriptorSeeks)
+{
+    StackDisk disk;
+    auto ppfs = prepareFS(disk);
+    auto inode = ppfs->createWithParentInode("file", 0);
+    ASSERT_TRUE(inode.has_value());
+    auto fd = ppfs->openByInode(inode.value(), OpenMode::Normal);
+    ASSERT_TRUE(fd.has_value());
+
+    std::array<uint8_t, 200> data_buffer {};
+    static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), data_buffer.size());
+    ASSERT_TRUE(ppfs->write(fd.value(), data).has_value());
+    ASSERT_TRUE(ppfs->seek(fd.value(), 0).has_value());
+
+    static constexpr int ROUNDS = 200;
+    // Truncate checks positions of descriptors it does not lock
+    std::thread seeker([&] {
+        for (int round = 0; round < ROUNDS; round++)
+            ASSERT_TRUE(ppfs->seek(fd.value(), round % 100).has_value());
+    });
+    for (int round = 0; round < ROUNDS; round++)
+        ASSERT_TRUE(ppfs->truncate(inode.value(), 150 + round % 50).has_value());
+    seeker.join();
+
+    // Shrinking below the position is still refused
+    ASSERT_TRUE(ppfs->seek(fd.value(), 120).has_value());
+    EXPECT_FALSE(ppfs->truncate(inode.value(), 100).has_value());
+    ASSERT_TRUE(ppfs->close(fd.value()).has_value());
+}
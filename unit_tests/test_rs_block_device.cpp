@@ -1,10 +1,16 @@
 #include "ppfs/blockdevice/rs_block_device.hpp"
 #include "ppfs/common/static_vector.hpp"
 #include "ppfs/disk/stack_disk.hpp"
+#include "ppfs/ecc_helpers/rs_decoder.hpp"
+#include "ppfs/ecc_helpers/rs_encoder.hpp"
+#include "ppfs/ecc_helpers/syndrome_calculator.hpp"
 
+#include <algorithm>
 #include <array>
 #include <gtest/gtest.h>
+#include <numeric>
 #include <random>
+#include <vector>
 
 TEST(ReedSolomonBlockDevice, BasicReadWrite)
 {
@@ -136,3 +142,205 @@ TEST(ReedSolomonBlockDevice, TripleByteError)
         EXPECT_EQ(fixed[i], data[i]) << "Data mismatch after three-byte corruption at " << i;
     }
 }
+
+TEST(SyndromeCalculator, MatchesPolynomialEvaluation)
+{
+    std::mt19937 rng(7);
+    std::array<size_t, 5> sizes = { 1, 15, 33, 128, 255 };
+    std::array<size_t, 4> counts = { 2, 6, 32, 254 };
+
+    std::array<uint8_t, MAX_RS_BLOCK_SIZE> codeword_buffer;
+    std::array<GF256, MAX_RS_BLOCK_SIZE> simd_buffer, scalar_buffer;
+    for (auto count : counts) {
+        SyndromeCalculator simd(count);
+        SyndromeCalculator scalar(count, false);
+        EXPECT_EQ(scalar.width(), 1);
+        for (auto size : sizes) {
+            static_vector<uint8_t> codeword(codeword_buffer.data(), codeword_buffer.size(), size);
+            for (auto& byte : codeword) {
+                byte = static_cast<uint8_t>(rng());
+            }
+            static_vector<GF256> simd_syndromes(simd_buffer.data(), simd_buffer.size());
+            static_vector<GF256> scalar_syndromes(scalar_buffer.data(), scalar_buffer.size());
+            simd.calculate(codeword, simd_syndromes);
+            scalar.calculate(codeword, scalar_syndromes);
+
+            static_vector<GF256> coeffs(
+                reinterpret_cast<GF256*>(codeword.data()), codeword.size(), codeword.size());
+            PolynomialGF256 poly(coeffs);
+            GF256 power(1);
+            ASSERT_EQ(simd_syndromes.size(), count);
+            for (size_t j = 0; j < count; j++) {
+                power = power * GF256::getPrimitiveElement();
+                auto expected = poly.evaluate(power);
+                EXPECT_EQ(simd_syndromes[j], expected) << "size " << size << ", j " << j;
+                EXPECT_EQ(scalar_syndromes[j], expected) << "size " << size << ", j " << j;
+            }
+        }
+    }
+}
+
+TEST(SyndromeCalculator, ValidCodewordHasZeroSyndromes)
+{
+    StackDisk disk;
+    ReedSolomonBlockDevice rs(disk, 200, 4);
+    SyndromeCalculator calculator(8);
+
+    std::array<uint8_t, 512> data_buffer;
+    std::iota(data_buffer.begin(), data_buffer.begin() + rs.dataSize(), std::uint8_t { 3 });
+    static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), rs.dataSize());
+    ASSERT_TRUE(rs.formatBlock(0).has_value());
+    ASSERT_TRUE(rs.writeBlock(data, DataLocation(0, 0)).has_value());
+
+    std::array<uint8_t, 512> raw_buffer;
+    static_vector<uint8_t> raw(raw_buffer.data(), raw_buffer.size(), rs.rawBlockSize());
+    ASSERT_TRUE(disk.read(0, rs.rawBlockSize(), raw).has_value());
+
+    std::array<GF256, MAX_RS_BLOCK_SIZE> syndromes_buffer;
+    static_vector<GF256> syndromes(syndromes_buffer.data(), syndromes_buffer.size());
+    EXPECT_TRUE(calculator.calculate(raw, syndromes));
+
+    raw[17] ^= std::uint8_t { 0x40 };
+    EXPECT_FALSE(calculator.calculate(raw, syndromes));
+}
+
+static PolynomialGF256 makeGenerator(size_t parity_size)
+{
+    PolynomialGF256 g({ GF256(1) });
+    GF256 power = GF256::getPrimitiveElement();
+    for (size_t i = 0; i < parity_size; i++) {
+        g = g * PolynomialGF256({ power, GF256(1) });
+        power = power * GF256::getPrimitiveElement();
+    }
+    return g;
+}
+
+TEST(RsEncoder, MatchesPolynomialDivision)
+{
+    std::mt19937 rng(11);
+    std::array<std::pair<size_t, size_t>, 4> shapes = { std::pair<size_t, size_t> { 255, 2 },
+        { 255, 32 }, { 100, 6 }, { 17, 16 } };
+
+    for (auto [size, parity_size] : shapes) {
+        auto generator = makeGenerator(parity_size);
+        RsEncoder encoder(generator, size);
+
+        std::array<uint8_t, MAX_RS_BLOCK_SIZE> codeword_buffer;
+        static_vector<uint8_t> codeword(codeword_buffer.data(), codeword_buffer.size(), size);
+        for (auto& byte : codeword) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        encoder.encode(codeword);
+
+        static_vector<GF256> message(reinterpret_cast<GF256*>(codeword.data() + parity_size),
+            size - parity_size, size - parity_size);
+        auto shifted = PolynomialGF256(message).multiply_by_xk(parity_size);
+        auto parity = shifted.mod(generator);
+        for (size_t i = 0; i < parity_size; i++) {
+            EXPECT_EQ(GF256(codeword[i]), parity[i]) << "size " << size << ", byte " << i;
+        }
+    }
+}
+
+TEST(RsEncoder, UpdateMatchesEncode)
+{
+    std::mt19937 rng(12);
+    auto generator = makeGenerator(10);
+    RsEncoder encoder(generator, 200);
+
+    std::array<uint8_t, MAX_RS_BLOCK_SIZE> codeword_buffer, expected_buffer, data_buffer;
+    static_vector<uint8_t> codeword(codeword_buffer.data(), codeword_buffer.size(), 200);
+    for (auto& byte : codeword) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    encoder.encode(codeword);
+
+    std::array<std::pair<size_t, size_t>, 4> writes = { std::pair<size_t, size_t> { 0, 1 },
+        { 5, 17 }, { 150, 40 }, { 189, 30 } };
+    for (auto [offset, size] : writes) {
+        static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), size);
+        for (auto& byte : data) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        auto written = encoder.update(codeword, offset, data);
+        EXPECT_EQ(written, std::min(size, 190 - offset));
+
+        std::copy_n(codeword.begin(), codeword.size(), expected_buffer.begin());
+        static_vector<uint8_t> expected(expected_buffer.data(), expected_buffer.size(), 200);
+        encoder.encode(expected);
+        for (size_t i = 0; i < 200; i++) {
+            EXPECT_EQ(codeword[i], expected[i]) << "offset " << offset << ", byte " << i;
+        }
+    }
+}
+
+TEST(ReedSolomonBlockDevice, PartialWritesKeepBlockValid)
+{
+    StackDisk disk;
+    ReedSolomonBlockDevice rs(disk, 255, 3);
+    SyndromeCalculator calculator(6);
+    ASSERT_TRUE(rs.formatBlock(0).has_value());
+
+    std::array<uint8_t, 64> data_buffer;
+    std::iota(data_buffer.begin(), data_buffer.end(), std::uint8_t { 1 });
+    static_vector<uint8_t> data(data_buffer.data(), data_buffer.size(), data_buffer.size());
+    for (size_t offset : { 0, 10, 100, 200, 240 }) {
+        ASSERT_TRUE(rs.writeBlock(data, DataLocation(0, offset)).has_value());
+
+        std::array<uint8_t, 512> raw_buffer;
+        static_vector<uint8_t> raw(raw_buffer.data(), raw_buffer.size(), rs.rawBlockSize());
+        ASSERT_TRUE(disk.read(0, rs.rawBlockSize(), raw).has_value());
+        std::array<GF256, MAX_RS_BLOCK_SIZE> syndromes_buffer;
+        static_vector<GF256> syndromes(syndromes_buffer.data(), syndromes_buffer.size());
+        EXPECT_TRUE(calculator.calculate(raw, syndromes)) << "offset " << offset;
+    }
+
+    std::array<uint8_t, 512> read_buffer;
+    static_vector<uint8_t> read_data(read_buffer.data(), read_buffer.size());
+    ASSERT_TRUE(rs.readBlock({ 0, 100 }, data.size(), read_data).has_value());
+    ASSERT_EQ(read_data.size(), data.size());
+    for (size_t i = 0; i < data.size(); i++) {
+        EXPECT_EQ(read_data[i], data[i]);
+    }
+}
+
+TEST(RsDecoder, CorrectsUpToHalfOfParity)
+{
+    std::mt19937 rng(13);
+    std::array<std::pair<size_t, size_t>, 3> shapes = { std::pair<size_t, size_t> { 255, 32 },
+        { 100, 6 }, { 40, 2 } };
+
+    for (auto [size, parity_size] : shapes) {
+        RsEncoder encoder(makeGenerator(parity_size), size);
+        RsDecoder decoder(size, parity_size);
+        SyndromeCalculator calculator(parity_size);
+
+        for (size_t errors = 1; errors <= parity_size / 2; errors++) {
+            std::array<uint8_t, MAX_RS_BLOCK_SIZE> original_buffer, codeword_buffer;
+            static_vector<uint8_t> original(original_buffer.data(), original_buffer.size(), size);
+            for (auto& byte : original) {
+                byte = static_cast<uint8_t>(rng());
+            }
+            encoder.encode(original);
+            std::copy_n(original.begin(), size, codeword_buffer.begin());
+            static_vector<uint8_t> codeword(codeword_buffer.data(), codeword_buffer.size(), size);
+
+            std::vector<size_t> positions(size);
+            std::iota(positions.begin(), positions.end(), 0);
+            std::shuffle(positions.begin(), positions.end(), rng);
+            for (size_t i = 0; i < errors; i++) {
+                codeword[positions[i]] ^= static_cast<uint8_t>(1 + rng() % 255);
+            }
+
+            std::array<GF256, MAX_RS_BLOCK_SIZE> syndromes_buffer;
+            static_vector<GF256> syndromes(syndromes_buffer.data(), syndromes_buffer.size());
+            ASSERT_FALSE(calculator.calculate(codeword, syndromes));
+            auto res = decoder.correct(codeword, syndromes);
+            ASSERT_TRUE(res.has_value()) << "size " << size << ", errors " << errors;
+            EXPECT_EQ(res.value(), errors);
+            for (size_t i = 0; i < size; i++) {
+                ASSERT_EQ(codeword[i], original[i]) << "size " << size << ", errors " << errors;
+            }
+        }
+    }
+}
@@ -59,6 +59,79 @@ TEST(SuperBlockManager, WriteAndReadConsistency)
     EXPECT_EQ(sb.ecc_type, read_res.value().ecc_type);
 }
 
+TEST(SuperBlockManager, RejectsOtherVersion)
+{
+    StackDisk disk;
+
+    SuperBlockManager writer(disk);
+    SuperBlock sb { .block_size = 512, .version = SUPER_BLOCK_VERSION + 1 };
+    ASSERT_TRUE(writer.put(sb).has_value());
+
+    SuperBlockManager reader(disk);
+    auto read_res = reader.get();
+    ASSERT_FALSE(read_res.has_value());
+    EXPECT_EQ(read_res.error(), FsError::SuperBlockManager_UnsupportedVersion);
+}
+
+TEST(SuperBlockManager, ReadsVersion1Layout)
+{
+    StackDisk disk;
+
+    SuperBlock sb { .total_blocks = 100,
+        .total_inodes = 200,
+        .inode_table_address = 3,
+        .block_size = 16,
+        .crc_polynomial = 348975,
+        .ecc_type = ECCType::Crc };
+    // Copies of a version 1 image end right after ecc_type
+    static_vector<uint8_t> copy((uint8_t*)&sb, SUPER_BLOCK_V1_SIZE, SUPER_BLOCK_V1_SIZE);
+    ASSERT_TRUE(disk.write(0, copy).has_value());
+    ASSERT_TRUE(disk.write(SUPER_BLOCK_V1_SIZE, copy).has_value());
+    ASSERT_TRUE(disk.write(disk.size() - SUPER_BLOCK_V1_SIZE, copy).has_value());
+
+    // Damage the second copy
+    std::array<uint8_t, 1> byte_buffer { 0xff };
+    static_vector<uint8_t> byte(byte_buffer.data(), 1, 1);
+    ASSERT_TRUE(disk.write(SUPER_BLOCK_V1_SIZE + 5, byte).has_value());
+
+    SuperBlockManager reader(disk);
+    auto read_res = reader.get();
+    ASSERT_TRUE(read_res.has_value())
+        << "Failed to read superblock: " << toString(read_res.error());
+    EXPECT_EQ(read_res->version, 1);
+    EXPECT_EQ(read_res->total_blocks, sb.total_blocks);
+    EXPECT_EQ(read_res->total_inodes, sb.total_inodes);
+    EXPECT_EQ(read_res->inode_table_address, sb.inode_table_address);
+    EXPECT_EQ(read_res->crc_polynomial, sb.crc_polynomial);
+    EXPECT_EQ(read_res->ecc_type, sb.ecc_type);
+    EXPECT_EQ(read_res->allocation_policy, AllocationPolicy::FirstFit);
+
+    // Repaired in place, nothing is written past the version 1 copies
+    ASSERT_TRUE(disk.read(SUPER_BLOCK_V1_SIZE + 5, 1, byte).has_value());
+    EXPECT_EQ(byte[0], copy[5]);
+    ASSERT_TRUE(disk.read(2 * SUPER_BLOCK_V1_SIZE, 1, byte).has_value());
+    EXPECT_EQ(byte[0], 0);
+
+    auto indexes_res = reader.getFreeBlocksIndexes();
+    ASSERT_TRUE(indexes_res.has_value());
+    EXPECT_EQ(indexes_res->start_block, 7);
+    EXPECT_EQ(indexes_res->end_block, disk.size() / 16 - 4);
+}
+
+TEST(SuperBlockManager, RejectsUnknownAllocationPolicy)
+{
+    StackDisk disk;
+
+    SuperBlockManager writer(disk);
+    SuperBlock sb { .block_size = 512, .allocation_policy = static_cast<AllocationPolicy>(7) };
+    ASSERT_TRUE(writer.put(sb).has_value());
+
+    SuperBlockManager reader(disk);
+    auto read_res = reader.get();
+    ASSERT_FALSE(read_res.has_value());
+    EXPECT_EQ(read_res.error(), FsError::SuperBlockManager_InvalidValue);
+}
+
 TEST(SuperBlockManager, GetFreeBlocksIndexes)
 {
     StackDisk disk;